@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: MIT
+
+   Christophe BLAESS 2026.
+   Copyright 2026 Logilin. All rights reserved.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <liberis.h>
+
+#include "eris-api-test.h"
+#include "containers-api-test.h"
+
+// ---------------------- Private macros.
+
+// ---------------------- Private method declarations.
+
+static int get_container_state     (int sockfd);
+static int get_container_list      (int sockfd);
+static int get_container_timeline  (int sockfd);
+static int get_container_resources (int sockfd);
+static int get_container_stats     (int sockfd);
+static int get_container_logs      (int sockfd);
+
+static int read_container_index    (int sockfd, int *index, int all);
+
+
+// ---------------------- Private variables.
+
+// ---------------------- Public variable definitions.
+
+// ---------------------- Public methods
+
+int containers_api_test(int sockfd)
+{
+	for (;;) {
+		sockprintf(sockfd, "\r\n**** Eris Linux Containers Monitoring *****\r\n\n");
+		sockprintf(sockfd, "1:  Get container state      4: Get container resources     \r\n");
+		sockprintf(sockfd, "2:  Get list of containers   5: Get container statistics    \r\n");
+		sockprintf(sockfd, "3:  Get start timeline       6: Get container logs          \r\n");
+		sockprintf(sockfd, "0:  Return                                                  \r\n");
+
+		for (;;) {
+			char choice[32];
+
+			sockprintf(sockfd, "\r\nYour choice: ");
+			if (sockgets(sockfd, choice, 32) == NULL)
+				break;
+
+			if (strcmp(choice, "0") == 0)
+				return 0;
+
+			if (strcmp(choice, "1") == 0) {
+				if (get_container_state(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "2") == 0) {
+				if (get_container_list(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "3") == 0) {
+				if (get_container_timeline(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "4") == 0) {
+				if (get_container_resources(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "5") == 0) {
+				if (get_container_stats(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "6") == 0) {
+				if (get_container_logs(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			sockprintf(sockfd, "INVALID CHOICE");
+			break;
+		}
+	}
+	return 0;
+}
+
+
+// ---------------------- Private methods
+
+static int get_container_state(int sockfd)
+{
+	int index;
+	if (read_container_index(sockfd, &index, 0) != 0)
+		return -1;
+	if (index < 0)
+		return 0;
+
+	char buffer[BUFFER_SIZE];
+	int err = eris_get_container_state(index, buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	if ((strncmp(buffer, "status=", 7) != 0)
+	 || (strstr(buffer, " uptime=") == NULL)
+	 || (strstr(buffer, " restarts=") == NULL)
+	 || (strstr(buffer, " exit_code=") == NULL)
+	 || (strstr(buffer, " health=") == NULL))
+		sockprintf(sockfd, "UNEXPECTED REPLY: ");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int get_container_list(int sockfd)
+{
+	char buffer[BUFFER_SIZE];
+
+	int err = eris_get_container_list(buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// index!presence!id!name!version!status!uptime!restarts!exit_code!health
+	if (check_reply_lines(buffer, NULL, '!', 10) != 0)
+		sockprintf(sockfd, "UNEXPECTED REPLY:\r\n");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int get_container_timeline(int sockfd)
+{
+	char buffer[BUFFER_SIZE];
+
+	int err = eris_get_container_timeline(buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// <uptime in ms> slot-<n> <step> <duration in ms>
+	char *saveptr = NULL;
+	for (char *line = strtok_r(buffer, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
+		long long uptime, duration;
+		int slot;
+		char step[32];
+		if (sscanf(line, "%lld slot-%d %31s %lld", &uptime, &slot, step, &duration) != 4)
+			sockprintf(sockfd, "UNEXPECTED REPLY: ");
+		sockprintf(sockfd, "%s\r\n", line);
+	}
+	return 0;
+}
+
+
+
+static int get_container_resources(int sockfd)
+{
+	int index;
+	if (read_container_index(sockfd, &index, 0) != 0)
+		return -1;
+	if (index < 0)
+		return 0;
+
+	char buffer[BUFFER_SIZE];
+	int err = eris_get_container_resources(index, buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// One <resource>=<usage>[/<limit>] line per resource available.
+	if ((buffer[0] == '\0') || (check_reply_lines(buffer, NULL, '=', 2) != 0))
+		sockprintf(sockfd, "UNEXPECTED REPLY:\r\n");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int get_container_stats(int sockfd)
+{
+	int index;
+	if (read_container_index(sockfd, &index, 1) != 0)
+		return -1;
+	if (index < -1)
+		return 0;
+
+	char buffer[BUFFER_SIZE];
+	int err = eris_get_container_stats(index, buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// index!cpu%!memory!anon!file!read B/s!write B/s!pids, the first field
+	// being the uptime of the sample for a single container.
+	if (check_reply_lines(buffer, NULL, '!', 8) != 0)
+		sockprintf(sockfd, "UNEXPECTED REPLY:\r\n");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int get_container_logs(int sockfd)
+{
+	int index;
+	if (read_container_index(sockfd, &index, 0) != 0)
+		return -1;
+	if (index < 0)
+		return 0;
+
+	char buffer[BUFFER_SIZE];
+	int err = eris_get_container_logs(index, buffer, BUFFER_SIZE);
+	if (err == 0)
+		sockprintf(sockfd, "%s\r\n", buffer);
+	else
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+	return 0;
+}
+
+
+
+// The index is -2 if none was entered (-1 is all the containers).
+static int read_container_index(int sockfd, int *index, int all)
+{
+	if (all)
+		sockprintf(sockfd, "Enter the container index (from 0, -1 for all): ");
+	else
+		sockprintf(sockfd, "Enter the container index (from 0): ");
+	char reply[64];
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	*index = -2;
+	if ((sscanf(reply, "%d", index) != 1) || (*index < (all ? -1 : 0)))
+		*index = -2;
+	return 0;
+}
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: MIT
+
+   Christophe BLAESS 2026.
+   Copyright 2026 Logilin. All rights reserved.
+*/
+
+#ifndef CONTAINERS_API_TEST_H
+#define CONTAINERS_API_TEST_H
+
+int containers_api_test(int sockfd);
+
+#endif
\ No newline at end of file
@@ -14,6 +14,7 @@
 
 #include <liberis.h>
 
+#include "containers-api-test.h"
 #include "eris-api-test.h"
 #include "gpio-api-test.h"
 #include "network-api-test.h"
@@ -127,6 +128,33 @@ char *sockgets(int sockfd, char *buffer, size_t size)
 }
 
 
+
+int check_reply_lines(const char *reply, const char *prefix, char separator, int fields)
+{
+	const char *line = reply;
+
+	while (*line != '\0') {
+		const char *end = strchr(line, '\n');
+		if (end == NULL)
+			end = line + strlen(line);
+		if (end > line) {
+			if ((prefix != NULL) && (strncmp(line, prefix, strlen(prefix)) != 0))
+				return -1;
+			if (fields > 0) {
+				int n = 1;
+				for (const char *c = line; c < end; c++)
+					if (*c == separator)
+						n++;
+				if (n != fields)
+					return -1;
+			}
+		}
+		line = (*end == '\0') ? end : end + 1;
+	}
+	return 0;
+}
+
+
 // ---------------------- Private methods
 
 static void *thread_function(void *arg)
@@ -140,7 +168,7 @@ static void *thread_function(void *arg)
 		sockprintf(sockfd, "2: System & Containers Update   7: Network Interfaces         \r\n");
 		sockprintf(sockfd, "3: Time Setup                   8: General Purpose I/O        \r\n");
 		sockprintf(sockfd, "4: Watchdog Configuration       9: Display Features(*)        \r\n");
-		sockprintf(sockfd, "5: Audio Features(*)                                          \r\n");
+		sockprintf(sockfd, "5: Audio Features(*)           10: Containers Monitoring      \r\n");
 		sockprintf(sockfd, "0: Quit                                                       \r\n");
 		sockprintf(sockfd, "                      (*) Coming soon                         \r\n");
 		sockprintf(sockfd, "Your choice: ");
@@ -181,6 +209,10 @@ static void *thread_function(void *arg)
 			if (gpio_api_test(sockfd) < 0)
 				break;
 
+		if (strcmp(buffer, "10") == 0)
+			if (containers_api_test(sockfd) < 0)
+				break;
+
 //		if (strcmp(buffer, "9") == 0)
 //			if (display_api_test(sockfd) < 0)
 //				break;
@@ -20,6 +20,14 @@ int   sockprintf(int sockfd, const char *format, ...);
 /// @return A pointer to the buffer, NULL on error (like fgets()).
 char *sockgets(int sockfd, char *buffer, size_t size);
 
+/// @brief Check the format of a multi-line reply of the API.
+/// @param reply The reply to check.
+/// @param prefix The beginning of each line (NULL if any).
+/// @param separator The separator of the fields.
+/// @param fields The number of fields of each line (0 if any).
+/// @return 0 if each line matches, -1 otherwise.
+int   check_reply_lines(const char *reply, const char *prefix, char separator, int fields);
+
 #define BUFFER_SIZE       2048
 
 #endif
\ No newline at end of file
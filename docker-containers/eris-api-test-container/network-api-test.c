@@ -4,7 +4,11 @@
    Copyright 2025-2026 Logilin. All rights reserved.
 */
 
+#include <pthread.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
 
 #include <liberis.h>
 
@@ -13,6 +17,8 @@
 
 // ---------------------- Private macros.
 
+#define SELFTEST_ECHO_PORT  10007
+
 // ---------------------- Private method declarations.
 
 static int get_list_of_interfaces  (int sockfd);
@@ -27,6 +33,10 @@ static int scan_wifi_access_points (int sockfd);
 static int connect_to_wifi_ap      (int sockfd);
 static int disconnect_from_wifi_ap (int sockfd);
 static int get_wifi_quality        (int sockfd);
+static int get_network_quality     (int sockfd);
+static int run_network_selftest    (int sockfd);
+
+static void *echo_server_thread    (void *arg);
 
 
 // ---------------------- Private variables.
@@ -45,6 +55,7 @@ int network_api_test(int sockfd)
 		sockprintf(sockfd, "4:  Get interface config     10: Connect to Wifi AP (BROKEN?)\r\n");
 		sockprintf(sockfd, "5:  Set interface config     11: Disconnect from Wifi A.P.   \r\n");
 		sockprintf(sockfd, "6:  Is interface wireless    12: Get Wifi quality            \r\n");
+		sockprintf(sockfd, "13: Get network quality      14: Run network self-test       \r\n");
 		sockprintf(sockfd, "0:  Return                                                   \r\n");
 
 		for (;;) {
@@ -129,6 +140,18 @@ int network_api_test(int sockfd)
 				continue;
 			}
 
+			if (strcmp(choice, "13") == 0) {
+				if (get_network_quality(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "14") == 0) {
+				if (run_network_selftest(sockfd) != 0)
+					break;
+				continue;
+			}
+
 			sockprintf(sockfd, "INVALID CHOICE");
 			break;
 		}
@@ -504,3 +527,107 @@ static int get_wifi_quality(int sockfd)
 	return 0;
 }
 
+
+
+static int get_network_quality(int sockfd)
+{
+	char buffer[BUFFER_SIZE];
+
+	int err = eris_get_network_quality(buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// One line per target and per window.
+	if ((check_reply_lines(buffer, "target=", 0, 0) != 0)
+	 || ((buffer[0] != '\0') && (strstr(buffer, " loss=") == NULL)))
+		sockprintf(sockfd, "UNEXPECTED REPLY:\r\n");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int run_network_selftest(int sockfd)
+{
+	sockprintf(sockfd, "Number of bytes to send [1-67108864]: ");
+	char reply[64];
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	size_t bytes;
+	if ((sscanf(reply, "%zu", &bytes) != 1) || (bytes < 1) || (bytes > 67108864))
+		return 0;
+
+	sockprintf(sockfd, "Number of round trips [1-1000]: ");
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	int pings;
+	if ((sscanf(reply, "%d", &pings) != 1) || (pings < 1) || (pings > 1000))
+		return 0;
+
+	// The host connects back to an echo server of the container.
+	int server = socket(AF_INET, SOCK_STREAM, 0);
+	if (server < 0) {
+		sockprintf(sockfd, "ERROR: unable to open the echo server\r\n");
+		return 0;
+	}
+	int option = 1;
+	(void) setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons(SELFTEST_ECHO_PORT);
+	pthread_t thread;
+	if ((bind(server, (struct sockaddr *) &address, sizeof(address)) != 0)
+	 || (listen(server, 2) != 0)
+	 || (pthread_create(&thread, NULL, echo_server_thread, (void *) (long) server) != 0)) {
+		sockprintf(sockfd, "ERROR: unable to start the echo server\r\n");
+		close(server);
+		return 0;
+	}
+
+	char buffer[BUFFER_SIZE];
+	int err = eris_run_network_selftest(SELFTEST_ECHO_PORT, bytes, pings, buffer, BUFFER_SIZE);
+
+	// Stop the echo server.
+	shutdown(server, SHUT_RDWR);
+	pthread_join(thread, NULL);
+	close(server);
+
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	size_t sent = 0;
+	if ((strncmp(buffer, "peer=", 5) != 0)
+	 || (strstr(buffer, " bytes=") == NULL)
+	 || (sscanf(strstr(buffer, " bytes="), " bytes=%zu", &sent) != 1)
+	 || (sent != bytes)
+	 || (strstr(buffer, " throughput_mbps=") == NULL)
+	 || (strstr(buffer, " rtt_p50_us=") == NULL))
+		sockprintf(sockfd, "UNEXPECTED REPLY: ");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+// Send back everything received, one connection after the other, until
+// the listening socket is shut down.
+static void *echo_server_thread(void *arg)
+{
+	int server = (int) (long) arg;
+	int client;
+	char buffer[16384];
+
+	while ((client = accept(server, NULL, NULL)) >= 0) {
+		ssize_t n;
+		while ((n = read(client, buffer, sizeof(buffer))) > 0)
+			if (write(client, buffer, n) != n)
+				break;
+		close(client);
+	}
+	return NULL;
+}
+
@@ -26,6 +26,7 @@ static int set_time_zone   (int sockfd);
 static int get_local_time  (int sockfd);
 static int get_system_time (int sockfd);
 static int set_system_time (int sockfd);
+static int get_ntp_status  (int sockfd);
 
 
 // ---------------------- Private variables.
@@ -43,6 +44,7 @@ int time_api_test(int sockfd)
 		sockprintf(sockfd, "3:  Get NTP server           8: Get local time              \r\n");
 		sockprintf(sockfd, "4:  Set NTP server           9: Get system time             \r\n");
 		sockprintf(sockfd, "5:  List of time zones      10: Set system time             \r\n");
+		sockprintf(sockfd, "                            11: Get NTP synchronization     \r\n");
 		sockprintf(sockfd, "0:  Return                                                  \r\n");
 
 		for (;;) {
@@ -115,6 +117,12 @@ int time_api_test(int sockfd)
 				continue;
 			}
 
+			if (strcmp(choice, "11") == 0) {
+				if (get_ntp_status(sockfd) != 0)
+					break;
+				continue;
+			}
+
 			sockprintf(sockfd, "INVALID CHOICE");
 			break;
 		}
@@ -293,3 +301,23 @@ static int set_system_time(int sockfd)
 	return 0;
 }
 
+
+
+static int get_ntp_status(int sockfd)
+{
+	char buffer[BUFFER_SIZE];
+
+	int err = eris_get_ntp_status(buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// One <key>=<value> line per field.
+	if ((strncmp(buffer, "enabled=", 8) != 0)
+	 || (strstr(buffer, "\nsynchronized=") == NULL)
+	 || (check_reply_lines(buffer, NULL, '=', 2) != 0))
+		sockprintf(sockfd, "UNEXPECTED REPLY:\r\n");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
@@ -4,6 +4,7 @@
    Copyright 2026 Logilin. All rights reserved.
 */
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -29,6 +30,20 @@ static int set_container_update_policy (int sockfd);
 static int reboot_now                  (int sockfd);
 static int force_rollback              (int sockfd);
 static int restore_factory_preset      (int sockfd);
+static int get_switch_report           (int sockfd);
+static int install_system_image        (int sockfd);
+static int get_install_progress        (int sockfd);
+static int wait_for_events             (int sockfd);
+
+static int print_event                 (const char *event, const char *value, void *arg);
+
+
+// ---------------------- Private types.
+
+typedef struct {
+	int sockfd;
+	int remaining;
+} event_wait_t;
 
 
 // ---------------------- Private variables.
@@ -47,7 +62,9 @@ int update_api_test(int sockfd)
 		sockprintf(sockfd, "4: Get Server Contact Period   11: Reboot Now                  \r\n");
 		sockprintf(sockfd, "5: Set Server Contact Period   12: Force System Rollback       \r\n");
 		sockprintf(sockfd, "6: Contact the Server Now      13: Restore Factory Presets     \r\n");
-		sockprintf(sockfd, "7: Get 'Automatic Reboot' Flag                                 \r\n");
+		sockprintf(sockfd, "7: Get 'Automatic Reboot' Flag 14: Get Container Switch Report \r\n");
+		sockprintf(sockfd, "15: Install System Image       16: Get Install Progress        \r\n");
+		sockprintf(sockfd, "17: Wait for Update Events                                     \r\n");
 		sockprintf(sockfd, "0: Return                                                      \r\n");
 
 		for (;;) {
@@ -138,6 +155,30 @@ int update_api_test(int sockfd)
 				continue;
 			}
 
+			if (strcmp(choice, "14") == 0) {
+				if (get_switch_report(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "15") == 0) {
+				if (install_system_image(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "16") == 0) {
+				if (get_install_progress(sockfd) != 0)
+					break;
+				continue;
+			}
+
+			if (strcmp(choice, "17") == 0) {
+				if (wait_for_events(sockfd) != 0)
+					break;
+				continue;
+			}
+
 			sockprintf(sockfd, "INVALID CHOICE");
 			break;
 		}
@@ -358,3 +399,120 @@ static int restore_factory_preset(int sockfd)
 }
 
 
+
+static int get_switch_report(int sockfd)
+{
+	sockprintf(sockfd, "Enter the container index (from 0): ");
+	char reply[64];
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	int index;
+	if ((sscanf(reply, "%d", &index) != 1) || (index < 0))
+		return 0;
+
+	char buffer[BUFFER_SIZE];
+	int ret = eris_get_container_switch_report(index, buffer, BUFFER_SIZE);
+	if (ret != 0) {
+		sockprintf(sockfd, "ERROR %d (no switch yet?)\r\n", ret);
+		return 0;
+	}
+	if (((strncmp(buffer, "result=switched ", 16) != 0)
+	  && (strncmp(buffer, "result=rolled-back ", 19) != 0)
+	  && (strncmp(buffer, "result=stage-failed ", 20) != 0))
+	 || (strstr(buffer, " mode=") == NULL)
+	 || (strstr(buffer, " time=") == NULL))
+		sockprintf(sockfd, "UNEXPECTED REPLY: ");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int install_system_image(int sockfd)
+{
+	sockprintf(sockfd, "Enter the URL of the system image: ");
+	char url[1024];
+	if (sockgets(sockfd, url, 1024) == NULL)
+		return -1;
+	if (url[0] == '\0')
+		return 0;
+
+	sockprintf(sockfd, "Enter the URL of its signature (empty for <url>.sig): ");
+	char signature[1024];
+	if (sockgets(sockfd, signature, 1024) == NULL)
+		return -1;
+
+	int ret = eris_install_system_update(url, signature[0] != '\0' ? signature : NULL);
+	if (ret == 0)
+		sockprintf(sockfd, "Ok, installation started.\r\n");
+	else if (errno == EBUSY)
+		sockprintf(sockfd, "ERROR %d (installation already in progress)\r\n", ret);
+	else
+		sockprintf(sockfd, "ERROR %d\r\n", ret);
+	return 0;
+}
+
+
+
+static int get_install_progress(int sockfd)
+{
+	char buffer[BUFFER_SIZE];
+
+	int ret = eris_get_system_update_progress(buffer, BUFFER_SIZE);
+	if (ret != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", ret);
+		return 0;
+	}
+	// The status number, then one <key>=<value> line per field.
+	int status;
+	char *fields = strchr(buffer, '\n');
+	if ((sscanf(buffer, "%d", &status) != 1)
+	 || (fields == NULL)
+	 || (strncmp(fields, "\nstage=", 7) != 0)
+	 || (check_reply_lines(fields + 1, NULL, '=', 2) != 0))
+		sockprintf(sockfd, "UNEXPECTED REPLY:\r\n");
+	sockprintf(sockfd, "%s\r\n", buffer);
+	return 0;
+}
+
+
+
+static int wait_for_events(int sockfd)
+{
+	sockprintf(sockfd, "Number of events to wait for (the current states come first): ");
+	char reply[64];
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	event_wait_t wait = { .sockfd = sockfd };
+	if ((sscanf(reply, "%d", &wait.remaining) != 1) || (wait.remaining <= 0))
+		return 0;
+
+	int ret = eris_subscribe_events(print_event, &wait);
+	if (ret == 0)
+		sockprintf(sockfd, "Ok\r\n");
+	else
+		sockprintf(sockfd, "ERROR %d\r\n", ret);
+	return 0;
+}
+
+
+
+static int print_event(const char *event, const char *value, void *arg)
+{
+	event_wait_t *wait = arg;
+	int number;
+	int expected;
+
+	if ((strcmp(event, "update-status") == 0) || (strcmp(event, "contact-period") == 0))
+		expected = (sscanf(value, "%d", &number) == 1);
+	else if ((strcmp(event, "reboot-needed") == 0) || (strcmp(event, "boot-ended") == 0))
+		expected = (strcmp(value, "yes") == 0) || (strcmp(value, "no") == 0);
+	else
+		expected = 0;
+
+	sockprintf(wait->sockfd, "%s%s: %s\r\n", expected ? "" : "UNEXPECTED EVENT: ", event, value);
+
+	wait->remaining--;
+	return (wait->remaining > 0) ? 0 : 1;
+}
+
@@ -23,6 +23,12 @@ static int set_watchdog_delay     (int sockfd);
 static int start_watchdog_feeder  (int sockfd);
 static int stop_watchdog_feeder   (int sockfd);
 static int watchdog_feeder_status (int sockfd);
+static int register_wdog_client   (int sockfd);
+static int feed_wdog_client       (int sockfd);
+static int unregister_wdog_client (int sockfd);
+static int list_wdog_clients      (int sockfd);
+
+static int read_client_index      (int sockfd, int *index);
 
 
 // ---------------------- Private variables.
@@ -38,7 +44,9 @@ int wdog_api_test(int sockfd)
 		sockprintf(sockfd, "1:  Feed the watchdog        5: Start the watchdog feeder   \r\n");
 		sockprintf(sockfd, "2:  Disable the watchdog     6: Stop the watchdog feeder    \r\n");
 		sockprintf(sockfd, "3:  Get watchdog delay       7: Get the feeder status       \r\n");
-		sockprintf(sockfd, "4:  Set watchdog delay                                      \r\n");
+		sockprintf(sockfd, "4:  Set watchdog delay       8: Register client watchdog    \r\n");
+		sockprintf(sockfd, "9:  Feed client watchdog    10: Unregister client watchdog  \r\n");
+		sockprintf(sockfd, "11: List client watchdogs                                   \r\n");
 		sockprintf(sockfd, "0:  Return                                                  \r\n");
 
 		for (;;) {
@@ -90,6 +98,26 @@ int wdog_api_test(int sockfd)
 					break;
 				continue;
 			}
+			if (strcmp(choice, "8") == 0) {
+				if (register_wdog_client(sockfd) != 0)
+					break;
+				continue;
+			}
+			if (strcmp(choice, "9") == 0) {
+				if (feed_wdog_client(sockfd) != 0)
+					break;
+				continue;
+			}
+			if (strcmp(choice, "10") == 0) {
+				if (unregister_wdog_client(sockfd) != 0)
+					break;
+				continue;
+			}
+			if (strcmp(choice, "11") == 0) {
+				if (list_wdog_clients(sockfd) != 0)
+					break;
+				continue;
+			}
 
 			sockprintf(sockfd, "INVALID CHOICE");
 			break;
@@ -202,3 +230,112 @@ static int watchdog_feeder_status(int sockfd)
 	return 0;
 }
 
+
+
+static int register_wdog_client(int sockfd)
+{
+	int index;
+	if (read_client_index(sockfd, &index) != 0)
+		return -1;
+	if (index < 0)
+		return 0;
+
+	sockprintf(sockfd, "Enter the timeout in seconds [1-3600]: ");
+	char reply[64];
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	int timeout;
+	if (sscanf(reply, "%d", &timeout) != 1)
+		return 0;
+
+	sockprintf(sockfd, "Enter the action ('restart' or 'reboot'): ");
+	char action[64];
+	if (sockgets(sockfd, action, 64) == NULL)
+		return -1;
+
+	int err = eris_register_watchdog_client(index, timeout, action[0] != '\0' ? action : NULL);
+	if (err == 0) {
+		sockprintf(sockfd, "Ok\r\n");
+	} else {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+	}
+	return 0;
+}
+
+
+
+static int feed_wdog_client(int sockfd)
+{
+	int index;
+	if (read_client_index(sockfd, &index) != 0)
+		return -1;
+	if (index < 0)
+		return 0;
+
+	int err = eris_feed_watchdog_client(index);
+	if (err == 0) {
+		sockprintf(sockfd, "Ok\r\n");
+	} else {
+		sockprintf(sockfd, "ERROR %d (not registered?)\r\n", err);
+	}
+	return 0;
+}
+
+
+
+static int unregister_wdog_client(int sockfd)
+{
+	int index;
+	if (read_client_index(sockfd, &index) != 0)
+		return -1;
+	if (index < 0)
+		return 0;
+
+	int err = eris_unregister_watchdog_client(index);
+	if (err == 0) {
+		sockprintf(sockfd, "Ok\r\n");
+	} else {
+		sockprintf(sockfd, "ERROR %d (not registered?)\r\n", err);
+	}
+	return 0;
+}
+
+
+
+static int list_wdog_clients(int sockfd)
+{
+	char buffer[BUFFER_SIZE];
+
+	int err = eris_get_watchdog_clients(buffer, BUFFER_SIZE);
+	if (err != 0) {
+		sockprintf(sockfd, "ERROR %d\r\n", err);
+		return 0;
+	}
+	// <index>!<healthy|expired>!<timeout in ms>!<action>!<remaining ms>!<expirations>
+	if (buffer[0] == '\0')
+		sockprintf(sockfd, "No client watchdog registered.\r\n");
+	char *saveptr = NULL;
+	for (char *line = strtok_r(buffer, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
+		char *state = strchr(line, '!');
+		int unexpected = (check_reply_lines(line, NULL, '!', 6) != 0)
+		              || (state == NULL)
+		              || ((strncmp(state, "!healthy!", 9) != 0) && (strncmp(state, "!expired!", 9) != 0));
+		sockprintf(sockfd, "%s%s\r\n", unexpected ? "UNEXPECTED REPLY: " : "", line);
+	}
+	return 0;
+}
+
+
+
+// The index is -1 if none was entered.
+static int read_client_index(int sockfd, int *index)
+{
+	sockprintf(sockfd, "Enter the container index [0-3]: ");
+	char reply[64];
+	if (sockgets(sockfd, reply, 64) == NULL)
+		return -1;
+	if ((sscanf(reply, "%d", index) != 1) || (*index < 0))
+		*index = -1;
+	return 0;
+}
+
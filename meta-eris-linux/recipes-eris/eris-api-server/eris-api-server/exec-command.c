@@ -0,0 +1,293 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#define _GNU_SOURCE   // pipe2().
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "exec-command.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define EXEC_READ_SIZE        4096
+#define EXEC_MAX_INPUT        4096     // Written at once in the pipe before spawning.
+#define EXEC_WAITPID_TICK_MS  100      // Polling period when pidfd_open() is not available.
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open        434
+#endif
+
+
+// ---------------------- Private types definitions.
+
+enum { SOURCE_OUTPUT, SOURCE_PIDFD, SOURCE_CANCEL };
+
+
+// ---------------------- Private method declarations.
+
+static int   has_exited      (pid_t pid);
+
+static long long monotonic_ms(void);
+
+
+// ---------------------- Private variables declarations.
+
+extern char **environ;
+
+
+// ---------------------- Public methods
+
+int run_command(const char *const argv[], const char *input, int timeout_ms, size_t output_limit,
+                int cancel_fd, exec_result_t *result)
+{
+	struct epoll_event events[3];
+	sigset_t mask, old_mask;
+	pid_t pid;
+	int output_fd = -1;
+	int killed = 0;
+	int status;
+
+	memset(result, 0, sizeof(exec_result_t));
+	result->exit_status = -1;
+
+	// The SIGCHLD handler inherited from the server would reap the command.
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &mask, &old_mask);
+
+	if (spawn_command(argv, input, output_limit, &pid, &output_fd) != 0) {
+		sigprocmask(SIG_SETMASK, &old_mask, NULL);
+		result->output = calloc(1, 1);
+		return -1;
+	}
+
+	int pidfd = syscall(SYS_pidfd_open, pid, 0);
+	int epfd  = epoll_create1(EPOLL_CLOEXEC);
+	if (epfd >= 0) {
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u32 = SOURCE_OUTPUT;
+		if (output_fd >= 0)
+			epoll_ctl(epfd, EPOLL_CTL_ADD, output_fd, &event);
+		event.data.u32 = SOURCE_PIDFD;
+		if (pidfd >= 0)
+			epoll_ctl(epfd, EPOLL_CTL_ADD, pidfd, &event);
+		event.events = EPOLLRDHUP;
+		event.data.u32 = SOURCE_CANCEL;
+		if (cancel_fd >= 0)
+			epoll_ctl(epfd, EPOLL_CTL_ADD, cancel_fd, &event);
+	}
+
+	long long deadline = (timeout_ms < 0) ? -1 : monotonic_ms() + timeout_ms;
+	int exited = 0;
+
+	while (! exited) {
+		long long now = monotonic_ms();
+		int timeout = (killed || (deadline < 0)) ? -1 : (deadline > now ? (int)(deadline - now) : 0);
+		if (((pidfd < 0) || (epfd < 0)) && ((timeout < 0) || (timeout > EXEC_WAITPID_TICK_MS)))
+			timeout = EXEC_WAITPID_TICK_MS;
+
+		int n = (epfd >= 0) ? epoll_wait(epfd, events, 3, timeout) : 0;
+		if (epfd < 0)
+			usleep(EXEC_WAITPID_TICK_MS * 1000);
+		if ((n < 0) && (errno != EINTR))
+			break;
+
+		for (int i = 0; i < n; i++) {
+			switch (events[i].data.u32) {
+				case SOURCE_OUTPUT:
+					if (read_command_output(output_fd, output_limit, result) != 0) {
+						epoll_ctl(epfd, EPOLL_CTL_DEL, output_fd, NULL);
+						close(output_fd);
+						output_fd = -1;
+					}
+					break;
+				case SOURCE_PIDFD:
+					exited = 1;
+					break;
+				case SOURCE_CANCEL:
+					epoll_ctl(epfd, EPOLL_CTL_DEL, cancel_fd, NULL);
+					result->cancelled = 1;
+					if (! killed)
+						kill(pid, SIGKILL);
+					killed = 1;
+					break;
+			}
+		}
+		if ((! killed) && (deadline >= 0) && (monotonic_ms() >= deadline)) {
+			result->timed_out = 1;
+			kill(pid, SIGKILL);
+			killed = 1;
+		}
+		if (((pidfd < 0) || (epfd < 0)) && has_exited(pid))
+			exited = 1;
+	}
+
+	// The command may have left a daemon holding the pipe: read what is available only.
+	if (output_fd >= 0) {
+		read_command_output(output_fd, output_limit, result);
+		close(output_fd);
+	}
+	if (waitpid(pid, &status, 0) == pid)
+		result->exit_status = (WIFEXITED(status) && ! killed) ? WEXITSTATUS(status) : -1;
+	sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+	if (pidfd >= 0)
+		close(pidfd);
+	if (epfd >= 0)
+		close(epfd);
+	if (result->output == NULL)
+		result->output = calloc(1, 1);
+
+	return (result->exit_status == 0) ? 0 : -1;
+}
+
+
+
+void free_command_result(exec_result_t *result)
+{
+	free(result->output);
+	result->output = NULL;
+	result->length = 0;
+}
+
+
+
+int spawn_command(const char *const argv[], const char *input, size_t output_limit, pid_t *pid, int *output_fd)
+{
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t attr;
+	int in_pipe[2]  = { -1, -1 };
+	int out_pipe[2] = { -1, -1 };
+	int err = -1;
+
+	if ((input != NULL) && (strlen(input) > EXEC_MAX_INPUT))
+		return -1;
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawnattr_init(&attr);
+
+	if (input != NULL) {
+		// The input is small enough to fit in the pipe buffer.
+		if (pipe2(in_pipe, O_CLOEXEC) != 0)
+			goto out;
+		if (write(in_pipe[1], input, strlen(input)) != (ssize_t) strlen(input))
+			goto out;
+		close(in_pipe[1]);
+		in_pipe[1] = -1;
+		posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+	} else {
+		posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+	}
+
+	if (output_limit > 0) {
+		if (pipe2(out_pipe, O_CLOEXEC) != 0)
+			goto out;
+		fcntl(out_pipe[0], F_SETFL, O_NONBLOCK);
+		posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+	} else {
+		posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+	}
+
+	// Do not let the child inherit the blocked or ignored signals of the daemon.
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	sigaddset(&mask, SIGPIPE);
+	sigaddset(&mask, SIGCHLD);
+	posix_spawnattr_setsigdefault(&attr, &mask);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+	if (posix_spawnp(pid, argv[0], &actions, &attr, (char *const *) argv, environ) != 0)
+		goto out;
+
+	*output_fd = out_pipe[0];
+	out_pipe[0] = -1;
+	err = 0;
+
+out:
+	if (in_pipe[0] >= 0)
+		close(in_pipe[0]);
+	if (in_pipe[1] >= 0)
+		close(in_pipe[1]);
+	if (out_pipe[0] >= 0)
+		close(out_pipe[0]);
+	if (out_pipe[1] >= 0)
+		close(out_pipe[1]);
+	posix_spawn_file_actions_destroy(&actions);
+	posix_spawnattr_destroy(&attr);
+	return err;
+}
+
+
+
+// Return 0 while the pipe is open, -1 at end of file.
+int read_command_output(int fd, size_t output_limit, exec_result_t *result)
+{
+	char buffer[EXEC_READ_SIZE];
+
+	for (;;) {
+		ssize_t n = read(fd, buffer, sizeof(buffer));
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if ((n < 0) && (errno == EAGAIN))
+			return 0;
+		if (n <= 0)
+			return -1;
+
+		// Keep on reading past the limit so that the command does not block.
+		size_t room = output_limit - result->length;
+		if ((size_t) n > room) {
+			result->truncated = 1;
+			n = room;
+		}
+		if (n == 0)
+			continue;
+		char *output = realloc(result->output, result->length + n + 1);
+		if (output == NULL)
+			continue;
+		memcpy(output + result->length, buffer, n);
+		result->output = output;
+		result->length += n;
+		result->output[result->length] = '\0';
+	}
+}
+
+
+// ---------------------- Private methods
+
+static int has_exited(pid_t pid)
+{
+	siginfo_t info;
+
+	info.si_pid = 0;
+	if ((waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0) && (info.si_pid == pid))
+		return 1;
+	return 0;
+}
+
+
+
+static long long monotonic_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,42 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef EXEC_COMMAND_H
+#define EXEC_COMMAND_H
+
+	#include <stddef.h>
+	#include <sys/types.h>
+
+	typedef struct {
+
+		int     exit_status;    // -1 if the command could not be run or was killed.
+		int     timed_out;
+		int     cancelled;      // The client disconnected before the end of the command.
+		int     truncated;      // The output was longer than the limit.
+		char   *output;         // Standard output, always NUL-terminated.
+		size_t  length;
+
+	} exec_result_t;
+
+	// Executor shared by eris-api-server and eris-rest-api.
+
+	// Run the command and wait for its end, its deadline (none if timeout_ms
+	// is negative) or the hang-up of cancel_fd (the client socket, -1 if
+	// none). If output_limit is 0, the standard output is redirected to
+	// /dev/null.
+	int  run_command(const char *const argv[], const char *input, int timeout_ms, size_t output_limit,
+	                 int cancel_fd, exec_result_t *result);
+
+	void free_command_result(exec_result_t *result);
+
+	// Building blocks of run_command() for the event loops of the callers.
+	// The output pipe (-1 if output_limit is 0) is non-blocking, and
+	// read_command_output() returns -1 once it reaches its end.
+	int  spawn_command(const char *const argv[], const char *input, size_t output_limit, pid_t *pid, int *output_fd);
+	int  read_command_output(int fd, size_t output_limit, exec_result_t *result);
+
+#endif
@@ -22,6 +22,7 @@
 #include <sys/socket.h>
 
 #include "api-server.h"
+#include "exec-command.h"
 #include "net-api.h"
 
 
@@ -32,6 +33,13 @@
 #define INTERFACE_NAME_LENGTH 32
 #define IP_ADDRESS_LENGTH   64
 
+#define IFUPDOWN_TIMEOUT_MS   30000
+#define IP_LINK_TIMEOUT_MS    5000
+#define IW_SCAN_TIMEOUT_MS    15000
+#define IW_SCAN_OUTPUT_LIMIT  (256 * 1024)
+#define WPA_TIMEOUT_MS        10000
+#define WPA_OUTPUT_LIMIT      4096
+
 #define EOL_CHAR(x) ((x == '\0') || (x == 0x23) || (x == '\n') || (x == '\r'))
 
 // ---------------------- Private types definitions.
@@ -401,18 +409,15 @@ static void set_network_interface_status(int sock, int argc, char *argv[])
 		return;
 	}
 
-	char command[256];
-
-	snprintf(command, 255, "/sbin/if%s  %s",
-		argv[1][0] == 'u' ? "up" : "down",
-		argv[0]);
-	command[255] = '\0';
+	exec_result_t result;
+	const char *args[] = { argv[1][0] == 'u' ? "/sbin/ifup" : "/sbin/ifdown", argv[0], NULL };
 
-	if (system(command) == 0) {
+	if (run_command(args, NULL, IFUPDOWN_TIMEOUT_MS, 0, sock, &result) == 0) {
 		send_reply(sock, 2, "ok");
 	} else {
-		send_error(sock, errno, "Failed to set interface status");
+		send_error(sock, result.timed_out ? ETIMEDOUT : EIO, "Failed to set interface status");
 	}
+	free_command_result(&result);
 }
 
 
@@ -597,9 +602,8 @@ static void is_interface_wireless(int sock, int argc, char *argv[])
 
 static void scan_wifi(int sock, int argc, char *argv[])
 {
-	char command[256];
-	FILE *fp;
-	char line[256];
+	exec_result_t result;
+	char *saveptr = NULL;
 	char ssid[256];
 
 	char *reply = NULL;
@@ -611,22 +615,21 @@ static void scan_wifi(int sock, int argc, char *argv[])
 		return;
 	}
 
-	snprintf(command, 256, "/sbin/ip link set dev %s up", argv[0]);
-	command[255] = '\0';
-	if (system(command) != 0) {
-		send_error(sock, errno, "Unable to activate this interface.");
+	const char *link_args[] = { "/sbin/ip", "link", "set", "dev", argv[0], "up", NULL };
+	if (run_command(link_args, NULL, IP_LINK_TIMEOUT_MS, 0, sock, &result) != 0) {
+		free_command_result(&result);
+		send_error(sock, EINVAL, "Unable to activate this interface.");
 		return;
 	}
+	free_command_result(&result);
 
-	snprintf(command, 256, "/usr/sbin/iw dev %s scan", argv[0]);
-	command[255] = '\0';
-
-	fp = popen(command, "r");
-	if (fp == NULL) {
-		send_error(sock, errno, "Unable to scan this interface.");
+	const char *scan_args[] = { "/usr/sbin/iw", "dev", argv[0], "scan", NULL };
+	if (run_command(scan_args, NULL, IW_SCAN_TIMEOUT_MS, IW_SCAN_OUTPUT_LIMIT, sock, &result) != 0) {
+		free_command_result(&result);
+		send_error(sock, result.timed_out ? ETIMEDOUT : EIO, "Unable to scan this interface.");
 		return;
 	}
-	while (fgets(line, 256, fp) != NULL) {
+	for (char *line = strtok_r(result.output, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
 		int start = 0;
 		if (! isspace(line[start]))
 			continue;
@@ -637,14 +640,14 @@ static void scan_wifi(int sock, int argc, char *argv[])
 			continue;
 		start += sizeof(IW_SSID_PREFIX) - 1;
 		int i = 0;
-		while ((i < 255) && (line[start + i] != '\n') && (line[start + i] != '\r') && (line[start + i] != '\0')) {
+		while ((i < 255) && (line[start + i] != '\r') && (line[start + i] != '\0')) {
 			ssid[i] = line[start + i];
 			i++;
 		}
 		ssid[i] = '\0';
 		addsnprintf(&reply, &size, &pos, "\n%s", ssid);
 	}
-	pclose(fp);
+	free_command_result(&result);
 	if (reply != NULL)
 		send_reply(sock, strlen(reply), reply);
 	else
@@ -656,38 +659,48 @@ static void scan_wifi(int sock, int argc, char *argv[])
 
 static void connect_wifi(int sock, int argc, char *argv[])
 {
+	exec_result_t result;
+	char *saveptr = NULL;
+	char line[256];
 	FILE *fp = NULL;
-	FILE *pp = NULL;
-	char line[1024];
 
 	if (argc < 3) {
 		send_error(sock, EINVAL, "connect-wifi needs three arguments.");
 		return;
 	}
 
+	// The passphrase is given on stdin to keep it out of the command line.
+	if (snprintf(line, sizeof(line), "%s\n", argv[2]) >= (int) sizeof(line)) {
+		send_error(sock, EINVAL, "Passphrase too long.");
+		return;
+	}
+	const char *pass_args[] = { "/usr/sbin/wpa_passphrase", argv[1], NULL };
+	if (run_command(pass_args, line, WPA_TIMEOUT_MS, WPA_OUTPUT_LIMIT, sock, &result) != 0) {
+		free_command_result(&result);
+		send_error(sock, EIO, "Unable to call wpa_passphrase.");
+		return;
+	}
+
 	fp = fopen("/etc/wpa_supplicant.conf", "w");
 	if (fp == NULL) {
+		free_command_result(&result);
 		send_error(sock, errno, "Unable to open wpa_supplicant.conf.");
 		return;
 	}
 	fprintf(fp, "# This file is automatically generated by Eris Linux API. DO NOT EDIT\n\n");
 	fprintf(fp, "ctrl_interface=/var/run/wpa_supplicant\nctrl_interface_group=0\nupdate_config=1\n\n");
 
-	snprintf(line, 1024, "/usr/sbin/wpa_passphrase '%s' %s | grep -v '#psk", argv[1], argv[2]);
-	line[1023] = '\0';
-	pp = popen(line, "r");
-	if (pp == NULL) {
-		send_error(sock, errno, "Unable to call wpa_passphrase.");
-		return;
-	}
-	while (fgets(line, 1024, pp) != NULL)
-		fputs(line, fp);
-	pclose(pp);
+	// Do not store the clear passphrase.
+	for (char *l = strtok_r(result.output, "\n", &saveptr); l != NULL; l = strtok_r(NULL, "\n", &saveptr))
+		if (strstr(l, "#psk") == NULL)
+			fprintf(fp, "%s\n", l);
 	fclose(fp);
+	free_command_result(&result);
 
-	snprintf(line, 1024, "wpa_supplicant -B -Dnl80211 -c/etc/wpa_supplicant.conf -i%s -P /var/run/wpa_supplicant.pid", argv[0]);
-	line[1023] = '\0';
-	system(line);
+	snprintf(line, sizeof(line), "-i%s", argv[0]);
+	const char *wpa_args[] = { "wpa_supplicant", "-B", "-Dnl80211", "-c/etc/wpa_supplicant.conf", line, "-P", "/var/run/wpa_supplicant.pid", NULL };
+	run_command(wpa_args, NULL, WPA_TIMEOUT_MS, 0, sock, &result);
+	free_command_result(&result);
 
 	send_reply(sock, 2, "Ok");
 }
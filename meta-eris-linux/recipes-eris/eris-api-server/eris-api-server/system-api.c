@@ -12,6 +12,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/reboot.h>
+#include <sys/stat.h>
 #include <uuid/uuid.h>
 
 
@@ -24,6 +25,23 @@
 
 #define MAX_CONTAINERS  4
 
+#define CONTAINERS_FILE          "/etc/eris-linux/containers"
+#define CONTAINER_FIELD_LENGTH   256
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	int   complete;       // The description has a line for this slot.
+	int   consistent;     // The line of the slot is well formed.
+	int   present;
+	char  id[CONTAINER_FIELD_LENGTH];
+	char  name[CONTAINER_FIELD_LENGTH];
+	char  version[CONTAINER_FIELD_LENGTH];
+
+} container_entry_t;
+
 
 // ---------------------- Private method declarations.
 
@@ -42,6 +60,20 @@ static void get_number_of_slots_command(int sock, int argc, char *argv[]);
 static void get_container_present_command(int sock, int argc, char *argv[]);
 static void get_container_name_command(int sock, int argc, char *argv[]);
 static void get_container_version_command(int sock, int argc, char *argv[]);
+static void get_container_list_command(int sock, int argc, char *argv[]);
+
+static const container_entry_t *lookup_container(int sock, const char *command, int argc, char *argv[], int need_fields);
+static int  load_containers(void);
+static void parse_container_line(char *line, container_entry_t *entry);
+static int  copy_container_field(char *field, const char *start, const char *end);
+
+
+// ---------------------- Private variables declarations.
+
+// Parsed once per client connection, then only when the file changes.
+static container_entry_t  container_entries[MAX_CONTAINERS];
+static int                containers_loaded = 0;
+static struct stat        containers_stat;
 
 
 // ---------------------- Public methods
@@ -70,6 +102,8 @@ int init_system_api(void)
 		return -1;
 	if (register_api_command("get-container-version", "cntv", "Get the container image version.", get_container_version_command))
 		return -1;
+	if (register_api_command("get-container-list", "cntl", "Get the presence, id, name and version of all the containers.", get_container_list_command))
+		return -1;
 
 	return 0;
 }
@@ -300,198 +334,189 @@ static void get_number_of_slots_command(int sock, int argc, char *argv[])
 
 static void get_container_present_command(int sock, int argc, char *argv[])
 {
-	int cnt;
-	char line[128];
-	FILE *fp;
-
-	if (argc < 1) {
-		send_error(sock, EINVAL, "get-container-present needs an argument.");
+	const container_entry_t *entry = lookup_container(sock, "get-container-present", argc, argv, 0);
+	if (entry == NULL)
 		return;
-	}
-	if (argc > 1) {
-		send_error(sock, EINVAL, "get-container-present doesn't take any argument.");
+
+	send_reply(sock, 1, entry->present ? "1" : "0");
+}
+
+
+
+static void get_container_name_command(int sock, int argc, char *argv[])
+{
+	const container_entry_t *entry = lookup_container(sock, "get-container-name", argc, argv, 1);
+	if (entry == NULL)
 		return;
-	}
-	if (sscanf(argv[0], "%d", &cnt) != 1) {
-		send_error(sock, EINVAL, "Wrong container number.");
+
+	send_reply(sock, strlen(entry->name), entry->name);
+}
+
+
+
+static void get_container_version_command(int sock, int argc, char *argv[])
+{
+	const container_entry_t *entry = lookup_container(sock, "get-container-version", argc, argv, 1);
+	if (entry == NULL)
 		return;
-	}
-	if ((cnt < 0) || (cnt >= MAX_CONTAINERS)) {
-		snprintf(line, 128, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
-		line[127] = '\0';
-		send_error(sock, EINVAL, line);
+
+	send_reply(sock, strlen(entry->version), entry->version);
+}
+
+
+
+// One line per slot: index!presence!id!name!version
+static void get_container_list_command(int sock, int argc, char *argv[])
+{
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+
+	if (argc > 0) {
+		send_error(sock, EINVAL, "get-container-list doesn't take any argument.");
 		return;
 	}
-
-	fp = fopen("/etc/eris-linux/containers", "r");
-	if (fp == NULL) {
+	if (load_containers() != 0) {
 		send_error(sock, errno, "Unable to open containers description.");
 		return;
 	}
 
-	int c;
-	for (c = 0; c <= cnt; c++)
-		if (fgets(line, 127, fp) == NULL)
-			break;
-	fclose(fp);
+	for (int cnt = 0; cnt < MAX_CONTAINERS; cnt++) {
+		const container_entry_t *entry = &(container_entries[cnt]);
+		int usable = entry->complete && (entry->consistent || ! entry->present);
 
-	if (c != cnt + 1) {
-		send_error(sock, EIO, "Containers description is incomplete.");
-		return;
-	}
-	line[strlen(line) - 1] = '\0';
-
-	if ((line[0] == '-') && (line[1] == '1')) {
-		send_reply(sock, 1, "0");
-		return;
+		if (addsnprintf(&reply, &size, &pos, "%d!%s!%s!%s!%s\n", cnt,
+		                usable ? (entry->present ? "present" : "absent") : "unknown",
+		                usable ? entry->id : "", usable ? entry->name : "", usable ? entry->version : "") != 0) {
+			free(reply);
+			send_error(sock, ENOMEM, "Not enough memory.");
+			return;
+		}
 	}
-	send_reply(sock, 1, "1");
+	send_reply(sock, pos, reply);
+	free(reply);
 }
 
 
 
-static void get_container_name_command(int sock, int argc, char *argv[])
+// Check the slot number given in argument and return its description,
+// or send the error and return NULL.
+static const container_entry_t *lookup_container(int sock, const char *command, int argc, char *argv[], int need_fields)
 {
-	int cnt;
 	char line[128];
-	FILE *fp;
+	int cnt;
 
 	if (argc < 1) {
-		send_error(sock, EINVAL, "get-container-name needs an argument.");
-		return;
+		snprintf(line, sizeof(line), "%s needs an argument.", command);
+		send_error(sock, EINVAL, line);
+		return NULL;
 	}
 	if (argc > 1) {
-		send_error(sock, EINVAL, "get-container-name takes only one argument.");
-		return;
+		snprintf(line, sizeof(line), "%s takes only one argument.", command);
+		send_error(sock, EINVAL, line);
+		return NULL;
 	}
 	if (sscanf(argv[0], "%d", &cnt) != 1) {
 		send_error(sock, EINVAL, "Wrong container number.");
-		return;
+		return NULL;
 	}
 	if ((cnt < 0) || (cnt >= MAX_CONTAINERS)) {
 		snprintf(line, 128, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
 		line[127] = '\0';
 		send_error(sock, EINVAL, line);
-		return;
+		return NULL;
 	}
 
-	fp = fopen("/etc/eris-linux/containers", "r");
-	if (fp == NULL) {
+	if (load_containers() != 0) {
 		send_error(sock, errno, "Unable to open containers description.");
-		return;
+		return NULL;
 	}
 
-	int c;
-	for (c = 0; c <= cnt; c++)
-		if (fgets(line, 127, fp) == NULL)
-			break;
-	fclose(fp);
-
-	if (c != cnt + 1) {
+	const container_entry_t *entry = &(container_entries[cnt]);
+	if (! entry->complete) {
 		send_error(sock, EIO, "Containers description is incomplete.");
-		return;
+		return NULL;
 	}
-	if (line[0] != '\0')
-		if (line[strlen(line) - 1] == '\n')
-			line[strlen(line) - 1] = '\0';
-
-	int i;
-
-	for (i = 0; (i < 127) && (line[i] != '!'); i++)
-		// container id
-		;
-	if ((i == 127) || (line[i] !='!')) {
+	if (need_fields && entry->present && (! entry->consistent)) {
 		send_error(sock, EIO, "Containers description is inconsistant.");
-		return;
-	}
-
-	int start = i + 1;
-	for (i ++; (i < 127) && (line[i] != '!'); i++)
-		// container name
-		;
-	if ((i == 127) || (line[i] !='!')) {
-		send_error(sock, EIO, "Containers description is inconsistant.\n");
-		return;
+		return NULL;
 	}
-	line[i] = '\0';
-
-	send_reply(sock, i - start, &(line[start]));
+	return entry;
 }
 
 
 
-static void get_container_version_command(int sock, int argc, char *argv[])
+static int load_containers(void)
 {
+	struct stat status;
+	char *line = NULL;
+	size_t size = 0;
 	int cnt;
-	char line[128];
-	FILE *fp;
 
-	if (argc < 1) {
-		send_error(sock, EINVAL, "get-container-version needs an argument.");
-		return;
-	}
-	if (argc > 1) {
-		send_error(sock, EINVAL, "get-container-version takes only one argument.");
-		return;
-	}
-	if (sscanf(argv[0], "%d", &cnt) != 1) {
-		send_error(sock, EINVAL, "wrong container number.");
-		return;
-	}
-	if ((cnt < 0) || (cnt >= MAX_CONTAINERS)) {
-		snprintf(line, 128, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
-		line[127] = '\0';
-		send_error(sock, EINVAL, line);
-		return;
-	}
+	if (stat(CONTAINERS_FILE, &status) != 0)
+		return -1;
 
-	fp = fopen("/etc/eris-linux/containers", "r");
-	if (fp == NULL) {
-		send_error(sock, errno, "Unable to open containers description.\n");
-		return;
-	}
+	if (containers_loaded
+	 && (status.st_ino == containers_stat.st_ino)
+	 && (status.st_size == containers_stat.st_size)
+	 && (status.st_mtim.tv_sec == containers_stat.st_mtim.tv_sec)
+	 && (status.st_mtim.tv_nsec == containers_stat.st_mtim.tv_nsec))
+		return 0;
 
-	int c;
-	for (c = 0; c <= cnt; c++)
-		if (fgets(line, 127, fp) == NULL)
+	FILE *fp = fopen(CONTAINERS_FILE, "r");
+	if (fp == NULL)
+		return -1;
+
+	memset(container_entries, 0, sizeof(container_entries));
+	for (cnt = 0; cnt < MAX_CONTAINERS; cnt++) {
+		if (getline(&line, &size, fp) < 0)
 			break;
+		parse_container_line(line, &(container_entries[cnt]));
+	}
+	free(line);
 	fclose(fp);
 
-	if (c != cnt + 1) {
-		send_error(sock, EIO, "Containers description is incomplete.\n");
-		return;
-	}
-	if (line[0] != '\0')
-		if (line[strlen(line) - 1] == '\n')
-			line[strlen(line) - 1] = '\0';
+	containers_stat   = status;
+	containers_loaded = 1;
+	return 0;
+}
 
-	int i;
 
-	for (i = 0; (i < 127) && (line[i] != '!'); i++)
-		// container id
-		;
-	if ((i == 127) || (line[i] !='!')) {
-		send_error(sock, EIO, "Containers description is inconsistant.\n");
-		return;
-	}
-	for (i ++; (i < 127) && (line[i] != '!'); i++)
-		// container name
-		;
-	if ((i == 127) || (line[i] !='!')) {
-		send_error(sock, EIO, "Containers description is inconsistant.\n");
+
+// Line format: id!name!version!filename!b64!graphical!redirections!privileged
+static void parse_container_line(char *line, container_entry_t *entry)
+{
+	line[strcspn(line, "\r\n")] = '\0';
+
+	entry->complete   = 1;
+	entry->consistent = 1;
+	if ((line[0] == '\0') || ((line[0] == '-') && (line[1] == '1')))
 		return;
-	}
+	entry->present = 1;
 
-	int start = i + 1;
-	for (i ++; (i < 127) && (line[i] != '!'); i++)
-		// container version
-		;
-	if ((i == 127) || (line[i] !='!')) {
-		send_error(sock, EIO, "Containers description is inconsistant.\n");
+	char *id_end = strchr(line, '!');
+	char *name_end = (id_end != NULL) ? strchr(id_end + 1, '!') : NULL;
+	if (name_end == NULL) {
+		entry->consistent = 0;
 		return;
 	}
-	line[i] = '\0';
+	char *version_end = strchr(name_end + 1, '!');
+	if (version_end == NULL)
+		version_end = name_end + 1 + strlen(name_end + 1);
 
-	send_reply(sock, i - start, &(line[start]));
+	if ((copy_container_field(entry->id, line, id_end) != 0)
+	 || (copy_container_field(entry->name, id_end + 1, name_end) != 0)
+	 || (copy_container_field(entry->version, name_end + 1, version_end) != 0))
+		entry->consistent = 0;
 }
 
+
+
+static int copy_container_field(char *field, const char *start, const char *end)
+{
+	if (end - start >= CONTAINER_FIELD_LENGTH)
+		return -1;
+	memcpy(field, start, end - start);
+	field[end - start] = '\0';
+	return 0;
+}
@@ -0,0 +1,344 @@
+/*
+ *  ERIS LINUX CONTAINER SUPERVISOR
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Log ring of a container: start-containers pipes the output of docker run
+// to "eris-container-supervisor log <n>" instead of the console, where a
+// verbose application would wait for the serial line. The lines go to a
+// ring file in /run (tmpfs), read by GET /api/container/logs. The slot.conf
+// file of the slot may contain:
+//
+//   log_size=256k           Size of the ring.
+//   log_rate=16k            Bytes per second accepted (bursts of 4 seconds),
+//                           the lines above are dropped and counted.
+//   log_persist=yes         Copy the lines to /data/container-logs/slot-<n>.log
+//   log_persist_size=1m     by blocks of half a ring, the previous file being
+//                           kept as slot-<n>.log.old when it is full.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "container-log.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define SLOTS_DIR                "/data/containers"
+#define LOG_PERSIST_DIR          "/data/container-logs"
+
+#define DEFAULT_RING_SIZE        (256 * 1024)
+#define MIN_RING_SIZE            (16 * 1024)
+#define DEFAULT_RATE             (16 * 1024)
+#define BURST_SECONDS            4
+#define DEFAULT_PERSIST_SIZE     (1024 * 1024)
+
+#define LOG_LINE_MAX             4096
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	long  ring_size;
+	long  rate;
+	int   persist;
+	long  persist_size;
+
+} log_config_t;
+
+
+// ---------------------- Private method declarations.
+
+static void      load_log_config  (int slot, log_config_t *config);
+static long      parse_size       (const char *value);
+static int       open_ring        (int slot, long size);
+static void      emit_line        (const char *line, size_t length);
+static void      note_dropped     (void);
+static void      ring_write       (const char *data, size_t length);
+static void      spill_ring       (log_ring_header_t *header);
+static long long monotonic_ms     (void);
+
+
+// ---------------------- Private variables declarations.
+
+static log_config_t  config;
+static int           ring_fd = -1;
+static char          persist_path[256];
+
+static double        tokens;
+static long long     tokens_ms;
+static uint64_t      dropped_lines;
+
+
+// ---------------------- Public methods
+
+int run_container_log(int slot)
+{
+	char chunk[4096];
+	char line[LOG_LINE_MAX + 1];
+	size_t length = 0;
+
+	load_log_config(slot, &config);
+	if (open_ring(slot, config.ring_size) != 0)
+		return -1;
+	if (config.persist) {
+		mkdir(LOG_PERSIST_DIR, 0755);
+		snprintf(persist_path, sizeof(persist_path), "%s/slot-%d.log", LOG_PERSIST_DIR, slot);
+	}
+
+	tokens = config.rate * BURST_SECONDS;
+	tokens_ms = monotonic_ms();
+
+	static const char start[] = "[eris-linux] container started\n";
+	ring_write(start, sizeof(start) - 1);
+
+	for (;;) {
+		ssize_t n = read(STDIN_FILENO, chunk, sizeof(chunk));
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0)
+			break;
+		for (ssize_t i = 0; i < n; i++) {
+			// The containers run with a terminal (docker run -t).
+			if (chunk[i] == '\r')
+				continue;
+			line[length++] = chunk[i];
+			if ((chunk[i] == '\n') || (length == LOG_LINE_MAX)) {
+				emit_line(line, length);
+				length = 0;
+			}
+		}
+	}
+	if (length > 0) {
+		line[length++] = '\n';
+		emit_line(line, length);
+	}
+	note_dropped();
+
+	if (config.persist) {
+		log_ring_header_t header;
+		flock(ring_fd, LOCK_EX);
+		if (pread(ring_fd, &header, sizeof(header), 0) == sizeof(header))
+			spill_ring(&header);
+		flock(ring_fd, LOCK_UN);
+	}
+	close(ring_fd);
+	return 0;
+}
+
+
+// ---------------------- Private methods
+
+static void load_log_config(int slot, log_config_t *cfg)
+{
+	char path[256];
+	char line[512];
+
+	cfg->ring_size    = DEFAULT_RING_SIZE;
+	cfg->rate         = DEFAULT_RATE;
+	cfg->persist      = 0;
+	cfg->persist_size = DEFAULT_PERSIST_SIZE;
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.conf", SLOTS_DIR, slot);
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (strncmp(line, "log_size=", 9) == 0)
+			cfg->ring_size = parse_size(line + 9);
+		else if (strncmp(line, "log_rate=", 9) == 0)
+			cfg->rate = parse_size(line + 9);
+		else if (strncmp(line, "log_persist=", 12) == 0)
+			cfg->persist = (line[12] == 'y') || (line[12] == 'Y');
+		else if (strncmp(line, "log_persist_size=", 17) == 0)
+			cfg->persist_size = parse_size(line + 17);
+	}
+	fclose(fp);
+
+	if (cfg->ring_size < MIN_RING_SIZE)
+		cfg->ring_size = MIN_RING_SIZE;
+	if (cfg->rate <= 0)
+		cfg->rate = DEFAULT_RATE;
+}
+
+
+
+// <n>, <n>k or <n>m.
+static long parse_size(const char *value)
+{
+	char *end;
+	long size = strtol(value, &end, 10);
+
+	if ((*end == 'k') || (*end == 'K'))
+		size *= 1024;
+	else if ((*end == 'm') || (*end == 'M'))
+		size *= 1024 * 1024;
+	return size;
+}
+
+
+
+// The ring is kept across the restarts of the container. During a
+// blue/green switch, two containers of the slot write to it: the writes
+// are serialized with flock().
+static int open_ring(int slot, long size)
+{
+	char path[256];
+	log_ring_header_t header;
+
+	mkdir(LOG_RING_DIR, 0755);
+	snprintf(path, sizeof(path), "%s/slot-%d.log", LOG_RING_DIR, slot);
+	ring_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (ring_fd < 0)
+		return -1;
+
+	flock(ring_fd, LOCK_EX);
+	if ((pread(ring_fd, &header, sizeof(header), 0) != sizeof(header))
+	 || (memcmp(header.magic, LOG_RING_MAGIC, sizeof(header.magic)) != 0)
+	 || (header.capacity == 0)) {
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, LOG_RING_MAGIC, sizeof(header.magic));
+		header.capacity = size;
+		if ((ftruncate(ring_fd, LOG_RING_DATA_OFFSET + size) != 0)
+		 || (pwrite(ring_fd, &header, sizeof(header), 0) != sizeof(header))) {
+			flock(ring_fd, LOCK_UN);
+			close(ring_fd);
+			return -1;
+		}
+	}
+	flock(ring_fd, LOCK_UN);
+	return 0;
+}
+
+
+
+// Token bucket: the tokens are bytes, refilled at the configured rate.
+static void emit_line(const char *line, size_t length)
+{
+	long long now = monotonic_ms();
+
+	tokens += (now - tokens_ms) * config.rate / 1000.0;
+	if (tokens > config.rate * BURST_SECONDS)
+		tokens = config.rate * BURST_SECONDS;
+	tokens_ms = now;
+
+	if (tokens < length) {
+		dropped_lines++;
+		return;
+	}
+	tokens -= length;
+
+	note_dropped();
+	ring_write(line, length);
+}
+
+
+
+static void note_dropped(void)
+{
+	char note[64];
+
+	if (dropped_lines == 0)
+		return;
+	int n = snprintf(note, sizeof(note), "[eris-linux] %llu lines dropped\n", (unsigned long long) dropped_lines);
+	ring_write(note, n);
+}
+
+
+
+static void ring_write(const char *data, size_t length)
+{
+	log_ring_header_t header;
+
+	flock(ring_fd, LOCK_EX);
+	if (pread(ring_fd, &header, sizeof(header), 0) != sizeof(header)) {
+		flock(ring_fd, LOCK_UN);
+		return;
+	}
+
+	// The data first: the readers check the header after reading the data.
+	size_t done = 0;
+	while (done < length) {
+		uint64_t offset = (header.written + done) % header.capacity;
+		size_t n = length - done;
+		if (n > header.capacity - offset)
+			n = header.capacity - offset;
+		if (pwrite(ring_fd, data + done, n, LOG_RING_DATA_OFFSET + offset) != (ssize_t) n)
+			break;
+		done += n;
+	}
+	header.written += done;
+	header.dropped += dropped_lines;
+	dropped_lines = 0;
+	if (pwrite(ring_fd, &header, sizeof(header), 0) != sizeof(header))
+		fprintf(stderr, "unable to update the log ring.\n");
+
+	if (config.persist && (header.written - header.spilled >= header.capacity / 2))
+		spill_ring(&header);
+	flock(ring_fd, LOCK_UN);
+}
+
+
+
+// Called with the lock of the ring. Large blocks limit the flash writes.
+static void spill_ring(log_ring_header_t *header)
+{
+	char buffer[4096];
+	struct stat st;
+
+	uint64_t start = header->spilled;
+	if (header->written - start > header->capacity)
+		start = header->written - header->capacity;
+	if (start >= header->written)
+		return;
+
+	if ((stat(persist_path, &st) == 0) && (st.st_size > config.persist_size)) {
+		char old[sizeof(persist_path) + 8];
+		snprintf(old, sizeof(old), "%s.old", persist_path);
+		rename(persist_path, old);
+	}
+	int fd = open(persist_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return;
+
+	while (start < header->written) {
+		uint64_t offset = start % header->capacity;
+		size_t n = sizeof(buffer);
+		if (n > header->written - start)
+			n = header->written - start;
+		if (n > header->capacity - offset)
+			n = header->capacity - offset;
+		if ((pread(ring_fd, buffer, n, LOG_RING_DATA_OFFSET + offset) != (ssize_t) n)
+		 || (write(fd, buffer, n) != (ssize_t) n))
+			break;
+		start += n;
+	}
+	close(fd);
+
+	header->spilled = start;
+	if (pwrite(ring_fd, header, sizeof(*header), 0) != sizeof(*header))
+		fprintf(stderr, "unable to update the log ring.\n");
+}
+
+
+
+static long long monotonic_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
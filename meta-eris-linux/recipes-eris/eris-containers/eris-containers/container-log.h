@@ -0,0 +1,35 @@
+/*
+ *  ERIS LINUX CONTAINER SUPERVISOR
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef CONTAINER_LOG_H
+#define CONTAINER_LOG_H
+
+	#include <stdint.h>
+
+	#define LOG_RING_DIR          "/run/eris-linux"
+	#define LOG_RING_MAGIC        "ERISLOG1"
+	#define LOG_RING_DATA_OFFSET  64
+
+	// Header of the ring file /run/eris-linux/slot-<n>.log, followed by the
+	// data area at LOG_RING_DATA_OFFSET. The byte number p written since the
+	// creation of the ring is at p % capacity in the data area. The same
+	// layout is read by eris-rest-api (container-logs.c).
+	typedef struct {
+
+		char      magic[8];
+		uint64_t  capacity;     // Size of the data area.
+		uint64_t  written;      // Bytes written since the creation of the ring.
+		uint64_t  dropped;      // Lines dropped by the rate limit.
+		uint64_t  spilled;      // Bytes copied to the persistent log.
+
+	} log_ring_header_t;
+
+	// Copy the standard input (the output of the container of the slot,
+	// numbered from 1) into the ring of the slot until the end of file.
+	int run_container_log(int slot);
+
+#endif
@@ -0,0 +1,603 @@
+/*
+ *  ERIS LINUX CONTAINER SUPERVISOR
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Start the containers of all the slots, in parallel unless a slot has to
+// wait for other slots to be ready. Each slot may have a slot.conf file
+// beside its slot.tar (or compressed tarball), with the following optional lines:
+//
+//   after=1,3              Start once slots 1 and 3 are ready (or failed).
+//   ready=tcp:8080         Ready when the host port accepts connections,
+//   ready=file:/data/ok    when the file exists in the container,
+//   ready=exec:<command>   or when the shell command succeeds in it.
+//   ready_timeout=60       Seconds to wait for the readiness.
+//
+// The resource profile of the slot (cpuset=, memory=, ...), in the same
+// file, is applied by start-containers to the docker run command.
+//
+// Without readiness probe, a slot is ready as soon as its container runs.
+// The steps of each slot are appended to the containers timeline.
+//
+//   eris-container-supervisor probe <n> <container id> [<address>:<port>]
+//
+// waits for the readiness of a container started by start-containers
+// beside the current one of the slot (blue/green switch). A TCP probe is
+// then done on the given address of the container, the port of the host
+// not being published yet. The file and exec probes are always done in
+// the container itself, never in the one it replaces.
+//
+//   eris-container-supervisor log <n>
+//
+// copies its standard input (the output of the container) into the log
+// ring of the slot, see container-log.c.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "container-log.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define CONTAINERS_FILE          "/etc/eris-linux/containers"
+#define SLOTS_DIR                "/data/containers"
+#define TIMELINE_DIR             "/run/eris-linux"
+#define TIMELINE_FILE            TIMELINE_DIR "/container-timeline"
+#define START_SCRIPT             "/etc/init.d/start-containers"
+#define DOCKER_SOCKET_PATH       "/var/run/docker.sock"
+#define DOCKER_COMMAND           "/usr/bin/docker"
+
+#define MAX_SLOTS                4
+#define TICK_MS                  100
+#define PROBE_PERIOD_MS          500
+#define START_TIMEOUT_S          30        // From the end of the import to the running container.
+#define DEFAULT_READY_TIMEOUT_S  60
+
+#define DOCKER_REPLY_MAX         (64 * 1024)
+
+
+// ---------------------- Private types definitions.
+
+typedef enum {
+
+	PROBE_NONE = 0,
+	PROBE_TCP,
+	PROBE_FILE,
+	PROBE_EXEC,
+
+} probe_type_t;
+
+
+typedef enum {
+
+	SLOT_ABSENT = 0,
+	SLOT_WAITING,       // For the slots it starts after.
+	SLOT_LAUNCHING,     // start-containers imports the image and runs the container.
+	SLOT_CREATING,      // Waiting for the container id.
+	SLOT_STARTING,      // Waiting for the container to run.
+	SLOT_PROBING,       // Waiting for the readiness probe to succeed.
+	SLOT_READY,
+	SLOT_FAILED,
+
+} slot_phase_t;
+
+
+typedef struct {
+
+	slot_phase_t  phase;
+	int           after[MAX_SLOTS];
+	probe_type_t  probe;
+	char          probe_arg[256];
+	int           ready_timeout_s;
+
+	pid_t         script_pid;
+	pid_t         probe_pid;
+	long long     launch_ms;
+	long long     phase_ms;
+	long long     next_probe_ms;
+	char          cid[80];
+	pid_t         container_pid;     // In the namespace of the host.
+
+} slot_t;
+
+
+// ---------------------- Private method declarations.
+
+static void      load_slots           (void);
+static void      load_slot_config     (int slot);
+static int       dependencies_settled (int slot);
+static int       slot_is_settled      (int slot);
+static void      launch_slot          (int slot, long long now);
+static void      reap_children        (long long now);
+static void      update_slot          (int slot, long long now);
+static int       read_container_id    (int slot);
+static int       container_is_running (const char *cid, pid_t *pid);
+static int       run_probe            (int slot);
+static int       probe_container      (int slot, const char *cid, const char *target);
+static void      set_phase            (int slot, slot_phase_t phase, long long now);
+static void      record_step          (int slot, const char *step, long long duration);
+static pid_t     spawn                (const char *const argv[]);
+static long long uptime_ms            (void);
+
+
+// ---------------------- Private variables declarations.
+
+static slot_t  slots[MAX_SLOTS];
+
+static struct in_addr  probe_address;
+
+// Plain or compressed image of a slot, as accepted by start-containers.
+static const char *slot_payloads[] = { "slot.tar", "slot.tar.zst", "slot.tar.xz", "slot.tar.gz", NULL };
+
+extern char **environ;
+
+
+// ---------------------- Public methods
+
+int main(int argc, char *argv[])
+{
+	signal(SIGPIPE, SIG_IGN);
+	probe_address.s_addr = htonl(INADDR_LOOPBACK);
+
+	if ((argc >= 4) && (strcmp(argv[1], "probe") == 0)) {
+		int slot = atoi(argv[2]) - 1;
+		if ((slot < 0) || (slot >= MAX_SLOTS))
+			return EXIT_FAILURE;
+		return (probe_container(slot, argv[3], (argc > 4) ? argv[4] : NULL) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if ((argc >= 3) && (strcmp(argv[1], "log") == 0)) {
+		int slot = atoi(argv[2]);
+		if ((slot < 1) || (slot > MAX_SLOTS))
+			return EXIT_FAILURE;
+		return (run_container_log(slot) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	load_slots();
+
+	for (;;) {
+		long long now = uptime_ms();
+		int busy = 0;
+		int blocked = 0;
+
+		reap_children(now);
+
+		for (int slot = 0; slot < MAX_SLOTS; slot++) {
+			if ((slots[slot].phase == SLOT_WAITING) && dependencies_settled(slot))
+				launch_slot(slot, now);
+			update_slot(slot, now);
+		}
+
+		for (int slot = 0; slot < MAX_SLOTS; slot++) {
+			if ((slots[slot].phase == SLOT_WAITING) && (! dependencies_settled(slot)))
+				blocked++;
+			else if (! slot_is_settled(slot))
+				busy++;
+		}
+		if ((busy == 0) && (blocked == 0))
+			break;
+
+		// Circular dependencies: start the remaining slots anyway.
+		if (busy == 0) {
+			for (int slot = 0; slot < MAX_SLOTS; slot++)
+				if (slots[slot].phase == SLOT_WAITING) {
+					record_step(slot, "after-ignored", 0);
+					launch_slot(slot, now);
+				}
+		}
+		usleep(TICK_MS * 1000);
+	}
+	return EXIT_SUCCESS;
+}
+
+
+// ---------------------- Private methods
+
+static void load_slots(void)
+{
+	char path[256];
+	char *line = NULL;
+	size_t size = 0;
+
+	FILE *fp = fopen(CONTAINERS_FILE, "r");
+	if (fp == NULL)
+		return;
+
+	for (int slot = 0; slot < MAX_SLOTS; slot++) {
+		if (getline(&line, &size, fp) < 0)
+			break;
+		if ((line[0] == '\0') || (line[0] == '\n') || ((line[0] == '-') && (line[1] == '1')))
+			continue;
+		int payload;
+		for (payload = 0; slot_payloads[payload] != NULL; payload++) {
+			snprintf(path, sizeof(path), "%s/slot-%d/%s", SLOTS_DIR, slot + 1, slot_payloads[payload]);
+			if (access(path, F_OK) == 0)
+				break;
+		}
+		if (slot_payloads[payload] == NULL)
+			continue;
+		slots[slot].phase = SLOT_WAITING;
+		load_slot_config(slot);
+	}
+	free(line);
+	fclose(fp);
+}
+
+
+
+static void load_slot_config(int slot)
+{
+	char path[256];
+	char line[512];
+
+	slots[slot].ready_timeout_s = DEFAULT_READY_TIMEOUT_S;
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.conf", SLOTS_DIR, slot + 1);
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (strncmp(line, "after=", 6) == 0) {
+			char *saveptr = NULL;
+			for (char *item = strtok_r(line + 6, ", ", &saveptr); item != NULL; item = strtok_r(NULL, ", ", &saveptr)) {
+				int other = atoi(item) - 1;
+				if ((other >= 0) && (other < MAX_SLOTS) && (other != slot))
+					slots[slot].after[other] = 1;
+			}
+		} else if (strncmp(line, "ready=tcp:", 10) == 0) {
+			slots[slot].probe = PROBE_TCP;
+			snprintf(slots[slot].probe_arg, sizeof(slots[slot].probe_arg), "%s", line + 10);
+		} else if (strncmp(line, "ready=file:", 11) == 0) {
+			slots[slot].probe = PROBE_FILE;
+			snprintf(slots[slot].probe_arg, sizeof(slots[slot].probe_arg), "%s", line + 11);
+		} else if (strncmp(line, "ready=exec:", 11) == 0) {
+			slots[slot].probe = PROBE_EXEC;
+			snprintf(slots[slot].probe_arg, sizeof(slots[slot].probe_arg), "%s", line + 11);
+		} else if (strncmp(line, "ready_timeout=", 14) == 0) {
+			int timeout = atoi(line + 14);
+			if (timeout > 0)
+				slots[slot].ready_timeout_s = timeout;
+		}
+	}
+	fclose(fp);
+}
+
+
+
+// A slot waits for the readiness of the slots listed in its "after" line,
+// but not longer than their own failure.
+static int dependencies_settled(int slot)
+{
+	for (int other = 0; other < MAX_SLOTS; other++)
+		if (slots[slot].after[other] && (! slot_is_settled(other)))
+			return 0;
+	return 1;
+}
+
+
+
+static int slot_is_settled(int slot)
+{
+	return (slots[slot].phase == SLOT_ABSENT) || (slots[slot].phase == SLOT_READY) || (slots[slot].phase == SLOT_FAILED);
+}
+
+
+
+static void launch_slot(int slot, long long now)
+{
+	char number[16];
+
+	snprintf(number, sizeof(number), "%d", slot + 1);
+	const char *argv[] = { START_SCRIPT, "start-slot", number, NULL };
+
+	slots[slot].launch_ms = now;
+	slots[slot].script_pid = spawn(argv);
+	if (slots[slot].script_pid < 0) {
+		record_step(slot, "failed", 0);
+		set_phase(slot, SLOT_FAILED, now);
+		return;
+	}
+	set_phase(slot, SLOT_LAUNCHING, now);
+}
+
+
+
+static void reap_children(long long now)
+{
+	pid_t pid;
+	int status;
+
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		int success = WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+
+		for (int slot = 0; slot < MAX_SLOTS; slot++) {
+			if (pid == slots[slot].script_pid) {
+				slots[slot].script_pid = 0;
+				if (success) {
+					set_phase(slot, SLOT_CREATING, now);
+				} else {
+					record_step(slot, "failed", now - slots[slot].launch_ms);
+					set_phase(slot, SLOT_FAILED, now);
+				}
+			}
+			if (pid == slots[slot].probe_pid) {
+				slots[slot].probe_pid = 0;
+				if (success && (slots[slot].phase == SLOT_PROBING)) {
+					record_step(slot, "ready", now - slots[slot].launch_ms);
+					set_phase(slot, SLOT_READY, now);
+				}
+			}
+		}
+	}
+}
+
+
+
+static void update_slot(int slot, long long now)
+{
+	slot_t *s = &(slots[slot]);
+
+	switch (s->phase) {
+
+		case SLOT_CREATING:
+			if (read_container_id(slot) == 0) {
+				record_step(slot, "created", now - s->launch_ms);
+				set_phase(slot, SLOT_STARTING, now);
+			} else if (now - s->phase_ms > START_TIMEOUT_S * 1000LL) {
+				record_step(slot, "create-timeout", now - s->launch_ms);
+				set_phase(slot, SLOT_FAILED, now);
+			}
+			break;
+
+		case SLOT_STARTING:
+			if (container_is_running(s->cid, &(s->container_pid))) {
+				record_step(slot, "started", now - s->launch_ms);
+				if (s->probe == PROBE_NONE) {
+					record_step(slot, "ready", now - s->launch_ms);
+					set_phase(slot, SLOT_READY, now);
+				} else {
+					set_phase(slot, SLOT_PROBING, now);
+				}
+			} else if (now - s->phase_ms > START_TIMEOUT_S * 1000LL) {
+				record_step(slot, "start-timeout", now - s->launch_ms);
+				set_phase(slot, SLOT_FAILED, now);
+			}
+			break;
+
+		case SLOT_PROBING:
+			if (now - s->phase_ms > s->ready_timeout_s * 1000LL) {
+				if (s->probe_pid > 0)
+					kill(s->probe_pid, SIGKILL);
+				record_step(slot, "ready-timeout", now - s->launch_ms);
+				set_phase(slot, SLOT_FAILED, now);
+				break;
+			}
+			if ((now >= s->next_probe_ms) && (s->probe_pid <= 0)) {
+				s->next_probe_ms = now + PROBE_PERIOD_MS;
+				if (run_probe(slot) == 0) {
+					record_step(slot, "ready", now - s->launch_ms);
+					set_phase(slot, SLOT_READY, now);
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+
+// docker run writes the container id in the file given with --cidfile.
+static int read_container_id(int slot)
+{
+	char path[256];
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.cid", SLOTS_DIR, slot + 1);
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	if (fgets(slots[slot].cid, sizeof(slots[slot].cid), fp) == NULL)
+		slots[slot].cid[0] = '\0';
+	fclose(fp);
+
+	slots[slot].cid[strcspn(slots[slot].cid, "\r\n ")] = '\0';
+	return (slots[slot].cid[0] != '\0') ? 0 : -1;
+}
+
+
+
+// Fill the pid of the init process of a running container.
+static int container_is_running(const char *cid, pid_t *pid)
+{
+	struct sockaddr_un addr;
+	char request[256];
+	char *reply;
+	size_t length = 0;
+
+	int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return 0;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, DOCKER_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+	if (connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+		close(sock);
+		return 0;
+	}
+
+	// HTTP/1.0: the reply is neither chunked nor kept alive.
+	int n = snprintf(request, sizeof(request), "GET /containers/%s/json HTTP/1.0\r\n\r\n", cid);
+	if ((send(sock, request, n, 0) != n) || ((reply = malloc(DOCKER_REPLY_MAX + 1)) == NULL)) {
+		close(sock);
+		return 0;
+	}
+	while (length < DOCKER_REPLY_MAX) {
+		ssize_t r = recv(sock, reply + length, DOCKER_REPLY_MAX - length, 0);
+		if ((r < 0) && (errno == EINTR))
+			continue;
+		if (r <= 0)
+			break;
+		length += r;
+	}
+	reply[length] = '\0';
+	close(sock);
+
+	int running = (strncmp(reply, "HTTP/1.0 200", 12) == 0 || strncmp(reply, "HTTP/1.1 200", 12) == 0)
+	           && (strstr(reply, "\"Running\":true") != NULL);
+	char *field = strstr(reply, "\"Pid\":");
+	*pid = (field != NULL) ? atoi(field + 6) : 0;
+	if (*pid <= 0)
+		running = 0;
+	free(reply);
+
+	return running;
+}
+
+
+
+// Return 0 when the slot is ready. The exec probes end in reap_children().
+static int run_probe(int slot)
+{
+	slot_t *s = &(slots[slot]);
+
+	switch (s->probe) {
+
+		case PROBE_TCP: {
+			struct sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons(atoi(s->probe_arg));
+			addr.sin_addr = probe_address;
+			int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if (sock < 0)
+				return -1;
+			int err = connect(sock, (struct sockaddr *) &addr, sizeof(addr));
+			close(sock);
+			return err;
+		}
+
+		// During a blue/green switch the previous container of the slot
+		// runs too: the probes must not see its files or processes.
+		case PROBE_FILE: {
+			char path[512];
+			snprintf(path, sizeof(path), "/proc/%d/root/%s", (int) s->container_pid, s->probe_arg);
+			return access(path, F_OK);
+		}
+
+		case PROBE_EXEC: {
+			const char *argv[] = { DOCKER_COMMAND, "exec", s->cid, "/bin/sh", "-c", s->probe_arg, NULL };
+			s->probe_pid = spawn(argv);
+			return -1;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+
+
+// The container is followed from its start, as for a slot launched by the supervisor.
+static int probe_container(int slot, const char *cid, const char *target)
+{
+	slot_t *s = &(slots[slot]);
+	long long now = uptime_ms();
+
+	load_slot_config(slot);
+	if ((target != NULL) && (s->probe == PROBE_TCP)) {
+		char address[64];
+		snprintf(address, sizeof(address), "%s", target);
+		char *port = strrchr(address, ':');
+		if (port != NULL) {
+			*port = '\0';
+			snprintf(s->probe_arg, sizeof(s->probe_arg), "%s", port + 1);
+		}
+		if (inet_pton(AF_INET, address, &probe_address) != 1)
+			return -1;
+	}
+
+	snprintf(s->cid, sizeof(s->cid), "%s", cid);
+	s->launch_ms = now;
+	set_phase(slot, SLOT_STARTING, now);
+
+	while (! slot_is_settled(slot)) {
+		usleep(TICK_MS * 1000);
+		now = uptime_ms();
+		reap_children(now);
+		update_slot(slot, now);
+	}
+	return (s->phase == SLOT_READY) ? 0 : -1;
+}
+
+
+
+static void set_phase(int slot, slot_phase_t phase, long long now)
+{
+	slots[slot].phase    = phase;
+	slots[slot].phase_ms = now;
+}
+
+
+
+// <uptime in ms> slot-<n> <step> <duration since the launch of the slot in ms>
+static void record_step(int slot, const char *step, long long duration)
+{
+	char line[128];
+
+	mkdir(TIMELINE_DIR, 0755);
+	int fd = open(TIMELINE_FILE, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return;
+	int n = snprintf(line, sizeof(line), "%lld slot-%d %s %lld\n", uptime_ms(), slot + 1, step, duration);
+	if (write(fd, line, n) != n)
+		fprintf(stderr, "unable to write the containers timeline.\n");
+	close(fd);
+}
+
+
+
+static pid_t spawn(const char *const argv[])
+{
+	posix_spawn_file_actions_t actions;
+	pid_t pid;
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+	int err = posix_spawn(&pid, argv[0], &actions, NULL, (char *const *) argv, environ);
+	posix_spawn_file_actions_destroy(&actions);
+
+	return (err == 0) ? pid : -1;
+}
+
+
+
+// Same time base as /proc/uptime, used by start-containers.
+static long long uptime_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_BOOTTIME, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,830 @@
+/*
+ *  ERIS LINUX SLOT DELTA
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// File-level delta between two uncompressed container images (tarballs).
+//
+//   eris-slot-delta create <old.tar> <new.tar>  > delta.tar     (build host)
+//   eris-slot-delta apply  <base.tar> <delta.tar> > staged.tar  (target)
+//
+// A delta is a tarball whose first member, ".eris-delta", lists:
+//
+//   base=<sha256 of the base tarball>
+//   target=<sha256 of the new tarball>
+//   keep=<path>              (next member of the base with this path)
+//   touch=<path>             (idem, with the headers of the next member
+//                             of the delta)
+//   add=<path>               (next member of the delta)
+//   padding=<blocks>         (zero blocks after the last member)
+//
+// followed by the new and modified members. The keep, touch and add lines
+// give the members of the new tarball in its order: the rebuilt tarball
+// is identical to it, and is the base of the next delta. The members of
+// the base that are not kept are dropped.
+//
+// Members are matched on their contents, modes and owners, but not on
+// their times: an image rebuilt without reproducible mtimes only changes
+// the headers. Such a member is a touch line, and the delta carries its
+// new headers as the data of a ".eris-delta-headers" member. Both digests are checked while
+// streaming, and apply exits with a non-zero status if any of them
+// differs. The inputs may be FIFOs: each one is read only once by apply,
+// so a member of the base is only kept if it comes after the previous
+// kept one; otherwise it is added by the delta.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+
+
+// ---------------------- Private macros declarations.
+
+#define BLOCK_SIZE          512
+#define COPY_BLOCKS         128
+#define MANIFEST_NAME       ".eris-delta"
+#define HEADERS_NAME        ".eris-delta-headers"
+#define MANIFEST_MAX        (16 * 1024 * 1024)
+
+#define EXIT_BAD_INPUT      2
+#define EXIT_BAD_BASE       3
+#define EXIT_BAD_TARGET     4
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	FILE        *fp;
+	EVP_MD_CTX  *hash;
+
+} stream_t;
+
+
+// Headers of a member: the extension headers (GNU long names, pax) and
+// the main header. The data blocks are streamed separately.
+typedef struct {
+
+	uint8_t     *headers;
+	size_t       nb_headers;
+	size_t       allocated;
+	size_t       data_blocks;
+
+	char        *path;
+	EVP_MD_CTX  *running;      // Headers, then data.
+	uint8_t      digest[32];
+	EVP_MD_CTX  *matching;     // Idem, without the times.
+	uint8_t      match[32];
+
+} member_t;
+
+
+typedef struct {
+
+	char     *path;
+	size_t    position;        // Rank of the member in the tarball.
+	uint8_t   digest[32];
+	uint8_t   match[32];
+
+} index_entry_t;
+
+
+// ---------------------- Private method declarations.
+
+static int    create_delta        (const char *old_name, const char *new_name);
+static int    apply_delta         (const char *base_name, const char *delta_name);
+
+static int    read_member         (stream_t *in, member_t *member, int compare);
+static int    copy_data           (stream_t *in, stream_t *out, member_t *member, int compare);
+static int    write_headers       (stream_t *out, const member_t *member);
+static void   hash_match_headers  (member_t *member);
+static void   make_header         (uint8_t *header, const char *name, size_t size);
+static void   free_member         (member_t *member);
+static int    read_block          (stream_t *in, uint8_t *block);
+static int    write_blocks        (stream_t *out, const void *data, size_t nb_blocks);
+static int    write_end_of_archive(stream_t *out);
+static int    hash_file           (const char *name, uint8_t digest[32]);
+static int    is_zero_block       (const uint8_t *block);
+
+static uint64_t parse_number      (const uint8_t *field, size_t length);
+static char  *extension_string    (const uint8_t *data, size_t size);
+static char  *pax_value           (const uint8_t *data, size_t size, const char *key);
+static char  *normalize_path      (char *path);
+static int    compare_entries     (const void *a, const void *b);
+static index_entry_t *find_entry  (index_entry_t *index, size_t nb, const char *path, size_t position, const uint8_t match[32]);
+static void   to_hex              (const uint8_t digest[32], char hex[65]);
+static EVP_MD_CTX *new_digest     (void);
+
+
+// ---------------------- Public methods
+
+int main(int argc, char *argv[])
+{
+	if ((argc == 4) && (strcmp(argv[1], "create") == 0))
+		return create_delta(argv[2], argv[3]);
+	if ((argc == 4) && (strcmp(argv[1], "apply") == 0))
+		return apply_delta(argv[2], argv[3]);
+
+	fprintf(stderr, "usage: %s create <old.tar> <new.tar> > delta.tar\n", argv[0]);
+	fprintf(stderr, "       %s apply <base.tar> <delta.tar> > new.tar\n", argv[0]);
+	return EXIT_BAD_INPUT;
+}
+
+
+// ---------------------- Private methods
+
+static int create_delta(const char *old_name, const char *new_name)
+{
+	stream_t in;
+	stream_t out;
+	member_t member;
+	index_entry_t *old_index = NULL;
+	size_t nb_old = 0;
+	char *kept = NULL;          // 'k'eep, 't'ouch or 'a'dd.
+	size_t nb_new = 0;
+	uint8_t base_digest[32];
+	uint8_t target_digest[32];
+	uint8_t block[BLOCK_SIZE];
+	char hex[65];
+	int r;
+
+	if ((hash_file(old_name, base_digest) != 0) || (hash_file(new_name, target_digest) != 0))
+		return EXIT_BAD_INPUT;
+
+	// Index the members of the old image.
+	if (((in.hash = new_digest()) == NULL) || ((out.hash = new_digest()) == NULL))
+		return EXIT_BAD_INPUT;
+	if ((in.fp = fopen(old_name, "r")) == NULL)
+		return EXIT_BAD_INPUT;
+	while ((r = read_member(&in, &member, 1)) == 0) {
+		old_index = realloc(old_index, (nb_old + 1) * sizeof(index_entry_t));
+		if ((old_index == NULL) || (copy_data(&in, NULL, &member, 1) != 0))
+			return EXIT_BAD_INPUT;
+		old_index[nb_old].path = strdup(member.path);
+		old_index[nb_old].position = nb_old;
+		memcpy(old_index[nb_old].digest, member.digest, 32);
+		memcpy(old_index[nb_old].match, member.match, 32);
+		nb_old++;
+		free_member(&member);
+	}
+	fclose(in.fp);
+	if (r < 0)
+		return EXIT_BAD_INPUT;
+	qsort(old_index, nb_old, sizeof(index_entry_t), compare_entries);
+
+	// Manifest: the members of the new image, kept from the old one when
+	// identical but for their times, and in the same order.
+	char *manifest = NULL;
+	size_t manifest_size = 0;
+	FILE *mfp = open_memstream(&manifest, &manifest_size);
+	if (mfp == NULL)
+		return EXIT_BAD_INPUT;
+	to_hex(base_digest, hex);
+	fprintf(mfp, "base=%s\n", hex);
+	to_hex(target_digest, hex);
+	fprintf(mfp, "target=%s\n", hex);
+
+	if ((in.fp = fopen(new_name, "r")) == NULL)
+		return EXIT_BAD_INPUT;
+	size_t next_position = 0;
+	while ((r = read_member(&in, &member, 1)) == 0) {
+		if (copy_data(&in, NULL, &member, 1) != 0)
+			return EXIT_BAD_INPUT;
+		kept = realloc(kept, nb_new + 1);
+		if (kept == NULL)
+			return EXIT_BAD_INPUT;
+		index_entry_t *old = find_entry(old_index, nb_old, member.path, next_position, member.match);
+		kept[nb_new] = 'a';
+		if (old != NULL) {
+			kept[nb_new] = (memcmp(old->digest, member.digest, 32) == 0) ? 'k' : 't';
+			next_position = old->position + 1;
+		}
+		fprintf(mfp, "%s=%s\n", (kept[nb_new] == 'k') ? "keep" : (kept[nb_new] == 't') ? "touch" : "add", member.path);
+		nb_new++;
+		free_member(&member);
+	}
+	if (r < 0)
+		return EXIT_BAD_INPUT;
+	// The end of archive block already read, then the padding of the last record.
+	size_t padding = 1;
+	while ((r = read_block(&in, block)) == 0) {
+		if (! is_zero_block(block)) {
+			fprintf(stderr, "eris-slot-delta: unexpected data at the end of %s.\n", new_name);
+			return EXIT_BAD_INPUT;
+		}
+		padding++;
+	}
+	fclose(in.fp);
+	if (r < 0)
+		return EXIT_BAD_INPUT;
+	fprintf(mfp, "padding=%zu\n", padding);
+	fclose(mfp);
+
+	uint8_t header[BLOCK_SIZE];
+	make_header(header, MANIFEST_NAME, manifest_size);
+
+	out.fp = stdout;
+	size_t manifest_blocks = (manifest_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	manifest = realloc(manifest, manifest_blocks * BLOCK_SIZE + 1);
+	if (manifest == NULL)
+		return EXIT_BAD_INPUT;
+	memset(manifest + manifest_size, 0, manifest_blocks * BLOCK_SIZE - manifest_size);
+	if ((write_blocks(&out, header, 1) != 0) || (write_blocks(&out, manifest, manifest_blocks) != 0))
+		return EXIT_BAD_INPUT;
+	free(manifest);
+
+	// New and modified members, and headers of the touched ones.
+	if ((in.fp = fopen(new_name, "r")) == NULL)
+		return EXIT_BAD_INPUT;
+	size_t index = 0;
+	while ((r = read_member(&in, &member, 0)) == 0) {
+		char status = kept[index++];
+		if (status == 't') {
+			make_header(header, HEADERS_NAME, member.nb_headers * BLOCK_SIZE);
+			if (write_blocks(&out, header, 1) != 0)
+				return EXIT_BAD_INPUT;
+		}
+		if ((status != 'k') && (write_headers(&out, &member) != 0))
+			return EXIT_BAD_INPUT;
+		if (copy_data(&in, (status == 'a') ? &out : NULL, &member, 0) != 0)
+			return EXIT_BAD_INPUT;
+		free_member(&member);
+	}
+	fclose(in.fp);
+	if ((r < 0) || (write_end_of_archive(&out) != 0) || (fflush(stdout) != 0))
+		return EXIT_BAD_INPUT;
+	EVP_MD_CTX_free(in.hash);
+	EVP_MD_CTX_free(out.hash);
+
+	return EXIT_SUCCESS;
+}
+
+
+
+static int apply_delta(const char *base_name, const char *delta_name)
+{
+	stream_t base;
+	stream_t delta;
+	stream_t out;
+	member_t member;
+	char **lines = NULL;
+	size_t nb_lines = 0;
+	char *expected_base = NULL;
+	char *expected_target = NULL;
+	char *padding = NULL;
+	uint8_t block[BLOCK_SIZE];
+	uint8_t digest[32];
+	char hex[65];
+	int r;
+
+	if (((delta.hash = new_digest()) == NULL) || ((base.hash = new_digest()) == NULL) || ((out.hash = new_digest()) == NULL))
+		return EXIT_BAD_INPUT;
+	if ((delta.fp = fopen(delta_name, "r")) == NULL)
+		return EXIT_BAD_INPUT;
+
+	// Manifest.
+	if ((read_member(&delta, &member, 0) != 0) || (strcmp(member.path, MANIFEST_NAME) != 0)
+	 || (member.data_blocks * BLOCK_SIZE > MANIFEST_MAX)) {
+		fprintf(stderr, "eris-slot-delta: missing delta manifest.\n");
+		return EXIT_BAD_INPUT;
+	}
+	char *manifest = malloc(member.data_blocks * BLOCK_SIZE + 1);
+	if (manifest == NULL)
+		return EXIT_BAD_INPUT;
+	for (size_t i = 0; i < member.data_blocks; i++)
+		if (read_block(&delta, (uint8_t *) manifest + i * BLOCK_SIZE) != 0)
+			return EXIT_BAD_INPUT;
+	manifest[member.data_blocks * BLOCK_SIZE] = '\0';
+	free_member(&member);
+
+	char *saveptr = NULL;
+	for (char *line = strtok_r(manifest, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
+		if (strncmp(line, "base=", 5) == 0)
+			expected_base = line + 5;
+		else if (strncmp(line, "target=", 7) == 0)
+			expected_target = line + 7;
+		else if (strncmp(line, "padding=", 8) == 0)
+			padding = line + 8;
+		else if ((strncmp(line, "keep=", 5) == 0) || (strncmp(line, "touch=", 6) == 0) || (strncmp(line, "add=", 4) == 0)) {
+			lines = realloc(lines, (nb_lines + 1) * sizeof(char *));
+			if (lines == NULL)
+				return EXIT_BAD_INPUT;
+			lines[nb_lines++] = line;
+		}
+	}
+	if ((expected_base == NULL) || (expected_target == NULL) || (padding == NULL)) {
+		fprintf(stderr, "eris-slot-delta: incomplete delta manifest.\n");
+		return EXIT_BAD_INPUT;
+	}
+
+	out.fp = stdout;
+
+	if ((base.fp = fopen(base_name, "r")) == NULL)
+		return EXIT_BAD_INPUT;
+
+	// Members of the new image, in its order.
+	for (size_t i = 0; i < nb_lines; i++) {
+		char *path = strchr(lines[i], '=') + 1;
+		if (lines[i][0] != 'a') {
+			member_t touched;
+			memset(&touched, 0, sizeof(touched));
+			if (lines[i][0] == 't') {
+				// New headers of the member, the data come from the base.
+				if ((read_member(&delta, &touched, 0) != 0) || (strcmp(touched.path, HEADERS_NAME) != 0)
+				 || (touched.data_blocks * BLOCK_SIZE > MANIFEST_MAX)) {
+					fprintf(stderr, "eris-slot-delta: the members of the delta don't match its manifest.\n");
+					return EXIT_BAD_INPUT;
+				}
+				touched.headers = realloc(touched.headers, touched.data_blocks * BLOCK_SIZE);
+				if (touched.headers == NULL)
+					return EXIT_BAD_INPUT;
+				for (touched.nb_headers = 0; touched.nb_headers < touched.data_blocks; touched.nb_headers++)
+					if (read_block(&delta, touched.headers + touched.nb_headers * BLOCK_SIZE) != 0)
+						return EXIT_BAD_INPUT;
+			}
+			// Drop the members of the base up to the kept one.
+			for (;;) {
+				if ((r = read_member(&base, &member, 0)) != 0) {
+					fprintf(stderr, "eris-slot-delta: the delta doesn't apply to this base image.\n");
+					return (r < 0) ? EXIT_BAD_INPUT : EXIT_BAD_BASE;
+				}
+				int keep = (strcmp(member.path, path) == 0);
+				if (keep && (write_headers(&out, (lines[i][0] == 't') ? &touched : &member) != 0))
+					return EXIT_BAD_INPUT;
+				if (copy_data(&base, keep ? &out : NULL, &member, 0) != 0)
+					return EXIT_BAD_INPUT;
+				free_member(&member);
+				if (keep)
+					break;
+			}
+			free_member(&touched);
+		} else {
+			if ((read_member(&delta, &member, 0) != 0) || (strcmp(member.path, path) != 0)) {
+				fprintf(stderr, "eris-slot-delta: the members of the delta don't match its manifest.\n");
+				return EXIT_BAD_INPUT;
+			}
+			if ((write_headers(&out, &member) != 0) || (copy_data(&delta, &out, &member, 0) != 0))
+				return EXIT_BAD_INPUT;
+			free_member(&member);
+		}
+	}
+	fclose(delta.fp);
+
+	memset(block, 0, sizeof(block));
+	for (unsigned long n = strtoul(padding, NULL, 10); n > 0; n--)
+		if (write_blocks(&out, block, 1) != 0)
+			return EXIT_BAD_INPUT;
+	if (fflush(stdout) != 0)
+		return EXIT_BAD_INPUT;
+
+	// Hash the rest of the base up to its end.
+	while ((r = read_block(&base, block)) == 0)
+		;
+	fclose(base.fp);
+	if (r < 0)
+		return EXIT_BAD_INPUT;
+	EVP_DigestFinal_ex(base.hash, digest, NULL);
+	to_hex(digest, hex);
+	if (strcmp(hex, expected_base) != 0) {
+		fprintf(stderr, "eris-slot-delta: the delta doesn't apply to this base image.\n");
+		return EXIT_BAD_BASE;
+	}
+
+	EVP_DigestFinal_ex(out.hash, digest, NULL);
+	to_hex(digest, hex);
+	if (strcmp(hex, expected_target) != 0) {
+		fprintf(stderr, "eris-slot-delta: the rebuilt image doesn't match the target digest.\n");
+		return EXIT_BAD_TARGET;
+	}
+	free(lines);
+	free(manifest);
+	EVP_MD_CTX_free(delta.hash);
+	EVP_MD_CTX_free(base.hash);
+	EVP_MD_CTX_free(out.hash);
+
+	return EXIT_SUCCESS;
+}
+
+
+
+// Read the headers of the next member. Return 0 on success, 1 at the end
+// of the archive, -1 on error. With compare, the digest of the member is
+// started (completed by copy_data()).
+static int read_member(stream_t *in, member_t *member, int compare)
+{
+	uint8_t block[BLOCK_SIZE];
+	char *long_name = NULL;
+	char *pax_path = NULL;
+	char *pax_size = NULL;
+
+	memset(member, 0, sizeof(member_t));
+
+	for (;;) {
+		int r = read_block(in, block);
+		if (r != 0)
+			return (r > 0) ? 1 : -1;
+
+		int empty = 1;
+		for (int i = 0; (i < BLOCK_SIZE) && empty; i++)
+			empty = (block[i] == 0);
+		if (empty && (member->nb_headers == 0))
+			return 1;
+
+		if (member->nb_headers == member->allocated) {
+			member->allocated = member->allocated * 2 + 4;
+			member->headers = realloc(member->headers, member->allocated * BLOCK_SIZE);
+			if (member->headers == NULL)
+				return -1;
+		}
+		memcpy(member->headers + member->nb_headers * BLOCK_SIZE, block, BLOCK_SIZE);
+		member->nb_headers++;
+
+		char type = block[156];
+		uint64_t size = parse_number(block + 124, 12);
+		size_t blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+		if ((type == 'L') || (type == 'K') || (type == 'x')) {
+			if (size > MANIFEST_MAX)
+				return -1;
+			// The extension data are part of the headers.
+			size_t first = member->nb_headers;
+			if (member->nb_headers + blocks > member->allocated) {
+				member->allocated = member->nb_headers + blocks + 4;
+				member->headers = realloc(member->headers, member->allocated * BLOCK_SIZE);
+				if (member->headers == NULL)
+					return -1;
+			}
+			for (size_t i = 0; i < blocks; i++)
+				if (read_block(in, member->headers + (first + i) * BLOCK_SIZE) != 0)
+					return -1;
+			member->nb_headers += blocks;
+			uint8_t *data = member->headers + first * BLOCK_SIZE;
+
+			if (type == 'x') {
+				free(pax_path);
+				free(pax_size);
+				pax_path = pax_value(data, size, "path");
+				pax_size = pax_value(data, size, "size");
+			} else if (type == 'L') {
+				free(long_name);
+				long_name = extension_string(data, size);
+			}
+			continue;
+		}
+
+		// Main header.
+		if (pax_size != NULL)
+			size = strtoull(pax_size, NULL, 10);
+		member->data_blocks = (type == '5') || (type == '1') || (type == '2') ? 0 : (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+		if (pax_path != NULL) {
+			member->path = pax_path;
+			pax_path = NULL;
+		} else if (long_name != NULL) {
+			member->path = long_name;
+			long_name = NULL;
+		} else {
+			char name[257];
+			if (memcmp(block + 257, "ustar", 5) == 0 && block[345] != '\0')
+				snprintf(name, sizeof(name), "%.155s/%.100s", (char *) block + 345, (char *) block);
+			else
+				snprintf(name, sizeof(name), "%.100s", (char *) block);
+			member->path = strdup(name);
+		}
+		free(long_name);
+		free(pax_path);
+		free(pax_size);
+		if (member->path == NULL)
+			return -1;
+		normalize_path(member->path);
+
+		if (compare) {
+			if (((member->running = new_digest()) == NULL) || ((member->matching = new_digest()) == NULL))
+				return -1;
+			EVP_DigestUpdate(member->running, member->headers, member->nb_headers * BLOCK_SIZE);
+			hash_match_headers(member);
+		}
+		return 0;
+	}
+}
+
+
+
+static int copy_data(stream_t *in, stream_t *out, member_t *member, int compare)
+{
+	uint8_t blocks[COPY_BLOCKS * BLOCK_SIZE];
+
+	size_t remaining = member->data_blocks;
+	while (remaining > 0) {
+		size_t n = (remaining > COPY_BLOCKS) ? COPY_BLOCKS : remaining;
+		for (size_t i = 0; i < n; i++)
+			if (read_block(in, blocks + i * BLOCK_SIZE) != 0)
+				return -1;
+		if (compare) {
+			EVP_DigestUpdate(member->running, blocks, n * BLOCK_SIZE);
+			EVP_DigestUpdate(member->matching, blocks, n * BLOCK_SIZE);
+		}
+		if ((out != NULL) && (write_blocks(out, blocks, n) != 0))
+			return -1;
+		remaining -= n;
+	}
+
+	if (compare) {
+		EVP_DigestFinal_ex(member->running, member->digest, NULL);
+		EVP_DigestFinal_ex(member->matching, member->match, NULL);
+	}
+	return 0;
+}
+
+
+
+static int write_headers(stream_t *out, const member_t *member)
+{
+	return write_blocks(out, member->headers, member->nb_headers);
+}
+
+
+
+// Hash the headers without the mtime and checksum fields, nor the time
+// records and the name and size of the pax headers (which depend on them).
+static void hash_match_headers(member_t *member)
+{
+	uint8_t block[BLOCK_SIZE];
+	size_t i = 0;
+
+	while (i < member->nb_headers) {
+		memcpy(block, member->headers + i * BLOCK_SIZE, BLOCK_SIZE);
+		char type = block[156];
+		uint64_t size = parse_number(block + 124, 12);
+		memset(block + 136, 0, 20);
+		if (type == 'x') {
+			memset(block, 0, 100);
+			memset(block + 124, 0, 12);
+		}
+		EVP_DigestUpdate(member->matching, block, BLOCK_SIZE);
+		i++;
+		if ((type != 'L') && (type != 'K') && (type != 'x'))
+			continue;
+
+		const uint8_t *data = member->headers + i * BLOCK_SIZE;
+		i += (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		if (type != 'x') {
+			EVP_DigestUpdate(member->matching, data, size);
+			continue;
+		}
+		// Pax records: "<length> <key>=<value>\n".
+		size_t pos = 0;
+		while (pos < size) {
+			char *end;
+			unsigned long length = strtoul((const char *) data + pos, &end, 10);
+			if ((length == 0) || (pos + length > size) || (*end != ' ')) {
+				EVP_DigestUpdate(member->matching, data + pos, size - pos);
+				break;
+			}
+			if ((strncmp(end + 1, "mtime=", 6) != 0) && (strncmp(end + 1, "atime=", 6) != 0)
+			 && (strncmp(end + 1, "ctime=", 6) != 0))
+				EVP_DigestUpdate(member->matching, end + 1, length - (end + 1 - ((const char *) data + pos)));
+			pos += length;
+		}
+	}
+}
+
+
+
+// Ustar header of a regular file owned by root.
+static void make_header(uint8_t *header, const char *name, size_t size)
+{
+	memset(header, 0, BLOCK_SIZE);
+	strcpy((char *) header, name);
+	sprintf((char *) header + 100, "%07o", 0644);
+	sprintf((char *) header + 108, "%07o", 0);
+	sprintf((char *) header + 116, "%07o", 0);
+	sprintf((char *) header + 124, "%011zo", size);
+	sprintf((char *) header + 136, "%011o", 0);
+	header[156] = '0';
+	memcpy(header + 257, "ustar\0" "00", 8);
+	memset(header + 148, ' ', 8);
+	unsigned int checksum = 0;
+	for (int i = 0; i < BLOCK_SIZE; i++)
+		checksum += header[i];
+	sprintf((char *) header + 148, "%06o", checksum);
+	header[155] = ' ';
+}
+
+
+
+static void free_member(member_t *member)
+{
+	free(member->headers);
+	free(member->path);
+	EVP_MD_CTX_free(member->running);
+	EVP_MD_CTX_free(member->matching);
+	memset(member, 0, sizeof(member_t));
+}
+
+
+
+// Return 0 on success, 1 at end of file, -1 on error.
+static int read_block(stream_t *in, uint8_t *block)
+{
+	size_t n = fread(block, 1, BLOCK_SIZE, in->fp);
+	if (n == 0)
+		return feof(in->fp) ? 1 : -1;
+	if (n != BLOCK_SIZE)
+		return -1;
+	EVP_DigestUpdate(in->hash, block, BLOCK_SIZE);
+	return 0;
+}
+
+
+
+static int write_blocks(stream_t *out, const void *data, size_t nb_blocks)
+{
+	EVP_DigestUpdate(out->hash, data, nb_blocks * BLOCK_SIZE);
+	if (out->fp == NULL)
+		return 0;
+	return (fwrite(data, BLOCK_SIZE, nb_blocks, out->fp) == nb_blocks) ? 0 : -1;
+}
+
+
+
+static int write_end_of_archive(stream_t *out)
+{
+	uint8_t zeros[2 * BLOCK_SIZE];
+
+	memset(zeros, 0, sizeof(zeros));
+	return write_blocks(out, zeros, 2);
+}
+
+
+
+static int is_zero_block(const uint8_t *block)
+{
+	for (int i = 0; i < BLOCK_SIZE; i++)
+		if (block[i] != 0)
+			return 0;
+	return 1;
+}
+
+
+
+static int hash_file(const char *name, uint8_t digest[32])
+{
+	uint8_t buffer[COPY_BLOCKS * BLOCK_SIZE];
+	size_t n;
+
+	EVP_MD_CTX *ctx = new_digest();
+	if (ctx == NULL)
+		return -1;
+	FILE *fp = fopen(name, "r");
+	if (fp == NULL) {
+		EVP_MD_CTX_free(ctx);
+		return -1;
+	}
+	while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+		EVP_DigestUpdate(ctx, buffer, n);
+	int err = ferror(fp);
+	fclose(fp);
+	EVP_DigestFinal_ex(ctx, digest, NULL);
+	EVP_MD_CTX_free(ctx);
+	return err ? -1 : 0;
+}
+
+
+
+// Octal, or base-256 if the high bit of the first byte is set.
+static uint64_t parse_number(const uint8_t *field, size_t length)
+{
+	uint64_t value = 0;
+
+	if (field[0] & 0x80) {
+		for (size_t i = 1; i < length; i++)
+			value = (value << 8) | field[i];
+		return value;
+	}
+	for (size_t i = 0; i < length; i++) {
+		if ((field[i] >= '0') && (field[i] <= '7'))
+			value = value * 8 + (field[i] - '0');
+		else if ((field[i] != ' ') || (value != 0))
+			break;
+	}
+	return value;
+}
+
+
+
+static char *extension_string(const uint8_t *data, size_t size)
+{
+	char *string = malloc(size + 1);
+	if (string == NULL)
+		return NULL;
+	memcpy(string, data, size);
+	string[size] = '\0';
+	return string;
+}
+
+
+
+// Pax records: "<length> <key>=<value>\n".
+static char *pax_value(const uint8_t *data, size_t size, const char *key)
+{
+	size_t pos = 0;
+	size_t key_length = strlen(key);
+
+	while (pos < size) {
+		char *end;
+		unsigned long length = strtoul((const char *) data + pos, &end, 10);
+		if ((length == 0) || (pos + length > size) || (*end != ' '))
+			return NULL;
+		const char *record = end + 1;
+		const char *record_end = (const char *) data + pos + length - 1;
+		if ((strncmp(record, key, key_length) == 0) && (record[key_length] == '=')) {
+			const char *value = record + key_length + 1;
+			return strndup(value, record_end - value);
+		}
+		pos += length;
+	}
+	return NULL;
+}
+
+
+
+// "./usr/bin/" and "usr/bin" designate the same member.
+static char *normalize_path(char *path)
+{
+	size_t start = 0;
+
+	while ((path[start] == '.') && (path[start + 1] == '/'))
+		start += 2;
+	while (path[start] == '/')
+		start++;
+	memmove(path, path + start, strlen(path + start) + 1);
+
+	size_t length = strlen(path);
+	while ((length > 0) && (path[length - 1] == '/'))
+		path[--length] = '\0';
+	return path;
+}
+
+
+
+// By path, then by position for the paths present several times.
+static int compare_entries(const void *a, const void *b)
+{
+	const index_entry_t *x = a;
+	const index_entry_t *y = b;
+
+	int diff = strcmp(x->path, y->path);
+	if (diff != 0)
+		return diff;
+	return (x->position > y->position) - (x->position < y->position);
+}
+
+
+
+// First member of the sorted index with this path and match digest, at or
+// after the given position.
+static index_entry_t *find_entry(index_entry_t *index, size_t nb, const char *path, size_t position, const uint8_t match[32])
+{
+	size_t low = 0;
+	size_t high = nb;
+
+	while (low < high) {
+		size_t middle = (low + high) / 2;
+		if (strcmp(index[middle].path, path) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	for (; (low < nb) && (strcmp(index[low].path, path) == 0); low++)
+		if ((index[low].position >= position) && (memcmp(index[low].match, match, 32) == 0))
+			return &(index[low]);
+	return NULL;
+}
+
+
+
+static void to_hex(const uint8_t digest[32], char hex[65])
+{
+	for (int i = 0; i < 32; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+
+
+static EVP_MD_CTX *new_digest(void)
+{
+	EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+	if ((ctx != NULL) && (EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) != 1)) {
+		EVP_MD_CTX_free(ctx);
+		ctx = NULL;
+	}
+	return ctx;
+}
@@ -0,0 +1,288 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "block-delta.h"
+
+
+// ---------------------- Private method declarations.
+
+static int       run_record         (block_delta_t *delta);
+static int       parse_header       (block_delta_t *delta);
+static int       read_source_block  (block_delta_t *delta, uint64_t index);
+static int       emit_target        (block_delta_t *delta, const unsigned char *data, size_t length);
+static uint32_t  get_le32           (const unsigned char *p);
+static uint64_t  get_le64           (const unsigned char *p);
+
+
+// ---------------------- Public methods
+
+int block_delta_init(block_delta_t *delta, int source_fd, block_delta_output_t output)
+{
+	memset(delta, 0, sizeof(*delta));
+	delta->source_fd = source_fd;
+	delta->output = output;
+	delta->pending_needed = BLOCK_DELTA_HEADER_SIZE;
+
+	delta->digest = EVP_MD_CTX_new();
+	if ((delta->digest == NULL) || (EVP_DigestInit_ex(delta->digest, EVP_sha256(), NULL) != 1)) {
+		snprintf(delta->error, sizeof(delta->error), "Unable to initialize the digest.");
+		return -1;
+	}
+	return 0;
+}
+
+
+
+// The payload may be given in pieces of any size.
+int block_delta_feed(block_delta_t *delta, const unsigned char *data, size_t length)
+{
+	size_t pos = 0;
+
+	while (pos < length) {
+		if (delta->error[0] != '\0')
+			return -1;
+		if (delta->ended) {
+			snprintf(delta->error, sizeof(delta->error), "Data after the end of the delta.");
+			return -1;
+		}
+
+		if (delta->data_left > 0) {
+			size_t n = length - pos;
+			if (n > delta->data_left)
+				n = delta->data_left;
+			if (emit_target(delta, data + pos, n) != 0)
+				return -1;
+			delta->data_left -= n;
+			pos += n;
+			continue;
+		}
+
+		// Type of the next record.
+		if (delta->pending_needed == 0) {
+			delta->op = data[pos++];
+			delta->pending_length = 0;
+			switch (delta->op) {
+				case BLOCK_DELTA_COPY:
+					delta->pending_needed = 12;
+					break;
+				case BLOCK_DELTA_DATA:
+				case BLOCK_DELTA_ZERO:
+					delta->pending_needed = 4;
+					break;
+				case BLOCK_DELTA_END:
+					delta->ended = 1;
+					break;
+				default:
+					snprintf(delta->error, sizeof(delta->error), "Invalid record in the delta.");
+					return -1;
+			}
+			continue;
+		}
+
+		// Header or arguments of the record.
+		size_t n = delta->pending_needed - delta->pending_length;
+		if (n > length - pos)
+			n = length - pos;
+		memcpy(delta->pending + delta->pending_length, data + pos, n);
+		delta->pending_length += n;
+		pos += n;
+		if (delta->pending_length < delta->pending_needed)
+			continue;
+		delta->pending_needed = 0;
+		if (run_record(delta) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+
+
+int block_delta_finish(block_delta_t *delta)
+{
+	unsigned char digest[32];
+	unsigned int length = sizeof(digest);
+
+	if (delta->error[0] != '\0')
+		return -1;
+	if ((! delta->ended) || (delta->data_left > 0)) {
+		snprintf(delta->error, sizeof(delta->error), "Truncated delta.");
+		return -1;
+	}
+	if (delta->written < delta->target_size) {
+		snprintf(delta->error, sizeof(delta->error), "The delta doesn't build the whole target.");
+		return -1;
+	}
+	if ((EVP_DigestFinal_ex(delta->digest, digest, &length) != 1)
+	 || (memcmp(digest, delta->target_digest, sizeof(digest)) != 0)) {
+		snprintf(delta->error, sizeof(delta->error), "The delta doesn't match the running system.");
+		return -1;
+	}
+	return 0;
+}
+
+
+
+void block_delta_release(block_delta_t *delta)
+{
+	if (delta->digest != NULL)
+		EVP_MD_CTX_free(delta->digest);
+	delta->digest = NULL;
+	free(delta->block);
+	delta->block = NULL;
+}
+
+
+
+int is_block_delta(const unsigned char *data, size_t length)
+{
+	return (length >= strlen(BLOCK_DELTA_MAGIC)) && (memcmp(data, BLOCK_DELTA_MAGIC, strlen(BLOCK_DELTA_MAGIC)) == 0);
+}
+
+
+// ---------------------- Private methods
+
+static int run_record(block_delta_t *delta)
+{
+	if (delta->op == 0)
+		return parse_header(delta);
+
+	if (delta->op == BLOCK_DELTA_DATA) {
+		delta->data_left = (uint64_t) get_le32(delta->pending) * delta->block_size;
+		return 0;
+	}
+
+	if (delta->op == BLOCK_DELTA_ZERO) {
+		uint32_t count = get_le32(delta->pending);
+		memset(delta->block, 0, delta->block_size);
+		for (uint32_t i = 0; i < count; i++)
+			if (emit_target(delta, delta->block, delta->block_size) != 0)
+				return -1;
+		return 0;
+	}
+
+	// BLOCK_DELTA_COPY
+	uint64_t first = get_le64(delta->pending);
+	uint32_t count = get_le32(delta->pending + 8);
+	for (uint32_t i = 0; i < count; i++) {
+		if (read_source_block(delta, first + i) != 0)
+			return -1;
+		if (emit_target(delta, delta->block, delta->block_size) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+
+
+static int parse_header(block_delta_t *delta)
+{
+	const unsigned char *h = delta->pending;
+
+	if (! is_block_delta(h, BLOCK_DELTA_HEADER_SIZE)) {
+		snprintf(delta->error, sizeof(delta->error), "Not a block delta.");
+		return -1;
+	}
+	delta->block_size  = get_le32(h + 8);
+	delta->source_size = get_le64(h + 16);
+	delta->target_size = get_le64(h + 24);
+	memcpy(delta->target_digest, h + 32, 32);
+
+	if ((delta->block_size < BLOCK_DELTA_MIN_BLOCK) || (delta->block_size > BLOCK_DELTA_MAX_BLOCK)) {
+		snprintf(delta->error, sizeof(delta->error), "Invalid block size in the delta.");
+		return -1;
+	}
+	delta->block = malloc(delta->block_size);
+	if (delta->block == NULL) {
+		snprintf(delta->error, sizeof(delta->error), "Not enough memory.");
+		return -1;
+	}
+	// The records follow.
+	delta->op = 0;
+	delta->pending_needed = 0;
+	return 0;
+}
+
+
+
+// The last block of the source is padded with zeros: the partition holding
+// the source is usually larger than its image.
+static int read_source_block(block_delta_t *delta, uint64_t index)
+{
+	uint64_t offset = index * delta->block_size;
+
+	if ((index >= UINT64_MAX / delta->block_size) || (offset >= delta->source_size)) {
+		snprintf(delta->error, sizeof(delta->error), "Copy outside of the source.");
+		return -1;
+	}
+	size_t length = delta->block_size;
+	if (length > delta->source_size - offset)
+		length = delta->source_size - offset;
+
+	size_t done = 0;
+	while (done < length) {
+		ssize_t n = pread(delta->source_fd, delta->block + done, length - done, offset + done);
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0) {
+			snprintf(delta->error, sizeof(delta->error), "Unable to read the source of the delta.");
+			return -1;
+		}
+		done += n;
+	}
+	memset(delta->block + length, 0, delta->block_size - length);
+	return 0;
+}
+
+
+
+// Only the target size is given to the output, the padding of its last
+// block is dropped.
+static int emit_target(block_delta_t *delta, const unsigned char *data, size_t length)
+{
+	uint64_t padded = (delta->target_size + delta->block_size - 1) / delta->block_size * delta->block_size;
+
+	if (delta->written + length > padded) {
+		snprintf(delta->error, sizeof(delta->error), "The delta is larger than its target.");
+		return -1;
+	}
+	size_t useful = length;
+	if (delta->written >= delta->target_size)
+		useful = 0;
+	else if (useful > delta->target_size - delta->written)
+		useful = delta->target_size - delta->written;
+	delta->written += length;
+
+	if (useful == 0)
+		return 0;
+	EVP_DigestUpdate(delta->digest, data, useful);
+	if (delta->output(data, useful) != 0) {
+		if (delta->error[0] == '\0')
+			snprintf(delta->error, sizeof(delta->error), "Unable to write the target of the delta.");
+		return -1;
+	}
+	return 0;
+}
+
+
+
+static uint32_t get_le32(const unsigned char *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+
+
+static uint64_t get_le64(const unsigned char *p)
+{
+	return (uint64_t) get_le32(p) | ((uint64_t) get_le32(p + 4) << 32);
+}
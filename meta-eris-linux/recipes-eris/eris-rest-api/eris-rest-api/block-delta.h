@@ -0,0 +1,80 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef BLOCK_DELTA_H
+#define BLOCK_DELTA_H
+
+	#include <stddef.h>
+	#include <stdint.h>
+
+	#include <openssl/evp.h>
+
+	// Block delta of a system partition, created by eris-block-delta from
+	// the previous image (source) and the new one (target). The payload
+	// starts with a header (little-endian):
+	//
+	//   "ERISBDL1" <block size u32> <0 u32> <source size u64>
+	//   <target size u64> <SHA-256 of the target, 32 bytes>
+	//
+	// followed by records building the target from its beginning:
+	//
+	//   'C' <source block u64> <count u32>   copy blocks of the source,
+	//   'D' <count u32> <count blocks>       new blocks,
+	//   'Z' <count u32>                      zero blocks,
+	//   'E'                                  end of the delta.
+	//
+	// The last block of the source and of the target are padded with zeros.
+
+	#define BLOCK_DELTA_MAGIC        "ERISBDL1"
+	#define BLOCK_DELTA_HEADER_SIZE  64
+	#define BLOCK_DELTA_MIN_BLOCK    512
+	#define BLOCK_DELTA_MAX_BLOCK    (1024 * 1024)
+
+	#define BLOCK_DELTA_COPY         'C'
+	#define BLOCK_DELTA_DATA         'D'
+	#define BLOCK_DELTA_ZERO         'Z'
+	#define BLOCK_DELTA_END          'E'
+
+	typedef int (*block_delta_output_t)(const unsigned char *data, size_t length);
+
+	typedef struct {
+
+		int                    source_fd;
+		block_delta_output_t   output;
+
+		uint32_t               block_size;
+		uint64_t               source_size;
+		uint64_t               target_size;
+		unsigned char          target_digest[32];
+
+		uint64_t               written;      // Bytes of the target given to output.
+		EVP_MD_CTX            *digest;
+		unsigned char         *block;
+
+		// Parser: header or arguments of the current record being received.
+		unsigned char          pending[BLOCK_DELTA_HEADER_SIZE];
+		size_t                 pending_length;
+		size_t                 pending_needed;
+		int                    op;           // 0 while reading the header.
+		uint64_t               data_left;    // Bytes of a 'D' record still to come.
+		int                    ended;
+
+		char                   error[128];
+
+	} block_delta_t;
+
+	// The source fd is the partition (or image) the delta was made against.
+	int  block_delta_init    (block_delta_t *delta, int source_fd, block_delta_output_t output);
+	int  block_delta_feed    (block_delta_t *delta, const unsigned char *data, size_t length);
+	// Check that the whole target was built, with the expected digest.
+	int  block_delta_finish  (block_delta_t *delta);
+	void block_delta_release (block_delta_t *delta);
+
+	// Is this the beginning of a block delta?
+	int  is_block_delta      (const unsigned char *data, size_t length);
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "container-cgroup.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define CONTAINER_ID_LENGTH   80
+
+// Only at the root of a cgroup v2 (unified) hierarchy.
+#define CGROUP_V2_PROBE       CONTAINER_CGROUP_ROOT "/cgroup.controllers"
+// Limits of cgroup v1 above this value mean "no limit".
+#define CGROUP_V1_UNLIMITED   (1ULL << 62)
+
+
+// ---------------------- Private method declarations.
+
+static int read_container_id  (int slot, char *cid, size_t size);
+static int read_first_line    (const char *path, char *value, size_t size);
+
+
+// ---------------------- Private variables declarations.
+
+// Files of cgroup v1 matching the files of cgroup v2.
+static const struct {
+	const char *name;
+	const char *v1_name;
+} v1_files[] = {
+	{ "cpu.stat",              "cpuacct.usage"         },
+	{ "cpu.max",               "cpu.cfs_quota_us"      },
+	{ "cpu.weight",            "cpu.shares"            },
+	{ "cpuset.cpus.effective", "cpuset.effective_cpus" },
+	{ "cpuset.cpus",           "cpuset.cpus"           },
+	{ "memory.current",        "memory.usage_in_bytes" },
+	{ "memory.max",            "memory.limit_in_bytes" },
+	{ "pids.current",          "pids.current"          },
+	{ "pids.max",              "pids.max"              },
+	{ NULL,                    NULL                    },
+};
+
+
+// ---------------------- Public methods
+
+int container_cgroup(int slot, container_cgroup_t *cgroup)
+{
+	char cid[CONTAINER_ID_LENGTH];
+	char probe[512];
+
+	if (read_container_id(slot, cid, sizeof(cid)) != 0)
+		return -1;
+
+	cgroup->version = (access(CGROUP_V2_PROBE, F_OK) == 0) ? 2 : 1;
+
+	// cgroupfs driver of dockerd, then systemd driver.
+	const char *layouts[] = { "docker/%s", "system.slice/docker-%s.scope", NULL };
+	for (int i = 0; layouts[i] != NULL; i++) {
+		snprintf(cgroup->path, sizeof(cgroup->path), layouts[i], cid);
+		cgroup_file_path(cgroup, cgroup->version == 2 ? "cgroup.procs" : "cpu.shares", probe, sizeof(probe));
+		if (access(probe, R_OK) == 0)
+			return 0;
+	}
+	cgroup->path[0] = '\0';
+	return -1;
+}
+
+
+
+void cgroup_file_path(const container_cgroup_t *cgroup, const char *name, char *path, size_t size)
+{
+	if (cgroup->version == 2) {
+		snprintf(path, size, "%s/%s/%s", CONTAINER_CGROUP_ROOT, cgroup->path, name);
+		return;
+	}
+	// "memory.stat" is in /sys/fs/cgroup/memory/<cgroup>/.
+	int controller = strcspn(name, ".");
+	snprintf(path, size, "%s/%.*s/%s/%s", CONTAINER_CGROUP_ROOT, controller, name, cgroup->path, name);
+}
+
+
+
+int read_cgroup_file(const container_cgroup_t *cgroup, const char *name, char *value, size_t size)
+{
+	char path[512];
+	char period[32];
+	int i;
+
+	if (cgroup->version == 2) {
+		cgroup_file_path(cgroup, name, path, sizeof(path));
+		return read_first_line(path, value, size);
+	}
+
+	for (i = 0; v1_files[i].name != NULL; i++)
+		if (strcmp(v1_files[i].name, name) == 0)
+			break;
+	if (v1_files[i].name == NULL)
+		return -1;
+	cgroup_file_path(cgroup, v1_files[i].v1_name, path, sizeof(path));
+	if (read_first_line(path, value, size) != 0)
+		return -1;
+
+	if (strcmp(name, "cpu.stat") == 0) {
+		// Nanoseconds.
+		snprintf(value, size, "usage_usec %llu", strtoull(value, NULL, 10) / 1000);
+	} else if (strcmp(name, "cpu.max") == 0) {
+		cgroup_file_path(cgroup, "cpu.cfs_period_us", path, sizeof(path));
+		if (read_first_line(path, period, sizeof(period)) != 0)
+			return -1;
+		if (atoll(value) < 0)
+			snprintf(value, size, "max %s", period);
+		else
+			snprintf(value + strlen(value), size - strlen(value), " %s", period);
+	} else if (strcmp(name, "cpu.weight") == 0) {
+		// Conversion of the shares (2 to 262144) used by the OCI runtimes.
+		unsigned long long shares = strtoull(value, NULL, 10);
+		if (shares < 2)
+			shares = 2;
+		snprintf(value, size, "%llu", 1 + ((shares - 2) * 9999) / 262142);
+	} else if (strcmp(name, "memory.max") == 0) {
+		if (strtoull(value, NULL, 10) >= CGROUP_V1_UNLIMITED)
+			snprintf(value, size, "max");
+	}
+	return 0;
+}
+
+
+// ---------------------- Private methods
+
+// Written by docker run (--cidfile) when start-containers runs the slot.
+static int read_container_id(int slot, char *cid, size_t size)
+{
+	char path[256];
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.cid", CONTAINER_SLOTS_DIR, slot + 1);
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	if (fgets(cid, size, fp) == NULL)
+		cid[0] = '\0';
+	fclose(fp);
+
+	cid[strcspn(cid, "\r\n ")] = '\0';
+	return ((cid[0] != '\0') && (strchr(cid, '/') == NULL)) ? 0 : -1;
+}
+
+
+
+static int read_first_line(const char *path, char *value, size_t size)
+{
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	if (fgets(value, size, fp) == NULL) {
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+	value[strcspn(value, "\n")] = '\0';
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef CONTAINER_CGROUP_H
+#define CONTAINER_CGROUP_H
+
+	#include <stddef.h>
+
+	#define CONTAINER_SLOTS_DIR     "/data/containers"
+	#define CONTAINER_CGROUP_ROOT   "/sys/fs/cgroup"
+
+	typedef struct {
+
+		int   version;      // 2 (unified hierarchy) or 1.
+		char  path[256];    // Below the root of the hierarchy (of each controller with cgroup v1).
+
+	} container_cgroup_t;
+
+	// Find the cgroup of the container running in the slot (numbered from 0).
+	// Return 0 on success, -1 if the slot has no container.
+	int  container_cgroup(int slot, container_cgroup_t *cgroup);
+
+	// Path of a file of the cgroup. With cgroup v1, the file is in the
+	// hierarchy of the controller prefixing its name.
+	void cgroup_file_path(const container_cgroup_t *cgroup, const char *name, char *path, size_t size);
+
+	// Read the first line of a file of the cgroup, without its newline. The
+	// file is named as with cgroup v2: with cgroup v1, the matching file is
+	// read and its value given in the format of cgroup v2.
+	int  read_cgroup_file(const container_cgroup_t *cgroup, const char *name, char *value, size_t size);
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "container-logs.h"
+#include "eris-rest-api.h"
+
+
+// ---------------------- Private macros declarations.
+
+// Layout of the ring files, see container-log.h in eris-containers.
+#define LOG_RING_MAGIC           "ERISLOG1"
+#define LOG_RING_DATA_OFFSET     64
+
+#define LOGS_WATCH_EVENTS        (IN_MODIFY | IN_CREATE)
+#define LOGS_RETRY_DELAY_S       5
+// The suspended connections don't see their client going away.
+#define LOGS_IDLE_RESUME_MS      30000
+
+#define LOGS_BLOCK_SIZE          4096
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	char      magic[8];
+	uint64_t  capacity;
+	uint64_t  written;
+	uint64_t  dropped;
+	uint64_t  spilled;
+
+} log_ring_header_t;
+
+
+typedef struct log_follower {
+
+	struct MHD_Connection  *connection;
+	int                     slot;
+	int                     fd;           // Ring of the slot, -1 until it exists.
+	uint64_t                offset;       // Next byte to send.
+	int                     started;
+	int                     suspended;
+
+	struct log_follower    *next;
+
+} log_follower_t;
+
+
+// ---------------------- Private method declarations.
+
+static void    *container_logs_thread   (void *arg);
+static void     resume_followers        (int slot);
+static ssize_t  read_follower           (void *cls, uint64_t pos, char *buffer, size_t max);
+static void     free_follower           (void *cls);
+static int      open_ring               (log_follower_t *follower);
+static ssize_t  read_ring               (log_follower_t *follower, char *buffer, size_t max);
+static int      read_ring_header        (int fd, log_ring_header_t *header);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t  logs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static log_follower_t  *log_followers = NULL;
+
+static pthread_t        logs_thread;
+static int              logs_running = 0;
+
+
+// ---------------------- Public methods
+
+int start_container_logs(void)
+{
+	if (logs_running)
+		return 0;
+
+	mkdir(CONTAINER_LOGS_DIR, 0755);
+
+	logs_running = 1;
+	if (pthread_create(&logs_thread, NULL, container_logs_thread, NULL) != 0) {
+		logs_running = 0;
+		return -1;
+	}
+	pthread_detach(logs_thread);
+	return 0;
+}
+
+
+
+enum MHD_Result send_container_logs(struct MHD_Connection *connection, int slot, int follow)
+{
+	log_follower_t *follower = calloc(1, sizeof(log_follower_t));
+	if (follower == NULL)
+		return send_rest_error(connection, "Not enough memory.", 500);
+	follower->connection = connection;
+	follower->slot = slot;
+	follower->fd = -1;
+
+	if ((open_ring(follower) != 0) && (! follow)) {
+		free(follower);
+		return send_rest_error(connection, "No log for this container.", 404);
+	}
+
+	if (! follow) {
+		log_ring_header_t header;
+		char *reply = NULL;
+		size_t pos = 0;
+		enum MHD_Result ret;
+
+		// A snapshot up to the end of the ring at the time of the request.
+		if (read_ring_header(follower->fd, &header) == 0) {
+			reply = malloc(header.capacity);
+			while ((reply != NULL) && (follower->offset < header.written)) {
+				size_t max = header.written - follower->offset;
+				if (max > header.capacity - pos)
+					max = header.capacity - pos;
+				ssize_t n = read_ring(follower, reply + pos, max);
+				if (n <= 0)
+					break;
+				pos += n;
+			}
+		}
+		if (reply != NULL) {
+			struct MHD_Response *response = MHD_create_response_from_buffer(pos, reply, MHD_RESPMEM_MUST_FREE);
+			ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+			MHD_destroy_response(response);
+		} else {
+			ret = send_rest_error(connection, "Unable to read the log of the container.", 500);
+		}
+		close(follower->fd);
+		free(follower);
+		return ret;
+	}
+
+	struct MHD_Response *response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, LOGS_BLOCK_SIZE,
+	                                                                  read_follower, follower, free_follower);
+	if (response == NULL) {
+		if (follower->fd >= 0)
+			close(follower->fd);
+		free(follower);
+		return send_rest_error(connection, "Not enough memory.", 500);
+	}
+	pthread_mutex_lock(&logs_mutex);
+	follower->next = log_followers;
+	log_followers = follower;
+	pthread_mutex_unlock(&logs_mutex);
+
+	enum MHD_Result ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+	MHD_destroy_response(response);
+	return ret;
+}
+
+
+// ---------------------- Private methods
+
+// The supervisor writes the rings with pwrite(): each line is an IN_MODIFY
+// event of the directory, waking the followers of the slot up.
+static void *container_logs_thread(void *arg)
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	(void) arg;
+
+	for (;;) {
+		int fd = inotify_init1(IN_CLOEXEC);
+		if (fd < 0) {
+			sleep(LOGS_RETRY_DELAY_S);
+			continue;
+		}
+		if (inotify_add_watch(fd, CONTAINER_LOGS_DIR, LOGS_WATCH_EVENTS) < 0) {
+			close(fd);
+			sleep(LOGS_RETRY_DELAY_S);
+			mkdir(CONTAINER_LOGS_DIR, 0755);
+			continue;
+		}
+		// A ring may have been written before the watch was set.
+		resume_followers(-1);
+
+		int watching = 1;
+		while (watching) {
+			struct pollfd pfd = { .fd = fd, .events = POLLIN };
+			int err = poll(&pfd, 1, LOGS_IDLE_RESUME_MS);
+			if ((err < 0) && (errno == EINTR))
+				continue;
+			if (err < 0)
+				break;
+			if (err == 0) {
+				resume_followers(-1);
+				continue;
+			}
+			ssize_t n = read(fd, buffer, sizeof(buffer));
+			if ((n < 0) && (errno == EINTR))
+				continue;
+			if (n <= 0)
+				break;
+
+			int modified[CONTAINER_LOGS_SLOTS] = { 0 };
+			for (char *p = buffer; p < buffer + n; ) {
+				struct inotify_event *event = (struct inotify_event *) p;
+				int slot;
+				char end;
+				if (event->mask & (IN_IGNORED | IN_Q_OVERFLOW))
+					watching = 0;
+				if ((event->len > 0) && (sscanf(event->name, "slot-%d.lo%c", &slot, &end) == 2)
+				 && (end == 'g') && (slot >= 1) && (slot <= CONTAINER_LOGS_SLOTS))
+					modified[slot - 1] = 1;
+				p += sizeof(struct inotify_event) + event->len;
+			}
+			for (int slot = 0; slot < CONTAINER_LOGS_SLOTS; slot++)
+				if (modified[slot] || (! watching))
+					resume_followers(slot);
+		}
+		close(fd);
+	}
+	return NULL;
+}
+
+
+
+// All the slots if slot is -1.
+static void resume_followers(int slot)
+{
+	pthread_mutex_lock(&logs_mutex);
+	for (log_follower_t *f = log_followers; f != NULL; f = f->next) {
+		if (f->suspended && ((slot < 0) || (f->slot == slot))) {
+			f->suspended = 0;
+			MHD_resume_connection(f->connection);
+		}
+	}
+	pthread_mutex_unlock(&logs_mutex);
+}
+
+
+
+// Content reader of the follow replies, called by the MHD thread.
+static ssize_t read_follower(void *cls, uint64_t pos, char *buffer, size_t max)
+{
+	log_follower_t *follower = cls;
+
+	(void) pos;
+
+	ssize_t n = read_ring(follower, buffer, max);
+	if (n != 0)
+		return (n > 0) ? n : MHD_CONTENT_READER_END_WITH_ERROR;
+
+	// Nothing to send: suspended until the ring is written. The check is
+	// done again under the lock, the thread resuming the connections with it.
+	pthread_mutex_lock(&logs_mutex);
+	n = read_ring(follower, buffer, max);
+	if (n == 0) {
+		MHD_suspend_connection(follower->connection);
+		follower->suspended = 1;
+	}
+	pthread_mutex_unlock(&logs_mutex);
+
+	if (n < 0)
+		return MHD_CONTENT_READER_END_WITH_ERROR;
+	return n;
+}
+
+
+
+static void free_follower(void *cls)
+{
+	log_follower_t *follower = cls;
+	log_follower_t **prev;
+
+	pthread_mutex_lock(&logs_mutex);
+	for (prev = &log_followers; *prev != NULL; prev = &((*prev)->next)) {
+		if (*prev == follower) {
+			*prev = follower->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&logs_mutex);
+
+	if (follower->fd >= 0)
+		close(follower->fd);
+	free(follower);
+}
+
+
+
+static int open_ring(log_follower_t *follower)
+{
+	char path[256];
+
+	if (follower->fd >= 0)
+		return 0;
+
+	snprintf(path, sizeof(path), "%s/slot-%d.log", CONTAINER_LOGS_DIR, follower->slot + 1);
+	follower->fd = open(path, O_RDONLY | O_CLOEXEC);
+	return (follower->fd >= 0) ? 0 : -1;
+}
+
+
+
+// Return the number of bytes read, 0 if nothing new, -1 on error. The
+// first read starts at the oldest complete line of the ring.
+static ssize_t read_ring(log_follower_t *follower, char *buffer, size_t max)
+{
+	log_ring_header_t header;
+
+	if (open_ring(follower) != 0)
+		return 0;
+
+	for (;;) {
+		if (read_ring_header(follower->fd, &header) != 0)
+			return 0;
+
+		uint64_t oldest = (header.written > header.capacity) ? header.written - header.capacity : 0;
+		// Lines lost by a slow client, or ring created again.
+		if ((follower->offset < oldest) || (follower->offset > header.written)) {
+			follower->offset = oldest;
+			follower->started = 0;
+		}
+		if (follower->offset >= header.written)
+			return 0;
+
+		size_t n = header.written - follower->offset;
+		uint64_t index = follower->offset % header.capacity;
+		if (n > header.capacity - index)
+			n = header.capacity - index;
+		if (n > max)
+			n = max;
+		ssize_t err = pread(follower->fd, buffer, n, LOG_RING_DATA_OFFSET + index);
+		if (err < 0)
+			return -1;
+		if (err == 0)
+			return 0;
+		n = err;
+
+		// The data is written before the header: the bytes read are valid
+		// if they are still in the ring.
+		log_ring_header_t check;
+		if (read_ring_header(follower->fd, &check) != 0)
+			return 0;
+		if ((check.written > check.capacity) && (follower->offset < check.written - check.capacity))
+			continue;
+
+		if ((! follower->started) && (follower->offset > 0)) {
+			char *eol = memchr(buffer, '\n', n);
+			if (eol == NULL) {
+				follower->offset += n;
+				continue;
+			}
+			size_t skip = eol + 1 - buffer;
+			memmove(buffer, eol + 1, n - skip);
+			follower->offset += skip;
+			n -= skip;
+			if (n == 0)
+				continue;
+		}
+		follower->started = 1;
+		follower->offset += n;
+		return n;
+	}
+}
+
+
+
+static int read_ring_header(int fd, log_ring_header_t *header)
+{
+	if (pread(fd, header, sizeof(*header), 0) != sizeof(*header))
+		return -1;
+	if ((memcmp(header->magic, LOG_RING_MAGIC, sizeof(header->magic)) != 0) || (header->capacity == 0))
+		return -1;
+	return 0;
+}
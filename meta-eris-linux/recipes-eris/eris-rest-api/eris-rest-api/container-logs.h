@@ -0,0 +1,23 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef CONTAINER_LOGS_H
+#define CONTAINER_LOGS_H
+
+	#include <microhttpd.h>
+
+	#define CONTAINER_LOGS_DIR    "/run/eris-linux"
+	#define CONTAINER_LOGS_SLOTS  4
+
+	// Watch the log rings written by eris-container-supervisor in a thread.
+	int start_container_logs(void);
+
+	// Reply the log ring of the slot (numbered from 0). With follow, the
+	// reply is then streamed (chunked) as the container writes new lines.
+	enum MHD_Result send_container_logs(struct MHD_Connection *connection, int slot, int follow);
+
+#endif
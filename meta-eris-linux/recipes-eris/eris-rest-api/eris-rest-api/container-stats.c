@@ -0,0 +1,366 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "container-cgroup.h"
+#include "container-stats.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define STATS_BUFFER_SIZE     4096
+// Samples during which a new container is looked for at each sample,
+// the cgroup being created after slot.cid. Then once per period.
+#define STATS_LOOKUP_SAMPLES  10
+
+
+// ---------------------- Private types definitions.
+
+enum {
+	CGROUP_CPU_STAT = 0,
+	CGROUP_MEMORY_CURRENT,
+	CGROUP_MEMORY_STAT,
+	CGROUP_IO_STAT,
+	CGROUP_PIDS_CURRENT,
+	CGROUP_FILES
+};
+
+
+typedef struct {
+
+	container_cgroup_t  cgroup;           // Path empty if no container.
+	int                 fd[CGROUP_FILES];
+
+	int                 cid_present;      // slot.cid, checked with stat().
+	ino_t               cid_inode;
+	struct timespec     cid_mtime;
+	int                 lookups;          // Samples since the change of slot.cid.
+
+	container_sample_t  ring[CONTAINER_STATS_HISTORY];
+	int                 first;
+	int                 count;
+
+} slot_stats_t;
+
+
+// ---------------------- Private method declarations.
+
+static void  *container_stats_thread  (void *arg);
+static void   sample_slot             (int slot, long long now);
+static int    cid_file_changed        (int slot, slot_stats_t *stats);
+static void   reset_slot              (slot_stats_t *stats, const container_cgroup_t *cgroup);
+static void   open_cgroup_files       (slot_stats_t *stats);
+static void   close_cgroup_files      (slot_stats_t *stats);
+static int    read_cgroup_fd          (int fd, char *buffer, size_t size);
+static unsigned long long  stat_value (const char *buffer, const char *key);
+static void   sum_io_stat             (const char *buffer, unsigned long long *rbytes, unsigned long long *wbytes);
+static void   sum_blkio_stat          (const char *buffer, unsigned long long *rbytes, unsigned long long *wbytes);
+static long long           now_ms     (void);
+
+
+// ---------------------- Private variables declarations.
+
+// Indexed by the version of the cgroups.
+static const char *cgroup_files[3][CGROUP_FILES] = {
+	[1] = { "cpuacct.usage", "memory.usage_in_bytes", "memory.stat", "blkio.throttle.io_service_bytes", "pids.current" },
+	[2] = { "cpu.stat", "memory.current", "memory.stat", "io.stat", "pids.current" },
+};
+
+static pthread_mutex_t  stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static slot_stats_t     slot_stats[CONTAINER_STATS_SLOTS];
+
+static pthread_t        stats_thread;
+static int              stats_running = 0;
+
+
+// ---------------------- Public methods
+
+int start_container_stats(void)
+{
+	if (stats_running)
+		return 0;
+
+	for (int slot = 0; slot < CONTAINER_STATS_SLOTS; slot++)
+		for (int i = 0; i < CGROUP_FILES; i++)
+			slot_stats[slot].fd[i] = -1;
+
+	stats_running = 1;
+	if (pthread_create(&stats_thread, NULL, container_stats_thread, NULL) != 0) {
+		stats_running = 0;
+		return -1;
+	}
+	pthread_detach(stats_thread);
+	return 0;
+}
+
+
+
+int get_container_samples(int slot, container_sample_t *samples, int max)
+{
+	int n = 0;
+
+	if ((slot < 0) || (slot >= CONTAINER_STATS_SLOTS))
+		return 0;
+
+	pthread_mutex_lock(&stats_mutex);
+	slot_stats_t *stats = &(slot_stats[slot]);
+	int skip = (stats->count > max) ? stats->count - max : 0;
+	for (int i = skip; i < stats->count; i++)
+		samples[n++] = stats->ring[(stats->first + i) % CONTAINER_STATS_HISTORY];
+	pthread_mutex_unlock(&stats_mutex);
+
+	return n;
+}
+
+
+// ---------------------- Private methods
+
+// The requests only copy the rings: the cost of the sampling doesn't
+// depend on the number of clients.
+static void *container_stats_thread(void *arg)
+{
+	(void) arg;
+
+	for (;;) {
+		long long now = now_ms();
+		for (int slot = 0; slot < CONTAINER_STATS_SLOTS; slot++)
+			sample_slot(slot, now);
+		usleep(CONTAINER_STATS_PERIOD_MS * 1000);
+	}
+	return NULL;
+}
+
+
+
+static void sample_slot(int slot, long long now)
+{
+	slot_stats_t *stats = &(slot_stats[slot]);
+	char buffer[STATS_BUFFER_SIZE];
+	container_sample_t sample;
+
+	// A new container (restart, blue/green switch) has a new id, and a new cgroup.
+	int lookup = cid_file_changed(slot, stats);
+	// The cgroup is removed with its container.
+	if ((stats->fd[CGROUP_CPU_STAT] >= 0) && (read_cgroup_fd(stats->fd[CGROUP_CPU_STAT], buffer, sizeof(buffer)) != 0))
+		reset_slot(stats, NULL);
+	if ((stats->cgroup.path[0] == '\0') && stats->cid_present) {
+		stats->lookups++;
+		if ((stats->lookups < STATS_LOOKUP_SAMPLES) || (stats->lookups % STATS_LOOKUP_SAMPLES == 0))
+			lookup = 1;
+	}
+	if (lookup) {
+		container_cgroup_t cgroup;
+		if (container_cgroup(slot, &cgroup) != 0)
+			cgroup.path[0] = '\0';
+		if (strcmp(cgroup.path, stats->cgroup.path) != 0)
+			reset_slot(stats, &cgroup);
+	}
+	if (stats->cgroup.path[0] == '\0')
+		return;
+
+	memset(&sample, 0, sizeof(sample));
+	sample.time_ms = now;
+	int v1 = (stats->cgroup.version == 1);
+
+	if (read_cgroup_fd(stats->fd[CGROUP_CPU_STAT], buffer, sizeof(buffer)) == 0)
+		sample.cpu_usec = v1 ? strtoull(buffer, NULL, 10) / 1000 : stat_value(buffer, "usage_usec");
+	if (read_cgroup_fd(stats->fd[CGROUP_MEMORY_CURRENT], buffer, sizeof(buffer)) == 0)
+		sample.memory = strtoull(buffer, NULL, 10);
+	if (read_cgroup_fd(stats->fd[CGROUP_MEMORY_STAT], buffer, sizeof(buffer)) == 0) {
+		sample.memory_anon = stat_value(buffer, v1 ? "total_rss" : "anon");
+		sample.memory_file = stat_value(buffer, v1 ? "total_cache" : "file");
+	}
+	if (read_cgroup_fd(stats->fd[CGROUP_IO_STAT], buffer, sizeof(buffer)) == 0) {
+		if (v1)
+			sum_blkio_stat(buffer, &sample.io_read_bytes, &sample.io_write_bytes);
+		else
+			sum_io_stat(buffer, &sample.io_read_bytes, &sample.io_write_bytes);
+	}
+	if (read_cgroup_fd(stats->fd[CGROUP_PIDS_CURRENT], buffer, sizeof(buffer)) == 0)
+		sample.pids = strtoull(buffer, NULL, 10);
+
+	pthread_mutex_lock(&stats_mutex);
+	if (stats->count > 0) {
+		const container_sample_t *previous = &(stats->ring[(stats->first + stats->count - 1) % CONTAINER_STATS_HISTORY]);
+		double elapsed = (sample.time_ms - previous->time_ms) / 1000.0;
+		if (elapsed > 0) {
+			if (sample.cpu_usec >= previous->cpu_usec)
+				sample.cpu_percent = (sample.cpu_usec - previous->cpu_usec) / (elapsed * 10000.0);
+			if (sample.io_read_bytes >= previous->io_read_bytes)
+				sample.io_read_rate = (sample.io_read_bytes - previous->io_read_bytes) / elapsed;
+			if (sample.io_write_bytes >= previous->io_write_bytes)
+				sample.io_write_rate = (sample.io_write_bytes - previous->io_write_bytes) / elapsed;
+		}
+	}
+	if (stats->count < CONTAINER_STATS_HISTORY) {
+		stats->ring[(stats->first + stats->count) % CONTAINER_STATS_HISTORY] = sample;
+		stats->count++;
+	} else {
+		stats->ring[stats->first] = sample;
+		stats->first = (stats->first + 1) % CONTAINER_STATS_HISTORY;
+	}
+	pthread_mutex_unlock(&stats_mutex);
+}
+
+
+
+// Return 1 if slot.cid was written, replaced or removed since the previous call.
+static int cid_file_changed(int slot, slot_stats_t *stats)
+{
+	char path[256];
+	struct stat status;
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.cid", CONTAINER_SLOTS_DIR, slot + 1);
+	if (stat(path, &status) != 0) {
+		int changed = stats->cid_present;
+		stats->cid_present = 0;
+		return changed;
+	}
+	if (stats->cid_present
+	 && (status.st_ino == stats->cid_inode)
+	 && (status.st_mtim.tv_sec == stats->cid_mtime.tv_sec)
+	 && (status.st_mtim.tv_nsec == stats->cid_mtime.tv_nsec))
+		return 0;
+
+	stats->cid_present = 1;
+	stats->cid_inode   = status.st_ino;
+	stats->cid_mtime   = status.st_mtim;
+	stats->lookups     = 0;
+	return 1;
+}
+
+
+
+// Forget the samples of the previous container, and open the files of the
+// new cgroup (if any).
+static void reset_slot(slot_stats_t *stats, const container_cgroup_t *cgroup)
+{
+	close_cgroup_files(stats);
+	if (cgroup != NULL)
+		stats->cgroup = *cgroup;
+	else
+		stats->cgroup.path[0] = '\0';
+
+	pthread_mutex_lock(&stats_mutex);
+	stats->first = 0;
+	stats->count = 0;
+	pthread_mutex_unlock(&stats_mutex);
+
+	if (stats->cgroup.path[0] != '\0')
+		open_cgroup_files(stats);
+}
+
+
+
+// A missing controller leaves its file closed (-1).
+static void open_cgroup_files(slot_stats_t *stats)
+{
+	char path[512];
+
+	for (int i = 0; i < CGROUP_FILES; i++) {
+		cgroup_file_path(&(stats->cgroup), cgroup_files[stats->cgroup.version][i], path, sizeof(path));
+		stats->fd[i] = open(path, O_RDONLY | O_CLOEXEC);
+	}
+}
+
+
+
+static void close_cgroup_files(slot_stats_t *stats)
+{
+	for (int i = 0; i < CGROUP_FILES; i++) {
+		if (stats->fd[i] >= 0)
+			close(stats->fd[i]);
+		stats->fd[i] = -1;
+	}
+}
+
+
+
+static int read_cgroup_fd(int fd, char *buffer, size_t size)
+{
+	if (fd < 0)
+		return -1;
+
+	ssize_t n = pread(fd, buffer, size - 1, 0);
+	if (n <= 0)
+		return -1;
+	buffer[n] = '\0';
+	return 0;
+}
+
+
+
+// Value of a "<key> <value>" line of a flat keyed file (cpu.stat, memory.stat).
+static unsigned long long stat_value(const char *buffer, const char *key)
+{
+	size_t length = strlen(key);
+
+	const char *line = buffer;
+	while (line != NULL) {
+		if ((strncmp(line, key, length) == 0) && (line[length] == ' '))
+			return strtoull(line + length + 1, NULL, 10);
+		line = strchr(line, '\n');
+		if (line != NULL)
+			line++;
+	}
+	return 0;
+}
+
+
+
+// io.stat: one "<major>:<minor> rbytes=<n> wbytes=<n> rios=<n> ..." line per device.
+static void sum_io_stat(const char *buffer, unsigned long long *rbytes, unsigned long long *wbytes)
+{
+	const char *p;
+
+	*rbytes = 0;
+	*wbytes = 0;
+	for (p = strstr(buffer, "rbytes="); p != NULL; p = strstr(p + 7, "rbytes="))
+		*rbytes += strtoull(p + 7, NULL, 10);
+	for (p = strstr(buffer, "wbytes="); p != NULL; p = strstr(p + 7, "wbytes="))
+		*wbytes += strtoull(p + 7, NULL, 10);
+}
+
+
+
+// blkio.throttle.io_service_bytes (cgroup v1): "<major>:<minor> <operation> <n>" lines.
+static void sum_blkio_stat(const char *buffer, unsigned long long *rbytes, unsigned long long *wbytes)
+{
+	char operation[16];
+	unsigned long long n;
+
+	*rbytes = 0;
+	*wbytes = 0;
+	for (const char *line = buffer; line != NULL; line = strchr(line, '\n')) {
+		if (*line == '\n')
+			line++;
+		if (sscanf(line, "%*s %15s %llu", operation, &n) != 2)
+			continue;
+		if (strcmp(operation, "Read") == 0)
+			*rbytes += n;
+		else if (strcmp(operation, "Write") == 0)
+			*wbytes += n;
+	}
+}
+
+
+
+static long long now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_BOOTTIME, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
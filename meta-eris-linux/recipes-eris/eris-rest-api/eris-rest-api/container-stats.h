@@ -0,0 +1,40 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef CONTAINER_STATS_H
+#define CONTAINER_STATS_H
+
+	#define CONTAINER_STATS_SLOTS     4
+	#define CONTAINER_STATS_HISTORY   60
+	#define CONTAINER_STATS_PERIOD_MS 1000
+
+	typedef struct {
+
+		long long           time_ms;          // CLOCK_BOOTTIME.
+		unsigned long long  cpu_usec;         // Counters since the start of the container.
+		unsigned long long  io_read_bytes;
+		unsigned long long  io_write_bytes;
+		unsigned long long  memory;           // Current values.
+		unsigned long long  memory_anon;
+		unsigned long long  memory_file;
+		unsigned long long  pids;
+
+		// Rates since the previous sample.
+		double              cpu_percent;      // 100% for one CPU.
+		double              io_read_rate;     // Bytes per second.
+		double              io_write_rate;
+
+	} container_sample_t;
+
+	// Sample the cgroups of the containers in a thread.
+	int start_container_stats(void);
+
+	// Copy the samples of the slot (numbered from 0), oldest first, and
+	// return their number. 0 if the slot has no running container.
+	int get_container_samples(int slot, container_sample_t *samples, int max);
+
+#endif
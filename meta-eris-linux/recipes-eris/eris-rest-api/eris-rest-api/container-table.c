@@ -0,0 +1,202 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#define _GNU_SOURCE   // getline().
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/inotify.h>
+
+#include "container-table.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define CONTAINERS_DIRECTORY     "/etc/eris-linux"
+#define CONTAINERS_FILENAME      "containers"
+
+#define TABLE_WATCH_EVENTS       (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+#define TABLE_RETRY_DELAY_S      5
+
+
+// ---------------------- Private method declarations.
+
+static void  *container_table_thread  (void *arg);
+static void   load_container_table    (void);
+static void   parse_slot_line         (char *line, container_slot_t *entry);
+static int    copy_field              (char *field, const char *start, const char *end);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t   table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static container_slot_t  container_table[CONTAINER_TABLE_SLOTS];
+
+static pthread_t         table_thread;
+static int               table_running = 0;
+
+
+// ---------------------- Public methods
+
+int start_container_table(void)
+{
+	if (table_running)
+		return 0;
+
+	load_container_table();
+
+	table_running = 1;
+	if (pthread_create(&table_thread, NULL, container_table_thread, NULL) != 0) {
+		table_running = 0;
+		return -1;
+	}
+	pthread_detach(table_thread);
+	return 0;
+}
+
+
+
+int get_container_slot(int slot, container_slot_t *entry)
+{
+	if ((slot < 0) || (slot >= CONTAINER_TABLE_SLOTS))
+		return -1;
+
+	pthread_mutex_lock(&table_mutex);
+	*entry = container_table[slot];
+	pthread_mutex_unlock(&table_mutex);
+
+	return 0;
+}
+
+
+// ---------------------- Private methods
+
+// The directory is watched rather than the file, because the description
+// may be replaced by a rename() or created after the start of the daemon.
+static void *container_table_thread(void *arg)
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	(void) arg;
+
+	for (;;) {
+		int fd = inotify_init1(IN_CLOEXEC);
+		if (fd < 0) {
+			sleep(TABLE_RETRY_DELAY_S);
+			load_container_table();
+			continue;
+		}
+		if (inotify_add_watch(fd, CONTAINERS_DIRECTORY, TABLE_WATCH_EVENTS) < 0) {
+			close(fd);
+			sleep(TABLE_RETRY_DELAY_S);
+			load_container_table();
+			continue;
+		}
+		// The file may have changed before the watch was set.
+		load_container_table();
+
+		int watching = 1;
+		while (watching) {
+			ssize_t n = read(fd, buffer, sizeof(buffer));
+			if ((n < 0) && (errno == EINTR))
+				continue;
+			if (n <= 0)
+				break;
+
+			int modified = 0;
+			for (char *p = buffer; p < buffer + n; ) {
+				struct inotify_event *event = (struct inotify_event *) p;
+				if (event->mask & (IN_IGNORED | IN_Q_OVERFLOW))
+					watching = 0;
+				if ((event->len > 0) && (strcmp(event->name, CONTAINERS_FILENAME) == 0))
+					modified = 1;
+				p += sizeof(struct inotify_event) + event->len;
+			}
+			if (modified || (! watching))
+				load_container_table();
+		}
+		close(fd);
+	}
+	return NULL;
+}
+
+
+
+static void load_container_table(void)
+{
+	container_slot_t table[CONTAINER_TABLE_SLOTS];
+	char *line = NULL;
+	size_t size = 0;
+	int slot;
+
+	memset(table, 0, sizeof(table));
+
+	FILE *fp = fopen(CONTAINERS_FILE, "r");
+	if (fp == NULL) {
+		for (slot = 0; slot < CONTAINER_TABLE_SLOTS; slot++)
+			table[slot].validity = SLOT_NO_FILE;
+	} else {
+		for (slot = 0; slot < CONTAINER_TABLE_SLOTS; slot++) {
+			if (getline(&line, &size, fp) < 0)
+				break;
+			parse_slot_line(line, &(table[slot]));
+		}
+		for (; slot < CONTAINER_TABLE_SLOTS; slot++)
+			table[slot].validity = SLOT_INCOMPLETE;
+		free(line);
+		fclose(fp);
+	}
+
+	pthread_mutex_lock(&table_mutex);
+	memcpy(container_table, table, sizeof(table));
+	pthread_mutex_unlock(&table_mutex);
+}
+
+
+
+// Line format: id!name!version!filename!b64!graphical!redirections!privileged
+// An id of -1 or an empty line indicates an empty slot.
+static void parse_slot_line(char *line, container_slot_t *entry)
+{
+	line[strcspn(line, "\r\n")] = '\0';
+
+	entry->validity = SLOT_VALID;
+	if ((line[0] == '\0') || ((line[0] == '-') && (line[1] == '1')))
+		return;
+	entry->present = 1;
+
+	char *id_end = strchr(line, '!');
+	char *name_end = (id_end != NULL) ? strchr(id_end + 1, '!') : NULL;
+	if (name_end == NULL) {
+		entry->validity = SLOT_INCONSISTENT;
+		return;
+	}
+	char *version_end = strchr(name_end + 1, '!');
+	if (version_end == NULL)
+		version_end = name_end + 1 + strlen(name_end + 1);
+
+	if ((copy_field(entry->id, line, id_end) != 0)
+	 || (copy_field(entry->name, id_end + 1, name_end) != 0)
+	 || (copy_field(entry->version, name_end + 1, version_end) != 0))
+		entry->validity = SLOT_INCONSISTENT;
+}
+
+
+
+static int copy_field(char *field, const char *start, const char *end)
+{
+	if (end - start >= CONTAINER_FIELD_LENGTH)
+		return -1;
+	memcpy(field, start, end - start);
+	field[end - start] = '\0';
+	return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef CONTAINER_TABLE_H
+#define CONTAINER_TABLE_H
+
+	#define CONTAINERS_FILE         "/etc/eris-linux/containers"
+	#define CONTAINER_TABLE_SLOTS   4
+	#define CONTAINER_FIELD_LENGTH  256
+
+	typedef enum {
+
+		SLOT_VALID = 0,
+		SLOT_NO_FILE,        // The containers description can not be read.
+		SLOT_INCOMPLETE,     // The description has no line for this slot.
+		SLOT_INCONSISTENT,   // The line of the slot is not well formed.
+
+	} slot_validity_t;
+
+	typedef struct {
+
+		slot_validity_t  validity;
+		int              present;
+		char             id[CONTAINER_FIELD_LENGTH];
+		char             name[CONTAINER_FIELD_LENGTH];
+		char             version[CONTAINER_FIELD_LENGTH];
+
+	} container_slot_t;
+
+	// Parse the containers description and watch it for modifications.
+	int start_container_table(void);
+
+	// The slot is numbered from 0.
+	int get_container_slot(int slot, container_slot_t *entry);
+
+#endif
@@ -0,0 +1,1036 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <ifaddrs.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+
+#include "addsnprintf.h"
+#include "dns-cache.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define DNS_PORT                   53
+#define DNS_MESSAGE_SIZE           4096
+#define DNS_HEADER_SIZE            12
+// Largest UDP reply to a client without EDNS (RFC 1035).
+#define DNS_UDP_DEFAULT_PAYLOAD    512
+#define DNS_KEY_SIZE               (255 + 4)
+
+#define DNS_CACHE_ENTRIES          512
+#define DNS_CACHE_BUCKETS          256
+#define DNS_MAX_PENDING            64
+#define DNS_MAX_WAITERS            8
+#define DNS_MAX_TCP_CLIENTS        8
+
+#define DNS_UPSTREAM_TIMEOUT_MS    2000
+#define DNS_TCP_TIMEOUT_S          5
+#define DNS_MAX_TTL                86400
+#define DNS_NEGATIVE_MAX_TTL       900
+#define DNS_NEGATIVE_DEFAULT_TTL   60
+
+#define DNS_TYPE_SOA               6
+#define DNS_TYPE_OPT               41
+#define DNS_RCODE_NOERROR          0
+#define DNS_RCODE_NXDOMAIN         3
+
+#define DOCKER_BRIDGE_INTERFACE    "docker0"
+#define DOCKER_BRIDGE_DEFAULT      "172.17.0.1"
+#define RESOLV_CONF_FILE           "/etc/resolv.conf"
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	int            used;
+	unsigned char  key[DNS_KEY_SIZE];    // Lower-case question name + type + class.
+	size_t         key_length;
+	unsigned char *message;
+	size_t         length;
+	time_t         stored;
+	time_t         expires;
+	time_t         last_used;
+	int            negative;
+	int            next;                 // Next entry in the same bucket, -1 at end.
+
+} dns_entry_t;
+
+
+typedef struct {
+
+	struct sockaddr_storage address;
+	socklen_t               address_length;
+	uint16_t                id;
+	size_t                  payload;      // Largest UDP reply accepted by the client.
+
+} dns_waiter_t;
+
+
+// Each upstream query leaves from its own socket, bound to a random port
+// by the kernel, with a random ID: an off-path attacker has to guess both.
+typedef struct {
+
+	int                      used;
+	int                      sock;
+	uint16_t                 upstream_id;
+	struct sockaddr_storage  upstream;
+	socklen_t                upstream_length;
+	unsigned char            key[DNS_KEY_SIZE];
+	size_t                   key_length;
+	long long                sent_ms;
+	dns_waiter_t             waiters[DNS_MAX_WAITERS];
+	int                      nb_waiters;
+
+} dns_pending_t;
+
+
+typedef struct {
+
+	unsigned long  queries;
+	unsigned long  hits;
+	unsigned long  negative_hits;
+	unsigned long  misses;
+	unsigned long  deduplicated;
+	unsigned long  upstream_timeouts;
+	unsigned long  tcp_queries;
+
+} dns_statistics_t;
+
+
+// ---------------------- Private method declarations.
+
+static void *dns_cache_thread      (void *arg);
+static void *dns_tcp_client_thread (void *arg);
+
+static int   open_listening_socket (int type, struct in_addr *address);
+static int   get_bridge_address    (struct in_addr *address);
+static int   get_upstream_address  (struct sockaddr_storage *upstream, socklen_t *length);
+static int   same_address          (const struct sockaddr_storage *a, const struct sockaddr_storage *b);
+static int   random_query_id       (uint16_t *id);
+
+static void  handle_udp_query      (int udp_sock);
+static void  handle_upstream_reply (int udp_sock, dns_pending_t *pending);
+static void  release_pending       (dns_pending_t *pending);
+static void  expire_pending        (void);
+
+static int   parse_question        (const unsigned char *message, size_t length, unsigned char *key, size_t *key_length);
+static int   skip_name             (const unsigned char *message, size_t length, size_t offset);
+static size_t udp_payload_size     (const unsigned char *message, size_t length);
+static size_t truncate_reply       (unsigned char *message, size_t length, size_t payload);
+static int   walk_records          (unsigned char *message, size_t length, uint32_t elapsed, uint32_t *min_ttl, uint32_t *soa_ttl);
+
+static int   cache_lookup          (const unsigned char *key, size_t key_length, unsigned char *message, size_t *length);
+static void  cache_store           (const unsigned char *key, size_t key_length, const unsigned char *message, size_t length);
+static unsigned int cache_hash     (const unsigned char *key, size_t key_length);
+
+static long long monotonic_ms      (void);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t   cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static dns_entry_t       cache_entries[DNS_CACHE_ENTRIES];
+static int               cache_buckets[DNS_CACHE_BUCKETS];
+static dns_statistics_t  cache_statistics;
+
+static dns_pending_t     pending_queries[DNS_MAX_PENDING];
+
+// Started and stopped by the REST API thread only. cache_running is read by
+// the cache thread, and cleared by it on error.
+static pthread_t         cache_thread;
+static int               cache_thread_started = 0;
+static int               cache_running   = 0;
+static int               cache_wakeup_fd = -1;
+static int               cache_udp_sock  = -1;
+static int               cache_tcp_sock  = -1;
+static int               tcp_clients     = 0;
+
+
+// ---------------------- Public methods
+
+// The listening sockets are opened here, so that the caller knows whether
+// the cache could be started.
+int start_dns_cache(void)
+{
+	if (__atomic_load_n(&cache_running, __ATOMIC_SEQ_CST))
+		return 0;
+
+	// Thread ended by an error.
+	stop_dns_cache();
+
+	pthread_mutex_lock(&cache_mutex);
+	for (int i = 0; i < DNS_CACHE_BUCKETS; i++)
+		cache_buckets[i] = -1;
+	for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+		free(cache_entries[i].message);
+		memset(&(cache_entries[i]), 0, sizeof(dns_entry_t));
+		cache_entries[i].next = -1;
+	}
+	memset(&cache_statistics, 0, sizeof(cache_statistics));
+	pthread_mutex_unlock(&cache_mutex);
+
+	memset(pending_queries, 0, sizeof(pending_queries));
+
+	struct in_addr bridge;
+	get_bridge_address(&bridge);
+
+	cache_udp_sock = open_listening_socket(SOCK_DGRAM, &bridge);
+	cache_tcp_sock = open_listening_socket(SOCK_STREAM, &bridge);
+	cache_wakeup_fd = eventfd(0, EFD_CLOEXEC);
+
+	if ((cache_udp_sock < 0) || (cache_tcp_sock < 0) || (cache_wakeup_fd < 0)) {
+		fprintf(stderr, "dns-cache: unable to open sockets on %s:%d.\n", inet_ntoa(bridge), DNS_PORT);
+		goto error;
+	}
+
+	__atomic_store_n(&cache_running, 1, __ATOMIC_SEQ_CST);
+	if (pthread_create(&cache_thread, NULL, dns_cache_thread, NULL) != 0) {
+		__atomic_store_n(&cache_running, 0, __ATOMIC_SEQ_CST);
+		goto error;
+	}
+	cache_thread_started = 1;
+	return 0;
+
+error:
+	if (cache_udp_sock >= 0)
+		close(cache_udp_sock);
+	if (cache_tcp_sock >= 0)
+		close(cache_tcp_sock);
+	if (cache_wakeup_fd >= 0)
+		close(cache_wakeup_fd);
+	cache_udp_sock = -1;
+	cache_tcp_sock = -1;
+	cache_wakeup_fd = -1;
+	return -1;
+}
+
+
+
+void stop_dns_cache(void)
+{
+	if (! cache_thread_started)
+		return;
+
+	uint64_t one = 1;
+	__atomic_store_n(&cache_running, 0, __ATOMIC_SEQ_CST);
+	write(cache_wakeup_fd, &one, sizeof(one));
+	pthread_join(cache_thread, NULL);
+	cache_thread_started = 0;
+
+	// The listening sockets are closed by the thread.
+	close(cache_wakeup_fd);
+	cache_wakeup_fd = -1;
+}
+
+
+
+int dns_cache_is_running(void)
+{
+	return __atomic_load_n(&cache_running, __ATOMIC_SEQ_CST);
+}
+
+
+
+void flush_dns_cache(void)
+{
+	pthread_mutex_lock(&cache_mutex);
+	for (int i = 0; i < DNS_CACHE_BUCKETS; i++)
+		cache_buckets[i] = -1;
+	for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+		free(cache_entries[i].message);
+		memset(&(cache_entries[i]), 0, sizeof(dns_entry_t));
+		cache_entries[i].next = -1;
+	}
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+
+
+int get_dns_cache_statistics(char **string, size_t *size, size_t *pos)
+{
+	dns_statistics_t stats;
+	int entries = 0;
+
+	pthread_mutex_lock(&cache_mutex);
+	stats = cache_statistics;
+	for (int i = 0; i < DNS_CACHE_ENTRIES; i++)
+		if (cache_entries[i].used)
+			entries++;
+	pthread_mutex_unlock(&cache_mutex);
+
+	unsigned long hit_rate = 0;
+	if (stats.queries > 0)
+		hit_rate = (100 * (stats.hits + stats.negative_hits)) / stats.queries;
+
+	return addsnprintf(string, size, pos,
+		"queries=%lu\nhits=%lu\nnegative_hits=%lu\nmisses=%lu\ndeduplicated=%lu\ntimeouts=%lu\ntcp=%lu\nentries=%d\nhit_rate=%lu%%\n",
+		stats.queries, stats.hits, stats.negative_hits, stats.misses,
+		stats.deduplicated, stats.upstream_timeouts, stats.tcp_queries,
+		entries, hit_rate);
+}
+
+
+// ---------------------- Private methods
+
+static void *dns_cache_thread(void *arg)
+{
+	(void) arg;
+
+	int udp_sock = cache_udp_sock;
+	int tcp_sock = cache_tcp_sock;
+
+	// Listening sockets, then the sockets of the pending upstream queries.
+	struct pollfd fds[3 + DNS_MAX_PENDING];
+	dns_pending_t *polled[DNS_MAX_PENDING];
+
+	while (__atomic_load_n(&cache_running, __ATOMIC_SEQ_CST)) {
+		fds[0].fd = cache_wakeup_fd;
+		fds[1].fd = udp_sock;
+		fds[2].fd = tcp_sock;
+		int nfds = 3;
+		for (int i = 0; i < DNS_MAX_PENDING; i++) {
+			if (! pending_queries[i].used)
+				continue;
+			polled[nfds - 3] = &(pending_queries[i]);
+			fds[nfds++].fd = pending_queries[i].sock;
+		}
+		for (int i = 0; i < nfds; i++) {
+			fds[i].events  = POLLIN;
+			fds[i].revents = 0;
+		}
+
+		if (poll(fds, nfds, DNS_UPSTREAM_TIMEOUT_MS / 4) < 0) {
+			if (errno == EINTR)
+				continue;
+			__atomic_store_n(&cache_running, 0, __ATOMIC_SEQ_CST);
+			break;
+		}
+		for (int i = 3; i < nfds; i++)
+			if (fds[i].revents & POLLIN)
+				handle_upstream_reply(udp_sock, polled[i - 3]);
+
+		if (fds[1].revents & POLLIN)
+			handle_udp_query(udp_sock);
+
+		if (fds[2].revents & POLLIN) {
+			int client = accept(tcp_sock, NULL, NULL);
+			if (client >= 0) {
+				pthread_t thread;
+				if ((__atomic_load_n(&tcp_clients, __ATOMIC_SEQ_CST) >= DNS_MAX_TCP_CLIENTS)
+				 || (pthread_create(&thread, NULL, dns_tcp_client_thread, (void *)(long) client) != 0)) {
+					close(client);
+				} else {
+					__atomic_add_fetch(&tcp_clients, 1, __ATOMIC_SEQ_CST);
+					pthread_detach(thread);
+				}
+			}
+		}
+		expire_pending();
+	}
+
+	for (int i = 0; i < DNS_MAX_PENDING; i++)
+		if (pending_queries[i].used)
+			release_pending(&(pending_queries[i]));
+	close(udp_sock);
+	close(tcp_sock);
+	cache_udp_sock = -1;
+	cache_tcp_sock = -1;
+	return NULL;
+}
+
+
+
+static int open_listening_socket(int type, struct in_addr *address)
+{
+	int sock = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+
+	int on = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	// The docker bridge may not be configured yet when we start.
+	setsockopt(sock, IPPROTO_IP, IP_FREEBIND, &on, sizeof(on));
+
+	struct sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port   = htons(DNS_PORT);
+	sin.sin_addr   = *address;
+
+	if (bind(sock, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+		close(sock);
+		return -1;
+	}
+	if ((type == SOCK_STREAM) && (listen(sock, DNS_MAX_TCP_CLIENTS) < 0)) {
+		close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+
+
+static int get_bridge_address(struct in_addr *address)
+{
+	struct ifaddrs *ifaddr;
+
+	inet_pton(AF_INET, DOCKER_BRIDGE_DEFAULT, address);
+
+	if (getifaddrs(&ifaddr) != 0)
+		return -1;
+
+	for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+		if ((ifa->ifa_addr == NULL) || (ifa->ifa_addr->sa_family != AF_INET))
+			continue;
+		if (strcmp(ifa->ifa_name, DOCKER_BRIDGE_INTERFACE) != 0)
+			continue;
+		*address = ((struct sockaddr_in *) ifa->ifa_addr)->sin_addr;
+		break;
+	}
+	freeifaddrs(ifaddr);
+	return 0;
+}
+
+
+
+// IPv4 servers are reached with IPv4 sockets: the cache works with IPv6
+// disabled.
+static int get_upstream_address(struct sockaddr_storage *upstream, socklen_t *length)
+{
+	FILE *fp;
+	char line[256];
+	char ip[INET6_ADDRSTRLEN];
+	int found = 0;
+
+	// The host resolv.conf keeps the real name server (see set_dns_address()).
+	fp = fopen(RESOLV_CONF_FILE, "r");
+	if (fp == NULL)
+		return -1;
+	while (fgets(line, 256, fp) != NULL) {
+		if (sscanf(line, "nameserver %45s", ip) == 1) {
+			found = 1;
+			break;
+		}
+	}
+	fclose(fp);
+	if (! found)
+		return -1;
+
+	memset(upstream, 0, sizeof(struct sockaddr_storage));
+
+	struct sockaddr_in *sin = (struct sockaddr_in *) upstream;
+	if (inet_pton(AF_INET, ip, &(sin->sin_addr)) == 1) {
+		sin->sin_family = AF_INET;
+		sin->sin_port   = htons(DNS_PORT);
+		*length = sizeof(struct sockaddr_in);
+		return 0;
+	}
+
+	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) upstream;
+	if (inet_pton(AF_INET6, ip, &(sin6->sin6_addr)) == 1) {
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port   = htons(DNS_PORT);
+		*length = sizeof(struct sockaddr_in6);
+		return 0;
+	}
+	return -1;
+}
+
+
+
+// Address and port.
+static int same_address(const struct sockaddr_storage *a, const struct sockaddr_storage *b)
+{
+	if (a->ss_family != b->ss_family)
+		return 0;
+
+	if (a->ss_family == AF_INET) {
+		const struct sockaddr_in *a4 = (const struct sockaddr_in *) a;
+		const struct sockaddr_in *b4 = (const struct sockaddr_in *) b;
+		return (a4->sin_port == b4->sin_port) && (a4->sin_addr.s_addr == b4->sin_addr.s_addr);
+	}
+	if (a->ss_family == AF_INET6) {
+		const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *) a;
+		const struct sockaddr_in6 *b6 = (const struct sockaddr_in6 *) b;
+		return (a6->sin6_port == b6->sin6_port)
+		    && (memcmp(&(a6->sin6_addr), &(b6->sin6_addr), sizeof(struct in6_addr)) == 0);
+	}
+	return 0;
+}
+
+
+
+static int random_query_id(uint16_t *id)
+{
+	return (getrandom(id, sizeof(*id), 0) == sizeof(*id)) ? 0 : -1;
+}
+
+
+
+static void handle_udp_query(int udp_sock)
+{
+	unsigned char message[DNS_MESSAGE_SIZE];
+	unsigned char key[DNS_KEY_SIZE];
+	size_t key_length;
+	struct sockaddr_storage client;
+	socklen_t client_length = sizeof(client);
+
+	ssize_t length = recvfrom(udp_sock, message, DNS_MESSAGE_SIZE, 0, (struct sockaddr *) &client, &client_length);
+	if (length < DNS_HEADER_SIZE)
+		return;
+
+	// Ignore responses and anything that is not a standard query.
+	if ((message[2] & 0x80) || (message[2] & 0x78))
+		return;
+
+	if (parse_question(message, length, key, &key_length) < 0)
+		return;
+
+	uint16_t id = (message[0] << 8) | message[1];
+	size_t payload = udp_payload_size(message, length);
+
+	pthread_mutex_lock(&cache_mutex);
+	cache_statistics.queries++;
+	pthread_mutex_unlock(&cache_mutex);
+
+	// The entry may come from a client with a larger EDNS payload, or from TCP.
+	unsigned char reply[DNS_MESSAGE_SIZE];
+	size_t reply_length = DNS_MESSAGE_SIZE;
+	if (cache_lookup(key, key_length, reply, &reply_length) == 0) {
+		reply[0] = id >> 8;
+		reply[1] = id & 0xFF;
+		reply_length = truncate_reply(reply, reply_length, payload);
+		sendto(udp_sock, reply, reply_length, 0, (struct sockaddr *) &client, client_length);
+		return;
+	}
+
+	// Deduplicate in-flight queries for the same question.
+	int free_slot = -1;
+	for (int i = 0; i < DNS_MAX_PENDING; i++) {
+		if (! pending_queries[i].used) {
+			if (free_slot < 0)
+				free_slot = i;
+			continue;
+		}
+		if ((pending_queries[i].key_length != key_length)
+		 || (memcmp(pending_queries[i].key, key, key_length) != 0))
+			continue;
+		if (pending_queries[i].nb_waiters < DNS_MAX_WAITERS) {
+			dns_waiter_t *waiter = &(pending_queries[i].waiters[pending_queries[i].nb_waiters++]);
+			waiter->address        = client;
+			waiter->address_length = client_length;
+			waiter->id             = id;
+			waiter->payload        = payload;
+			pthread_mutex_lock(&cache_mutex);
+			cache_statistics.deduplicated++;
+			pthread_mutex_unlock(&cache_mutex);
+		}
+		return;
+	}
+
+	if (free_slot < 0)
+		return;
+
+	dns_pending_t *pending = &(pending_queries[free_slot]);
+	if (get_upstream_address(&(pending->upstream), &(pending->upstream_length)) < 0)
+		return;
+	if (random_query_id(&(pending->upstream_id)) < 0)
+		return;
+
+	// Bound by connect() to a random ephemeral port, and only receiving
+	// from the server.
+	pending->sock = socket(pending->upstream.ss_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (pending->sock < 0)
+		return;
+	if (connect(pending->sock, (struct sockaddr *) &(pending->upstream), pending->upstream_length) < 0) {
+		close(pending->sock);
+		return;
+	}
+
+	pending->used        = 1;
+	memcpy(pending->key, key, key_length);
+	pending->key_length  = key_length;
+	pending->sent_ms     = monotonic_ms();
+	pending->nb_waiters  = 1;
+	pending->waiters[0].address        = client;
+	pending->waiters[0].address_length = client_length;
+	pending->waiters[0].id             = id;
+	pending->waiters[0].payload        = payload;
+
+	message[0] = pending->upstream_id >> 8;
+	message[1] = pending->upstream_id & 0xFF;
+	send(pending->sock, message, length, 0);
+}
+
+
+
+// Replies not matching the query (source address and port, ID, question)
+// are dropped, the query keeps waiting for the right one.
+static void handle_upstream_reply(int udp_sock, dns_pending_t *pending)
+{
+	unsigned char message[DNS_MESSAGE_SIZE];
+	unsigned char key[DNS_KEY_SIZE];
+	size_t key_length;
+	struct sockaddr_storage from;
+	socklen_t from_length = sizeof(from);
+
+	ssize_t length = recvfrom(pending->sock, message, DNS_MESSAGE_SIZE, 0, (struct sockaddr *) &from, &from_length);
+	if (length < DNS_HEADER_SIZE)
+		return;
+	if (! same_address(&from, &(pending->upstream)))
+		return;
+	// A reply to a standard query.
+	if (((message[2] & 0x80) == 0) || (message[2] & 0x78))
+		return;
+	if ((((message[0] << 8) | message[1]) != pending->upstream_id))
+		return;
+	if (parse_question(message, length, key, &key_length) < 0)
+		return;
+	if ((pending->key_length != key_length) || (memcmp(pending->key, key, key_length) != 0))
+		return;
+
+	// Truncated answers are relayed but never cached: the client retries over TCP.
+	if ((message[2] & 0x02) == 0)
+		cache_store(key, key_length, message, length);
+
+	// The deduplicated clients may accept smaller replies than the first one.
+	unsigned char reply[DNS_MESSAGE_SIZE];
+	for (int w = 0; w < pending->nb_waiters; w++) {
+		memcpy(reply, message, length);
+		reply[0] = pending->waiters[w].id >> 8;
+		reply[1] = pending->waiters[w].id & 0xFF;
+		size_t reply_length = truncate_reply(reply, length, pending->waiters[w].payload);
+		sendto(udp_sock, reply, reply_length, 0, (struct sockaddr *) &(pending->waiters[w].address), pending->waiters[w].address_length);
+	}
+	release_pending(pending);
+}
+
+
+
+static void release_pending(dns_pending_t *pending)
+{
+	close(pending->sock);
+	pending->sock = -1;
+	pending->used = 0;
+}
+
+
+
+static void expire_pending(void)
+{
+	long long now = monotonic_ms();
+
+	for (int i = 0; i < DNS_MAX_PENDING; i++) {
+		if (! pending_queries[i].used)
+			continue;
+		if (now - pending_queries[i].sent_ms < DNS_UPSTREAM_TIMEOUT_MS)
+			continue;
+		// Clients will retry by themselves.
+		release_pending(&(pending_queries[i]));
+		pthread_mutex_lock(&cache_mutex);
+		cache_statistics.upstream_timeouts++;
+		pthread_mutex_unlock(&cache_mutex);
+	}
+}
+
+
+
+static void *dns_tcp_client_thread(void *arg)
+{
+	int sock = (int)(long) arg;
+	unsigned char message[DNS_MESSAGE_SIZE + 2];
+	unsigned char key[DNS_KEY_SIZE];
+	size_t key_length;
+
+	struct timeval tv = { .tv_sec = DNS_TCP_TIMEOUT_S, .tv_usec = 0 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	for (;;) {
+		if (recv(sock, message, 2, MSG_WAITALL) != 2)
+			break;
+		size_t length = (message[0] << 8) | message[1];
+		if ((length < DNS_HEADER_SIZE) || (length > DNS_MESSAGE_SIZE))
+			break;
+		if (recv(sock, &(message[2]), length, MSG_WAITALL) != (ssize_t) length)
+			break;
+		if (parse_question(&(message[2]), length, key, &key_length) < 0)
+			break;
+
+		pthread_mutex_lock(&cache_mutex);
+		cache_statistics.queries++;
+		cache_statistics.tcp_queries++;
+		pthread_mutex_unlock(&cache_mutex);
+
+		unsigned char reply[DNS_MESSAGE_SIZE + 2];
+		size_t reply_length = DNS_MESSAGE_SIZE;
+
+		if (cache_lookup(key, key_length, &(reply[2]), &reply_length) == 0) {
+			reply[2] = message[2];
+			reply[3] = message[3];
+		} else {
+			// Miss: forward the query over TCP to the upstream server.
+			struct sockaddr_storage upstream;
+			socklen_t upstream_length;
+			if (get_upstream_address(&upstream, &upstream_length) < 0)
+				break;
+			int up = socket(upstream.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if (up < 0)
+				break;
+			setsockopt(up, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+			setsockopt(up, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+			if ((connect(up, (struct sockaddr *) &upstream, upstream_length) < 0)
+			 || (send(up, message, length + 2, MSG_NOSIGNAL) != (ssize_t)(length + 2))
+			 || (recv(up, reply, 2, MSG_WAITALL) != 2)) {
+				close(up);
+				break;
+			}
+			reply_length = (reply[0] << 8) | reply[1];
+			if ((reply_length < DNS_HEADER_SIZE) || (reply_length > DNS_MESSAGE_SIZE)
+			 || (recv(up, &(reply[2]), reply_length, MSG_WAITALL) != (ssize_t) reply_length)) {
+				close(up);
+				break;
+			}
+			close(up);
+			cache_store(key, key_length, &(reply[2]), reply_length);
+		}
+		reply[0] = reply_length >> 8;
+		reply[1] = reply_length & 0xFF;
+		if (send(sock, reply, reply_length + 2, MSG_NOSIGNAL) != (ssize_t)(reply_length + 2))
+			break;
+	}
+	close(sock);
+	__atomic_sub_fetch(&tcp_clients, 1, __ATOMIC_SEQ_CST);
+	return NULL;
+}
+
+
+
+static int parse_question(const unsigned char *message, size_t length, unsigned char *key, size_t *key_length)
+{
+	if (length < DNS_HEADER_SIZE)
+		return -1;
+
+	// Only single-question messages are cached (that's what every stub resolver sends).
+	if ((message[4] != 0) || (message[5] != 1))
+		return -1;
+
+	size_t offset = DNS_HEADER_SIZE;
+	size_t k = 0;
+
+	for (;;) {
+		if (offset >= length)
+			return -1;
+		unsigned int label = message[offset];
+		if (label == 0)
+			break;
+		if ((label & 0xC0) != 0)
+			return -1;
+		if ((offset + 1 + label > length) || (k + 1 + label > DNS_KEY_SIZE - 5))
+			return -1;
+		key[k++] = label;
+		for (unsigned int i = 1; i <= label; i++)
+			key[k++] = tolower(message[offset + i]);
+		offset += 1 + label;
+	}
+	if (offset + 5 > length)
+		return -1;
+	key[k++] = 0;
+	// Question type and class.
+	memcpy(&(key[k]), &(message[offset + 1]), 4);
+	k += 4;
+
+	*key_length = k;
+	return 0;
+}
+
+
+
+static int skip_name(const unsigned char *message, size_t length, size_t offset)
+{
+	while (offset < length) {
+		unsigned int label = message[offset];
+		if ((label & 0xC0) == 0xC0)
+			return offset + 2;
+		if (label == 0)
+			return offset + 1;
+		offset += 1 + label;
+	}
+	return -1;
+}
+
+
+
+// RFC 6891: the class of the OPT record of the query is the largest UDP
+// reply accepted by the client, 512 bytes without OPT record.
+static size_t udp_payload_size(const unsigned char *message, size_t length)
+{
+	unsigned int ancount = (message[6] << 8) | message[7];
+	unsigned int nscount = (message[8] << 8) | message[9];
+	unsigned int arcount = (message[10] << 8) | message[11];
+
+	int offset = skip_name(message, length, DNS_HEADER_SIZE);
+	if (offset < 0)
+		return DNS_UDP_DEFAULT_PAYLOAD;
+	offset += 4;
+
+	for (unsigned int rr = 0; rr < ancount + nscount + arcount; rr++) {
+		offset = skip_name(message, length, offset);
+		if ((offset < 0) || (offset + 10 > (int) length))
+			return DNS_UDP_DEFAULT_PAYLOAD;
+		unsigned int type     = (message[offset] << 8) | message[offset + 1];
+		unsigned int payload  = (message[offset + 2] << 8) | message[offset + 3];
+		unsigned int rdlength = (message[offset + 8] << 8) | message[offset + 9];
+		if ((rr >= ancount + nscount) && (type == DNS_TYPE_OPT))
+			return (payload > DNS_UDP_DEFAULT_PAYLOAD) ? payload : DNS_UDP_DEFAULT_PAYLOAD;
+		offset += 10 + rdlength;
+	}
+	return DNS_UDP_DEFAULT_PAYLOAD;
+}
+
+
+
+// A reply too large for the client keeps its question only, with the TC
+// flag set: the client retries over TCP. Without a valid question, only
+// the header is left.
+static size_t truncate_reply(unsigned char *message, size_t length, size_t payload)
+{
+	if (length <= payload)
+		return length;
+
+	message[2] |= 0x02;
+	memset(&(message[6]), 0, 6);
+
+	unsigned int qdcount = (message[4] << 8) | message[5];
+	int offset = (qdcount == 1) ? skip_name(message, length, DNS_HEADER_SIZE) : -1;
+	if ((offset < 0) || ((size_t) offset + 4 > length) || ((size_t) offset + 4 > payload)) {
+		memset(&(message[4]), 0, 2);
+		return DNS_HEADER_SIZE;
+	}
+	return offset + 4;
+}
+
+
+
+static int walk_records(unsigned char *message, size_t length, uint32_t elapsed, uint32_t *min_ttl, uint32_t *soa_ttl)
+{
+	unsigned int ancount = (message[6] << 8) | message[7];
+	unsigned int nscount = (message[8] << 8) | message[9];
+	unsigned int arcount = (message[10] << 8) | message[11];
+
+	int offset = skip_name(message, length, DNS_HEADER_SIZE);
+	if (offset < 0)
+		return -1;
+	offset += 4;
+
+	*min_ttl = DNS_MAX_TTL;
+	*soa_ttl = 0;
+
+	for (unsigned int rr = 0; rr < ancount + nscount + arcount; rr++) {
+		offset = skip_name(message, length, offset);
+		if ((offset < 0) || (offset + 10 > (int) length))
+			return -1;
+
+		unsigned int type   = (message[offset] << 8) | message[offset + 1];
+		uint32_t     ttl    = ((uint32_t) message[offset + 4] << 24) | (message[offset + 5] << 16)
+		                    | (message[offset + 6] << 8) | message[offset + 7];
+		unsigned int rdlength = (message[offset + 8] << 8) | message[offset + 9];
+
+		if (offset + 10 + rdlength > length)
+			return -1;
+
+		if (type != DNS_TYPE_OPT) {
+			if ((rr < ancount) && (ttl < *min_ttl))
+				*min_ttl = ttl;
+
+			if ((rr >= ancount) && (rr < ancount + nscount) && (type == DNS_TYPE_SOA) && (rdlength >= 4)) {
+				// RFC 2308: negative TTL is min(SOA TTL, SOA MINIMUM).
+				const unsigned char *minimum = &(message[offset + 10 + rdlength - 4]);
+				uint32_t soa_minimum = ((uint32_t) minimum[0] << 24) | (minimum[1] << 16) | (minimum[2] << 8) | minimum[3];
+				*soa_ttl = (ttl < soa_minimum) ? ttl : soa_minimum;
+			}
+
+			if (elapsed > 0) {
+				ttl = (ttl > elapsed) ? ttl - elapsed : 0;
+				message[offset + 4] = ttl >> 24;
+				message[offset + 5] = (ttl >> 16) & 0xFF;
+				message[offset + 6] = (ttl >> 8) & 0xFF;
+				message[offset + 7] = ttl & 0xFF;
+			}
+		}
+		offset += 10 + rdlength;
+	}
+	return 0;
+}
+
+
+
+static int cache_lookup(const unsigned char *key, size_t key_length, unsigned char *message, size_t *length)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	pthread_mutex_lock(&cache_mutex);
+
+	int e = cache_buckets[cache_hash(key, key_length)];
+	for (; e >= 0; e = cache_entries[e].next) {
+		if ((cache_entries[e].key_length == key_length)
+		 && (memcmp(cache_entries[e].key, key, key_length) == 0))
+			break;
+	}
+	if ((e < 0) || (cache_entries[e].expires <= ts.tv_sec) || (cache_entries[e].length > *length)) {
+		cache_statistics.misses++;
+		pthread_mutex_unlock(&cache_mutex);
+		return -1;
+	}
+
+	memcpy(message, cache_entries[e].message, cache_entries[e].length);
+	*length = cache_entries[e].length;
+	uint32_t elapsed = ts.tv_sec - cache_entries[e].stored;
+	cache_entries[e].last_used = ts.tv_sec;
+	if (cache_entries[e].negative)
+		cache_statistics.negative_hits++;
+	else
+		cache_statistics.hits++;
+
+	pthread_mutex_unlock(&cache_mutex);
+
+	// Serve the remaining TTL, not the original one.
+	uint32_t min_ttl, soa_ttl;
+	walk_records(message, *length, elapsed, &min_ttl, &soa_ttl);
+	return 0;
+}
+
+
+
+static void cache_store(const unsigned char *key, size_t key_length, const unsigned char *message, size_t length)
+{
+	unsigned char *copy;
+	uint32_t min_ttl, soa_ttl;
+	uint32_t ttl;
+	int negative = 0;
+
+	unsigned int rcode   = message[3] & 0x0F;
+	unsigned int ancount = (message[6] << 8) | message[7];
+
+	copy = malloc(length);
+	if (copy == NULL)
+		return;
+	memcpy(copy, message, length);
+
+	if (walk_records(copy, length, 0, &min_ttl, &soa_ttl) < 0) {
+		free(copy);
+		return;
+	}
+
+	if ((rcode == DNS_RCODE_NOERROR) && (ancount > 0)) {
+		ttl = min_ttl;
+	} else if ((rcode == DNS_RCODE_NXDOMAIN) || (rcode == DNS_RCODE_NOERROR)) {
+		// NXDOMAIN or NODATA.
+		negative = 1;
+		ttl = (soa_ttl > 0) ? soa_ttl : DNS_NEGATIVE_DEFAULT_TTL;
+		if (ttl > DNS_NEGATIVE_MAX_TTL)
+			ttl = DNS_NEGATIVE_MAX_TTL;
+	} else {
+		// SERVFAIL, REFUSED...: not cached.
+		free(copy);
+		return;
+	}
+	if (ttl == 0) {
+		free(copy);
+		return;
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	pthread_mutex_lock(&cache_mutex);
+
+	unsigned int bucket = cache_hash(key, key_length);
+
+	// Reuse the entry of the same question, or an expired one, or the least recently used.
+	int victim = -1;
+	for (int e = cache_buckets[bucket]; e >= 0; e = cache_entries[e].next) {
+		if ((cache_entries[e].key_length == key_length) && (memcmp(cache_entries[e].key, key, key_length) == 0)) {
+			victim = e;
+			break;
+		}
+	}
+	if (victim < 0) {
+		for (int e = 0; e < DNS_CACHE_ENTRIES; e++) {
+			if ((! cache_entries[e].used) || (cache_entries[e].expires <= ts.tv_sec)) {
+				victim = e;
+				break;
+			}
+			if ((victim < 0) || (cache_entries[e].last_used < cache_entries[victim].last_used))
+				victim = e;
+		}
+	}
+
+	// Unlink the victim from its bucket.
+	if (cache_entries[victim].used) {
+		int *link = &(cache_buckets[cache_hash(cache_entries[victim].key, cache_entries[victim].key_length)]);
+		while ((*link >= 0) && (*link != victim))
+			link = &(cache_entries[*link].next);
+		if (*link == victim)
+			*link = cache_entries[victim].next;
+		free(cache_entries[victim].message);
+	}
+
+	dns_entry_t *entry = &(cache_entries[victim]);
+	entry->used       = 1;
+	memcpy(entry->key, key, key_length);
+	entry->key_length = key_length;
+	entry->message    = copy;
+	entry->length     = length;
+	entry->stored     = ts.tv_sec;
+	entry->expires    = ts.tv_sec + ttl;
+	entry->last_used  = ts.tv_sec;
+	entry->negative   = negative;
+	entry->next       = cache_buckets[bucket];
+	cache_buckets[bucket] = victim;
+
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+
+
+static unsigned int cache_hash(const unsigned char *key, size_t key_length)
+{
+	// FNV-1a.
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < key_length; i++) {
+		hash ^= key[i];
+		hash *= 16777619u;
+	}
+	return hash % DNS_CACHE_BUCKETS;
+}
+
+
+
+static long long monotonic_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
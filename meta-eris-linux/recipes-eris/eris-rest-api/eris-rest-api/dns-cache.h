@@ -0,0 +1,20 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+	#include <stddef.h>
+
+	int  start_dns_cache(void);
+	void stop_dns_cache(void);
+	int  dns_cache_is_running(void);
+	void flush_dns_cache(void);
+
+	int  get_dns_cache_statistics(char **string, size_t *size, size_t *pos);
+
+#endif
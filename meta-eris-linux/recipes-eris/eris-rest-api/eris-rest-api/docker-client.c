@@ -0,0 +1,859 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#define _GNU_SOURCE   // strptime(), timegm().
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "docker-client.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define DOCKER_BUFFER_SIZE       4096
+#define DOCKER_EVENT_MAX         (64 * 1024)     // Longer events are dropped.
+#define DOCKER_BODY_MAX          (1024 * 1024)
+#define DOCKER_ID_LENGTH         72
+#define DOCKER_IO_TIMEOUT_S      5
+#define DOCKER_RETRY_DELAY_S     1
+
+// filters={"type":["container"]}
+#define DOCKER_EVENTS_PATH       "/events?filters=%7B%22type%22%3A%5B%22container%22%5D%7D"
+#define DOCKER_CONTAINERS_PATH   "/containers/json?all=1"
+
+#define HEALTH_STATUS_ACTION     "health_status: "
+// Set by start-containers on the containers of the slots.
+#define SLOT_LABEL               "org.eris-linux.slot"
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	int     sock;
+	char    buffer[DOCKER_BUFFER_SIZE];
+	size_t  start;
+	size_t  end;
+
+} docker_stream_t;
+
+
+typedef struct {
+
+	int     chunked;
+	long    remaining;      // Left in the current chunk or in the body, -1 if delimited by the end of file.
+	int     done;
+
+} docker_body_t;
+
+
+typedef struct {
+
+	container_state_t  state;
+	char               id[DOCKER_ID_LENGTH];
+
+} slot_entry_t;
+
+
+// ---------------------- Private method declarations.
+
+static void  *docker_client_thread  (void *arg);
+
+static int    open_docker_request   (const char *path, int timeout, docker_stream_t *stream, docker_body_t *body);
+static int    docker_get            (const char *path, char **content);
+static int    stream_fill           (docker_stream_t *stream);
+static int    stream_read_line      (docker_stream_t *stream, char *line, size_t size);
+static ssize_t read_body            (docker_stream_t *stream, docker_body_t *body, char *data, size_t size);
+
+static int    resync_containers     (void);
+static int    inspect_container     (const char *id, container_state_t *state);
+static void   read_events           (docker_stream_t *stream, docker_body_t *body);
+static void   handle_event          (const char *event);
+static int    slot_of_container     (const char *labels, const char *image);
+static int    slot_of_image         (const char *image);
+static time_t parse_docker_time     (const char *string);
+
+static const char *json_skip_spaces   (const char *p);
+static const char *json_skip_string   (const char *p);
+static const char *json_skip_value    (const char *p);
+static const char *json_find_member   (const char *object, const char *name);
+static const char *json_find_path     (const char *object, const char *path);
+static const char *json_first_element (const char *array);
+static const char *json_next_element  (const char *element);
+static int         json_get_string    (const char *value, char *buffer, size_t size);
+static int         json_get_long      (const char *value, long *number);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t  docker_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static slot_entry_t     slot_entries[DOCKER_MAX_SLOTS];
+static int              docker_connected = 0;
+
+static pthread_t        docker_thread;
+static int              docker_running = 0;
+
+
+// ---------------------- Public methods
+
+int start_docker_client(void)
+{
+	if (docker_running)
+		return 0;
+
+	for (int i = 0; i < DOCKER_MAX_SLOTS; i++)
+		slot_entries[i].state.exit_code = -1;
+
+	docker_running = 1;
+	if (pthread_create(&docker_thread, NULL, docker_client_thread, NULL) != 0) {
+		docker_running = 0;
+		return -1;
+	}
+	pthread_detach(docker_thread);
+	return 0;
+}
+
+
+
+int get_docker_slot_state(int slot, container_state_t *state)
+{
+	if ((slot < 0) || (slot >= DOCKER_MAX_SLOTS))
+		return -1;
+
+	pthread_mutex_lock(&docker_mutex);
+	int connected = docker_connected;
+	*state = slot_entries[slot].state;
+	pthread_mutex_unlock(&docker_mutex);
+
+	return connected ? 0 : -1;
+}
+
+
+// ---------------------- Private methods
+
+// Subscribe to the events before listing the containers, so that no change
+// is lost between the two. The events already reflected by the list are
+// recognized by the container id.
+static void *docker_client_thread(void *arg)
+{
+	static docker_stream_t stream;
+	docker_body_t body;
+
+	(void) arg;
+
+	for (;;) {
+		if (open_docker_request(DOCKER_EVENTS_PATH, 0, &stream, &body) == 200) {
+			if (resync_containers() == 0) {
+				pthread_mutex_lock(&docker_mutex);
+				docker_connected = 1;
+				pthread_mutex_unlock(&docker_mutex);
+
+				read_events(&stream, &body);
+
+				pthread_mutex_lock(&docker_mutex);
+				docker_connected = 0;
+				pthread_mutex_unlock(&docker_mutex);
+			}
+		}
+		if (stream.sock >= 0)
+			close(stream.sock);
+		stream.sock = -1;
+		sleep(DOCKER_RETRY_DELAY_S);
+	}
+	return NULL;
+}
+
+
+
+// Send a GET request on the docker socket and read the response header.
+// Return the HTTP status, or -1 if the daemon could not be reached.
+static int open_docker_request(const char *path, int timeout, docker_stream_t *stream, docker_body_t *body)
+{
+	struct sockaddr_un addr;
+	char line[DOCKER_BUFFER_SIZE];
+	long content_length = -1;
+	int status;
+
+	stream->sock  = -1;
+	stream->start = 0;
+	stream->end   = 0;
+	memset(body, 0, sizeof(docker_body_t));
+
+	int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+
+	if (timeout > 0) {
+		struct timeval tv = { .tv_sec = timeout, .tv_usec = 0 };
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, DOCKER_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+	if (connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+		close(sock);
+		return -1;
+	}
+
+	int length = snprintf(line, sizeof(line), "GET %s HTTP/1.1\r\nHost: docker\r\nConnection: close\r\n\r\n", path);
+	if (send(sock, line, length, MSG_NOSIGNAL) != length) {
+		close(sock);
+		return -1;
+	}
+	stream->sock = sock;
+
+	if ((stream_read_line(stream, line, sizeof(line)) != 0) || (sscanf(line, "HTTP/%*s %d", &status) != 1))
+		return -1;
+
+	for (;;) {
+		if (stream_read_line(stream, line, sizeof(line)) != 0)
+			return -1;
+		if (line[0] == '\0')
+			break;
+		if ((strncasecmp(line, "Transfer-Encoding:", 18) == 0) && (strcasestr(line + 18, "chunked") != NULL))
+			body->chunked = 1;
+		if (strncasecmp(line, "Content-Length:", 15) == 0)
+			content_length = atol(line + 15);
+	}
+	body->remaining = body->chunked ? 0 : content_length;
+
+	return status;
+}
+
+
+
+// Fill content with the NUL-terminated body of the response. Return 0 on success.
+static int docker_get(const char *path, char **content)
+{
+	docker_stream_t *stream;
+	docker_body_t body;
+	size_t length = 0;
+	int err = -1;
+
+	*content = NULL;
+	stream = malloc(sizeof(docker_stream_t));
+	if (stream == NULL)
+		return -1;
+
+	if (open_docker_request(path, DOCKER_IO_TIMEOUT_S, stream, &body) == 200) {
+		char *buffer = malloc(DOCKER_BUFFER_SIZE + 1);
+		size_t size = DOCKER_BUFFER_SIZE;
+		for (;;) {
+			if (buffer == NULL)
+				break;
+			if (length == size) {
+				char *larger = (size < DOCKER_BODY_MAX) ? realloc(buffer, 2 * size + 1) : NULL;
+				if (larger == NULL)
+					break;
+				buffer = larger;
+				size *= 2;
+			}
+			ssize_t n = read_body(stream, &body, buffer + length, size - length);
+			if (n < 0)
+				break;
+			if (n == 0) {
+				buffer[length] = '\0';
+				*content = buffer;
+				buffer = NULL;
+				err = 0;
+				break;
+			}
+			length += n;
+		}
+		free(buffer);
+	}
+	if (stream->sock >= 0)
+		close(stream->sock);
+	free(stream);
+
+	return err;
+}
+
+
+
+// Return the number of bytes received, 0 at end of file, -1 on error.
+static int stream_fill(docker_stream_t *stream)
+{
+	if (stream->start == stream->end) {
+		stream->start = 0;
+		stream->end   = 0;
+	}
+	if ((stream->end == DOCKER_BUFFER_SIZE) && (stream->start > 0)) {
+		memmove(stream->buffer, stream->buffer + stream->start, stream->end - stream->start);
+		stream->end  -= stream->start;
+		stream->start = 0;
+	}
+	if (stream->end == DOCKER_BUFFER_SIZE)
+		return -1;
+
+	for (;;) {
+		ssize_t n = recv(stream->sock, stream->buffer + stream->end, DOCKER_BUFFER_SIZE - stream->end, 0);
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n < 0)
+			return -1;
+		stream->end += n;
+		return n;
+	}
+}
+
+
+
+static int stream_read_line(docker_stream_t *stream, char *line, size_t size)
+{
+	for (;;) {
+		char *eol = memchr(stream->buffer + stream->start, '\n', stream->end - stream->start);
+		if (eol != NULL) {
+			size_t length = eol - (stream->buffer + stream->start);
+			if (length >= size)
+				length = size - 1;
+			memcpy(line, stream->buffer + stream->start, length);
+			line[length] = '\0';
+			if ((length > 0) && (line[length - 1] == '\r'))
+				line[length - 1] = '\0';
+			stream->start = eol - stream->buffer + 1;
+			return 0;
+		}
+		if (stream_fill(stream) <= 0)
+			return -1;
+	}
+}
+
+
+
+// Read the next piece of the body (chunks are decoded).
+// Return its length, 0 at the end of the body, -1 on error.
+static ssize_t read_body(docker_stream_t *stream, docker_body_t *body, char *data, size_t size)
+{
+	char line[64];
+
+	if (body->done)
+		return 0;
+
+	if (body->chunked && (body->remaining == 0)) {
+		char *end;
+		if (stream_read_line(stream, line, sizeof(line)) != 0)
+			return -1;
+		body->remaining = strtol(line, &end, 16);
+		if ((end == line) || (body->remaining < 0))
+			return -1;
+		if (body->remaining == 0) {
+			// Skip the trailer.
+			do {
+				if (stream_read_line(stream, line, sizeof(line)) != 0)
+					return -1;
+			} while (line[0] != '\0');
+			body->done = 1;
+			return 0;
+		}
+	}
+	if (body->remaining == 0) {
+		body->done = 1;
+		return 0;
+	}
+
+	if (stream->start == stream->end) {
+		int n = stream_fill(stream);
+		if (n < 0)
+			return -1;
+		if (n == 0) {
+			if (body->remaining > 0)
+				return -1;
+			body->done = 1;
+			return 0;
+		}
+	}
+
+	size_t length = stream->end - stream->start;
+	if (length > size)
+		length = size;
+	if ((body->remaining > 0) && (length > (size_t) body->remaining))
+		length = body->remaining;
+	memcpy(data, stream->buffer + stream->start, length);
+	stream->start += length;
+
+	if (body->remaining > 0) {
+		body->remaining -= length;
+		if (body->chunked && (body->remaining == 0))
+			if ((stream_read_line(stream, line, sizeof(line)) != 0) || (line[0] != '\0'))
+				return -1;
+	}
+	return length;
+}
+
+
+
+static int resync_containers(void)
+{
+	slot_entry_t entries[DOCKER_MAX_SLOTS];
+	char *list;
+
+	if (docker_get(DOCKER_CONTAINERS_PATH, &list) != 0)
+		return -1;
+
+	memset(entries, 0, sizeof(entries));
+	for (const char *element = json_first_element(list); element != NULL; element = json_next_element(element)) {
+		char image[128];
+		char id[DOCKER_ID_LENGTH];
+		container_state_t state;
+
+		if (json_get_string(json_find_member(element, "Image"), image, sizeof(image)) != 0)
+			image[0] = '\0';
+		int slot = slot_of_container(json_find_member(element, "Labels"), image);
+		if (slot < 0)
+			continue;
+		if (json_get_string(json_find_member(element, "Id"), id, sizeof(id)) != 0)
+			continue;
+		if (inspect_container(id, &state) != 0)
+			continue;
+		// Several containers may come from the same image: prefer the running one.
+		if (entries[slot].state.known && entries[slot].state.running && (! state.running))
+			continue;
+		entries[slot].state = state;
+		strcpy(entries[slot].id, id);
+	}
+	free(list);
+
+	pthread_mutex_lock(&docker_mutex);
+	for (int slot = 0; slot < DOCKER_MAX_SLOTS; slot++) {
+		slot_entry_t *previous = &(slot_entries[slot]);
+		slot_entry_t *current  = &(entries[slot]);
+
+		if (! current->state.known) {
+			// The container ended and was removed while we were not listening.
+			if (previous->state.known && previous->state.running) {
+				previous->state.running = 0;
+				strcpy(previous->state.status, "exited");
+			}
+			continue;
+		}
+		if (previous->state.known) {
+			if (strcmp(previous->id, current->id) != 0)
+				current->state.restarts += previous->state.restarts + 1;
+			else if (previous->state.restarts > current->state.restarts)
+				current->state.restarts = previous->state.restarts;
+			if (current->state.running)
+				current->state.exit_code = previous->state.exit_code;
+		}
+		*previous = *current;
+	}
+	pthread_mutex_unlock(&docker_mutex);
+
+	return 0;
+}
+
+
+
+static int inspect_container(const char *id, container_state_t *state)
+{
+	char path[128];
+	char string[64];
+	char *content;
+	long number;
+
+	memset(state, 0, sizeof(container_state_t));
+	state->exit_code = -1;
+
+	snprintf(path, sizeof(path), "/containers/%s/json", id);
+	if (docker_get(path, &content) != 0)
+		return -1;
+
+	const char *json_state = json_find_member(content, "State");
+	if (json_state == NULL) {
+		free(content);
+		return -1;
+	}
+	state->known = 1;
+
+	if (json_get_string(json_find_member(json_state, "Status"), state->status, sizeof(state->status)) != 0)
+		strcpy(state->status, "unknown");
+
+	const char *running = json_find_member(json_state, "Running");
+	state->running = (running != NULL) && (strncmp(running, "true", 4) == 0);
+
+	if (json_get_string(json_find_member(json_state, "StartedAt"), string, sizeof(string)) == 0)
+		state->started = parse_docker_time(string);
+
+	if (json_get_string(json_find_path(json_state, "Health.Status"), state->health, sizeof(state->health)) != 0)
+		strcpy(state->health, "none");
+
+	if ((! state->running) && (state->started != 0) && (json_get_long(json_find_member(json_state, "ExitCode"), &number) == 0))
+		state->exit_code = number;
+
+	if (json_get_long(json_find_member(content, "RestartCount"), &number) == 0)
+		state->restarts = number;
+
+	free(content);
+	return 0;
+}
+
+
+
+// The events are JSON objects separated by newlines, possibly split over several chunks.
+static void read_events(docker_stream_t *stream, docker_body_t *body)
+{
+	char *pending = malloc(DOCKER_EVENT_MAX + 1);
+	size_t length = 0;
+	int discarding = 0;
+
+	if (pending == NULL)
+		return;
+
+	for (;;) {
+		ssize_t n = read_body(stream, body, pending + length, DOCKER_EVENT_MAX - length);
+		if (n <= 0)
+			break;
+		length += n;
+
+		char *eol;
+		while ((eol = memchr(pending, '\n', length)) != NULL) {
+			*eol = '\0';
+			if (! discarding)
+				handle_event(pending);
+			discarding = 0;
+			length -= eol + 1 - pending;
+			memmove(pending, eol + 1, length);
+		}
+		if (length == DOCKER_EVENT_MAX) {
+			discarding = 1;
+			length = 0;
+		}
+	}
+	free(pending);
+}
+
+
+
+static void handle_event(const char *event)
+{
+	char type[32];
+	char action[64];
+	char id[DOCKER_ID_LENGTH];
+	char image[128];
+	char string[16];
+	container_state_t inspected;
+	long number;
+
+	if ((json_get_string(json_find_member(event, "Type"), type, sizeof(type)) != 0) || (strcmp(type, "container") != 0))
+		return;
+	if (json_get_string(json_find_member(event, "Action"), action, sizeof(action)) != 0)
+		return;
+	if (json_get_string(json_find_path(event, "Actor.ID"), id, sizeof(id)) != 0)
+		return;
+	// The labels of the container are given among the attributes.
+	const char *attributes = json_find_path(event, "Actor.Attributes");
+	if (json_get_string(json_find_member(attributes, "image"), image, sizeof(image)) != 0)
+		image[0] = '\0';
+
+	int slot = slot_of_container(attributes, image);
+	if (slot < 0)
+		return;
+
+	time_t date = time(NULL);
+	if (json_get_long(json_find_member(event, "time"), &number) == 0)
+		date = number;
+
+	// The health check configuration is only known by inspecting the container.
+	int have_inspected = 0;
+	if (strcmp(action, "start") == 0)
+		have_inspected = (inspect_container(id, &inspected) == 0);
+
+	pthread_mutex_lock(&docker_mutex);
+	slot_entry_t *entry = &(slot_entries[slot]);
+
+	if (strcmp(action, "create") == 0) {
+		if (! entry->state.running) {
+			entry->state.known = 1;
+			strcpy(entry->state.status, "created");
+		}
+
+	} else if (strcmp(action, "start") == 0) {
+		if ((strcmp(entry->id, id) != 0) || (! entry->state.running)) {
+			if (entry->state.started != 0)
+				entry->state.restarts++;
+			entry->state.known   = 1;
+			entry->state.running = 1;
+			entry->state.started = date;
+			strcpy(entry->state.status, "running");
+			strcpy(entry->state.health, have_inspected ? inspected.health : "none");
+			snprintf(entry->id, sizeof(entry->id), "%s", id);
+		}
+
+	} else if (strcmp(action, "die") == 0) {
+		if (strcmp(entry->id, id) == 0) {
+			entry->state.running = 0;
+			strcpy(entry->state.status, "exited");
+			if (json_get_string(json_find_path(event, "Actor.Attributes.exitCode"), string, sizeof(string)) == 0)
+				entry->state.exit_code = atoi(string);
+		}
+
+	} else if ((strcmp(action, "pause") == 0) || (strcmp(action, "unpause") == 0)) {
+		if ((strcmp(entry->id, id) == 0) && entry->state.running)
+			strcpy(entry->state.status, action[0] == 'p' ? "paused" : "running");
+
+	} else if (strncmp(action, HEALTH_STATUS_ACTION, strlen(HEALTH_STATUS_ACTION)) == 0) {
+		if (strcmp(entry->id, id) == 0)
+			snprintf(entry->state.health, sizeof(entry->state.health), "%s", action + strlen(HEALTH_STATUS_ACTION));
+	}
+	pthread_mutex_unlock(&docker_mutex);
+}
+
+
+
+// After a warm switch, the image of the container is only known by its
+// ID: the slot is given by the label of the container, or by the name of
+// the image for the containers started without it.
+static int slot_of_container(const char *labels, const char *image)
+{
+	char value[16];
+	int number;
+
+	if ((json_get_string(json_find_member(labels, SLOT_LABEL), value, sizeof(value)) == 0)
+	 && (sscanf(value, "%d", &number) == 1) && (number >= 1) && (number <= DOCKER_MAX_SLOTS))
+		return number - 1;
+	return slot_of_image(image);
+}
+
+
+
+// The containers are run from the images "slot-1" to "slot-4".
+static int slot_of_image(const char *image)
+{
+	int number;
+	int length;
+
+	if (sscanf(image, "slot-%d%n", &number, &length) != 1)
+		return -1;
+	if ((image[length] != '\0') && (image[length] != ':'))
+		return -1;
+	if ((number < 1) || (number > DOCKER_MAX_SLOTS))
+		return -1;
+	return number - 1;
+}
+
+
+
+// Dates are given in UTC as "2026-01-31T12:34:56.123456789Z".
+static time_t parse_docker_time(const char *string)
+{
+	struct tm tm;
+
+	memset(&tm, 0, sizeof(tm));
+	if (strptime(string, "%Y-%m-%dT%H:%M:%S", &tm) == NULL)
+		return 0;
+	if (tm.tm_year < 70)
+		return 0;
+	return timegm(&tm);
+}
+
+
+
+static const char *json_skip_spaces(const char *p)
+{
+	while ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n'))
+		p++;
+	return p;
+}
+
+
+
+static const char *json_skip_string(const char *p)
+{
+	if (*p != '"')
+		return NULL;
+	for (p++; *p != '\0'; p++) {
+		if (*p == '"')
+			return p + 1;
+		if ((*p == '\\') && (*(++p) == '\0'))
+			return NULL;
+	}
+	return NULL;
+}
+
+
+
+static const char *json_skip_value(const char *p)
+{
+	int depth = 0;
+
+	p = json_skip_spaces(p);
+	if ((*p != '{') && (*p != '[')) {
+		if (*p == '"')
+			return json_skip_string(p);
+		while ((*p != '\0') && (strchr(",}] \t\r\n", *p) == NULL))
+			p++;
+		return p;
+	}
+
+	while (*p != '\0') {
+		if (*p == '"') {
+			p = json_skip_string(p);
+			if (p == NULL)
+				return NULL;
+			continue;
+		}
+		if ((*p == '{') || (*p == '['))
+			depth++;
+		if ((*p == '}') || (*p == ']'))
+			depth--;
+		p++;
+		if (depth == 0)
+			return p;
+	}
+	return NULL;
+}
+
+
+
+// Return a pointer on the value of the member, or NULL if it doesn't exist.
+static const char *json_find_member(const char *object, const char *name)
+{
+	size_t length = strlen(name);
+
+	if (object == NULL)
+		return NULL;
+	const char *p = json_skip_spaces(object);
+	if (*p != '{')
+		return NULL;
+	p++;
+
+	for (;;) {
+		p = json_skip_spaces(p);
+		if (*p != '"')
+			return NULL;
+		const char *key = p + 1;
+		p = json_skip_string(p);
+		if (p == NULL)
+			return NULL;
+		int match = ((size_t) (p - 1 - key) == length) && (strncmp(key, name, length) == 0);
+		p = json_skip_spaces(p);
+		if (*p != ':')
+			return NULL;
+		p = json_skip_spaces(p + 1);
+		if (match)
+			return p;
+		p = json_skip_value(p);
+		if (p == NULL)
+			return NULL;
+		p = json_skip_spaces(p);
+		if (*p != ',')
+			return NULL;
+		p++;
+	}
+}
+
+
+
+// The path is a list of member names separated by dots.
+static const char *json_find_path(const char *object, const char *path)
+{
+	char name[64];
+
+	while ((object != NULL) && (*path != '\0')) {
+		size_t length = strcspn(path, ".");
+		if (length >= sizeof(name))
+			return NULL;
+		memcpy(name, path, length);
+		name[length] = '\0';
+		object = json_find_member(object, name);
+		path += length;
+		if (*path == '.')
+			path++;
+	}
+	return object;
+}
+
+
+
+static const char *json_first_element(const char *array)
+{
+	const char *p = json_skip_spaces(array);
+	if (*p != '[')
+		return NULL;
+	p = json_skip_spaces(p + 1);
+	if ((*p == ']') || (*p == '\0'))
+		return NULL;
+	return p;
+}
+
+
+
+static const char *json_next_element(const char *element)
+{
+	const char *p = json_skip_value(element);
+	if (p == NULL)
+		return NULL;
+	p = json_skip_spaces(p);
+	if (*p != ',')
+		return NULL;
+	return json_skip_spaces(p + 1);
+}
+
+
+
+// Unicode escapes are replaced by '?', the string is truncated to the buffer size.
+static int json_get_string(const char *value, char *buffer, size_t size)
+{
+	size_t length = 0;
+
+	if ((value == NULL) || (*value != '"') || (size == 0))
+		return -1;
+
+	for (value++; *value != '"'; value++) {
+		char c = *value;
+		if (c == '\0')
+			return -1;
+		if (c == '\\') {
+			value++;
+			switch (*value) {
+				case '\0': return -1;
+				case 'n':  c = '\n'; break;
+				case 't':  c = '\t'; break;
+				case 'r':  c = '\r'; break;
+				case 'b':  c = '\b'; break;
+				case 'f':  c = '\f'; break;
+				case 'u':
+					c = '?';
+					for (int i = 0; (i < 4) && (value[1] != '\0') && (value[1] != '"'); i++)
+						value++;
+					break;
+				default:   c = *value; break;
+			}
+		}
+		if (length < size - 1)
+			buffer[length++] = c;
+	}
+	buffer[length] = '\0';
+	return 0;
+}
+
+
+
+static int json_get_long(const char *value, long *number)
+{
+	char *end;
+
+	if (value == NULL)
+		return -1;
+	*number = strtol(value, &end, 10);
+	if (end == value)
+		return -1;
+	return 0;
+}
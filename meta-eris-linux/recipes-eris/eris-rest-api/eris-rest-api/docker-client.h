@@ -0,0 +1,34 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef DOCKER_CLIENT_H
+#define DOCKER_CLIENT_H
+
+	#include <time.h>
+
+	#define DOCKER_SOCKET_PATH   "/var/run/docker.sock"
+	#define DOCKER_MAX_SLOTS     4
+
+	typedef struct {
+
+		int     known;          // A container has been seen in the slot.
+		int     running;        // Also set while the container is paused.
+		char    status[16];     // created, running, paused, restarting, exited, dead.
+		char    health[16];     // none, starting, healthy, unhealthy.
+		time_t  started;        // Wall-clock time of the last start.
+		int     restarts;       // Starts observed after the first one.
+		int     exit_code;      // -1 if the container never exited.
+
+	} container_state_t;
+
+	int start_docker_client(void);
+
+	// The slot is numbered from 0. Return -1 until the table is synchronized
+	// with the docker events.
+	int get_docker_slot_state(int slot, container_state_t *state);
+
+#endif
@@ -0,0 +1,361 @@
+/*
+ *  ERIS LINUX BLOCK DELTA
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Block delta between two system images (see block-delta.h).
+//
+//   eris-block-delta create [-b <block size>] <old.img> <new.img> > delta   (build host)
+//   eris-block-delta apply <old.img> <delta> > new.img                     (check)
+//
+// The delta is then compressed, signed and installed like a full image
+// (POST /api/update/install), the running partition being the source. The
+// blocks of the new image found anywhere in the old one are copied from
+// it, the others are carried by the delta.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "block-delta.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define DEFAULT_BLOCK_SIZE  4096
+#define DATA_RECORD_BYTES   (1024 * 1024)
+
+#define EXIT_BAD_INPUT      2
+#define EXIT_BAD_BASE       3
+#define EXIT_BAD_TARGET     4
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	uint64_t  hash;
+	uint64_t  block;       // UINT64_MAX: empty entry.
+
+} index_entry_t;
+
+
+typedef struct {
+
+	int             op;           // 0: no record in progress.
+	uint64_t        first;        // First block of a copy.
+	uint32_t        count;
+	unsigned char  *data;         // Blocks of a data record.
+
+} record_t;
+
+
+// ---------------------- Private method declarations.
+
+static int       create_delta      (const char *old_name, const char *new_name, uint32_t block_size);
+static int       apply_delta       (const char *old_name, const char *delta_name);
+static int       write_stdout      (const unsigned char *data, size_t length);
+static int       read_block        (int fd, uint64_t size, uint64_t index, uint32_t block_size, unsigned char *block);
+static int       flush_record      (record_t *record, uint32_t block_size);
+static uint64_t  hash_block        (const unsigned char *block, uint32_t block_size);
+static void      put_le32          (unsigned char *p, uint32_t value);
+static void      put_le64          (unsigned char *p, uint64_t value);
+
+
+// ---------------------- Public methods
+
+int main(int argc, char *argv[])
+{
+	uint32_t block_size = DEFAULT_BLOCK_SIZE;
+
+	if ((argc == 6) && (strcmp(argv[1], "create") == 0) && (strcmp(argv[2], "-b") == 0)) {
+		block_size = strtoul(argv[3], NULL, 0);
+		if ((block_size < BLOCK_DELTA_MIN_BLOCK) || (block_size > BLOCK_DELTA_MAX_BLOCK)) {
+			fprintf(stderr, "%s: block size must be between %d and %d.\n", argv[0], BLOCK_DELTA_MIN_BLOCK, BLOCK_DELTA_MAX_BLOCK);
+			return EXIT_BAD_INPUT;
+		}
+		return create_delta(argv[4], argv[5], block_size);
+	}
+	if ((argc == 4) && (strcmp(argv[1], "create") == 0))
+		return create_delta(argv[2], argv[3], block_size);
+	if ((argc == 4) && (strcmp(argv[1], "apply") == 0))
+		return apply_delta(argv[2], argv[3]);
+
+	fprintf(stderr, "usage: %s create [-b <block size>] <old.img> <new.img> > delta\n", argv[0]);
+	fprintf(stderr, "       %s apply <old.img> <delta> > new.img\n", argv[0]);
+	return EXIT_BAD_INPUT;
+}
+
+
+// ---------------------- Private methods
+
+static int create_delta(const char *old_name, const char *new_name, uint32_t block_size)
+{
+	unsigned char header[BLOCK_DELTA_HEADER_SIZE];
+	unsigned char digest[32];
+	unsigned int digest_length = sizeof(digest);
+	record_t record = { 0, 0, 0, NULL };
+	uint64_t copied = 0;
+	uint64_t moved = 0;
+	uint64_t zeros = 0;
+	uint64_t carried = 0;
+
+	int old_fd = open(old_name, O_RDONLY);
+	int new_fd = open(new_name, O_RDONLY);
+	if ((old_fd < 0) || (new_fd < 0)) {
+		perror("open");
+		return EXIT_BAD_INPUT;
+	}
+	// Works for block devices too.
+	uint64_t old_size = lseek(old_fd, 0, SEEK_END);
+	uint64_t new_size = lseek(new_fd, 0, SEEK_END);
+	uint64_t old_blocks = (old_size + block_size - 1) / block_size;
+	uint64_t new_blocks = (new_size + block_size - 1) / block_size;
+
+	unsigned char *block = malloc(block_size);
+	unsigned char *other = malloc(block_size);
+	unsigned char *zero = calloc(1, block_size);
+	record.data = malloc(DATA_RECORD_BYTES > block_size ? DATA_RECORD_BYTES : block_size);
+	if ((block == NULL) || (other == NULL) || (zero == NULL) || (record.data == NULL))
+		return EXIT_BAD_INPUT;
+
+	// Index of the blocks of the old image (open addressing).
+	uint64_t index_size = 1024;
+	while (index_size < 2 * old_blocks)
+		index_size *= 2;
+	index_entry_t *index = malloc(index_size * sizeof(index_entry_t));
+	if (index == NULL)
+		return EXIT_BAD_INPUT;
+	for (uint64_t i = 0; i < index_size; i++)
+		index[i].block = UINT64_MAX;
+	for (uint64_t b = 0; b < old_blocks; b++) {
+		if (read_block(old_fd, old_size, b, block_size, block) != 0)
+			return EXIT_BAD_BASE;
+		if (memcmp(block, zero, block_size) == 0)
+			continue;
+		uint64_t hash = hash_block(block, block_size);
+		uint64_t slot = hash & (index_size - 1);
+		while ((index[slot].block != UINT64_MAX) && (index[slot].hash != hash))
+			slot = (slot + 1) & (index_size - 1);
+		// The first occurrence of a block is kept.
+		if (index[slot].block == UINT64_MAX) {
+			index[slot].hash = hash;
+			index[slot].block = b;
+		}
+	}
+
+	// Digest of the new image, given in the header.
+	EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+	if ((ctx == NULL) || (EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) != 1))
+		return EXIT_BAD_INPUT;
+	for (uint64_t b = 0; b < new_blocks; b++) {
+		if (read_block(new_fd, new_size, b, block_size, block) != 0)
+			return EXIT_BAD_TARGET;
+		uint64_t length = new_size - b * block_size;
+		EVP_DigestUpdate(ctx, block, (length < block_size) ? length : block_size);
+	}
+	EVP_DigestFinal_ex(ctx, digest, &digest_length);
+	EVP_MD_CTX_free(ctx);
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, BLOCK_DELTA_MAGIC, strlen(BLOCK_DELTA_MAGIC));
+	put_le32(header + 8, block_size);
+	put_le64(header + 16, old_size);
+	put_le64(header + 24, new_size);
+	memcpy(header + 32, digest, sizeof(digest));
+	if (write_stdout(header, sizeof(header)) != 0)
+		return EXIT_BAD_INPUT;
+
+	for (uint64_t b = 0; b < new_blocks; b++) {
+		if (read_block(new_fd, new_size, b, block_size, block) != 0)
+			return EXIT_BAD_TARGET;
+
+		int op = BLOCK_DELTA_DATA;
+		uint64_t source = 0;
+		if (memcmp(block, zero, block_size) == 0) {
+			op = BLOCK_DELTA_ZERO;
+			zeros++;
+		} else if ((b < old_blocks) && (read_block(old_fd, old_size, b, block_size, other) == 0)
+		        && (memcmp(block, other, block_size) == 0)) {
+			op = BLOCK_DELTA_COPY;
+			source = b;
+			copied++;
+		} else {
+			uint64_t hash = hash_block(block, block_size);
+			uint64_t slot = hash & (index_size - 1);
+			while ((index[slot].block != UINT64_MAX) && (index[slot].hash != hash))
+				slot = (slot + 1) & (index_size - 1);
+			if ((index[slot].block != UINT64_MAX)
+			 && (read_block(old_fd, old_size, index[slot].block, block_size, other) == 0)
+			 && (memcmp(block, other, block_size) == 0)) {
+				op = BLOCK_DELTA_COPY;
+				source = index[slot].block;
+				moved++;
+			}
+		}
+		if (op == BLOCK_DELTA_DATA)
+			carried++;
+
+		// Extend the current record, or start a new one.
+		int extend = (op == record.op);
+		if (extend && (op == BLOCK_DELTA_COPY))
+			extend = (source == record.first + record.count);
+		if (extend && (op == BLOCK_DELTA_DATA))
+			extend = ((record.count + 1) * (uint64_t) block_size <= DATA_RECORD_BYTES);
+		if (extend && (record.count == UINT32_MAX))
+			extend = 0;
+		if (! extend) {
+			if (flush_record(&record, block_size) != 0)
+				return EXIT_BAD_INPUT;
+			record.op = op;
+			record.first = source;
+			record.count = 0;
+		}
+		if (op == BLOCK_DELTA_DATA)
+			memcpy(record.data + record.count * (size_t) block_size, block, block_size);
+		record.count++;
+	}
+	unsigned char end = BLOCK_DELTA_END;
+	if ((flush_record(&record, block_size) != 0) || (write_stdout(&end, 1) != 0))
+		return EXIT_BAD_INPUT;
+
+	fprintf(stderr, "%llu blocks: %llu unchanged, %llu moved, %llu zero, %llu new.\n",
+	        (unsigned long long) new_blocks, (unsigned long long) copied, (unsigned long long) moved,
+	        (unsigned long long) zeros, (unsigned long long) carried);
+	free(index);
+	free(record.data);
+	free(zero);
+	free(other);
+	free(block);
+	close(old_fd);
+	close(new_fd);
+	return EXIT_SUCCESS;
+}
+
+
+
+static int apply_delta(const char *old_name, const char *delta_name)
+{
+	unsigned char buffer[64 * 1024];
+	block_delta_t delta;
+
+	int old_fd = open(old_name, O_RDONLY);
+	FILE *fp = (strcmp(delta_name, "-") == 0) ? stdin : fopen(delta_name, "r");
+	if ((old_fd < 0) || (fp == NULL)) {
+		perror("open");
+		return EXIT_BAD_INPUT;
+	}
+	if (block_delta_init(&delta, old_fd, write_stdout) != 0)
+		return EXIT_BAD_INPUT;
+
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+		if (block_delta_feed(&delta, buffer, n) != 0)
+			break;
+
+	int err = block_delta_finish(&delta);
+	if (err != 0)
+		fprintf(stderr, "%s\n", delta.error);
+	block_delta_release(&delta);
+	close(old_fd);
+	if (fp != stdin)
+		fclose(fp);
+	return (err == 0) ? EXIT_SUCCESS : EXIT_BAD_TARGET;
+}
+
+
+
+static int write_stdout(const unsigned char *data, size_t length)
+{
+	return (fwrite(data, 1, length, stdout) == length) ? 0 : -1;
+}
+
+
+
+// Blocks are padded with zeros after the end of the image.
+static int read_block(int fd, uint64_t size, uint64_t index, uint32_t block_size, unsigned char *block)
+{
+	uint64_t offset = index * block_size;
+	size_t length = block_size;
+
+	if (offset >= size)
+		return -1;
+	if (length > size - offset)
+		length = size - offset;
+
+	size_t done = 0;
+	while (done < length) {
+		ssize_t n = pread(fd, block + done, length - done, offset + done);
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0)
+			return -1;
+		done += n;
+	}
+	memset(block + length, 0, block_size - length);
+	return 0;
+}
+
+
+
+static int flush_record(record_t *record, uint32_t block_size)
+{
+	unsigned char args[13];
+	size_t length = 0;
+
+	if ((record->op == 0) || (record->count == 0))
+		return 0;
+
+	args[length++] = record->op;
+	if (record->op == BLOCK_DELTA_COPY) {
+		put_le64(args + length, record->first);
+		length += 8;
+	}
+	put_le32(args + length, record->count);
+	length += 4;
+	if (write_stdout(args, length) != 0)
+		return -1;
+	if ((record->op == BLOCK_DELTA_DATA) && (write_stdout(record->data, record->count * (size_t) block_size) != 0))
+		return -1;
+	record->op = 0;
+	record->count = 0;
+	return 0;
+}
+
+
+
+// FNV-1a.
+static uint64_t hash_block(const unsigned char *block, uint32_t block_size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (uint32_t i = 0; i < block_size; i++) {
+		hash ^= block[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+
+static void put_le32(unsigned char *p, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		p[i] = value >> (8 * i);
+}
+
+
+
+static void put_le64(unsigned char *p, uint64_t value)
+{
+	put_le32(p, value);
+	put_le32(p + 4, value >> 32);
+}
@@ -16,12 +16,16 @@
 
 #include "addsnprintf.h"
 #include "eris-rest-api.h"
+#include "events-rest-api.h"
+#include "exec-job.h"
 #include "gpio-rest-api.h"
 #include "net-rest-api.h"
+#include "net-selftest.h"
 #include "sbom-rest-api.h"
 #include "system-rest-api.h"
 #include "time-rest-api.h"
 #include "update-rest-api.h"
+#include "upload-rest-api.h"
 #include "wdog-rest-api.h"
 
 
@@ -36,6 +40,8 @@
 
 static enum MHD_Result eris_rest_api_handler(void *, struct MHD_Connection *, const char *, const char *, const char *, const char *a, size_t *, void **);
 
+static void eris_rest_api_completed(void *, struct MHD_Connection *, void **, enum MHD_RequestTerminationCode);
+
 static int eris_rest_api_init(int argc, char *argv[]);
 
 static enum MHD_Result eris_rest_api(struct MHD_Connection *connection, const char *url, const char *method);
@@ -53,12 +59,14 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 
 	daemon = MHD_start_daemon(
-		MHD_USE_SELECT_INTERNALLY,  // flags.
+		MHD_USE_SELECT_INTERNALLY   // flags.
+		| MHD_ALLOW_SUSPEND_RESUME, //   connections wait for commands suspended.
 		8080,                       // port.
 		NULL,                       // apc: callback to check authorized clients. NULL = all IP.
 		NULL,                       // apc_cls: extra argument to apc.
 		&eris_rest_api_handler,     // dh: default handler for all URI.
 		NULL,                       // dh_cls: extra argument to dh.
+		MHD_OPTION_NOTIFY_COMPLETED, &eris_rest_api_completed, NULL,
 		MHD_OPTION_END              // End of arguments.
 	);
 
@@ -188,13 +196,26 @@ static enum MHD_Result eris_rest_api_handler(
 {
 	(void) cls;
 	(void) version;
-	(void) upload_data;
-	(void) upload_data_size;
-	(void) ptr;
+
+	// The times to convert are read from the body.
+	if (is_time_convert_request(url, method))
+		return time_convert_rest_api(connection, upload_data, upload_data_size, ptr);
+
+	// The body of the uploads is processed as it arrives.
+	if ((*ptr != NULL) || is_upload_request(url, method))
+		return upload_rest_api(connection, url, upload_data, upload_data_size, ptr);
+
+	// Connection resumed at the end of a command.
+	enum MHD_Result ret;
+	if (resume_command_reply(connection, &ret))
+		return ret;
 
 	if (strcasecmp(url, "/api") == 0)
 		return eris_rest_api(connection, url, method);
 
+	if (strncasecmp(url, "/api/events", 11) == 0)
+		return events_rest_api(connection, url, method);
+
 	if (strncasecmp(url, "/api/gpio", 9) == 0)
 		return gpio_rest_api(connection, url, method);
 
@@ -223,8 +244,27 @@ static enum MHD_Result eris_rest_api_handler(
 
 
 
+static void eris_rest_api_completed(void *cls, struct MHD_Connection *connection, void **ptr, enum MHD_RequestTerminationCode code)
+{
+	(void) cls;
+	(void) code;
+
+	release_upload(connection, ptr);
+	release_command_jobs(connection);
+	release_net_selftest(connection);
+	release_time_convert(ptr);
+}
+
+
+
 static int eris_rest_api_init(int argc, char *argv[])
 {
+	if (init_exec_jobs() != 0)
+		return -1;
+
+	if (init_events_rest_api(argv[0]) != 0)
+		return -1;
+
 	if (init_gpio_rest_api(argv[0]) != 0)
 		return -1;
 
@@ -243,6 +283,9 @@ static int eris_rest_api_init(int argc, char *argv[])
 	if (init_update_rest_api(argv[0]) != 0)
 		return -1;
 
+	if (init_upload_rest_api(argv[0]) != 0)
+		return -1;
+
 	if (init_wdog_rest_api(argv[0]) != 0)
 		return -1;
 
@@ -257,6 +300,7 @@ static enum MHD_Result eris_rest_api(struct MHD_Connection *connection, const ch
 		char * message =
 			"Welcome on the Eris-Linux REST API.\n"
 			"Here are some API modules endpoints:\n"
+			"  /api/events     stream of the update and reboot state changes,\n"
 			"  /api/gpio       access to GPIO-based features,\n"
 			"  /api/network    access to network setup functions,\n"
 			"  /api/package    access to package versions and licenses,\n"
@@ -3,6 +3,13 @@
 
 #include <microhttpd.h>
 
+// The requests reading a body keep their state in the con_cls pointer of
+// MHD until the completion callback. The state starts with its kind.
+typedef enum {
+	REQUEST_UPLOAD = 1,
+	REQUEST_TIME_CONVERT,
+} request_kind_t;
+
 enum MHD_Result send_rest_error    (struct MHD_Connection *connection, const char *err_message, unsigned int err_code);
 enum MHD_Result send_rest_response (struct MHD_Connection *connection, const char *reply_message);
 
@@ -0,0 +1,376 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// State changes of the device, streamed on GET /api/events (server-sent
+// events). The flag files of /tmp and the parameters file are watched with
+// inotify; a change of state wakes the suspended subscribers up. Each
+// subscriber receives the current state of every event first, then the new
+// values only: a state changing several times before being sent is sent
+// once, with its last value.
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/inotify.h>
+
+#include "eris-rest-api.h"
+#include "events-rest-api.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define FLAG_FILES_DIR             "/tmp"
+#define SYSTEM_UPDATE_STATUS_NAME  "system-update-status"
+#define REBOOT_NEEDED_FLAG_NAME    "reboot-is-needed"
+#define BOOT_ENDED_FLAG_NAME       "boot-ended"
+
+#define PARAMETERS_DIR             "/etc/eris-linux"
+#define PARAMETERS_NAME            "parameters"
+#define CONTACT_PERIOD_PREFIX      "status_upload_period_seconds="
+
+#define EVENTS_WATCH_EVENTS        (IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM)
+#define EVENTS_RETRY_DELAY_S       5
+// The suspended connections don't see their client going away.
+#define EVENTS_IDLE_RESUME_MS      30000
+
+#define EVENT_VALUE_MAX            32
+#define EVENTS_BLOCK_SIZE          1024
+
+
+// ---------------------- Private types definitions.
+
+typedef enum {
+
+	EVENT_UPDATE_STATUS = 0,
+	EVENT_REBOOT_NEEDED,
+	EVENT_BOOT_ENDED,
+	EVENT_CONTACT_PERIOD,
+	EVENTS_COUNT
+
+} event_kind_t;
+
+
+typedef struct event_subscriber {
+
+	struct MHD_Connection    *connection;
+	unsigned long             sent[EVENTS_COUNT];    // Versions of the states sent.
+	int                       suspended;
+
+	struct event_subscriber  *next;
+
+} event_subscriber_t;
+
+
+// ---------------------- Private method declarations.
+
+static void    *events_thread          (void *arg);
+static int      watch_event_files      (int fd, int *flags_wd, int *parameters_wd);
+static int      update_event           (event_kind_t kind);
+static void     read_event_value       (event_kind_t kind, char *value);
+static void     resume_subscribers     (void);
+static ssize_t  read_subscriber        (void *cls, uint64_t pos, char *buffer, size_t max);
+static void     free_subscriber        (void *cls);
+
+
+// ---------------------- Private variables declarations.
+
+static const char *event_names[EVENTS_COUNT] = {
+	"update-status",
+	"reboot-needed",
+	"boot-ended",
+	"contact-period",
+};
+
+static pthread_mutex_t     events_mutex = PTHREAD_MUTEX_INITIALIZER;
+static event_subscriber_t *event_subscribers = NULL;
+
+static char                event_values[EVENTS_COUNT][EVENT_VALUE_MAX];
+static unsigned long       event_versions[EVENTS_COUNT];
+
+
+// ---------------------- Public methods
+
+int init_events_rest_api(const char *app)
+{
+	pthread_t thread;
+
+	(void) app;
+
+	for (int kind = 0; kind < EVENTS_COUNT; kind++)
+		update_event(kind);
+
+	if (pthread_create(&thread, NULL, events_thread, NULL) != 0)
+		return -1;
+	pthread_detach(thread);
+	return 0;
+}
+
+
+
+enum MHD_Result events_rest_api(struct MHD_Connection *connection, const char *url, const char *method)
+{
+	if ((strcasecmp(url, "/api/events") != 0) || (strcmp(method, "GET") != 0))
+		return MHD_NO;
+
+	event_subscriber_t *subscriber = calloc(1, sizeof(event_subscriber_t));
+	if (subscriber == NULL)
+		return send_rest_error(connection, "Not enough memory.", 500);
+	subscriber->connection = connection;
+
+	struct MHD_Response *response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, EVENTS_BLOCK_SIZE,
+	                                                                  read_subscriber, subscriber, free_subscriber);
+	if (response == NULL) {
+		free(subscriber);
+		return send_rest_error(connection, "Not enough memory.", 500);
+	}
+	MHD_add_response_header(response, "Content-Type", "text/event-stream");
+	MHD_add_response_header(response, "Cache-Control", "no-cache");
+
+	pthread_mutex_lock(&events_mutex);
+	subscriber->next = event_subscribers;
+	event_subscribers = subscriber;
+	pthread_mutex_unlock(&events_mutex);
+
+	enum MHD_Result ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+	MHD_destroy_response(response);
+	return ret;
+}
+
+
+// ---------------------- Private methods
+
+static void *events_thread(void *arg)
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	int flags_wd;
+	int parameters_wd;
+
+	(void) arg;
+
+	for (;;) {
+		int fd = inotify_init1(IN_CLOEXEC);
+		if (fd < 0) {
+			sleep(EVENTS_RETRY_DELAY_S);
+			continue;
+		}
+		if (watch_event_files(fd, &flags_wd, &parameters_wd) != 0) {
+			close(fd);
+			sleep(EVENTS_RETRY_DELAY_S);
+			continue;
+		}
+		// The files may have changed before the watches were set.
+		int changed = 0;
+		for (int kind = 0; kind < EVENTS_COUNT; kind++)
+			changed |= update_event(kind);
+		if (changed)
+			resume_subscribers();
+
+		int watching = 1;
+		while (watching) {
+			struct pollfd pfd = { .fd = fd, .events = POLLIN };
+			int err = poll(&pfd, 1, EVENTS_IDLE_RESUME_MS);
+			if ((err < 0) && (errno == EINTR))
+				continue;
+			if (err < 0)
+				break;
+			if (err == 0) {
+				resume_subscribers();
+				continue;
+			}
+			ssize_t n = read(fd, buffer, sizeof(buffer));
+			if ((n < 0) && (errno == EINTR))
+				continue;
+			if (n <= 0)
+				break;
+
+			int modified[EVENTS_COUNT] = { 0 };
+			for (char *p = buffer; p < buffer + n; ) {
+				struct inotify_event *event = (struct inotify_event *) p;
+				p += sizeof(struct inotify_event) + event->len;
+
+				if (event->mask & (IN_IGNORED | IN_Q_OVERFLOW)) {
+					watching = 0;
+					continue;
+				}
+				if (event->len == 0)
+					continue;
+				if (event->wd == flags_wd) {
+					if (strcmp(event->name, SYSTEM_UPDATE_STATUS_NAME) == 0)
+						modified[EVENT_UPDATE_STATUS] = 1;
+					else if (strcmp(event->name, REBOOT_NEEDED_FLAG_NAME) == 0)
+						modified[EVENT_REBOOT_NEEDED] = 1;
+					else if (strcmp(event->name, BOOT_ENDED_FLAG_NAME) == 0)
+						modified[EVENT_BOOT_ENDED] = 1;
+				} else if (event->wd == parameters_wd) {
+					if (strcmp(event->name, PARAMETERS_NAME) == 0)
+						modified[EVENT_CONTACT_PERIOD] = 1;
+				}
+			}
+			changed = 0;
+			for (int kind = 0; kind < EVENTS_COUNT; kind++)
+				if (modified[kind] || (! watching))
+					changed |= update_event(kind);
+			if (changed)
+				resume_subscribers();
+		}
+		close(fd);
+	}
+	return NULL;
+}
+
+
+
+static int watch_event_files(int fd, int *flags_wd, int *parameters_wd)
+{
+	*flags_wd = inotify_add_watch(fd, FLAG_FILES_DIR, EVENTS_WATCH_EVENTS);
+	if (*flags_wd < 0)
+		return -1;
+	// The parameters file is written in place, or replaced by some tools.
+	// Without it, the contact period is only read again at the next change
+	// of a flag.
+	*parameters_wd = inotify_add_watch(fd, PARAMETERS_DIR, IN_CLOSE_WRITE | IN_MOVED_TO);
+	return 0;
+}
+
+
+
+// Return 1 if the state changed.
+static int update_event(event_kind_t kind)
+{
+	char value[EVENT_VALUE_MAX];
+	int changed = 0;
+
+	read_event_value(kind, value);
+	// File being written.
+	if (value[0] == '\0')
+		return 0;
+
+	pthread_mutex_lock(&events_mutex);
+	if (strcmp(event_values[kind], value) != 0) {
+		strcpy(event_values[kind], value);
+		event_versions[kind] ++;
+		changed = 1;
+	}
+	pthread_mutex_unlock(&events_mutex);
+
+	return changed;
+}
+
+
+
+// Same values as the GET requests of /api/update: status number (0 if
+// unknown), yes or no, period in seconds.
+static void read_event_value(event_kind_t kind, char *value)
+{
+	char *period = NULL;
+	FILE *fp;
+	int status = 0;
+
+	value[0] = '\0';
+
+	switch (kind) {
+		case EVENT_UPDATE_STATUS:
+			fp = fopen(FLAG_FILES_DIR "/" SYSTEM_UPDATE_STATUS_NAME, "r");
+			if (fp != NULL) {
+				if (fscanf(fp, "%d", &status) != 1) {
+					fclose(fp);
+					return;
+				}
+				fclose(fp);
+			}
+			snprintf(value, EVENT_VALUE_MAX, "%d", status);
+			break;
+		case EVENT_REBOOT_NEEDED:
+			strcpy(value, access(FLAG_FILES_DIR "/" REBOOT_NEEDED_FLAG_NAME, F_OK) == 0 ? "yes" : "no");
+			break;
+		case EVENT_BOOT_ENDED:
+			strcpy(value, access(FLAG_FILES_DIR "/" BOOT_ENDED_FLAG_NAME, F_OK) == 0 ? "yes" : "no");
+			break;
+		case EVENT_CONTACT_PERIOD:
+			if ((read_parameter_value(CONTACT_PERIOD_PREFIX, &period) == 0) && (period != NULL))
+				snprintf(value, EVENT_VALUE_MAX, "%s", period);
+			else
+				strcpy(value, "0");
+			free(period);
+			break;
+		default:
+			break;
+	}
+}
+
+
+
+static void resume_subscribers(void)
+{
+	pthread_mutex_lock(&events_mutex);
+	for (event_subscriber_t *s = event_subscribers; s != NULL; s = s->next) {
+		if (s->suspended) {
+			s->suspended = 0;
+			MHD_resume_connection(s->connection);
+		}
+	}
+	pthread_mutex_unlock(&events_mutex);
+}
+
+
+
+// Content reader of the event stream, called by the MHD thread. One event
+// per call, suspended until the next change when everything was sent.
+static ssize_t read_subscriber(void *cls, uint64_t pos, char *buffer, size_t max)
+{
+	event_subscriber_t *subscriber = cls;
+	int pending = 0;
+	ssize_t n = 0;
+
+	(void) pos;
+
+	pthread_mutex_lock(&events_mutex);
+	for (int kind = 0; kind < EVENTS_COUNT; kind++) {
+		if (subscriber->sent[kind] == event_versions[kind])
+			continue;
+		pending = 1;
+		n = snprintf(buffer, max, "event: %s\ndata: %s\n\n", event_names[kind], event_values[kind]);
+		if ((n < 0) || ((size_t) n >= max)) {
+			// Sent at the next call, with more room.
+			n = 0;
+			break;
+		}
+		subscriber->sent[kind] = event_versions[kind];
+		break;
+	}
+	if (! pending) {
+		MHD_suspend_connection(subscriber->connection);
+		subscriber->suspended = 1;
+	}
+	pthread_mutex_unlock(&events_mutex);
+
+	return n;
+}
+
+
+
+static void free_subscriber(void *cls)
+{
+	event_subscriber_t *subscriber = cls;
+	event_subscriber_t **prev;
+
+	pthread_mutex_lock(&events_mutex);
+	for (prev = &event_subscribers; *prev != NULL; prev = &((*prev)->next)) {
+		if (*prev == subscriber) {
+			*prev = subscriber->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&events_mutex);
+
+	free(subscriber);
+}
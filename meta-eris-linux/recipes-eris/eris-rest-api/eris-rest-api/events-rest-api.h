@@ -0,0 +1,17 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef EVENTS_REST_API_H
+#define EVENTS_REST_API_H
+
+	#include <microhttpd.h>
+
+	int init_events_rest_api(const char *app);
+
+	enum MHD_Result events_rest_api(struct MHD_Connection *connection, const char *url, const char *method);
+
+#endif
@@ -0,0 +1,412 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#define _GNU_SOURCE   // F_DUPFD_CLOEXEC.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "exec-job.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define EXEC_MAX_EVENTS       16
+#define EXEC_WAITPID_TICK_MS  100      // Polling period when pidfd_open() is not available.
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open        434
+#endif
+
+
+// ---------------------- Private types definitions.
+
+enum { SOURCE_OUTPUT, SOURCE_PIDFD, SOURCE_CANCEL };
+
+typedef struct exec_job exec_job_t;
+
+typedef struct {
+
+	exec_job_t  *job;
+	int          kind;
+
+} exec_source_t;
+
+
+struct exec_job {
+
+	struct MHD_Connection *connection;    // NULL when the connection has been closed.
+	pid_t                  pid;
+	int                    pidfd;
+	int                    output_fd;
+	int                    cancel_fd;     // Duplicate of the client socket.
+	exec_source_t          sources[3];
+	long long              deadline_ms;
+	size_t                 output_limit;
+	int                    killed;
+	int                    done;
+	exec_result_t          result;
+	exec_reply_t           reply;
+	void                  *arg;
+	void                 (*free_arg)(void *);
+	exec_job_t            *next;
+
+};
+
+
+// ---------------------- Private method declarations.
+
+static void *exec_thread        (void *arg);
+
+static void  watch_fd           (exec_job_t *job, int fd, int kind, uint32_t events);
+static void  read_output        (exec_job_t *job);
+static void  kill_job           (exec_job_t *job);
+static void  finish_job         (exec_job_t *job);
+static void  unlink_job         (exec_job_t *job);
+static void  free_job           (exec_job_t *job);
+
+static long long monotonic_ms   (void);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t  exec_mutex = PTHREAD_MUTEX_INITIALIZER;
+static exec_job_t      *exec_jobs      = NULL;
+static int              exec_epoll_fd  = -1;
+static int              exec_wakeup_fd = -1;
+
+
+// ---------------------- Public methods
+
+int init_exec_jobs(void)
+{
+	pthread_t thread;
+
+	exec_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (exec_epoll_fd < 0)
+		return -1;
+
+	exec_wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (exec_wakeup_fd < 0)
+		return -1;
+
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+	if (epoll_ctl(exec_epoll_fd, EPOLL_CTL_ADD, exec_wakeup_fd, &event) != 0)
+		return -1;
+
+	if (pthread_create(&thread, NULL, exec_thread, NULL) != 0)
+		return -1;
+	pthread_detach(thread);
+
+	return 0;
+}
+
+
+
+enum MHD_Result run_command_async(struct MHD_Connection *connection, const char *const argv[],
+                                  const char *input, int timeout_ms, size_t output_limit,
+                                  exec_reply_t reply, void *arg, void (*free_arg)(void *))
+{
+	exec_job_t *job = calloc(1, sizeof(exec_job_t));
+	if (job == NULL) {
+		if ((free_arg != NULL) && (arg != NULL))
+			free_arg(arg);
+		return MHD_NO;
+	}
+
+	job->connection   = connection;
+	job->pidfd        = -1;
+	job->output_fd    = -1;
+	job->cancel_fd    = -1;
+	job->output_limit = output_limit;
+	job->deadline_ms  = monotonic_ms() + timeout_ms;
+	job->reply        = reply;
+	job->arg          = arg;
+	job->free_arg     = free_arg;
+
+	if (spawn_command(argv, input, output_limit, &(job->pid), &(job->output_fd)) != 0) {
+		job->result.exit_status = -1;
+		job->result.output = calloc(1, 1);
+		enum MHD_Result ret = reply(connection, &(job->result), arg);
+		free_job(job);
+		return ret;
+	}
+	job->pidfd = syscall(SYS_pidfd_open, job->pid, 0);
+
+	// Watch the client socket to kill the command if the client goes away.
+	const union MHD_ConnectionInfo *info = MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CONNECTION_FD);
+	if (info != NULL)
+		job->cancel_fd = fcntl(info->connect_fd, F_DUPFD_CLOEXEC, 0);
+
+	MHD_suspend_connection(connection);
+
+	pthread_mutex_lock(&exec_mutex);
+	job->next = exec_jobs;
+	exec_jobs = job;
+	if (job->output_fd >= 0)
+		watch_fd(job, job->output_fd, SOURCE_OUTPUT, EPOLLIN);
+	if (job->pidfd >= 0)
+		watch_fd(job, job->pidfd, SOURCE_PIDFD, EPOLLIN);
+	if (job->cancel_fd >= 0)
+		watch_fd(job, job->cancel_fd, SOURCE_CANCEL, EPOLLRDHUP);
+	pthread_mutex_unlock(&exec_mutex);
+
+	uint64_t one = 1;
+	write(exec_wakeup_fd, &one, sizeof(one));
+
+	return MHD_YES;
+}
+
+
+
+int resume_command_reply(struct MHD_Connection *connection, enum MHD_Result *ret)
+{
+	exec_job_t *job;
+
+	pthread_mutex_lock(&exec_mutex);
+	for (job = exec_jobs; job != NULL; job = job->next)
+		if (job->connection == connection)
+			break;
+	if ((job != NULL) && (! job->done)) {
+		pthread_mutex_unlock(&exec_mutex);
+		*ret = MHD_YES;
+		return 1;
+	}
+	if (job != NULL)
+		unlink_job(job);
+	pthread_mutex_unlock(&exec_mutex);
+
+	if (job == NULL)
+		return 0;
+
+	*ret = job->reply(connection, &(job->result), job->arg);
+	free_job(job);
+	return 1;
+}
+
+
+
+void release_command_jobs(struct MHD_Connection *connection)
+{
+	exec_job_t *job;
+	exec_job_t *next;
+
+	pthread_mutex_lock(&exec_mutex);
+	for (job = exec_jobs; job != NULL; job = next) {
+		next = job->next;
+		if (job->connection != connection)
+			continue;
+		if (job->done) {
+			unlink_job(job);
+			free_job(job);
+		} else {
+			// The executor thread releases it when the command ends.
+			job->connection = NULL;
+			kill_job(job);
+		}
+	}
+	pthread_mutex_unlock(&exec_mutex);
+}
+
+
+// ---------------------- Private methods
+
+static void *exec_thread(void *arg)
+{
+	(void) arg;
+
+	struct epoll_event events[EXEC_MAX_EVENTS];
+
+	for (;;) {
+		long long now = monotonic_ms();
+		int timeout = -1;
+
+		pthread_mutex_lock(&exec_mutex);
+		for (exec_job_t *job = exec_jobs; job != NULL; job = job->next) {
+			if (job->done)
+				continue;
+			int delay = job->killed ? -1 : (job->deadline_ms > now ? (int)(job->deadline_ms - now) : 0);
+			if (job->pidfd < 0)
+				delay = (delay < 0) || (delay > EXEC_WAITPID_TICK_MS) ? EXEC_WAITPID_TICK_MS : delay;
+			if ((delay >= 0) && ((timeout < 0) || (delay < timeout)))
+				timeout = delay;
+		}
+		pthread_mutex_unlock(&exec_mutex);
+
+		int n = epoll_wait(exec_epoll_fd, events, EXEC_MAX_EVENTS, timeout);
+		if ((n < 0) && (errno != EINTR))
+			break;
+
+		pthread_mutex_lock(&exec_mutex);
+		for (int i = 0; i < n; i++) {
+			exec_source_t *source = events[i].data.ptr;
+			if (source == NULL) {
+				uint64_t value;
+				read(exec_wakeup_fd, &value, sizeof(value));
+				continue;
+			}
+			exec_job_t *job = source->job;
+			if (job->done)
+				continue;
+			switch (source->kind) {
+				case SOURCE_OUTPUT:
+					read_output(job);
+					break;
+				case SOURCE_PIDFD:
+					finish_job(job);
+					break;
+				case SOURCE_CANCEL:
+					job->result.cancelled = 1;
+					kill_job(job);
+					epoll_ctl(exec_epoll_fd, EPOLL_CTL_DEL, job->cancel_fd, NULL);
+					break;
+			}
+		}
+
+		now = monotonic_ms();
+		exec_job_t *next;
+		for (exec_job_t *job = exec_jobs; job != NULL; job = next) {
+			next = job->next;
+			if (! job->done) {
+				if ((! job->killed) && (now >= job->deadline_ms)) {
+					job->result.timed_out = 1;
+					kill_job(job);
+				}
+				if (job->pidfd < 0) {
+					siginfo_t info;
+					info.si_pid = 0;
+					if ((waitid(P_PID, job->pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0) && (info.si_pid == job->pid))
+						finish_job(job);
+				}
+			}
+			// Jobs of closed connections are released once no event can refer to them anymore.
+			if (job->done && (job->connection == NULL)) {
+				unlink_job(job);
+				free_job(job);
+			}
+		}
+		pthread_mutex_unlock(&exec_mutex);
+	}
+	return NULL;
+}
+
+
+
+static void watch_fd(exec_job_t *job, int fd, int kind, uint32_t events)
+{
+	job->sources[kind].job  = job;
+	job->sources[kind].kind = kind;
+
+	struct epoll_event event = { .events = events, .data.ptr = &(job->sources[kind]) };
+	epoll_ctl(exec_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+
+
+static void read_output(exec_job_t *job)
+{
+	if ((job->output_fd >= 0) && (read_command_output(job->output_fd, job->output_limit, &(job->result)) != 0)) {
+		epoll_ctl(exec_epoll_fd, EPOLL_CTL_DEL, job->output_fd, NULL);
+		close(job->output_fd);
+		job->output_fd = -1;
+	}
+}
+
+
+
+static void kill_job(exec_job_t *job)
+{
+	if (job->killed)
+		return;
+	kill(job->pid, SIGKILL);
+	job->killed = 1;
+}
+
+
+
+static void finish_job(exec_job_t *job)
+{
+	int status;
+
+	// The command may have left a daemon holding the pipe: read what is available only.
+	read_output(job);
+
+	if (waitpid(job->pid, &status, 0) == job->pid)
+		job->result.exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	else
+		job->result.exit_status = -1;
+	if (job->killed)
+		job->result.exit_status = -1;
+
+	if (job->output_fd >= 0) {
+		epoll_ctl(exec_epoll_fd, EPOLL_CTL_DEL, job->output_fd, NULL);
+		close(job->output_fd);
+		job->output_fd = -1;
+	}
+	if (job->pidfd >= 0) {
+		epoll_ctl(exec_epoll_fd, EPOLL_CTL_DEL, job->pidfd, NULL);
+		close(job->pidfd);
+		job->pidfd = -1;
+	}
+	if (job->cancel_fd >= 0) {
+		epoll_ctl(exec_epoll_fd, EPOLL_CTL_DEL, job->cancel_fd, NULL);
+		close(job->cancel_fd);
+		job->cancel_fd = -1;
+	}
+	if (job->result.output == NULL)
+		job->result.output = calloc(1, 1);
+
+	job->done = 1;
+	if (job->connection != NULL)
+		MHD_resume_connection(job->connection);
+}
+
+
+
+static void unlink_job(exec_job_t *job)
+{
+	exec_job_t **prev;
+
+	for (prev = &exec_jobs; *prev != NULL; prev = &((*prev)->next)) {
+		if (*prev == job) {
+			*prev = job->next;
+			return;
+		}
+	}
+}
+
+
+
+static void free_job(exec_job_t *job)
+{
+	if ((job->free_arg != NULL) && (job->arg != NULL))
+		job->free_arg(job->arg);
+	free(job->result.output);
+	free(job);
+}
+
+
+
+static long long monotonic_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
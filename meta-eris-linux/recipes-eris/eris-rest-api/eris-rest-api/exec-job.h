@@ -0,0 +1,31 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef EXEC_JOB_H
+#define EXEC_JOB_H
+
+	#include <stddef.h>
+	#include <microhttpd.h>
+
+	#include "exec-command.h"
+
+	typedef enum MHD_Result (*exec_reply_t)(struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+
+	int  init_exec_jobs(void);
+
+	// Start the command and suspend the connection until it ends. The reply
+	// callback is then called from the request handler to queue the response
+	// (or to start another command). The arg is released with free_arg.
+	// If output_limit is 0, the standard output is redirected to /dev/null.
+	enum MHD_Result run_command_async(struct MHD_Connection *connection, const char *const argv[],
+	                                  const char *input, int timeout_ms, size_t output_limit,
+	                                  exec_reply_t reply, void *arg, void (*free_arg)(void *));
+
+	int  resume_command_reply(struct MHD_Connection *connection, enum MHD_Result *ret);
+	void release_command_jobs(struct MHD_Connection *connection);
+
+#endif
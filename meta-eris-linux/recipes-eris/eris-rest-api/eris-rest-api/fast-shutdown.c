@@ -0,0 +1,276 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Reboot requested through the API. The containers of all the slots are
+// stopped at the same time, with a shared deadline, then the parameters
+// and the data partition (holding the overlay of /etc and the container
+// logs) are flushed. The root filesystem is read-only and /tmp is in RAM:
+// no global sync() is needed. The reboot goes through fast-reboot when
+// installed.
+//
+// The duration of each step is kept on the data partition, and appended
+// to the boot timeline at the next boot by report_last_shutdown().
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/reboot.h>
+#include <sys/stat.h>
+
+#include "exec-command.h"
+#include "fast-shutdown.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define START_CONTAINERS_SCRIPT        "/etc/init.d/start-containers"
+#define FAST_REBOOT                    "/usr/sbin/fast-reboot"
+#define PARAMETERS_FILE                "/etc/eris-linux/parameters"
+#define DATA_MOUNT_POINT               "/data"
+#define SHUTDOWN_TIMELINE_DIR          "/data/eris-linux"
+#define SHUTDOWN_TIMELINE_FILE         SHUTDOWN_TIMELINE_DIR "/shutdown-timeline"
+
+#define SHUTDOWN_CONTAINERS_DEADLINE_S 5
+// Beyond the deadline given to docker stop, for the docker commands.
+#define SHUTDOWN_CONTAINERS_GRACE_MS   2000
+
+#define SHUTDOWN_STEPS_MAX             8
+// Above, the clock was not set at one of the boots.
+#define SHUTDOWN_OFFLINE_MAX_MS        (24LL * 3600 * 1000)
+
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	const char  *name;
+	long long    duration_ms;
+
+} shutdown_step_t;
+
+
+// ---------------------- Private method declarations.
+
+static void     *shutdown_thread          (void *arg);
+static int       stop_containers          (void);
+static int       flush_parameters         (void);
+static int       sync_data                (void);
+static void      write_shutdown_timeline  (const shutdown_step_t *steps, int count, long long realtime_ms);
+static long long clock_ms                 (clockid_t clock);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t  shutdown_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int              shutting_down = 0;
+
+
+// ---------------------- Public methods
+
+int start_shutdown(void)
+{
+	pthread_t thread;
+
+	pthread_mutex_lock(&shutdown_mutex);
+	if (shutting_down) {
+		pthread_mutex_unlock(&shutdown_mutex);
+		errno = EBUSY;
+		return -1;
+	}
+	shutting_down = 1;
+	pthread_mutex_unlock(&shutdown_mutex);
+
+	if (pthread_create(&thread, NULL, shutdown_thread, NULL) != 0) {
+		pthread_mutex_lock(&shutdown_mutex);
+		shutting_down = 0;
+		pthread_mutex_unlock(&shutdown_mutex);
+		return -1;
+	}
+	pthread_detach(thread);
+	return 0;
+}
+
+
+
+// The steps of the previous shutdown get the uptime 0. The time spent
+// offline (from the reboot to the start of the kernel) is known only if
+// the clock was set at both boots. The reboot step goes from the request
+// to now.
+void report_last_shutdown(void)
+{
+	char line[128];
+	char step[32];
+	long long value;
+	long long realtime_ms = 0;
+	long long total_ms = -1;
+
+	FILE *fp = fopen(SHUTDOWN_TIMELINE_FILE, "r");
+	if (fp == NULL)
+		return;
+
+	mkdir("/run/eris-linux", 0755);
+	FILE *timeline = fopen(BOOT_TIMELINE_FILE, "a");
+	if (timeline == NULL) {
+		fclose(fp);
+		return;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%31s %lld", step, &value) != 2)
+			continue;
+		if (strcmp(step, "realtime") == 0) {
+			realtime_ms = value;
+			continue;
+		}
+		if (strcmp(step, "total") == 0)
+			total_ms = value;
+		fprintf(timeline, "0 shutdown %s %lld\n", step, value);
+	}
+	fclose(fp);
+
+	long long uptime_ms = clock_ms(CLOCK_BOOTTIME);
+	long long offline_ms = clock_ms(CLOCK_REALTIME) - uptime_ms - realtime_ms;
+	if ((realtime_ms > 0) && (total_ms >= 0) && (offline_ms >= 0) && (offline_ms < SHUTDOWN_OFFLINE_MAX_MS)) {
+		fprintf(timeline, "%lld shutdown offline %lld\n", uptime_ms, offline_ms);
+		fprintf(timeline, "%lld shutdown reboot %lld\n", uptime_ms, total_ms + offline_ms + uptime_ms);
+	}
+	fclose(timeline);
+
+	// Reported once: a later reboot outside the API has no timeline.
+	unlink(SHUTDOWN_TIMELINE_FILE);
+}
+
+
+// ---------------------- Private methods
+
+static void *shutdown_thread(void *arg)
+{
+	shutdown_step_t steps[SHUTDOWN_STEPS_MAX];
+	int count = 0;
+
+	(void) arg;
+
+	long long start = clock_ms(CLOCK_MONOTONIC);
+	long long t = start;
+
+	steps[count].name = (stop_containers() == 0) ? "containers" : "containers-timeout";
+	steps[count++].duration_ms = clock_ms(CLOCK_MONOTONIC) - t;
+
+	t = clock_ms(CLOCK_MONOTONIC);
+	flush_parameters();
+	steps[count].name = "parameters";
+	steps[count++].duration_ms = clock_ms(CLOCK_MONOTONIC) - t;
+
+	t = clock_ms(CLOCK_MONOTONIC);
+	steps[count].name = (sync_data() == 0) ? "sync" : "sync-failed";
+	steps[count++].duration_ms = clock_ms(CLOCK_MONOTONIC) - t;
+
+	steps[count].name = "total";
+	steps[count++].duration_ms = clock_ms(CLOCK_MONOTONIC) - start;
+	write_shutdown_timeline(steps, count, clock_ms(CLOCK_REALTIME));
+
+	if (access(FAST_REBOOT, X_OK) == 0) {
+		exec_result_t result;
+		const char *argv[] = { FAST_REBOOT, NULL };
+		run_command(argv, NULL, -1, 0, -1, &result);
+		free_command_result(&result);
+	}
+	// Still here: fast-reboot is missing or failed.
+	reboot(RB_AUTOBOOT);
+
+	pthread_mutex_lock(&shutdown_mutex);
+	shutting_down = 0;
+	pthread_mutex_unlock(&shutdown_mutex);
+	return NULL;
+}
+
+
+
+// start-containers stops the slots in parallel. Killing it doesn't stop
+// the docker commands, but the reboot will.
+static int stop_containers(void)
+{
+	char deadline[16];
+	exec_result_t result;
+
+	snprintf(deadline, sizeof(deadline), "%d", SHUTDOWN_CONTAINERS_DEADLINE_S);
+	const char *argv[] = { START_CONTAINERS_SCRIPT, "stop", deadline, NULL };
+	run_command(argv, NULL, SHUTDOWN_CONTAINERS_DEADLINE_S * 1000 + SHUTDOWN_CONTAINERS_GRACE_MS, 0, -1, &result);
+	free_command_result(&result);
+	// The status of the script doesn't matter, only its end in time.
+	return ((result.exit_status < 0) || result.timed_out) ? -1 : 0;
+}
+
+
+
+static int flush_parameters(void)
+{
+	int fd = open(PARAMETERS_FILE, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	int err = fsync(fd);
+	close(fd);
+	return err;
+}
+
+
+
+static int sync_data(void)
+{
+	int fd = open(DATA_MOUNT_POINT, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	int err = syncfs(fd);
+	close(fd);
+	return err;
+}
+
+
+
+// Written after the sync of the data partition: only this file is synced.
+static void write_shutdown_timeline(const shutdown_step_t *steps, int count, long long realtime_ms)
+{
+	char path[sizeof(SHUTDOWN_TIMELINE_FILE) + 4];
+
+	mkdir(SHUTDOWN_TIMELINE_DIR, 0755);
+	snprintf(path, sizeof(path), "%s.tmp", SHUTDOWN_TIMELINE_FILE);
+	FILE *fp = fopen(path, "w");
+	if (fp == NULL)
+		return;
+	for (int i = 0; i < count; i++)
+		fprintf(fp, "%s %lld\n", steps[i].name, steps[i].duration_ms);
+	fprintf(fp, "realtime %lld\n", realtime_ms);
+	fflush(fp);
+	fsync(fileno(fp));
+	fclose(fp);
+	if (rename(path, SHUTDOWN_TIMELINE_FILE) != 0)
+		return;
+
+	int fd = open(SHUTDOWN_TIMELINE_DIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+}
+
+
+
+static long long clock_ms(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,21 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef FAST_SHUTDOWN_H
+#define FAST_SHUTDOWN_H
+
+	// Lines "<uptime in ms> <component> <step> <duration in ms>".
+	#define BOOT_TIMELINE_FILE      "/run/eris-linux/boot-timeline"
+
+	// Stop the containers, flush the data partition and reboot, in a
+	// thread. Return -1 with errno EBUSY if a shutdown is in progress.
+	int start_shutdown(void);
+
+	// Append the steps of the previous shutdown to the boot timeline.
+	void report_last_shutdown(void);
+
+#endif
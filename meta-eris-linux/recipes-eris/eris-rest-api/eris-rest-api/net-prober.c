@@ -0,0 +1,523 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <sys/socket.h>
+
+#include "addsnprintf.h"
+#include "net-prober.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define PROBE_MAX_TARGETS        8
+#define PROBE_NAME_LENGTH        64
+#define PROBE_INTERVAL_MS        1000
+#define PROBE_HISTORY            300      // Samples kept per target (one per interval).
+#define PROBE_PACKET_SIZE        64
+
+#define PROBE_GATEWAY_REFRESH    10       // Rounds between two reads of the routing table.
+#define PROBE_RESOLVE_REFRESH    60       // Rounds between two resolutions of the targets names.
+
+#define PROBE_SAMPLE_LOST        (-1.0)
+
+#define ROUTE_FILE               "/proc/net/route"
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	char            name[PROBE_NAME_LENGTH];
+	struct in_addr  address;
+	int             resolved;
+
+	double          samples[PROBE_HISTORY];   // RTT in ms, PROBE_SAMPLE_LOST if no reply.
+	int             head;
+	int             count;
+
+} probe_target_t;
+
+
+// ---------------------- Private method declarations.
+
+static void  *net_prober_thread    (void *arg);
+
+static int    open_icmp_socket     (int *raw);
+static int    send_echo_request    (int sock, int raw, struct in_addr *address, uint16_t sequence);
+static int    read_echo_reply      (int sock, int raw, struct in_addr *from, uint16_t *sequence, long long *sent_us);
+
+static void   refresh_gateway      (void);
+static void   resolve_targets      (void);
+static void   reset_target         (probe_target_t *target);
+static void   add_sample           (probe_target_t *target, double rtt);
+
+static int    compare_doubles      (const void *a, const void *b);
+static uint16_t icmp_checksum      (const void *data, size_t length);
+static long long monotonic_us      (void);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t  prober_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Index 0 is the default gateway, the others are the configured targets.
+static probe_target_t   probe_targets[PROBE_MAX_TARGETS + 1];
+static int              nb_probe_targets  = 1;
+static unsigned int     probe_generation  = 0;
+static int              probe_resolve_pending = 0;
+
+static pthread_t        prober_thread;
+static int              prober_running    = 0;
+static int              prober_socket     = -1;
+static int              prober_raw        = 0;
+static uint16_t         probe_identifier  = 0;
+
+static const int        quality_windows[] = { 10, 60, PROBE_HISTORY };
+
+
+// ---------------------- Public methods
+
+int start_net_prober(void)
+{
+	if (prober_running)
+		return 0;
+
+	probe_identifier = (uint16_t) getpid();
+
+	// Without any ICMP socket, the prober would only report lost samples.
+	prober_socket = open_icmp_socket(&prober_raw);
+	if (prober_socket < 0)
+		return -1;
+
+	prober_running = 1;
+	int err = pthread_create(&prober_thread, NULL, net_prober_thread, NULL);
+	if (err != 0) {
+		prober_running = 0;
+		close(prober_socket);
+		prober_socket = -1;
+		errno = err;
+		return -1;
+	}
+	pthread_detach(prober_thread);
+	return 0;
+}
+
+
+
+int set_net_prober_targets(const char *targets)
+{
+	probe_target_t new_targets[PROBE_MAX_TARGETS];
+	int nb = 0;
+
+	char *list = strdup(targets);
+	if (list == NULL)
+		return -1;
+
+	char *saveptr = NULL;
+	for (char *name = strtok_r(list, ", \t", &saveptr); name != NULL; name = strtok_r(NULL, ", \t", &saveptr)) {
+		if ((nb >= PROBE_MAX_TARGETS) || (strlen(name) >= PROBE_NAME_LENGTH)) {
+			free(list);
+			return -1;
+		}
+		memset(&(new_targets[nb]), 0, sizeof(probe_target_t));
+		strcpy(new_targets[nb].name, name);
+		nb++;
+	}
+	free(list);
+
+	pthread_mutex_lock(&prober_mutex);
+	for (int i = 0; i < nb; i++) {
+		// Keep the history of the targets that were already probed.
+		int j;
+		for (j = 1; j < nb_probe_targets; j++)
+			if (strcmp(probe_targets[j].name, new_targets[i].name) == 0)
+				break;
+		if (j < nb_probe_targets)
+			new_targets[i] = probe_targets[j];
+	}
+	memcpy(&(probe_targets[1]), new_targets, nb * sizeof(probe_target_t));
+	nb_probe_targets = nb + 1;
+	probe_generation++;
+	pthread_mutex_unlock(&prober_mutex);
+
+	// The names are resolved by the prober thread: the resolution may block.
+	__atomic_store_n(&probe_resolve_pending, 1, __ATOMIC_SEQ_CST);
+	return 0;
+}
+
+
+
+int get_net_prober_targets(char **string, size_t *size, size_t *pos)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&prober_mutex);
+	for (int i = 1; (i < nb_probe_targets) && (ret == 0); i++)
+		ret = addsnprintf(string, size, pos, "%s%s", i > 1 ? "," : "", probe_targets[i].name);
+	if ((ret == 0) && (*string == NULL))
+		ret = addsnprintf(string, size, pos, "%s", "");
+	pthread_mutex_unlock(&prober_mutex);
+
+	return ret;
+}
+
+
+
+int get_net_quality(char **string, size_t *size, size_t *pos)
+{
+	double window[PROBE_HISTORY];
+	char address[INET_ADDRSTRLEN];
+	int ret = 0;
+
+	pthread_mutex_lock(&prober_mutex);
+	for (int t = 0; (t < nb_probe_targets) && (ret == 0); t++) {
+		probe_target_t *target = &(probe_targets[t]);
+		if ((t == 0) && (! target->resolved))
+			continue;
+
+		for (size_t w = 0; (w < sizeof(quality_windows) / sizeof(quality_windows[0])) && (ret == 0); w++) {
+			int sent = 0;
+			int received = 0;
+			double sum = 0.0;
+
+			for (int i = 0; (i < quality_windows[w]) && (i < target->count); i++) {
+				double rtt = target->samples[(target->head - 1 - i + PROBE_HISTORY) % PROBE_HISTORY];
+				sent++;
+				if (rtt == PROBE_SAMPLE_LOST)
+					continue;
+				window[received++] = rtt;
+				sum += rtt;
+			}
+
+			if (! target->resolved)
+				strcpy(address, "-");
+			else
+				inet_ntop(AF_INET, &(target->address), address, sizeof(address));
+
+			ret = addsnprintf(string, size, pos, "target=%s address=%s role=%s window=%ds sent=%d received=%d loss=%.1f%%",
+				target->name, address,
+				t == 0 ? "gateway" : "target", quality_windows[w], sent, received,
+				sent > 0 ? (100.0 * (sent - received)) / sent : 0.0);
+
+			if ((ret == 0) && (received > 0)) {
+				qsort(window, received, sizeof(double), compare_doubles);
+				int p95 = (95 * received + 99) / 100 - 1;
+				ret = addsnprintf(string, size, pos, " min=%.3fms avg=%.3fms p95=%.3fms",
+					window[0], sum / received, window[p95]);
+			}
+			if (ret == 0)
+				ret = addsnprintf(string, size, pos, "\n");
+		}
+	}
+	if ((ret == 0) && (*string == NULL))
+		ret = addsnprintf(string, size, pos, "%s", "");
+	pthread_mutex_unlock(&prober_mutex);
+
+	return ret;
+}
+
+
+// ---------------------- Private methods
+
+static void *net_prober_thread(void *arg)
+{
+	(void) arg;
+
+	int sock = prober_socket;
+	int raw  = prober_raw;
+
+	struct in_addr addresses[PROBE_MAX_TARGETS + 1];
+	double         rtts[PROBE_MAX_TARGETS + 1];
+	int            valid[PROBE_MAX_TARGETS + 1];
+	uint16_t       sequence = 0;
+	unsigned int   round = 0;
+
+	while (prober_running) {
+		if ((round % PROBE_GATEWAY_REFRESH) == 0)
+			refresh_gateway();
+		// New targets are resolved at the next round.
+		int pending = __atomic_exchange_n(&probe_resolve_pending, 0, __ATOMIC_SEQ_CST);
+		if (pending || ((round % PROBE_RESOLVE_REFRESH) == 0))
+			resolve_targets();
+		round++;
+		sequence++;
+
+		// Work on a snapshot of the addresses to keep the lock short.
+		pthread_mutex_lock(&prober_mutex);
+		unsigned int generation = probe_generation;
+		int nb = nb_probe_targets;
+		for (int i = 0; i < nb; i++) {
+			addresses[i] = probe_targets[i].address;
+			valid[i]     = probe_targets[i].resolved;
+			rtts[i]      = PROBE_SAMPLE_LOST;
+		}
+		pthread_mutex_unlock(&prober_mutex);
+
+		long long start = monotonic_us();
+		for (int i = 0; i < nb; i++)
+			if (valid[i])
+				send_echo_request(sock, raw, &(addresses[i]), sequence);
+
+		// Collect the replies until the next round.
+		long long deadline = start + PROBE_INTERVAL_MS * 1000LL;
+		long long now;
+		while ((now = monotonic_us()) < deadline) {
+			struct pollfd fd = { .fd = sock, .events = POLLIN };
+			if (poll(&fd, 1, (int)((deadline - now + 999) / 1000)) <= 0)
+				continue;
+
+			struct in_addr from;
+			uint16_t seq;
+			long long sent_us;
+			if (read_echo_reply(sock, raw, &from, &seq, &sent_us) != 0)
+				continue;
+			if (seq != sequence)
+				continue;
+			now = monotonic_us();
+			for (int i = 0; i < nb; i++) {
+				if (valid[i] && (rtts[i] == PROBE_SAMPLE_LOST) && (addresses[i].s_addr == from.s_addr))
+					rtts[i] = (now - sent_us) / 1000.0;
+			}
+		}
+
+		pthread_mutex_lock(&prober_mutex);
+		if (generation == probe_generation) {
+			for (int i = 0; i < nb; i++)
+				if (valid[i] && (probe_targets[i].address.s_addr == addresses[i].s_addr))
+					add_sample(&(probe_targets[i]), rtts[i]);
+		}
+		pthread_mutex_unlock(&prober_mutex);
+	}
+
+	close(sock);
+	prober_socket = -1;
+	return NULL;
+}
+
+
+
+static int open_icmp_socket(int *raw)
+{
+	// Unprivileged ICMP sockets (net.ipv4.ping_group_range) do not see the other echo replies.
+	int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_ICMP);
+	if (sock >= 0) {
+		*raw = 0;
+		return sock;
+	}
+	sock = socket(AF_INET, SOCK_RAW | SOCK_CLOEXEC, IPPROTO_ICMP);
+	if (sock >= 0)
+		*raw = 1;
+	return sock;
+}
+
+
+
+static int send_echo_request(int sock, int raw, struct in_addr *address, uint16_t sequence)
+{
+	unsigned char packet[PROBE_PACKET_SIZE];
+	struct icmphdr *icmp = (struct icmphdr *) packet;
+	long long now = monotonic_us();
+
+	memset(packet, 0, sizeof(packet));
+	icmp->type = ICMP_ECHO;
+	icmp->code = 0;
+	icmp->un.echo.id       = htons(probe_identifier);   // Replaced by the kernel on datagram sockets.
+	icmp->un.echo.sequence = htons(sequence);
+	memcpy(packet + sizeof(struct icmphdr), &now, sizeof(now));
+	if (raw)
+		icmp->checksum = icmp_checksum(packet, sizeof(packet));
+
+	struct sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr   = *address;
+
+	if (sendto(sock, packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr *) &to, sizeof(to)) < 0)
+		return -1;
+	return 0;
+}
+
+
+
+static int read_echo_reply(int sock, int raw, struct in_addr *from, uint16_t *sequence, long long *sent_us)
+{
+	unsigned char packet[PROBE_PACKET_SIZE + 60 + sizeof(struct iphdr)];
+	struct sockaddr_in addr;
+	socklen_t addr_length = sizeof(addr);
+
+	ssize_t length = recvfrom(sock, packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr *) &addr, &addr_length);
+	if (length <= 0)
+		return -1;
+
+	size_t offset = 0;
+	if (raw) {
+		struct iphdr *ip = (struct iphdr *) packet;
+		offset = ip->ihl * 4;
+	}
+	if ((size_t) length < offset + sizeof(struct icmphdr) + sizeof(long long))
+		return -1;
+
+	struct icmphdr *icmp = (struct icmphdr *) (packet + offset);
+	if (icmp->type != ICMP_ECHOREPLY)
+		return -1;
+	if (raw && (ntohs(icmp->un.echo.id) != probe_identifier))
+		return -1;
+
+	*from     = addr.sin_addr;
+	*sequence = ntohs(icmp->un.echo.sequence);
+	memcpy(sent_us, packet + offset + sizeof(struct icmphdr), sizeof(long long));
+	return 0;
+}
+
+
+
+static void refresh_gateway(void)
+{
+	char line[256];
+	char iface[32];
+	unsigned int destination, gateway, flags;
+	struct in_addr address = { .s_addr = 0 };
+	int found = 0;
+
+	FILE *fp = fopen(ROUTE_FILE, "r");
+	if (fp == NULL)
+		return;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%31s %x %x %x", iface, &destination, &gateway, &flags) != 4)
+			continue;
+		// Default route with the RTF_UP and RTF_GATEWAY flags.
+		if ((destination == 0) && ((flags & 0x3) == 0x3)) {
+			address.s_addr = gateway;
+			found = 1;
+			break;
+		}
+	}
+	fclose(fp);
+
+	pthread_mutex_lock(&prober_mutex);
+	probe_target_t *target = &(probe_targets[0]);
+	if ((found != target->resolved) || (address.s_addr != target->address.s_addr)) {
+		reset_target(target);
+		target->address  = address;
+		target->resolved = found;
+		target->name[0] = '\0';
+		if (found)
+			inet_ntop(AF_INET, &address, target->name, PROBE_NAME_LENGTH);
+	}
+	pthread_mutex_unlock(&prober_mutex);
+}
+
+
+
+static void resolve_targets(void)
+{
+	char names[PROBE_MAX_TARGETS][PROBE_NAME_LENGTH];
+	struct in_addr addresses[PROBE_MAX_TARGETS];
+	int resolved[PROBE_MAX_TARGETS];
+
+	pthread_mutex_lock(&prober_mutex);
+	int nb = nb_probe_targets - 1;
+	unsigned int generation = probe_generation;
+	for (int i = 0; i < nb; i++)
+		strcpy(names[i], probe_targets[i + 1].name);
+	pthread_mutex_unlock(&prober_mutex);
+
+	// Name resolution may block: it is done without holding the lock, and
+	// only by the prober thread.
+	for (int i = 0; i < nb; i++) {
+		struct addrinfo hints, *result;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		resolved[i] = 0;
+		if (getaddrinfo(names[i], NULL, &hints, &result) == 0) {
+			addresses[i] = ((struct sockaddr_in *) result->ai_addr)->sin_addr;
+			resolved[i]  = 1;
+			freeaddrinfo(result);
+		}
+	}
+
+	pthread_mutex_lock(&prober_mutex);
+	if (generation == probe_generation) {
+		for (int i = 0; i < nb; i++) {
+			probe_target_t *target = &(probe_targets[i + 1]);
+			if (! resolved[i])
+				continue;
+			if (target->resolved && (target->address.s_addr != addresses[i].s_addr))
+				reset_target(target);
+			target->address  = addresses[i];
+			target->resolved = 1;
+		}
+	}
+	pthread_mutex_unlock(&prober_mutex);
+}
+
+
+
+static void reset_target(probe_target_t *target)
+{
+	target->head  = 0;
+	target->count = 0;
+}
+
+
+
+static void add_sample(probe_target_t *target, double rtt)
+{
+	target->samples[target->head] = rtt;
+	target->head = (target->head + 1) % PROBE_HISTORY;
+	if (target->count < PROBE_HISTORY)
+		target->count++;
+}
+
+
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+
+
+static uint16_t icmp_checksum(const void *data, size_t length)
+{
+	const uint16_t *words = data;
+	uint32_t sum = 0;
+
+	for (; length > 1; length -= 2)
+		sum += *(words++);
+	if (length > 0)
+		sum += *(const uint8_t *) words;
+	while (sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	return (uint16_t) ~sum;
+}
+
+
+
+static long long monotonic_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
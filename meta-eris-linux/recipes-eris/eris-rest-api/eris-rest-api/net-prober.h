@@ -0,0 +1,20 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef NET_PROBER_H
+#define NET_PROBER_H
+
+	#include <stddef.h>
+
+	int start_net_prober(void);
+
+	int set_net_prober_targets(const char *targets);
+	int get_net_prober_targets(char **string, size_t *size, size_t *pos);
+
+	int get_net_quality(char **string, size_t *size, size_t *pos);
+
+#endif
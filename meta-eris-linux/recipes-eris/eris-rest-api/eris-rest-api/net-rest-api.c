@@ -22,7 +22,11 @@
 #include <sys/socket.h>
 
 #include "addsnprintf.h"
+#include "dns-cache.h"
 #include "eris-rest-api.h"
+#include "exec-job.h"
+#include "net-prober.h"
+#include "net-selftest.h"
 #include "time-rest-api.h"
 
 
@@ -30,6 +34,15 @@
 
 #define ERIS_NETWORK_CONFIG_FILE     "/etc/eris-linux/network"
 #define SYSTEM_NETWORK_CONFIG_FILE   "/etc/network/interfaces"
+#define DNS_CACHE_ENABLE_PREFIX      "dns_cache_enable="
+#define PROBE_TARGETS_PREFIX         "network_probe_targets="
+
+#define IFUPDOWN_TIMEOUT_MS          30000
+#define IP_LINK_TIMEOUT_MS           5000
+#define IW_SCAN_TIMEOUT_MS           15000
+#define IW_SCAN_OUTPUT_LIMIT         (256 * 1024)
+#define WPA_TIMEOUT_MS               10000
+#define WPA_OUTPUT_LIMIT             4096
 #define INTERFACE_NAME_LENGTH 32
 #define IP_ADDRESS_LENGTH   INET6_ADDRSTRLEN
 #define EOL_CHAR(x) ((x == '\0') || (x == 0x23) || (x == '\n') || (x == '\r'))
@@ -62,6 +75,19 @@ static enum MHD_Result get_network_interface_config (struct MHD_Connection *conn
 static enum MHD_Result set_network_interface_config (struct MHD_Connection *connection);
 static enum MHD_Result get_dns_address              (struct MHD_Connection *connection);
 static enum MHD_Result set_dns_address              (struct MHD_Connection *connection);
+static enum MHD_Result get_dns_cache                (struct MHD_Connection *connection);
+static enum MHD_Result set_dns_cache                (struct MHD_Connection *connection);
+static enum MHD_Result get_dns_cache_stats          (struct MHD_Connection *connection);
+static enum MHD_Result get_network_quality          (struct MHD_Connection *connection);
+static enum MHD_Result get_quality_targets          (struct MHD_Connection *connection);
+static enum MHD_Result set_quality_targets          (struct MHD_Connection *connection);
+static enum MHD_Result get_selftest_result          (struct MHD_Connection *connection);
+static enum MHD_Result reply_interface_status       (struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static enum MHD_Result reply_scan_link_up           (struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static enum MHD_Result reply_scan_wifi              (struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static enum MHD_Result reply_wpa_passphrase         (struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static enum MHD_Result reply_wpa_supplicant         (struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static enum MHD_Result run_selftest                 (struct MHD_Connection *connection);
 static enum MHD_Result is_interface_wireless        (struct MHD_Connection *connection);
 static enum MHD_Result scan_wifi                    (struct MHD_Connection *connection);
 static enum MHD_Result connect_wifi                 (struct MHD_Connection *connection);
@@ -88,6 +114,24 @@ int init_net_rest_api(const char *app)
 		return -1;
 	if (write_system_network_configuration() < 0)
 		return -1;
+
+	char *enable = NULL;
+	if (read_parameter_value(DNS_CACHE_ENABLE_PREFIX, &enable) == 0) {
+		if ((enable != NULL) && (strcasecmp(enable, "yes") == 0))
+			if (start_dns_cache() != 0)
+				fprintf(stderr, "%s: unable to start the DNS cache.\n", app);
+		free(enable);
+	}
+
+	char *targets = NULL;
+	if (read_parameter_value(PROBE_TARGETS_PREFIX, &targets) == 0) {
+		if ((targets != NULL) && (set_net_prober_targets(targets) != 0))
+			fprintf(stderr, "%s: invalid network probe targets.\n", app);
+		free(targets);
+	}
+	if (start_net_prober() != 0)
+		fprintf(stderr, "%s: unable to start the network prober: %s.\n", app, strerror(errno));
+
 	return 0;
 }
 
@@ -121,6 +165,32 @@ enum MHD_Result net_rest_api(struct MHD_Connection *connection, const char *url,
 		if (strcmp(method, "PUT") == 0)
 			return set_dns_address(connection);
 	}
+	if (strcasecmp(url, "/api/network/dns/cache") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return get_dns_cache(connection);
+		if (strcmp(method, "PUT") == 0)
+			return set_dns_cache(connection);
+	}
+	if (strcasecmp(url, "/api/network/dns/cache/stats") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return get_dns_cache_stats(connection);
+	}
+	if (strcasecmp(url, "/api/network/quality") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return get_network_quality(connection);
+	}
+	if (strcasecmp(url, "/api/network/quality/targets") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return get_quality_targets(connection);
+		if (strcmp(method, "PUT") == 0)
+			return set_quality_targets(connection);
+	}
+	if (strcasecmp(url, "/api/network/selftest") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return get_selftest_result(connection);
+		if (strcmp(method, "POST") == 0)
+			return run_selftest(connection);
+	}
 	if (strcasecmp(url, "/api/network/wifi") == 0) {
 		if (strcmp(method, "GET") == 0)
 			return scan_wifi(connection);
@@ -443,14 +513,18 @@ static enum MHD_Result set_network_interface_status(struct MHD_Connection *conne
 	if ((strcmp(status, "up") != 0) && (strcmp(status, "down") != 0))
 	        return send_rest_error(connection, "Interface status is invalid.", 400);
 
-	char command[256];
+	const char *argv[] = { status[0] == 'u' ? "/sbin/ifup" : "/sbin/ifdown", name, NULL };
+
+	return run_command_async(connection, argv, NULL, IFUPDOWN_TIMEOUT_MS, 0, reply_interface_status, NULL, NULL);
+}
+
 
-	snprintf(command, 255, "/sbin/if%s  %s",
-		status[0] == 'u' ? "up" : "down",
-		name);
-	command[255] = '\0';
 
-	if (system(command) == 0)
+static enum MHD_Result reply_interface_status(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	(void) arg;
+
+	if (result->exit_status == 0)
 		return send_rest_response(connection, "Ok");
 	return send_rest_error(connection, "Unable to set status.", 400);
 }
@@ -628,11 +702,180 @@ static enum MHD_Result set_dns_address(struct MHD_Connection *connection)
 		fprintf(fp, "nameserver %s\n", address);
 		fclose(fp);
 	}
+	// Answers from the previous server are not relevant anymore.
+	flush_dns_cache();
+
+	return send_rest_response(connection, "Ok");
+}
+
+
+
+static enum MHD_Result get_dns_cache(struct MHD_Connection *connection)
+{
+	return send_rest_response(connection, dns_cache_is_running() ? "enabled" : "disabled");
+}
+
+
+
+static enum MHD_Result set_dns_cache(struct MHD_Connection *connection)
+{
+	const char *enable = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "enable");
+	if (enable == NULL)
+	        return send_rest_error(connection, "Missing 'enable' parameter.", 400);
+
+	if ((strcasecmp(enable, "yes") != 0) && (strcasecmp(enable, "no") != 0))
+	        return send_rest_error(connection, "Parameter 'enable' must be 'yes' or 'no'.", 400);
+
+	if (strcasecmp(enable, "yes") == 0) {
+		if (start_dns_cache() != 0)
+			return send_rest_error(connection, "Unable to start the DNS cache.", 500);
+	} else {
+		stop_dns_cache();
+	}
+
+	if (write_parameter_value(DNS_CACHE_ENABLE_PREFIX, strcasecmp(enable, "yes") == 0 ? "yes" : "no") != 0)
+		return send_rest_error(connection, "Unable to store DNS cache parameter.", 500);
+
 	return send_rest_response(connection, "Ok");
 }
 
 
 
+static enum MHD_Result get_dns_cache_stats(struct MHD_Connection *connection)
+{
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos  = 0;
+
+	if (! dns_cache_is_running())
+		return send_rest_error(connection, "DNS cache is disabled.", 404);
+
+	if (get_dns_cache_statistics(&reply, &size, &pos) != 0)
+		return send_rest_error(connection, "Unable to read DNS cache statistics.", 500);
+
+	int ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
+}
+
+
+
+static enum MHD_Result get_network_quality(struct MHD_Connection *connection)
+{
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos  = 0;
+
+	if (get_net_quality(&reply, &size, &pos) != 0)
+		return send_rest_error(connection, "Unable to read network quality.", 500);
+
+	int ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
+}
+
+
+
+static enum MHD_Result get_quality_targets(struct MHD_Connection *connection)
+{
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos  = 0;
+
+	if (get_net_prober_targets(&reply, &size, &pos) != 0)
+		return send_rest_error(connection, "Unable to read network probe targets.", 500);
+
+	int ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
+}
+
+
+
+static enum MHD_Result set_quality_targets(struct MHD_Connection *connection)
+{
+	const char *targets = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "targets");
+	if (targets == NULL)
+	        return send_rest_error(connection, "Missing 'targets' parameter.", 400);
+
+	if (set_net_prober_targets(targets) != 0)
+	        return send_rest_error(connection, "Invalid targets list.", 400);
+
+	if (write_parameter_value(PROBE_TARGETS_PREFIX, targets) != 0)
+		return send_rest_error(connection, "Unable to store network probe targets.", 500);
+
+	return send_rest_response(connection, "Ok");
+}
+
+
+
+static enum MHD_Result get_selftest_result(struct MHD_Connection *connection)
+{
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos  = 0;
+
+	if (get_net_selftest_result(&reply, &size, &pos) != 0)
+		return send_rest_error(connection, "No self-test result available.", 404);
+
+	int ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
+}
+
+
+
+static enum MHD_Result run_selftest(struct MHD_Connection *connection)
+{
+	const union MHD_ConnectionInfo *info;
+	struct sockaddr_in peer;
+	long port  = SELFTEST_DEFAULT_PORT;
+	long bytes = SELFTEST_DEFAULT_BYTES;
+	long pings = SELFTEST_DEFAULT_PINGS;
+	const char *value;
+	int running;
+	int status;
+
+	// Connection resumed at the end of the self-test.
+	if (resume_net_selftest(connection, &running, &status)) {
+		if (running)
+			return MHD_YES;
+		if (status != 0)
+			return send_rest_error(connection, "Self-test failed (is the echo server running?).", 502);
+		return get_selftest_result(connection);
+	}
+
+	// The peer is an echo server running inside the calling container.
+	info = MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CLIENT_ADDRESS);
+	if ((info == NULL) || (info->client_addr == NULL) || (info->client_addr->sa_family != AF_INET))
+	        return send_rest_error(connection, "Self-test is only available to IPv4 clients.", 400);
+	memcpy(&peer, info->client_addr, sizeof(peer));
+
+	if ((value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "port")) != NULL)
+		port = atol(value);
+	if ((value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "bytes")) != NULL)
+		bytes = atol(value);
+	if ((value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "pings")) != NULL)
+		pings = atol(value);
+
+	if ((port <= 0) || (port > 65535))
+	        return send_rest_error(connection, "Invalid 'port' parameter.", 400);
+	if ((bytes <= 0) || (bytes > SELFTEST_MAX_BYTES))
+	        return send_rest_error(connection, "Invalid 'bytes' parameter.", 400);
+	if ((pings < 0) || (pings > SELFTEST_MAX_PINGS))
+	        return send_rest_error(connection, "Invalid 'pings' parameter.", 400);
+
+	// The measurements last up to 40 seconds: the reply is sent when
+	// the connection is resumed.
+	peer.sin_port = htons(port);
+	if (start_net_selftest(connection, &peer, bytes, pings) != 0)
+		return send_rest_error(connection, "Unable to start the self-test (is another one running?).", 503);
+
+	return MHD_YES;
+}
+
+
+
 static enum MHD_Result is_interface_wireless(struct MHD_Connection *connection)
 {
 	char pathname[256];
@@ -665,15 +908,6 @@ static enum MHD_Result is_interface_wireless(struct MHD_Connection *connection)
 
 static enum MHD_Result scan_wifi(struct MHD_Connection *connection)
 {
-	char command[256];
-	FILE *fp;
-	char line[256];
-	char ssid[256];
-
-	char *reply = NULL;
-	size_t size = 0;
-	size_t pos  = 0;
-
 	const char *name = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "name");
 	if (name == NULL)
 	        return send_rest_error(connection, "Missing interface name.", 400);
@@ -682,19 +916,42 @@ static enum MHD_Result scan_wifi(struct MHD_Connection *connection)
 		if ((name[i] == '/') || ( name == ';'))
 			return send_rest_error(connection, "Invalid interface name.", 400);
 
-	snprintf(command, 256, "/sbin/ip link set dev %s up", name);
-	command[255] = '\0';
-	if (system(command) != 0)
+	const char *argv[] = { "/sbin/ip", "link", "set", "dev", name, "up", NULL };
+
+	return run_command_async(connection, argv, NULL, IP_LINK_TIMEOUT_MS, 0, reply_scan_link_up, strdup(name), free);
+}
+
+
+
+static enum MHD_Result reply_scan_link_up(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	const char *name = arg;
+
+	if ((result->exit_status != 0) || (name == NULL))
 	        return send_rest_error(connection, "Invalid interface name.", 400);
 
-	snprintf(command, 256, "/usr/sbin/iw dev %s scan", name);
-	command[255] = '\0';
+	const char *argv[] = { "/usr/sbin/iw", "dev", name, "scan", NULL };
 
-	fp = popen(command, "r");
-	if (fp == NULL)
+	return run_command_async(connection, argv, NULL, IW_SCAN_TIMEOUT_MS, IW_SCAN_OUTPUT_LIMIT, reply_scan_wifi, NULL, NULL);
+}
+
+
+
+static enum MHD_Result reply_scan_wifi(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	char ssid[256];
+	char *saveptr = NULL;
+
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos  = 0;
+
+	(void) arg;
+
+	if (result->exit_status != 0)
 	        return send_rest_error(connection, "Unable to scan this interface.", 400);
 
-	while (fgets(line, 256, fp) != NULL) {
+	for (char *line = strtok_r(result->output, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
 		int start = 0;
 		if (! isspace(line[start]))
 			continue;
@@ -705,14 +962,13 @@ static enum MHD_Result scan_wifi(struct MHD_Connection *connection)
 			continue;
 		start += sizeof(IW_SSID_PREFIX) - 1;
 		int i = 0;
-		while ((i < 255) && (line[start + i] != '\n') && (line[start + i] != '\r') && (line[start + i] != '\0')) {
+		while ((i < 255) && (line[start + i] != '\r') && (line[start + i] != '\0')) {
 			ssid[i] = line[start + i];
 			i++;
 		}
 		ssid[i] = '\0';
 		addsnprintf(&reply, &size, &pos, "\r\n%s", ssid);
 	}
-	pclose(fp);
 	if (reply == NULL)
 	        return send_rest_error(connection, "No wifi access point available.", 404);
 
@@ -725,9 +981,7 @@ static enum MHD_Result scan_wifi(struct MHD_Connection *connection)
 
 static enum MHD_Result connect_wifi(struct MHD_Connection *connection)
 {
-	FILE *fp = NULL;
-	FILE *pp = NULL;
-	char line[1024];
+	char input[256];
 
 	const char *name = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "name");
 	if (name == NULL)
@@ -745,6 +999,26 @@ static enum MHD_Result connect_wifi(struct MHD_Connection *connection)
 	if (pass == NULL)
 	        return send_rest_error(connection, "Missing 'pass' param.", 400);
 
+	// The passphrase is given on stdin to keep it out of the command line.
+	if (snprintf(input, sizeof(input), "%s\n", pass) >= (int) sizeof(input))
+	        return send_rest_error(connection, "Invalid 'pass' param.", 400);
+
+	const char *argv[] = { "/usr/sbin/wpa_passphrase", ssid, NULL };
+
+	return run_command_async(connection, argv, input, WPA_TIMEOUT_MS, WPA_OUTPUT_LIMIT, reply_wpa_passphrase, strdup(name), free);
+}
+
+
+
+static enum MHD_Result reply_wpa_passphrase(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	const char *name = arg;
+	char *saveptr = NULL;
+	FILE *fp;
+
+	if ((result->exit_status != 0) || (name == NULL))
+	        return send_rest_error(connection, "Unable to call 'wpa_passphrase'.", 500);
+
 	fp = fopen("/etc/wpa_supplicant.conf", "w");
 	if (fp == NULL)
 	        return send_rest_error(connection, "Unable to open 'wpa_supplicant.conf' file.", 500);
@@ -752,21 +1026,27 @@ static enum MHD_Result connect_wifi(struct MHD_Connection *connection)
 	fprintf(fp, "# This file is automatically generated by Eris Linux API. DO NOT EDIT\n\n");
 	fprintf(fp, "ctrl_interface=/var/run/wpa_supplicant\nctrl_interface_group=0\nupdate_config=1\n\n");
 
-	snprintf(line, 1024, "/usr/sbin/wpa_passphrase '%s' %s | grep -v '#psk", ssid, pass);
-	line[1023] = '\0';
-	pp = popen(line, "r");
-	if (pp == NULL) {
-		fclose(fp);
-	        return send_rest_error(connection, "Unable to call 'wpa_passphrase'.", 500);
-	}
-	while (fgets(line, 1024, pp) != NULL)
-		fputs(line, fp);
-	pclose(pp);
+	// Do not store the clear passphrase.
+	for (char *line = strtok_r(result->output, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr))
+		if (strstr(line, "#psk") == NULL)
+			fprintf(fp, "%s\n", line);
 	fclose(fp);
 
-	snprintf(line, 1024, "wpa_supplicant -B -Dnl80211 -c/etc/wpa_supplicant.conf -i%s -P /var/run/wpa_supplicant.pid", name);
-	line[1023] = '\0';
-	system(line);
+	char interface[64];
+	if (snprintf(interface, sizeof(interface), "-i%s", name) >= (int) sizeof(interface))
+	        return send_rest_error(connection, "Invalid interface name.", 400);
+
+	const char *argv[] = { "wpa_supplicant", "-B", "-Dnl80211", "-c/etc/wpa_supplicant.conf", interface, "-P", "/var/run/wpa_supplicant.pid", NULL };
+
+	return run_command_async(connection, argv, NULL, WPA_TIMEOUT_MS, 0, reply_wpa_supplicant, NULL, NULL);
+}
+
+
+
+static enum MHD_Result reply_wpa_supplicant(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	(void) result;
+	(void) arg;
 
 	return send_rest_response(connection, "Ok");
 }
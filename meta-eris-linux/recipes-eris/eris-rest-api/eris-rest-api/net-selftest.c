@@ -0,0 +1,497 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#define _GNU_SOURCE   // splice(), vmsplice().
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "addsnprintf.h"
+#include "net-selftest.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define SELFTEST_CHUNK_SIZE      (64 * 1024)
+#define SELFTEST_PING_SIZE       64
+#define SELFTEST_IO_TIMEOUT_S    5
+#define SELFTEST_DEADLINE_S      20
+
+#define SYSTEM_VERSION_FILE      "/usr/share/eris-linux/system-version"
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	int        sock;
+	size_t     expected;
+	size_t     received;
+	long long  cpu_ns;
+	long long  deadline_ns;
+	int        error;
+
+} selftest_receiver_t;
+
+
+typedef struct {
+
+	int        valid;
+	char       peer[INET_ADDRSTRLEN + 8];
+	size_t     bytes;
+	long long  duration_ns;
+	long long  cpu_ns;
+	int        pings;
+	long long  rtt_min_ns;
+	long long  rtt_p50_ns;
+	long long  rtt_p90_ns;
+	long long  rtt_p99_ns;
+	long long  rtt_max_ns;
+	char       version[64];
+
+} selftest_result_t;
+
+
+typedef struct {
+
+	struct MHD_Connection *connection;    // NULL when the connection has been closed.
+	struct sockaddr_in     peer;
+	size_t                 bytes;
+	int                    pings;
+	int                    done;
+	int                    status;
+
+} selftest_job_t;
+
+
+// ---------------------- Private method declarations.
+
+static void  *selftest_thread       (void *arg);
+static int    run_net_selftest      (const struct sockaddr_in *peer, size_t bytes, int pings);
+static int    connect_to_peer       (const struct sockaddr_in *peer);
+static int    measure_throughput    (const struct sockaddr_in *peer, size_t bytes, selftest_result_t *result);
+static void  *receiver_thread       (void *arg);
+static int    measure_latency       (const struct sockaddr_in *peer, int pings, selftest_result_t *result);
+static int    compare_long_longs    (const void *a, const void *b);
+static void   read_system_version   (char *version, size_t size);
+static long long monotonic_ns       (void);
+static long long thread_cpu_ns      (void);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t    selftest_mutex = PTHREAD_MUTEX_INITIALIZER;
+static selftest_result_t  last_result;
+static selftest_job_t    *selftest_job = NULL;
+
+
+// ---------------------- Public methods
+
+int start_net_selftest(struct MHD_Connection *connection, const struct sockaddr_in *peer, size_t bytes, int pings)
+{
+	pthread_t thread;
+
+	pthread_mutex_lock(&selftest_mutex);
+	if (selftest_job != NULL) {
+		pthread_mutex_unlock(&selftest_mutex);
+		return -1;
+	}
+	selftest_job_t *job = calloc(1, sizeof(selftest_job_t));
+	if (job == NULL) {
+		pthread_mutex_unlock(&selftest_mutex);
+		return -1;
+	}
+	job->connection = connection;
+	job->peer       = *peer;
+	job->bytes      = bytes;
+	job->pings      = pings;
+
+	// Suspended before the thread may resume it.
+	MHD_suspend_connection(connection);
+	if (pthread_create(&thread, NULL, selftest_thread, job) != 0) {
+		MHD_resume_connection(connection);
+		pthread_mutex_unlock(&selftest_mutex);
+		free(job);
+		return -1;
+	}
+	pthread_detach(thread);
+	selftest_job = job;
+	pthread_mutex_unlock(&selftest_mutex);
+
+	return 0;
+}
+
+
+
+int resume_net_selftest(struct MHD_Connection *connection, int *running, int *status)
+{
+	pthread_mutex_lock(&selftest_mutex);
+	selftest_job_t *job = selftest_job;
+	if ((job == NULL) || (job->connection != connection)) {
+		pthread_mutex_unlock(&selftest_mutex);
+		return 0;
+	}
+	*running = ! job->done;
+	*status  = job->status;
+	if (job->done) {
+		selftest_job = NULL;
+		free(job);
+	}
+	pthread_mutex_unlock(&selftest_mutex);
+	return 1;
+}
+
+
+
+void release_net_selftest(struct MHD_Connection *connection)
+{
+	pthread_mutex_lock(&selftest_mutex);
+	selftest_job_t *job = selftest_job;
+	if ((job != NULL) && (job->connection == connection)) {
+		if (job->done) {
+			selftest_job = NULL;
+			free(job);
+		} else {
+			// The worker thread releases it at the end of the self-test.
+			job->connection = NULL;
+		}
+	}
+	pthread_mutex_unlock(&selftest_mutex);
+}
+
+
+
+int get_net_selftest_result(char **string, size_t *size, size_t *pos)
+{
+	selftest_result_t result;
+
+	pthread_mutex_lock(&selftest_mutex);
+	result = last_result;
+	pthread_mutex_unlock(&selftest_mutex);
+
+	if (! result.valid)
+		return -1;
+
+	long long duration_us = result.duration_ns / 1000;
+	if (duration_us <= 0)
+		duration_us = 1;
+
+	return addsnprintf(string, size, pos,
+		"peer=%s bytes=%zu duration_ms=%lld throughput_mbps=%lld cpu_ms=%lld cpu_ns_per_kb=%lld "
+		"pings=%d rtt_min_us=%lld rtt_p50_us=%lld rtt_p90_us=%lld rtt_p99_us=%lld rtt_max_us=%lld "
+		"system_version=%s",
+		result.peer, result.bytes, result.duration_ns / 1000000,
+		(long long) result.bytes * 8 / duration_us,
+		result.cpu_ns / 1000000,
+		result.bytes > 0 ? result.cpu_ns * 1024 / (long long) result.bytes : 0,
+		result.pings, result.rtt_min_ns / 1000, result.rtt_p50_ns / 1000,
+		result.rtt_p90_ns / 1000, result.rtt_p99_ns / 1000, result.rtt_max_ns / 1000,
+		result.version);
+}
+
+
+// ---------------------- Private methods
+
+static void *selftest_thread(void *arg)
+{
+	selftest_job_t *job = arg;
+
+	int status = run_net_selftest(&(job->peer), job->bytes, job->pings);
+
+	pthread_mutex_lock(&selftest_mutex);
+	job->status = status;
+	job->done   = 1;
+	if (job->connection != NULL) {
+		MHD_resume_connection(job->connection);
+	} else {
+		selftest_job = NULL;
+		free(job);
+	}
+	pthread_mutex_unlock(&selftest_mutex);
+
+	return NULL;
+}
+
+
+
+static int run_net_selftest(const struct sockaddr_in *peer, size_t bytes, int pings)
+{
+	selftest_result_t result;
+
+	memset(&result, 0, sizeof(result));
+	char address[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &(peer->sin_addr), address, sizeof(address));
+	snprintf(result.peer, sizeof(result.peer), "%s:%d", address, ntohs(peer->sin_port));
+	read_system_version(result.version, sizeof(result.version));
+
+	if (measure_throughput(peer, bytes, &result) != 0)
+		return -1;
+	if (measure_latency(peer, pings, &result) != 0)
+		return -1;
+
+	result.valid = 1;
+	pthread_mutex_lock(&selftest_mutex);
+	last_result = result;
+	pthread_mutex_unlock(&selftest_mutex);
+
+	return 0;
+}
+
+
+
+static int connect_to_peer(const struct sockaddr_in *peer)
+{
+	int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+
+	struct timeval timeout = { .tv_sec = SELFTEST_IO_TIMEOUT_S, .tv_usec = 0 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	if (connect(sock, (const struct sockaddr *) peer, sizeof(*peer)) != 0) {
+		close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+
+
+// The peer echoes the data: the sender pushes zero-filled pages with
+// vmsplice()/splice() and a second thread sinks the echo with splice()
+// into /dev/null, so that no payload is copied in user space.
+static int measure_throughput(const struct sockaddr_in *peer, size_t bytes, selftest_result_t *result)
+{
+	static char zeros[SELFTEST_CHUNK_SIZE] __attribute__((aligned(4096)));
+	int pipe_fd[2];
+	pthread_t thread;
+	selftest_receiver_t receiver;
+
+	int sock = connect_to_peer(peer);
+	if (sock < 0)
+		return -1;
+
+	if (pipe2(pipe_fd, O_CLOEXEC) != 0) {
+		close(sock);
+		return -1;
+	}
+
+	long long start = monotonic_ns();
+	memset(&receiver, 0, sizeof(receiver));
+	receiver.sock        = sock;
+	receiver.expected    = bytes;
+	receiver.deadline_ns = start + SELFTEST_DEADLINE_S * 1000000000LL;
+
+	if (pthread_create(&thread, NULL, receiver_thread, &receiver) != 0) {
+		close(pipe_fd[0]);
+		close(pipe_fd[1]);
+		close(sock);
+		return -1;
+	}
+
+	long long cpu_start = thread_cpu_ns();
+	size_t sent = 0;
+	int error = 0;
+
+	while ((sent < bytes) && (! error)) {
+		struct iovec iov = { .iov_base = zeros, .iov_len = SELFTEST_CHUNK_SIZE };
+		if (bytes - sent < SELFTEST_CHUNK_SIZE)
+			iov.iov_len = bytes - sent;
+
+		ssize_t n = vmsplice(pipe_fd[1], &iov, 1, 0);
+		if (n <= 0) {
+			error = 1;
+			break;
+		}
+		while (n > 0) {
+			ssize_t m = splice(pipe_fd[0], NULL, sock, NULL, n, SPLICE_F_MOVE | SPLICE_F_MORE);
+			if ((m <= 0) || (monotonic_ns() > receiver.deadline_ns)) {
+				error = 1;
+				break;
+			}
+			n    -= m;
+			sent += m;
+		}
+	}
+	long long cpu_sender = thread_cpu_ns() - cpu_start;
+
+	if (error)
+		shutdown(sock, SHUT_RDWR);
+	pthread_join(thread, NULL);
+
+	result->duration_ns = monotonic_ns() - start;
+	result->cpu_ns      = cpu_sender + receiver.cpu_ns;
+	result->bytes       = receiver.received;
+
+	close(pipe_fd[0]);
+	close(pipe_fd[1]);
+	close(sock);
+
+	if (error || receiver.error)
+		return -1;
+	return 0;
+}
+
+
+
+static void *receiver_thread(void *arg)
+{
+	selftest_receiver_t *receiver = arg;
+	int pipe_fd[2];
+
+	long long cpu_start = thread_cpu_ns();
+
+	int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+	if ((null_fd < 0) || (pipe2(pipe_fd, O_CLOEXEC) != 0)) {
+		if (null_fd >= 0)
+			close(null_fd);
+		receiver->error = 1;
+		return NULL;
+	}
+
+	while (receiver->received < receiver->expected) {
+		size_t wanted = receiver->expected - receiver->received;
+		if (wanted > SELFTEST_CHUNK_SIZE)
+			wanted = SELFTEST_CHUNK_SIZE;
+
+		ssize_t n = splice(receiver->sock, NULL, pipe_fd[1], NULL, wanted, SPLICE_F_MOVE);
+		if ((n <= 0) || (monotonic_ns() > receiver->deadline_ns)) {
+			receiver->error = 1;
+			break;
+		}
+		receiver->received += n;
+		while (n > 0) {
+			ssize_t m = splice(pipe_fd[0], NULL, null_fd, NULL, n, SPLICE_F_MOVE);
+			if (m <= 0)
+				break;
+			n -= m;
+		}
+	}
+
+	close(pipe_fd[0]);
+	close(pipe_fd[1]);
+	close(null_fd);
+
+	receiver->cpu_ns = thread_cpu_ns() - cpu_start;
+	return NULL;
+}
+
+
+
+static int measure_latency(const struct sockaddr_in *peer, int pings, selftest_result_t *result)
+{
+	char buffer[SELFTEST_PING_SIZE];
+	int one = 1;
+
+	if (pings <= 0)
+		return 0;
+
+	long long *rtts = malloc(pings * sizeof(long long));
+	if (rtts == NULL)
+		return -1;
+
+	int sock = connect_to_peer(peer);
+	if (sock < 0) {
+		free(rtts);
+		return -1;
+	}
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	memset(buffer, 'E', sizeof(buffer));
+	long long deadline = monotonic_ns() + SELFTEST_DEADLINE_S * 1000000000LL;
+	int done;
+
+	for (done = 0; done < pings; done++) {
+		long long start = monotonic_ns();
+		if (start > deadline)
+			break;
+		if (send(sock, buffer, sizeof(buffer), MSG_NOSIGNAL) != sizeof(buffer))
+			break;
+		size_t received = 0;
+		while (received < sizeof(buffer)) {
+			ssize_t n = recv(sock, buffer + received, sizeof(buffer) - received, 0);
+			if (n <= 0)
+				break;
+			received += n;
+		}
+		if (received < sizeof(buffer))
+			break;
+		rtts[done] = monotonic_ns() - start;
+	}
+	close(sock);
+
+	if (done < pings) {
+		free(rtts);
+		return -1;
+	}
+
+	qsort(rtts, pings, sizeof(long long), compare_long_longs);
+	result->pings      = pings;
+	result->rtt_min_ns = rtts[0];
+	result->rtt_p50_ns = rtts[(50 * pings + 99) / 100 - 1];
+	result->rtt_p90_ns = rtts[(90 * pings + 99) / 100 - 1];
+	result->rtt_p99_ns = rtts[(99 * pings + 99) / 100 - 1];
+	result->rtt_max_ns = rtts[pings - 1];
+
+	free(rtts);
+	return 0;
+}
+
+
+
+static int compare_long_longs(const void *a, const void *b)
+{
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+	return (x > y) - (x < y);
+}
+
+
+
+static void read_system_version(char *version, size_t size)
+{
+	snprintf(version, size, "unknown");
+
+	FILE *fp = fopen(SYSTEM_VERSION_FILE, "r");
+	if (fp == NULL)
+		return;
+	if (fgets(version, size, fp) != NULL)
+		version[strcspn(version, "\n")] = '\0';
+	fclose(fp);
+}
+
+
+
+static long long monotonic_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+static long long thread_cpu_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
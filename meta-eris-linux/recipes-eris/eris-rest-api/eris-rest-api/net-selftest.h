@@ -0,0 +1,33 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef NET_SELFTEST_H
+#define NET_SELFTEST_H
+
+	#include <stddef.h>
+	#include <microhttpd.h>
+	#include <netinet/in.h>
+
+	#define SELFTEST_DEFAULT_PORT    7
+	#define SELFTEST_DEFAULT_BYTES   (16 * 1024 * 1024)
+	#define SELFTEST_MAX_BYTES       (256 * 1024 * 1024)
+	#define SELFTEST_DEFAULT_PINGS   100
+	#define SELFTEST_MAX_PINGS       10000
+
+	// Run the self-test in a worker thread and suspend the connection until
+	// its end. Only one self-test runs at a time.
+	int  start_net_selftest(struct MHD_Connection *connection, const struct sockaddr_in *peer, size_t bytes, int pings);
+
+	// Return 0 if no self-test was started by the connection. Otherwise
+	// *running is set until the end of the self-test, then *status gives
+	// its result (0 or -1) and the self-test is released.
+	int  resume_net_selftest(struct MHD_Connection *connection, int *running, int *status);
+	void release_net_selftest(struct MHD_Connection *connection);
+
+	int get_net_selftest_result(char **string, size_t *size, size_t *pos);
+
+#endif
@@ -0,0 +1,645 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// SNTP client (RFC 4330) of the REST API, in place of the ntpd -q loop.
+// At each poll, every address of every configured server gets a few
+// requests. The sample with the smallest round trip delay is kept for each
+// server (the others give its jitter). With three servers or more, those
+// too far from the median offset are discarded, then the server with the
+// smallest root distance is selected.
+//
+// The clock is stepped only at the first synchronization (the containers
+// are not started yet, or the clock was not set at all). Later offsets are
+// slewed by the kernel (adjtimex single shot, as adjtime()), so that the
+// time never goes backward. The RTC is written back at most every 11
+// minutes.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/rtc.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timex.h>
+
+#include "addsnprintf.h"
+#include "eris-rest-api.h"
+#include "sntp-client.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define NTP_SERVER_PREFIX         "ntp_server="
+#define NTP_ENABLE_PREFIX         "ntp_enable="
+
+#define NTP_PORT                  "123"
+#define NTP_PACKET_SIZE           48
+// Seconds from 1900 to 1970.
+#define NTP_UNIX_DELTA            2208988800LL
+
+#define SNTP_SERVERS_MAX          8
+#define SNTP_ADDRESSES_PER_NAME   4
+#define SNTP_SAMPLES              4
+#define SNTP_SAMPLE_SPACING_MS    2000
+#define SNTP_REPLY_TIMEOUT_MS     1000
+
+#define SNTP_MIN_POLL_S           64
+#define SNTP_MAX_POLL_S           1024
+#define SNTP_RETRY_S              30
+
+#define SNTP_STEP_THRESHOLD_NS    (128LL * 1000000)
+#define SNTP_FALSETICKER_NS       (128LL * 1000000)
+// Limit of adjtime().
+#define SNTP_MAX_SLEW_NS          (2000LL * 1000000000)
+
+#define SNTP_RTC_PERIOD_S         660
+#define RTC_DEVICE                "/dev/rtc"
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	char       address[64];
+	int        sock;
+	uint8_t    transmit[8];        // Transmit timestamp of the pending request.
+	long long  sent_ns;
+
+	int        samples;
+	long long  offsets_ns[SNTP_SAMPLES];
+	long long  delays_ns[SNTP_SAMPLES];
+	int        stratum;
+	long long  root_ns;            // Root delay / 2 + root dispersion.
+
+	long long  offset_ns;
+	long long  delay_ns;
+	long long  jitter_ns;
+	long long  distance_ns;
+
+} sntp_server_t;
+
+
+typedef struct {
+
+	int        enabled;
+	int        synchronized;
+	char       server[64];
+	int        servers;
+	int        stratum;
+	long long  offset_us;
+	long long  delay_us;
+	long long  jitter_us;
+	time_t     last_sync;
+	time_t     last_attempt;
+	time_t     last_rtc_write;
+	int        poll_s;
+	int        steps;
+	int        slews;
+
+} sntp_status_t;
+
+
+// ---------------------- Private method declarations.
+
+static void     *sntp_thread          (void *arg);
+static int       sntp_poll            (void);
+static int       open_servers         (sntp_server_t *servers);
+static void      send_requests        (sntp_server_t *servers, int count);
+static void      receive_replies      (sntp_server_t *servers, int count, long long deadline_ns);
+static void      read_reply           (sntp_server_t *server);
+static int       filter_server        (sntp_server_t *server);
+static int       select_server        (sntp_server_t *servers, int count);
+static void      correct_clock        (long long offset_ns);
+static void      write_rtc            (void);
+static void      ns_to_ntp            (long long ns, uint8_t *p);
+static long long ntp_to_ns            (const uint8_t *p);
+static long long ntp_short_to_ns      (const uint8_t *p);
+static long long realtime_ns          (void);
+static long long monotonic_ns         (void);
+static int       compare_offsets      (const void *a, const void *b);
+static void      format_time          (char *buffer, size_t size, time_t t);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t sntp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sntp_status_t   sntp_status;
+static int             sntp_wakeup_fd = -1;
+
+
+// ---------------------- Public methods
+
+int start_sntp_client(void)
+{
+	pthread_t thread;
+
+	sntp_wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (sntp_wakeup_fd < 0)
+		return -1;
+
+	if (pthread_create(&thread, NULL, sntp_thread, NULL) != 0) {
+		close(sntp_wakeup_fd);
+		sntp_wakeup_fd = -1;
+		return -1;
+	}
+	pthread_detach(thread);
+	return 0;
+}
+
+
+
+void wakeup_sntp_client(void)
+{
+	uint64_t one = 1;
+
+	if (sntp_wakeup_fd >= 0)
+		write(sntp_wakeup_fd, &one, sizeof(one));
+}
+
+
+
+int get_sntp_status(char **string, size_t *size, size_t *pos)
+{
+	sntp_status_t status;
+	char last_sync[32];
+	char last_attempt[32];
+	char last_rtc_write[32];
+
+	pthread_mutex_lock(&sntp_mutex);
+	status = sntp_status;
+	pthread_mutex_unlock(&sntp_mutex);
+
+	format_time(last_sync, sizeof(last_sync), status.last_sync);
+	format_time(last_attempt, sizeof(last_attempt), status.last_attempt);
+	format_time(last_rtc_write, sizeof(last_rtc_write), status.last_rtc_write);
+
+	return addsnprintf(string, size, pos,
+		"enabled=%s\nsynchronized=%s\nserver=%s\nservers=%d\nstratum=%d\n"
+		"offset_us=%lld\ndelay_us=%lld\njitter_us=%lld\n"
+		"last_sync=%s\nlast_attempt=%s\nlast_rtc_write=%s\npoll_s=%d\nsteps=%d\nslews=%d\n",
+		status.enabled ? "yes" : "no", status.synchronized ? "yes" : "no",
+		status.server[0] != '\0' ? status.server : "none", status.servers, status.stratum,
+		status.offset_us, status.delay_us, status.jitter_us,
+		last_sync, last_attempt, last_rtc_write, status.poll_s, status.steps, status.slews);
+}
+
+
+// ---------------------- Private methods
+
+static void *sntp_thread(void *arg)
+{
+	uint64_t value;
+
+	(void) arg;
+
+	for (;;) {
+		int delay_s = sntp_poll();
+
+		pthread_mutex_lock(&sntp_mutex);
+		sntp_status.poll_s = delay_s;
+		pthread_mutex_unlock(&sntp_mutex);
+
+		// Disabled: wait for a change of the parameters.
+		struct pollfd fds = { .fd = sntp_wakeup_fd, .events = POLLIN };
+		if (poll(&fds, 1, delay_s > 0 ? delay_s * 1000 : -1) > 0)
+			read(sntp_wakeup_fd, &value, sizeof(value));
+	}
+	return NULL;
+}
+
+
+
+// Returns the delay before the next poll, 0 if disabled.
+static int sntp_poll(void)
+{
+	sntp_server_t servers[SNTP_SERVERS_MAX];
+	char *enable = NULL;
+
+	int enabled = (read_parameter_value(NTP_ENABLE_PREFIX, &enable) == 0)
+	           && (enable != NULL) && (strcasecmp(enable, "yes") == 0);
+	free(enable);
+
+	pthread_mutex_lock(&sntp_mutex);
+	sntp_status.enabled = enabled;
+	if (enabled)
+		sntp_status.last_attempt = time(NULL);
+	int poll_s = sntp_status.poll_s;
+	pthread_mutex_unlock(&sntp_mutex);
+
+	if (! enabled)
+		return 0;
+
+	int count = open_servers(servers);
+	if (count == 0) {
+		pthread_mutex_lock(&sntp_mutex);
+		sntp_status.servers = 0;
+		pthread_mutex_unlock(&sntp_mutex);
+		return SNTP_RETRY_S;
+	}
+
+	for (int k = 0; k < SNTP_SAMPLES; k++) {
+		long long start = monotonic_ns();
+		send_requests(servers, count);
+		receive_replies(servers, count, start + SNTP_REPLY_TIMEOUT_MS * 1000000LL);
+		if (k < SNTP_SAMPLES - 1) {
+			long long left = start + SNTP_SAMPLE_SPACING_MS * 1000000LL - monotonic_ns();
+			if (left > 0) {
+				struct timespec ts = { .tv_sec = left / 1000000000, .tv_nsec = left % 1000000000 };
+				nanosleep(&ts, NULL);
+			}
+		}
+	}
+
+	int answering = 0;
+	for (int i = 0; i < count; i++) {
+		close(servers[i].sock);
+		if (filter_server(&(servers[i])) == 0)
+			answering++;
+	}
+
+	int selected = select_server(servers, count);
+	if (selected < 0) {
+		pthread_mutex_lock(&sntp_mutex);
+		sntp_status.servers = answering;
+		pthread_mutex_unlock(&sntp_mutex);
+		return SNTP_RETRY_S;
+	}
+	sntp_server_t *server = &(servers[selected]);
+
+	correct_clock(server->offset_ns);
+
+	// Longer polls while the offset stays in the noise.
+	if ((poll_s < SNTP_MIN_POLL_S) || (llabs(server->offset_ns) > 4 * server->jitter_ns + 1000000))
+		poll_s = SNTP_MIN_POLL_S;
+	else if (poll_s < SNTP_MAX_POLL_S)
+		poll_s *= 2;
+
+	pthread_mutex_lock(&sntp_mutex);
+	snprintf(sntp_status.server, sizeof(sntp_status.server), "%s", server->address);
+	sntp_status.servers   = answering;
+	sntp_status.stratum   = server->stratum;
+	sntp_status.offset_us = server->offset_ns / 1000;
+	sntp_status.delay_us  = server->delay_ns / 1000;
+	sntp_status.jitter_us = server->jitter_ns / 1000;
+	sntp_status.last_sync = time(NULL);
+	int write_back = (sntp_status.last_sync - sntp_status.last_rtc_write >= SNTP_RTC_PERIOD_S);
+	if (write_back)
+		sntp_status.last_rtc_write = sntp_status.last_sync;
+	pthread_mutex_unlock(&sntp_mutex);
+
+	if (write_back)
+		write_rtc();
+	return poll_s;
+}
+
+
+
+// Every address of every name of the ntp_server parameter.
+static int open_servers(sntp_server_t *servers)
+{
+	char *names = NULL;
+	char *saveptr = NULL;
+	int count = 0;
+
+	if ((read_parameter_value(NTP_SERVER_PREFIX, &names) != 0) || (names == NULL))
+		return 0;
+
+	for (char *name = strtok_r(names, ", \t", &saveptr); name != NULL; name = strtok_r(NULL, ", \t", &saveptr)) {
+		struct addrinfo hints;
+		struct addrinfo *list;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_DGRAM;
+		if (getaddrinfo(name, NTP_PORT, &hints, &list) != 0)
+			continue;
+
+		int per_name = 0;
+		for (struct addrinfo *ai = list; ai != NULL; ai = ai->ai_next) {
+			if ((count >= SNTP_SERVERS_MAX) || (per_name >= SNTP_ADDRESSES_PER_NAME))
+				break;
+			sntp_server_t *server = &(servers[count]);
+			memset(server, 0, sizeof(sntp_server_t));
+			// Connected: the replies from other sources are dropped by the kernel.
+			server->sock = socket(ai->ai_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+			if (server->sock < 0)
+				continue;
+			if (connect(server->sock, ai->ai_addr, ai->ai_addrlen) != 0) {
+				close(server->sock);
+				continue;
+			}
+			getnameinfo(ai->ai_addr, ai->ai_addrlen, server->address, sizeof(server->address), NULL, 0, NI_NUMERICHOST);
+			count++;
+			per_name++;
+		}
+		freeaddrinfo(list);
+	}
+	free(names);
+	return count;
+}
+
+
+
+static void send_requests(sntp_server_t *servers, int count)
+{
+	uint8_t packet[NTP_PACKET_SIZE];
+
+	for (int i = 0; i < count; i++) {
+		memset(packet, 0, sizeof(packet));
+		// LI 0, version 4, mode 3 (client).
+		packet[0] = 0x23;
+		servers[i].sent_ns = realtime_ns();
+		ns_to_ntp(servers[i].sent_ns, servers[i].transmit);
+		memcpy(packet + 40, servers[i].transmit, 8);
+		send(servers[i].sock, packet, sizeof(packet), 0);
+	}
+}
+
+
+
+static void receive_replies(sntp_server_t *servers, int count, long long deadline_ns)
+{
+	struct pollfd fds[SNTP_SERVERS_MAX];
+	int waiting = count;
+	int answered[SNTP_SERVERS_MAX];
+
+	memset(answered, 0, sizeof(answered));
+	while (waiting > 0) {
+		long long left = deadline_ns - monotonic_ns();
+		if (left <= 0)
+			return;
+		for (int i = 0; i < count; i++) {
+			fds[i].fd = answered[i] ? -1 : servers[i].sock;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+		if (poll(fds, count, (left + 999999) / 1000000) <= 0)
+			return;
+		for (int i = 0; i < count; i++) {
+			if ((fds[i].revents & POLLIN) == 0)
+				continue;
+			int samples = servers[i].samples;
+			read_reply(&(servers[i]));
+			if (servers[i].samples > samples) {
+				answered[i] = 1;
+				waiting--;
+			}
+		}
+	}
+}
+
+
+
+static void read_reply(sntp_server_t *server)
+{
+	uint8_t packet[NTP_PACKET_SIZE + 64];
+
+	ssize_t n = recv(server->sock, packet, sizeof(packet), 0);
+	long long t4 = realtime_ns();
+	if (n < NTP_PACKET_SIZE)
+		return;
+
+	int leap = packet[0] >> 6;
+	int mode = packet[0] & 0x07;
+	int stratum = packet[1];
+	// Server mode, synchronized, and answering our last request.
+	if ((mode != 4) || (leap == 3) || (stratum < 1) || (stratum > 15))
+		return;
+	if (memcmp(packet + 24, server->transmit, 8) != 0)
+		return;
+	static const uint8_t zero[8];
+	if (memcmp(packet + 40, zero, 8) == 0)
+		return;
+	// A duplicate would match again.
+	memset(server->transmit, 0, sizeof(server->transmit));
+
+	long long t1 = server->sent_ns;
+	long long t2 = ntp_to_ns(packet + 32);
+	long long t3 = ntp_to_ns(packet + 40);
+
+	long long delay = (t4 - t1) - (t3 - t2);
+	if (delay < 0)
+		delay = 0;
+
+	int k = server->samples++;
+	server->offsets_ns[k] = ((t2 - t1) + (t3 - t4)) / 2;
+	server->delays_ns[k] = delay;
+	server->stratum = stratum;
+	server->root_ns = ntp_short_to_ns(packet + 4) / 2 + ntp_short_to_ns(packet + 8);
+}
+
+
+
+// Keeps the sample with the smallest delay, the least disturbed by the
+// network queues.
+static int filter_server(sntp_server_t *server)
+{
+	if (server->samples == 0)
+		return -1;
+
+	int best = 0;
+	for (int k = 1; k < server->samples; k++)
+		if (server->delays_ns[k] < server->delays_ns[best])
+			best = k;
+
+	server->offset_ns = server->offsets_ns[best];
+	server->delay_ns = server->delays_ns[best];
+	server->jitter_ns = 0;
+	if (server->samples > 1) {
+		for (int k = 0; k < server->samples; k++)
+			server->jitter_ns += llabs(server->offsets_ns[k] - server->offset_ns);
+		server->jitter_ns /= server->samples - 1;
+	}
+	server->distance_ns = server->root_ns + server->delay_ns / 2 + server->jitter_ns;
+	return 0;
+}
+
+
+
+static int select_server(sntp_server_t *servers, int count)
+{
+	long long offsets[SNTP_SERVERS_MAX];
+	long long median = 0;
+	int valid = 0;
+	int selected = -1;
+
+	for (int i = 0; i < count; i++)
+		if (servers[i].samples > 0)
+			offsets[valid++] = servers[i].offset_ns;
+	if (valid == 0)
+		return -1;
+
+	if (valid >= 3) {
+		qsort(offsets, valid, sizeof(long long), compare_offsets);
+		median = offsets[valid / 2];
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (servers[i].samples == 0)
+			continue;
+		if ((valid >= 3) && (llabs(servers[i].offset_ns - median) > SNTP_FALSETICKER_NS))
+			continue;
+		if ((selected < 0) || (servers[i].distance_ns < servers[selected].distance_ns))
+			selected = i;
+	}
+	return selected;
+}
+
+
+
+static void correct_clock(long long offset_ns)
+{
+	pthread_mutex_lock(&sntp_mutex);
+	int first = ! sntp_status.synchronized;
+	sntp_status.synchronized = 1;
+	pthread_mutex_unlock(&sntp_mutex);
+
+	if ((first) && (llabs(offset_ns) >= SNTP_STEP_THRESHOLD_NS)) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		long long ns = ts.tv_sec * 1000000000LL + ts.tv_nsec + offset_ns;
+		ts.tv_sec = ns / 1000000000;
+		ts.tv_nsec = ns % 1000000000;
+		if (clock_settime(CLOCK_REALTIME, &ts) == 0) {
+			pthread_mutex_lock(&sntp_mutex);
+			sntp_status.steps++;
+			pthread_mutex_unlock(&sntp_mutex);
+		}
+		return;
+	}
+
+	if (offset_ns > SNTP_MAX_SLEW_NS)
+		offset_ns = SNTP_MAX_SLEW_NS;
+	if (offset_ns < -SNTP_MAX_SLEW_NS)
+		offset_ns = -SNTP_MAX_SLEW_NS;
+
+	// Replaces the correction in progress, if any.
+	struct timex tx;
+	memset(&tx, 0, sizeof(tx));
+	tx.modes = ADJ_OFFSET_SINGLESHOT;
+	tx.offset = offset_ns / 1000;
+	if (adjtimex(&tx) >= 0) {
+		pthread_mutex_lock(&sntp_mutex);
+		sntp_status.slews++;
+		pthread_mutex_unlock(&sntp_mutex);
+	}
+}
+
+
+
+// The RTC keeps the UTC time.
+static void write_rtc(void)
+{
+	struct rtc_time rtm;
+	struct tm tm;
+	time_t now = time(NULL);
+
+	int fd = open(RTC_DEVICE, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	gmtime_r(&now, &tm);
+	memset(&rtm, 0, sizeof(rtm));
+	rtm.tm_sec  = tm.tm_sec;
+	rtm.tm_min  = tm.tm_min;
+	rtm.tm_hour = tm.tm_hour;
+	rtm.tm_mday = tm.tm_mday;
+	rtm.tm_mon  = tm.tm_mon;
+	rtm.tm_year = tm.tm_year;
+
+	ioctl(fd, RTC_SET_TIME, &rtm);
+	close(fd);
+}
+
+
+
+static void ns_to_ntp(long long ns, uint8_t *p)
+{
+	uint32_t seconds = (uint32_t) (ns / 1000000000 + NTP_UNIX_DELTA);
+	uint32_t fraction = (uint32_t) (((ns % 1000000000) << 32) / 1000000000);
+
+	p[0] = seconds >> 24;  p[1] = seconds >> 16;  p[2] = seconds >> 8;  p[3] = seconds;
+	p[4] = fraction >> 24; p[5] = fraction >> 16; p[6] = fraction >> 8; p[7] = fraction;
+}
+
+
+
+// Nanoseconds since 1970. The seconds below 2^31 belong to the second NTP
+// era (from 2036).
+static long long ntp_to_ns(const uint8_t *p)
+{
+	long long seconds = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+	long long fraction = ((uint32_t) p[4] << 24) | ((uint32_t) p[5] << 16) | ((uint32_t) p[6] << 8) | p[7];
+
+	if (seconds < 0x80000000LL)
+		seconds += 0x100000000LL;
+	return (seconds - NTP_UNIX_DELTA) * 1000000000LL + ((fraction * 1000000000LL) >> 32);
+}
+
+
+
+// 16.16 fixed point seconds (root delay and dispersion).
+static long long ntp_short_to_ns(const uint8_t *p)
+{
+	long long value = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+
+	return (value * 1000000000LL) >> 16;
+}
+
+
+
+static long long realtime_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+static long long monotonic_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+static int compare_offsets(const void *a, const void *b)
+{
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+
+	return (x > y) - (x < y);
+}
+
+
+
+static void format_time(char *buffer, size_t size, time_t t)
+{
+	struct tm tm;
+
+	if (t == 0) {
+		snprintf(buffer, size, "never");
+		return;
+	}
+	gmtime_r(&t, &tm);
+	strftime(buffer, size, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
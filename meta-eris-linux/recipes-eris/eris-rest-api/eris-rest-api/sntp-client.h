@@ -0,0 +1,22 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef SNTP_CLIENT_H
+#define SNTP_CLIENT_H
+
+	#include <stddef.h>
+
+	// The servers are read from the ntp_server parameter (names or
+	// addresses separated by commas) at each poll.
+	int  start_sntp_client(void);
+
+	// Poll at once, after a change of the parameters.
+	void wakeup_sntp_client(void);
+
+	int  get_sntp_status(char **string, size_t *size, size_t *pos);
+
+#endif
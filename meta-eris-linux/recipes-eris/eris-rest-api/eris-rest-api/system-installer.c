@@ -0,0 +1,1135 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Installation of a system image in one pass: the image is downloaded,
+// checked against its signature and decompressed as it arrives, and
+// written to the inactive system partition (A or B). Only a few blocks are
+// kept in memory: the download thread hands them to a writer thread, the
+// network and the storage working at the same time. A broken transfer is
+// resumed with a Range request, the check and the decompression going on
+// where they were.
+//
+// The image may also be uploaded through the API (upload_system_image()):
+// the blocks are then queued by the HTTP server instead of curl, which is
+// woken up through install_wakeup when the queue has room again.
+//
+// The image may be a block delta (see block-delta.h) against the running
+// system partition, mounted read-only: the blocks are then copied from it
+// or taken from the delta, and the digest of the rebuilt system is checked.
+//
+// The boot loader is switched to the new partition only once the whole
+// image has been written and its signature checked.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+#include <curl/curl.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include "block-delta.h"
+#include "exec-command.h"
+#include "system-installer.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define SYSTEM_UPDATE_STATUS_FILE  "/tmp/system-update-status"
+#define REBOOT_NEEDED_FLAG_FILE    "/tmp/reboot-is-needed"
+#define KERNEL_COMMAND_LINE        "/proc/cmdline"
+#define FW_SETENV                  "/usr/bin/fw_setenv"
+#define FW_SETENV_TIMEOUT_MS       30000
+
+#define INSTALL_BLOCK_SIZE         (64 * 1024)
+#define INSTALL_QUEUE_BLOCKS       4
+#define INSTALL_OUTPUT_SIZE        (128 * 1024)
+
+#define INSTALL_RETRIES            5
+#define INSTALL_RETRY_DELAY_S      2
+#define INSTALL_CONNECT_TIMEOUT_S  30
+#define INSTALL_LOW_SPEED_TIME_S   30
+
+#define SIGNATURE_MAX              1024
+#define INSTALL_URL_MAX            1024
+
+// Values of the status file, see get_update_status().
+#define STATUS_IN_PROGRESS         2
+#define STATUS_INSTALL_OK          3
+#define STATUS_INSTALL_FAILED      4
+
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	unsigned char  data[INSTALL_BLOCK_SIZE];
+	size_t         length;
+
+} install_block_t;
+
+
+typedef struct {
+
+	CURL                *handle;
+	EVP_MD_CTX          *verify;
+	int                  checked;       // Response code of the transfer checked.
+	unsigned long long   skip;          // Bytes sent again by a server ignoring the range.
+	install_block_t      block;         // Block being filled.
+
+	long long            rate_ms;
+	unsigned long long   rate_bytes;
+
+} download_t;
+
+
+typedef struct {
+
+	unsigned char  data[SIGNATURE_MAX];
+	size_t         length;
+
+} signature_t;
+
+
+// ---------------------- Private method declarations.
+
+static void     *install_thread         (void *arg);
+static void     *writer_thread          (void *arg);
+static int       load_signature         (signature_t *signature);
+static size_t    on_signature_data      (char *data, size_t size, size_t nmemb, void *arg);
+static int       download_image         (EVP_MD_CTX *verify);
+static int       receive_upload         (EVP_MD_CTX *verify);
+static size_t    on_image_data          (char *data, size_t size, size_t nmemb, void *arg);
+static int       find_partitions        (char *target, char *source, size_t size, int *target_number, int *current_number);
+static int       open_target            (const char *target);
+static int       emit_output            (const unsigned char *data, size_t length);
+static int       write_output           (const unsigned char *data, size_t length);
+static int       activate_partition     (int target, int current);
+static int       run_fw_setenv          (const char *name, int value);
+
+static int       push_block             (const install_block_t *block);
+static void      enqueue_block          (const install_block_t *block);
+static void      push_end               (void);
+static install_block_t *next_block      (void);
+static void      release_block          (void);
+static void      abort_queue            (void);
+
+static void      set_stage              (install_stage_t stage);
+static void      wake_uploader          (void);
+static void      set_error              (install_error_t cause, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void      set_writer_error       (install_error_t cause, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void      write_status_file      (int status);
+static long long monotonic_ms           (void);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t     install_mutex = PTHREAD_MUTEX_INITIALIZER;
+static install_progress_t  progress;
+static char                image_url[INSTALL_URL_MAX];
+static char                sig_url[INSTALL_URL_MAX];
+
+static pthread_mutex_t     queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t      queue_cond  = PTHREAD_COND_INITIALIZER;
+static install_block_t     queue[INSTALL_QUEUE_BLOCKS];
+static int                 queue_first;
+static int                 queue_count;
+static int                 queue_end;
+static int                 queue_aborted;
+
+static int                 target_fd = -1;
+static unsigned long long  target_size;
+static char                writer_error[128];
+static install_error_t     writer_cause;
+
+static enum { PAYLOAD_UNKNOWN, PAYLOAD_IMAGE, PAYLOAD_DELTA } payload;
+static block_delta_t       delta;
+static char                source_path[sizeof(progress.partition)];
+static int                 source_fd = -1;
+
+// Upload of the image, protected by queue_mutex.
+static int                 uploading;
+static signature_t         upload_signature;
+static enum { UPLOAD_WAITING, UPLOAD_RECEIVING, UPLOAD_ENDED, UPLOAD_ABORTED } upload_state;
+static EVP_MD_CTX         *upload_verify;
+static install_block_t     upload_block;
+static void              (*install_wakeup)(void);
+
+
+// ---------------------- Public methods
+
+int start_system_install(const char *url, const char *signature_url)
+{
+	static int curl_ready = 0;
+	pthread_t thread;
+
+	if ((strlen(url) + 5 > INSTALL_URL_MAX)
+	 || ((signature_url != NULL) && (strlen(signature_url) >= INSTALL_URL_MAX))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&install_mutex);
+	if ((progress.stage != INSTALL_IDLE) && (progress.stage != INSTALL_DONE) && (progress.stage != INSTALL_FAILED)) {
+		pthread_mutex_unlock(&install_mutex);
+		errno = EBUSY;
+		return -1;
+	}
+	if (! curl_ready) {
+		curl_global_init(CURL_GLOBAL_DEFAULT);
+		curl_ready = 1;
+	}
+	pthread_mutex_lock(&queue_mutex);
+	uploading = 0;
+	pthread_mutex_unlock(&queue_mutex);
+	strcpy(image_url, url);
+	if (signature_url != NULL)
+		strcpy(sig_url, signature_url);
+	else
+		snprintf(sig_url, sizeof(sig_url), "%s.sig", url);
+	memset(&progress, 0, sizeof(progress));
+	progress.stage = INSTALL_SIGNATURE;
+	progress.eta_s = -1;
+	pthread_mutex_unlock(&install_mutex);
+
+	if (pthread_create(&thread, NULL, install_thread, NULL) != 0) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to start the installation.");
+		set_stage(INSTALL_FAILED);
+		return -1;
+	}
+	pthread_detach(thread);
+	return 0;
+}
+
+
+
+int start_system_upload(const unsigned char *signature, size_t length, unsigned long long total)
+{
+	pthread_t thread;
+
+	if ((length == 0) || (length > SIGNATURE_MAX)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&install_mutex);
+	if ((progress.stage != INSTALL_IDLE) && (progress.stage != INSTALL_DONE) && (progress.stage != INSTALL_FAILED)) {
+		pthread_mutex_unlock(&install_mutex);
+		errno = EBUSY;
+		return -1;
+	}
+	pthread_mutex_lock(&queue_mutex);
+	uploading = 1;
+	memcpy(upload_signature.data, signature, length);
+	upload_signature.length = length;
+	upload_state = UPLOAD_WAITING;
+	upload_block.length = 0;
+	pthread_mutex_unlock(&queue_mutex);
+	image_url[0] = '\0';
+	memset(&progress, 0, sizeof(progress));
+	progress.stage = INSTALL_SIGNATURE;
+	progress.total = total;
+	progress.eta_s = -1;
+	pthread_mutex_unlock(&install_mutex);
+
+	if (pthread_create(&thread, NULL, install_thread, NULL) != 0) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to start the installation.");
+		set_stage(INSTALL_FAILED);
+		return -1;
+	}
+	pthread_detach(thread);
+	return 0;
+}
+
+
+
+// Called by the HTTP server: the data is taken only if the queue has
+// room, the server keeps the rest and waits for install_wakeup.
+long upload_system_image(const unsigned char *data, size_t length)
+{
+	size_t done = 0;
+
+	pthread_mutex_lock(&queue_mutex);
+	if ((upload_state != UPLOAD_RECEIVING) || queue_aborted) {
+		int ready = (upload_state == UPLOAD_WAITING) && (! queue_aborted);
+		pthread_mutex_unlock(&queue_mutex);
+		return ready ? 0 : -1;
+	}
+	while (done < length) {
+		if (upload_block.length == INSTALL_BLOCK_SIZE) {
+			if (queue_count == INSTALL_QUEUE_BLOCKS)
+				break;
+			enqueue_block(&upload_block);
+			upload_block.length = 0;
+		}
+		size_t n = length - done;
+		if (n > INSTALL_BLOCK_SIZE - upload_block.length)
+			n = INSTALL_BLOCK_SIZE - upload_block.length;
+		memcpy(upload_block.data + upload_block.length, data + done, n);
+		upload_block.length += n;
+		done += n;
+	}
+	// The install thread frees the context once the upload has left the
+	// receiving state: the check stays under the lock.
+	EVP_DigestVerifyUpdate(upload_verify, data, done);
+	pthread_mutex_unlock(&queue_mutex);
+
+	pthread_mutex_lock(&install_mutex);
+	progress.downloaded += done;
+	pthread_mutex_unlock(&install_mutex);
+	return done;
+}
+
+
+
+int end_system_upload(int complete)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&queue_mutex);
+	if (! complete) {
+		if ((upload_state == UPLOAD_WAITING) || (upload_state == UPLOAD_RECEIVING))
+			upload_state = UPLOAD_ABORTED;
+	} else if ((upload_state != UPLOAD_RECEIVING) || queue_aborted) {
+		ret = ((upload_state == UPLOAD_WAITING) && (! queue_aborted)) ? 1 : -1;
+		if (upload_state == UPLOAD_ENDED)
+			ret = 0;
+	} else if (upload_block.length > 0) {
+		if (queue_count == INSTALL_QUEUE_BLOCKS) {
+			ret = 1;
+		} else {
+			enqueue_block(&upload_block);
+			upload_block.length = 0;
+		}
+	}
+	if (complete && (ret == 0) && (upload_state == UPLOAD_RECEIVING)) {
+		upload_state = UPLOAD_ENDED;
+		queue_end = 1;
+	}
+	pthread_cond_broadcast(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
+	return ret;
+}
+
+
+
+void set_install_wakeup(void (*wakeup)(void))
+{
+	pthread_mutex_lock(&queue_mutex);
+	install_wakeup = wakeup;
+	pthread_mutex_unlock(&queue_mutex);
+}
+
+
+
+void get_install_progress(install_progress_t *p)
+{
+	pthread_mutex_lock(&install_mutex);
+	*p = progress;
+	pthread_mutex_unlock(&install_mutex);
+}
+
+
+
+const char *install_stage_name(install_stage_t stage)
+{
+	switch (stage) {
+		case INSTALL_IDLE:      return "idle";
+		case INSTALL_SIGNATURE: return "signature";
+		case INSTALL_DOWNLOAD:  return "download";
+		case INSTALL_VERIFY:    return "verify";
+		case INSTALL_ACTIVATE:  return "activate";
+		case INSTALL_DONE:      return "done";
+		case INSTALL_FAILED:    return "failed";
+	}
+	return "unknown";
+}
+
+
+// ---------------------- Private methods
+
+static void *install_thread(void *arg)
+{
+	char target[sizeof(progress.partition)];
+	int target_number;
+	int current_number;
+	signature_t signature;
+	EVP_MD_CTX *verify = NULL;
+	EVP_PKEY *key = NULL;
+	pthread_t writer;
+	int writer_started = 0;
+
+	(void) arg;
+
+	write_status_file(STATUS_IN_PROGRESS);
+
+	FILE *fp = fopen(SYSTEM_PUBLIC_KEY_FILE, "r");
+	if (fp != NULL) {
+		key = PEM_read_PUBKEY(fp, NULL, NULL, NULL);
+		fclose(fp);
+	}
+	if (key == NULL) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to load the system public key.");
+		goto failed;
+	}
+	if (uploading)
+		signature = upload_signature;
+	else if (load_signature(&signature) != 0)
+		goto failed;
+
+	if (find_partitions(target, source_path, sizeof(target), &target_number, &current_number) != 0) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to find the inactive system partition.");
+		goto failed;
+	}
+	if (open_target(target) != 0) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to open %s.", target);
+		goto failed;
+	}
+	pthread_mutex_lock(&install_mutex);
+	strcpy(progress.partition, target);
+	pthread_mutex_unlock(&install_mutex);
+
+	verify = EVP_MD_CTX_new();
+	if ((verify == NULL) || (EVP_DigestVerifyInit(verify, NULL, EVP_sha256(), NULL, key) != 1)) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to initialize the signature check.");
+		goto failed;
+	}
+
+	queue_first = 0;
+	queue_count = 0;
+	queue_end = 0;
+	queue_aborted = 0;
+	writer_error[0] = '\0';
+	writer_cause = INSTALL_ERROR_DEVICE;
+	payload = PAYLOAD_UNKNOWN;
+	if (pthread_create(&writer, NULL, writer_thread, NULL) != 0) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to start the writer.");
+		goto failed;
+	}
+	writer_started = 1;
+
+	set_stage(INSTALL_DOWNLOAD);
+	int err = uploading ? receive_upload(verify) : download_image(verify);
+	if (err == 0)
+		push_end();
+	else
+		abort_queue();
+	pthread_join(writer, NULL);
+	writer_started = 0;
+	if (writer_error[0] != '\0') {
+		set_error(writer_cause, "%s", writer_error);
+		goto failed;
+	}
+	if (err != 0)
+		goto failed;
+
+	set_stage(INSTALL_VERIFY);
+	if (EVP_DigestVerifyFinal(verify, signature.data, signature.length) != 1) {
+		set_error(INSTALL_ERROR_IMAGE, "Invalid signature of the image.");
+		goto failed;
+	}
+
+	set_stage(INSTALL_ACTIVATE);
+	if (activate_partition(target_number, current_number) != 0) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to update the boot loader environment.");
+		goto failed;
+	}
+
+	close(target_fd);
+	target_fd = -1;
+	EVP_MD_CTX_free(verify);
+	EVP_PKEY_free(key);
+
+	fp = fopen(REBOOT_NEEDED_FLAG_FILE, "w");
+	if (fp != NULL)
+		fclose(fp);
+	write_status_file(STATUS_INSTALL_OK);
+	set_stage(INSTALL_DONE);
+	return NULL;
+
+failed:
+	pthread_mutex_lock(&queue_mutex);
+	if ((upload_state == UPLOAD_WAITING) || (upload_state == UPLOAD_RECEIVING))
+		upload_state = UPLOAD_ABORTED;
+	pthread_mutex_unlock(&queue_mutex);
+	if (writer_started) {
+		abort_queue();
+		pthread_join(writer, NULL);
+	}
+	if (target_fd >= 0)
+		close(target_fd);
+	target_fd = -1;
+	if (verify != NULL)
+		EVP_MD_CTX_free(verify);
+	if (key != NULL)
+		EVP_PKEY_free(key);
+	write_status_file(STATUS_INSTALL_FAILED);
+	// Last: a new installation may start from now.
+	set_stage(INSTALL_FAILED);
+	return NULL;
+}
+
+
+
+// Decompress the blocks of the queue (the format is given by the first
+// bytes) and write them to the target partition.
+static void *writer_thread(void *arg)
+{
+	enum { FORMAT_UNKNOWN, FORMAT_RAW, FORMAT_GZIP, FORMAT_ZSTD } format = FORMAT_UNKNOWN;
+	z_stream gzip;
+	ZSTD_DCtx *zstd = NULL;
+	size_t zstd_ret = 0;
+	int gzip_ret = Z_OK;
+	install_block_t *block;
+
+	(void) arg;
+
+	unsigned char *output = malloc(INSTALL_OUTPUT_SIZE);
+	if (output == NULL) {
+		set_writer_error(INSTALL_ERROR_DEVICE, "Not enough memory.");
+		abort_queue();
+		return NULL;
+	}
+	memset(&gzip, 0, sizeof(gzip));
+
+	while ((block = next_block()) != NULL) {
+		const unsigned char *data = block->data;
+		int err = 0;
+
+		if (format == FORMAT_UNKNOWN) {
+			if ((block->length >= 4) && (data[0] == 0x28) && (data[1] == 0xB5) && (data[2] == 0x2F) && (data[3] == 0xFD)) {
+				format = FORMAT_ZSTD;
+				zstd = ZSTD_createDCtx();
+				err = (zstd == NULL);
+			} else if ((block->length >= 2) && (data[0] == 0x1F) && (data[1] == 0x8B)) {
+				format = FORMAT_GZIP;
+				err = (inflateInit2(&gzip, 16 + MAX_WBITS) != Z_OK);
+			} else {
+				format = FORMAT_RAW;
+			}
+		}
+
+		if (err) {
+			set_writer_error(INSTALL_ERROR_DEVICE, "Unable to initialize the decompression.");
+		} else if (format == FORMAT_RAW) {
+			err = emit_output(data, block->length);
+		} else if (format == FORMAT_GZIP) {
+			gzip.next_in = (unsigned char *) data;
+			gzip.avail_in = block->length;
+			while ((! err) && (gzip.avail_in > 0) && (gzip_ret != Z_STREAM_END)) {
+				gzip.next_out = output;
+				gzip.avail_out = INSTALL_OUTPUT_SIZE;
+				gzip_ret = inflate(&gzip, Z_NO_FLUSH);
+				if ((gzip_ret != Z_OK) && (gzip_ret != Z_STREAM_END)) {
+					set_writer_error(INSTALL_ERROR_IMAGE, "Corrupted image (gzip).");
+					err = 1;
+				} else {
+					err = emit_output(output, INSTALL_OUTPUT_SIZE - gzip.avail_out);
+				}
+			}
+		} else {
+			ZSTD_inBuffer in = { data, block->length, 0 };
+			while ((! err) && (in.pos < in.size)) {
+				ZSTD_outBuffer out = { output, INSTALL_OUTPUT_SIZE, 0 };
+				zstd_ret = ZSTD_decompressStream(zstd, &out, &in);
+				if (ZSTD_isError(zstd_ret)) {
+					set_writer_error(INSTALL_ERROR_IMAGE, "Corrupted image (%s).", ZSTD_getErrorName(zstd_ret));
+					err = 1;
+				} else {
+					err = emit_output(output, out.pos);
+				}
+			}
+		}
+		release_block();
+		if (err) {
+			abort_queue();
+			break;
+		}
+	}
+
+	// End of the image: the decompression must have ended too.
+	if ((block == NULL) && (! queue_aborted)) {
+		if (((format == FORMAT_GZIP) && (gzip_ret != Z_STREAM_END))
+		 || ((format == FORMAT_ZSTD) && (zstd_ret != 0)))
+			set_writer_error(INSTALL_ERROR_IMAGE, "Truncated image.");
+		else if (format == FORMAT_UNKNOWN)
+			set_writer_error(INSTALL_ERROR_IMAGE, "Empty image.");
+		else if ((payload == PAYLOAD_DELTA) && (block_delta_finish(&delta) != 0))
+			set_writer_error(INSTALL_ERROR_IMAGE, "%s", delta.error);
+		else if (fsync(target_fd) != 0)
+			set_writer_error((errno == ENOSPC) ? INSTALL_ERROR_SPACE : INSTALL_ERROR_DEVICE, "Unable to write the partition.");
+	}
+
+	if (payload == PAYLOAD_DELTA)
+		block_delta_release(&delta);
+	if (source_fd >= 0)
+		close(source_fd);
+	source_fd = -1;
+
+	if (format == FORMAT_GZIP)
+		inflateEnd(&gzip);
+	if (zstd != NULL)
+		ZSTD_freeDCtx(zstd);
+	free(output);
+	return NULL;
+}
+
+
+
+static int load_signature(signature_t *signature)
+{
+	CURL *handle = curl_easy_init();
+	if (handle == NULL) {
+		set_error(INSTALL_ERROR_DEVICE, "Unable to initialize the download.");
+		return -1;
+	}
+	signature->length = 0;
+	curl_easy_setopt(handle, CURLOPT_URL, sig_url);
+	curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+	curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, (long) INSTALL_CONNECT_TIMEOUT_S);
+	curl_easy_setopt(handle, CURLOPT_TIMEOUT, (long) INSTALL_LOW_SPEED_TIME_S);
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, on_signature_data);
+	curl_easy_setopt(handle, CURLOPT_WRITEDATA, signature);
+	CURLcode res = curl_easy_perform(handle);
+	curl_easy_cleanup(handle);
+
+	if ((res != CURLE_OK) || (signature->length == 0)) {
+		set_error(INSTALL_ERROR_IMAGE, "Unable to download the signature (%s).", curl_easy_strerror(res));
+		return -1;
+	}
+	return 0;
+}
+
+
+
+static size_t on_signature_data(char *data, size_t size, size_t nmemb, void *arg)
+{
+	signature_t *signature = arg;
+	size_t length = size * nmemb;
+
+	if (signature->length + length > sizeof(signature->data))
+		return 0;
+	memcpy(signature->data + signature->length, data, length);
+	signature->length += length;
+	return length;
+}
+
+
+
+// The transfers broken without progress are retried a few times, the
+// others are resumed at once.
+static int download_image(EVP_MD_CTX *verify)
+{
+	download_t *dl = calloc(1, sizeof(download_t));
+	if (dl == NULL) {
+		set_error(INSTALL_ERROR_DEVICE, "Not enough memory.");
+		return -1;
+	}
+	dl->handle = curl_easy_init();
+	if (dl->handle == NULL) {
+		free(dl);
+		set_error(INSTALL_ERROR_DEVICE, "Unable to initialize the download.");
+		return -1;
+	}
+	dl->verify = verify;
+	dl->rate_ms = monotonic_ms();
+
+	curl_easy_setopt(dl->handle, CURLOPT_URL, image_url);
+	curl_easy_setopt(dl->handle, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(dl->handle, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(dl->handle, CURLOPT_FAILONERROR, 1L);
+	curl_easy_setopt(dl->handle, CURLOPT_CONNECTTIMEOUT, (long) INSTALL_CONNECT_TIMEOUT_S);
+	curl_easy_setopt(dl->handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+	curl_easy_setopt(dl->handle, CURLOPT_LOW_SPEED_TIME, (long) INSTALL_LOW_SPEED_TIME_S);
+	curl_easy_setopt(dl->handle, CURLOPT_WRITEFUNCTION, on_image_data);
+	curl_easy_setopt(dl->handle, CURLOPT_WRITEDATA, dl);
+
+	int err = 0;
+	int failures = 0;
+	for (;;) {
+		install_progress_t p;
+		get_install_progress(&p);
+		unsigned long long offset = p.downloaded;
+
+		// CURLOPT_RANGE rather than CURLOPT_RESUME_FROM: the servers
+		// ignoring the range are handled by on_image_data().
+		char range[32];
+		snprintf(range, sizeof(range), "%llu-", offset);
+		dl->checked = 0;
+		dl->skip = 0;
+		curl_easy_setopt(dl->handle, CURLOPT_RANGE, (offset > 0) ? range : NULL);
+		CURLcode res = curl_easy_perform(dl->handle);
+		if (res == CURLE_OK)
+			break;
+
+		get_install_progress(&p);
+		failures = (p.downloaded > offset) ? 1 : failures + 1;
+		if (queue_aborted || (res == CURLE_HTTP_RETURNED_ERROR) || (res == CURLE_WRITE_ERROR)
+		 || (failures > INSTALL_RETRIES)) {
+			if (! queue_aborted)
+				set_error(INSTALL_ERROR_IMAGE, "Unable to download the image (%s).", curl_easy_strerror(res));
+			err = -1;
+			break;
+		}
+		sleep(INSTALL_RETRY_DELAY_S * (failures - 1));
+		pthread_mutex_lock(&install_mutex);
+		progress.resumes++;
+		pthread_mutex_unlock(&install_mutex);
+	}
+
+	if ((err == 0) && (dl->block.length > 0) && (push_block(&(dl->block)) != 0))
+		err = -1;
+
+	curl_easy_cleanup(dl->handle);
+	free(dl);
+	return err;
+}
+
+
+
+static size_t on_image_data(char *data, size_t size, size_t nmemb, void *arg)
+{
+	download_t *dl = arg;
+	size_t length = size * nmemb;
+
+	if (! dl->checked) {
+		long code = 0;
+		curl_off_t content_length = -1;
+		curl_easy_getinfo(dl->handle, CURLINFO_RESPONSE_CODE, &code);
+		curl_easy_getinfo(dl->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+		pthread_mutex_lock(&install_mutex);
+		if (code == 200) {
+			// The range was ignored: the image is sent from its beginning.
+			dl->skip = progress.downloaded;
+			if (content_length > 0)
+				progress.total = content_length;
+		} else if (code == 206) {
+			if (content_length > 0)
+				progress.total = progress.downloaded + content_length;
+		} else {
+			pthread_mutex_unlock(&install_mutex);
+			return 0;
+		}
+		pthread_mutex_unlock(&install_mutex);
+		dl->checked = 1;
+	}
+
+	size_t done = 0;
+	if (dl->skip > 0) {
+		done = (dl->skip < length) ? dl->skip : length;
+		dl->skip -= done;
+	}
+	if (done < length)
+		EVP_DigestVerifyUpdate(dl->verify, data + done, length - done);
+	size_t received = length - done;
+
+	while (done < length) {
+		size_t n = length - done;
+		if (n > INSTALL_BLOCK_SIZE - dl->block.length)
+			n = INSTALL_BLOCK_SIZE - dl->block.length;
+		memcpy(dl->block.data + dl->block.length, data + done, n);
+		dl->block.length += n;
+		done += n;
+		if (dl->block.length == INSTALL_BLOCK_SIZE) {
+			if (push_block(&(dl->block)) != 0)
+				return 0;
+			dl->block.length = 0;
+		}
+	}
+
+	long long now = monotonic_ms();
+	pthread_mutex_lock(&install_mutex);
+	progress.downloaded += received;
+	dl->rate_bytes += received;
+	if (now - dl->rate_ms >= 1000) {
+		double rate = dl->rate_bytes * 1000.0 / (now - dl->rate_ms);
+		progress.rate = (progress.rate > 0) ? (0.7 * progress.rate + 0.3 * rate) : rate;
+		dl->rate_ms = now;
+		dl->rate_bytes = 0;
+	}
+	if ((progress.total > progress.downloaded) && (progress.rate > 0))
+		progress.eta_s = (progress.total - progress.downloaded) / progress.rate;
+	else
+		progress.eta_s = (progress.total > 0) ? 0 : -1;
+	pthread_mutex_unlock(&install_mutex);
+
+	return length;
+}
+
+
+
+// The blocks are queued by upload_system_image() until end_system_upload().
+static int receive_upload(EVP_MD_CTX *verify)
+{
+	pthread_mutex_lock(&queue_mutex);
+	if (upload_state == UPLOAD_WAITING) {
+		upload_verify = verify;
+		upload_state = UPLOAD_RECEIVING;
+	}
+	pthread_mutex_unlock(&queue_mutex);
+	wake_uploader();
+
+	pthread_mutex_lock(&queue_mutex);
+	while ((upload_state == UPLOAD_RECEIVING) && (! queue_aborted))
+		pthread_cond_wait(&queue_cond, &queue_mutex);
+	int ended = (upload_state == UPLOAD_ENDED);
+	if (! ended)
+		upload_state = UPLOAD_ABORTED;
+	upload_verify = NULL;
+	int aborted = queue_aborted;
+	pthread_mutex_unlock(&queue_mutex);
+
+	if (ended)
+		return 0;
+	if (! aborted)
+		set_error(INSTALL_ERROR_IMAGE, "The upload of the image was interrupted.");
+	return -1;
+}
+
+
+
+// The running system is given by the root= of the kernel command line.
+// From the recovery partition, the system A is installed. The source is
+// empty if the running partition is unknown.
+static int find_partitions(char *target, char *source, size_t size, int *target_number, int *current_number)
+{
+	char line[256];
+	char device[128] = "";
+	char separator[16] = "";
+	int system_a = -1;
+	int system_b = -1;
+
+	FILE *fp = fopen(SYSTEM_PARTITIONS_FILE, "r");
+	if (fp == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (strncmp(line, "ERIS_STORAGE_DEVICE=", 20) == 0)
+			snprintf(device, sizeof(device), "%s", line + 20);
+		else if (strncmp(line, "ERIS_PARTITION_SEPARATOR=", 25) == 0)
+			snprintf(separator, sizeof(separator), "%s", line + 25);
+		else if (strncmp(line, "ERIS_PARTITION_SYSTEM_A=", 24) == 0)
+			system_a = atoi(line + 24);
+		else if (strncmp(line, "ERIS_PARTITION_SYSTEM_B=", 24) == 0)
+			system_b = atoi(line + 24);
+	}
+	fclose(fp);
+	if ((device[0] == '\0') || (system_a <= 0) || (system_b <= 0))
+		return -1;
+
+	*current_number = -1;
+	fp = fopen(KERNEL_COMMAND_LINE, "r");
+	if (fp != NULL) {
+		if (fgets(line, sizeof(line), fp) != NULL) {
+			char *root = strstr(line, "root=");
+			if (root != NULL) {
+				root[strcspn(root, " \n")] = '\0';
+				size_t length = strlen(root);
+				while ((length > 0) && (root[length - 1] >= '0') && (root[length - 1] <= '9'))
+					length--;
+				if (root[length] != '\0')
+					*current_number = atoi(root + length);
+			}
+		}
+		fclose(fp);
+	}
+
+	*target_number = (*current_number == system_a) ? system_b : system_a;
+	snprintf(target, size, "%s%s%d", device, separator, *target_number);
+	source[0] = '\0';
+	if (*current_number > 0)
+		snprintf(source, size, "%s%s%d", device, separator, *current_number);
+	return 0;
+}
+
+
+
+static int open_target(const char *target)
+{
+	struct stat st;
+	uint64_t size = 0;
+
+	target_fd = open(target, O_WRONLY | O_CLOEXEC);
+	if (target_fd < 0)
+		return -1;
+	if (ioctl(target_fd, BLKGETSIZE64, &size) != 0) {
+		// Not a block device: no size limit.
+		size = 0;
+		if ((fstat(target_fd, &st) == 0) && S_ISREG(st.st_mode) && (ftruncate(target_fd, 0) != 0))
+			return -1;
+	}
+	target_size = size;
+	return 0;
+}
+
+
+
+// Decompressed payload: a full image, or a block delta.
+static int emit_output(const unsigned char *data, size_t length)
+{
+	if (length == 0)
+		return 0;
+
+	if (payload == PAYLOAD_UNKNOWN) {
+		if (! is_block_delta(data, length)) {
+			payload = PAYLOAD_IMAGE;
+		} else {
+			if ((source_path[0] == '\0') || ((source_fd = open(source_path, O_RDONLY | O_CLOEXEC)) < 0)) {
+				set_writer_error(INSTALL_ERROR_DEVICE, "Unable to open the running system partition.");
+				return -1;
+			}
+			payload = PAYLOAD_DELTA;
+			if (block_delta_init(&delta, source_fd, write_output) != 0) {
+				set_writer_error(INSTALL_ERROR_IMAGE, "%s", delta.error);
+				return -1;
+			}
+			pthread_mutex_lock(&install_mutex);
+			progress.delta = 1;
+			pthread_mutex_unlock(&install_mutex);
+		}
+	}
+
+	if (payload == PAYLOAD_IMAGE)
+		return write_output(data, length);
+
+	if (block_delta_feed(&delta, data, length) != 0) {
+		// The errors of write_output() come first.
+		if (writer_error[0] == '\0')
+			set_writer_error(INSTALL_ERROR_IMAGE, "%s", delta.error);
+		return -1;
+	}
+	return 0;
+}
+
+
+
+static int write_output(const unsigned char *data, size_t length)
+{
+	install_progress_t p;
+
+	if (length == 0)
+		return 0;
+
+	get_install_progress(&p);
+	if ((target_size > 0) && (p.written + length > target_size)) {
+		set_writer_error(INSTALL_ERROR_SPACE, "The image is larger than the partition.");
+		return -1;
+	}
+	size_t done = 0;
+	while (done < length) {
+		ssize_t n = write(target_fd, data + done, length - done);
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0) {
+			set_writer_error((errno == ENOSPC) ? INSTALL_ERROR_SPACE : INSTALL_ERROR_DEVICE, "Unable to write the partition (%s).", strerror(errno));
+			return -1;
+		}
+		done += n;
+	}
+
+	pthread_mutex_lock(&install_mutex);
+	progress.written += length;
+	pthread_mutex_unlock(&install_mutex);
+	return 0;
+}
+
+
+
+// Next boots: the new system, then the current one. The boot script
+// shifts these variables at each boot, rollback=1 marking the first boot
+// after an update.
+static int activate_partition(int target, int current)
+{
+	if (run_fw_setenv("boot_next_1", target) != 0)
+		return -1;
+	if ((current > 0) && (run_fw_setenv("boot_next_2", current) != 0))
+		return -1;
+	return run_fw_setenv("rollback", 1);
+}
+
+
+
+static int run_fw_setenv(const char *name, int value)
+{
+	char number[16];
+	exec_result_t result;
+
+	snprintf(number, sizeof(number), "%d", value);
+	const char *argv[] = { FW_SETENV, name, number, NULL };
+	int err = run_command(argv, NULL, FW_SETENV_TIMEOUT_MS, 0, -1, &result);
+	free_command_result(&result);
+	return err;
+}
+
+
+
+// Queue of the blocks between the download and the writer. The download
+// waits for a free block: the memory doesn't depend on the network rate.
+static int push_block(const install_block_t *block)
+{
+	pthread_mutex_lock(&queue_mutex);
+	while ((queue_count == INSTALL_QUEUE_BLOCKS) && (! queue_aborted))
+		pthread_cond_wait(&queue_cond, &queue_mutex);
+	if (queue_aborted) {
+		pthread_mutex_unlock(&queue_mutex);
+		return -1;
+	}
+	enqueue_block(block);
+	pthread_mutex_unlock(&queue_mutex);
+	return 0;
+}
+
+
+
+// Called with the queue locked and a free slot.
+static void enqueue_block(const install_block_t *block)
+{
+	install_block_t *slot = &(queue[(queue_first + queue_count) % INSTALL_QUEUE_BLOCKS]);
+	memcpy(slot->data, block->data, block->length);
+	slot->length = block->length;
+	queue_count++;
+	pthread_cond_broadcast(&queue_cond);
+}
+
+
+
+static void push_end(void)
+{
+	pthread_mutex_lock(&queue_mutex);
+	queue_end = 1;
+	pthread_cond_broadcast(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
+}
+
+
+
+// NULL at the end of the image or if the installation is aborted. The
+// block stays in the queue until release_block().
+static install_block_t *next_block(void)
+{
+	install_block_t *block = NULL;
+
+	pthread_mutex_lock(&queue_mutex);
+	while ((queue_count == 0) && (! queue_end) && (! queue_aborted))
+		pthread_cond_wait(&queue_cond, &queue_mutex);
+	if ((queue_count > 0) && (! queue_aborted))
+		block = &(queue[queue_first]);
+	pthread_mutex_unlock(&queue_mutex);
+	return block;
+}
+
+
+
+static void release_block(void)
+{
+	pthread_mutex_lock(&queue_mutex);
+	queue_first = (queue_first + 1) % INSTALL_QUEUE_BLOCKS;
+	queue_count--;
+	pthread_cond_broadcast(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
+	wake_uploader();
+}
+
+
+
+static void abort_queue(void)
+{
+	pthread_mutex_lock(&queue_mutex);
+	queue_aborted = 1;
+	pthread_cond_broadcast(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
+	wake_uploader();
+}
+
+
+
+static void set_stage(install_stage_t stage)
+{
+	pthread_mutex_lock(&install_mutex);
+	progress.stage = stage;
+	pthread_mutex_unlock(&install_mutex);
+	wake_uploader();
+}
+
+
+
+static void wake_uploader(void)
+{
+	void (*wakeup)(void);
+
+	pthread_mutex_lock(&queue_mutex);
+	wakeup = uploading ? install_wakeup : NULL;
+	pthread_mutex_unlock(&queue_mutex);
+	if (wakeup != NULL)
+		wakeup();
+}
+
+
+
+static void set_error(install_error_t cause, const char *format, ...)
+{
+	va_list args;
+
+	pthread_mutex_lock(&install_mutex);
+	va_start(args, format);
+	vsnprintf(progress.error, sizeof(progress.error), format, args);
+	va_end(args);
+	progress.cause = cause;
+	progress.eta_s = -1;
+	pthread_mutex_unlock(&install_mutex);
+}
+
+
+
+// Called by the writer thread, copied by set_error() once it has ended.
+static void set_writer_error(install_error_t cause, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(writer_error, sizeof(writer_error), format, args);
+	va_end(args);
+	writer_cause = cause;
+}
+
+
+
+static void write_status_file(int status)
+{
+	FILE *fp = fopen(SYSTEM_UPDATE_STATUS_FILE, "w");
+	if (fp == NULL)
+		return;
+	fprintf(fp, "%d\n", status);
+	fclose(fp);
+}
+
+
+
+static long long monotonic_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
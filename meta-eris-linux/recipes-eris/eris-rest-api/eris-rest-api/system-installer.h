@@ -0,0 +1,72 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef SYSTEM_INSTALLER_H
+#define SYSTEM_INSTALLER_H
+
+	#define SYSTEM_PUBLIC_KEY_FILE   "/usr/share/eris-linux/system-public-key.pem"
+	#define SYSTEM_PARTITIONS_FILE   "/usr/share/eris-linux/partitions"
+
+	typedef enum {
+
+		INSTALL_IDLE = 0,
+		INSTALL_SIGNATURE,      // Download of the signature.
+		INSTALL_DOWNLOAD,       // Download, check, decompression and write.
+		INSTALL_VERIFY,         // End of the signature check.
+		INSTALL_ACTIVATE,       // Boot loader environment.
+		INSTALL_DONE,
+		INSTALL_FAILED,
+
+	} install_stage_t;
+
+	typedef enum {
+
+		INSTALL_ERROR_DEVICE = 0,   // Failure of the device (storage, boot loader...).
+		INSTALL_ERROR_IMAGE,        // The image or its signature was rejected.
+		INSTALL_ERROR_SPACE,        // The image doesn't fit on the partition.
+
+	} install_error_t;
+
+	typedef struct {
+
+		install_stage_t     stage;
+		char                partition[64];    // Inactive system partition.
+		int                 delta;            // The image is a block delta.
+		unsigned long long  downloaded;       // Bytes of the image received.
+		unsigned long long  total;            // 0 if unknown.
+		unsigned long long  written;          // Bytes written to the partition.
+		double              rate;             // Bytes per second.
+		long                eta_s;            // -1 if unknown.
+		int                 resumes;          // Transfers resumed with a Range request.
+		char                error[128];
+		install_error_t     cause;            // Of the error.
+
+	} install_progress_t;
+
+	// Install the image at the URL (http or https, raw or compressed with
+	// gzip or zstd) on the inactive system partition, in a thread. The
+	// signature of the image defaults to <url>.sig. Return -1 with errno
+	// EBUSY if an installation is in progress.
+	int start_system_install(const char *url, const char *signature_url);
+
+	// Install an image uploaded through the API, with the same checks. The
+	// total size is 0 if unknown.
+	int  start_system_upload(const unsigned char *signature, size_t length, unsigned long long total);
+	// Return the number of bytes taken, 0 if the installation isn't ready
+	// for more data (wait for the wakeup), -1 if it failed.
+	long upload_system_image(const unsigned char *data, size_t length);
+	// End of the upload (complete) or interruption. Return 1 if the end
+	// must be given again after the wakeup, -1 if the installation failed.
+	int  end_system_upload(int complete);
+	// Called by the installer threads when the upload may go on.
+	void set_install_wakeup(void (*wakeup)(void));
+
+	void get_install_progress(install_progress_t *progress);
+
+	const char *install_stage_name(install_stage_t stage);
+
+#endif
@@ -11,7 +11,14 @@
 #include <uuid/uuid.h>
 
 #include "addsnprintf.h"
+#include "container-cgroup.h"
+#include "container-logs.h"
+#include "container-stats.h"
+#include "container-table.h"
+#include "docker-client.h"
 #include "eris-rest-api.h"
+#include "exec-job.h"
+#include "fast-shutdown.h"
 #include "system-rest-api.h"
 
 
@@ -23,11 +30,14 @@
 #define SYSTEM_MODEL_TYPE       "/usr/share/eris-linux/system-type"
 #define SYSTEM_VERSION_FILE     "/usr/share/eris-linux/system-version"
 #define SYSTEM_UUID_PREFIX      "machine_uuid="
-#define SYSTEM_CONTAINERS_FILE  "/etc/eris-linux/containers"
+#define CONTAINER_TIMELINE_FILE "/run/eris-linux/container-timeline"
 
 #define MAX_CONTAINERS  4
 #define CONTAINER_LINE  1024
 
+#define DOCKER_PS_TIMEOUT_MS   5000
+#define DOCKER_PS_OUTPUT_LIMIT (64 * 1024)
+
 // ---------------------- Private method declarations.
 
 static int init_system_uuid(const char *app);
@@ -40,7 +50,18 @@ static enum MHD_Result get_system_slots       (struct MHD_Connection *connection
 static enum MHD_Result get_container_name     (struct MHD_Connection *connection);
 static enum MHD_Result get_container_presence (struct MHD_Connection *connection);
 static enum MHD_Result get_container_status   (struct MHD_Connection *connection);
+static enum MHD_Result reply_container_status (struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static enum MHD_Result get_container_state    (struct MHD_Connection *connection);
 static enum MHD_Result get_container_version  (struct MHD_Connection *connection);
+static enum MHD_Result get_container_list     (struct MHD_Connection *connection);
+static enum MHD_Result get_boot_timeline      (struct MHD_Connection *connection);
+static enum MHD_Result get_container_timeline (struct MHD_Connection *connection);
+static enum MHD_Result send_timeline          (struct MHD_Connection *connection, const char *path);
+static enum MHD_Result get_container_resources(struct MHD_Connection *connection);
+static enum MHD_Result get_container_stats    (struct MHD_Connection *connection);
+static enum MHD_Result get_container_logs     (struct MHD_Connection *connection);
+
+static const char *container_slot_error(const container_slot_t *entry, int need_fields);
 
 //static enum MHD_Result put_system_reset      (struct MHD_Connection *connection);
 
@@ -54,6 +75,20 @@ int init_system_rest_api(const char *app)
 	if (init_system_uuid(app) != 0)
 		return -1;
 
+	report_last_shutdown();
+
+	if (start_container_table() != 0)
+		fprintf(stderr, "%s: unable to watch the containers description.\n", app);
+
+	if (start_docker_client() != 0)
+		fprintf(stderr, "%s: unable to start the docker client.\n", app);
+
+	if (start_container_stats() != 0)
+		fprintf(stderr, "%s: unable to start the containers sampler.\n", app);
+
+	if (start_container_logs() != 0)
+		fprintf(stderr, "%s: unable to watch the containers logs.\n", app);
+
 	return 0;
 }
 
@@ -67,6 +102,8 @@ enum MHD_Result system_rest_api(struct MHD_Connection *connection, const char *u
 		return get_system_type(connection);
 	if ((strcasecmp(url, "/api/system/uuid") == 0) && (strcmp(method, "GET") == 0))
 		return get_system_uuid(connection);
+	if ((strcasecmp(url, "/api/system/boot-timeline") == 0) && (strcmp(method, "GET") == 0))
+		return get_boot_timeline(connection);
 	if ((strcasecmp(url, "/api/system/version") == 0) && (strcmp(method, "GET") == 0))
 		return get_system_version(connection);
 	if ((strcasecmp(url, "/api/container/count") == 0) && (strcmp(method, "GET") == 0))
@@ -77,8 +114,20 @@ enum MHD_Result system_rest_api(struct MHD_Connection *connection, const char *u
 		return get_container_presence(connection);
 	if ((strcasecmp(url, "/api/container/status") == 0) && (strcmp(method, "GET") == 0))
 		return get_container_status(connection);
+	if ((strcasecmp(url, "/api/container/state") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_state(connection);
 	if ((strcasecmp(url, "/api/container/version") == 0) && (strcmp(method, "GET") == 0))
 		return get_container_version(connection);
+	if ((strcasecmp(url, "/api/container/list") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_list(connection);
+	if ((strcasecmp(url, "/api/container/timeline") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_timeline(connection);
+	if ((strcasecmp(url, "/api/container/resources") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_resources(connection);
+	if ((strcasecmp(url, "/api/container/stats") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_stats(connection);
+	if ((strcasecmp(url, "/api/container/logs") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_logs(connection);
 
 	return MHD_NO;
 }
@@ -221,7 +270,7 @@ static enum MHD_Result get_container_name(struct MHD_Connection *connection)
 {
 	int cnt;
 	char line[CONTAINER_LINE];
-	FILE *fp;
+	container_slot_t entry;
 
 	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
 	if (container_num == NULL)
@@ -235,40 +284,13 @@ static enum MHD_Result get_container_name(struct MHD_Connection *connection)
 		line[CONTAINER_LINE - 1] = '\0';
 		return send_rest_error(connection, line, 400);
 	}
-	
-	fp = fopen(SYSTEM_CONTAINERS_FILE, "r");
-	if (fp == NULL)
-		return send_rest_error(connection, "Unable to open containers description.", 500);
-
-	int c;
-	for (c = 0; c <= cnt; c++)
-		if (fgets(line, CONTAINER_LINE - 1, fp) == NULL)
-			break;
-	fclose(fp);
-	if (c != cnt + 1)
-		return send_rest_error(connection, "Containers description is incomplete.", 500);
 
-	if (((line[0] == '-') && (line[1] == '1')) || (line[0] == '\0'))
-		return send_rest_response(connection, "");
+	get_container_slot(cnt, &entry);
+	const char *error = container_slot_error(&entry, 1);
+	if (error != NULL)
+		return send_rest_error(connection, error, 500);
 
-	if (line[strlen(line) - 1] == '\n')
-			line[strlen(line) - 1] = '\0';
-	int i;
-	for (i = 0; (i < CONTAINER_LINE - 1) && (line[i] != '!'); i++)
-		// container id
-		;
-	if ((i == CONTAINER_LINE - 1) || (line[i] !='!'))
-		return send_rest_error(connection, "Containers description is inconsistant.", 500);
-
-	int start = i + 1;
-	for (i ++; (i < CONTAINER_LINE - 1) && (line[i] != '!'); i++)
-		// container name
-		;
-	if ((i == CONTAINER_LINE - 1) || (line[i] !='!'))
-	        return send_rest_error(connection, "Containers description is inconsistant.", 500);
-	line[i] = '\0';
-
-	return send_rest_response(connection, &(line[start]));
+	return send_rest_response(connection, entry.present ? entry.name : "");
 }
 
 
@@ -277,7 +299,7 @@ static enum MHD_Result get_container_presence(struct MHD_Connection *connection)
 {
 	int cnt;
 	char line[CONTAINER_LINE];
-	FILE *fp;
+	container_slot_t entry;
 
 	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
 	if (container_num == NULL)
@@ -291,21 +313,13 @@ static enum MHD_Result get_container_presence(struct MHD_Connection *connection)
 		line[CONTAINER_LINE - 1] = '\0';
 		return send_rest_error(connection, line, 400);
 	}
-	fp = fopen(SYSTEM_CONTAINERS_FILE, "r");
-	if (fp == NULL)
-		return send_rest_error(connection, "Unable to open containers description.", 500);
 
-	int c;
-	for (c = 0; c <= cnt; c++)
-		if (fgets(line, CONTAINER_LINE - 1, fp) == NULL)
-			break;
-	fclose(fp);
-	if (c != cnt + 1)
-		return send_rest_error(connection, "Containers description is incomplete.", 500);
-	
-	if (((line[0] == '-') && (line[1] == '1')) || (line[0] == '\0'))
-		return send_rest_response(connection, "absent");
-	return send_rest_response(connection, "present");
+	get_container_slot(cnt, &entry);
+	const char *error = container_slot_error(&entry, 0);
+	if (error != NULL)
+		return send_rest_error(connection, error, 500);
+
+	return send_rest_response(connection, entry.present ? "present" : "absent");
 }
 
 
@@ -314,8 +328,6 @@ static enum MHD_Result get_container_status(struct MHD_Connection *connection)
 {
 	int cnt;
 	char line[CONTAINER_LINE];
-	FILE *fp;
-	int found = 0;
 	char slotname[16];
 
 	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
@@ -331,20 +343,68 @@ static enum MHD_Result get_container_status(struct MHD_Connection *connection)
 		return send_rest_error(connection, line, 400);
 	}
 
+	// Answered from the table fed by the docker events, docker ps is the fallback.
+	container_state_t state;
+	if (get_docker_slot_state(cnt, &state) == 0)
+		return send_rest_response(connection, state.running ? "running" : "stopped");
+
 	snprintf(slotname, 15, "slot-%d", cnt + 1);
 
-	fp = popen("docker ps", "r");
-	if (fp == NULL)
+	const char *argv[] = { "docker", "ps", NULL };
+
+	return run_command_async(connection, argv, NULL, DOCKER_PS_TIMEOUT_MS, DOCKER_PS_OUTPUT_LIMIT, reply_container_status, strdup(slotname), free);
+}
+
+
+
+static enum MHD_Result reply_container_status(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	const char *slotname = arg;
+
+	if ((result->exit_status != 0) || (slotname == NULL))
 		return send_rest_error(connection, "Unable to communicate with docker.", 500);
-	while (fgets(line, CONTAINER_LINE - 1, fp) != NULL) {
-		if (strstr(line, slotname) != NULL) {
-			found = 1;
-			break;
-		}
+
+	return send_rest_response(connection, strstr(result->output, slotname) != NULL ? "running" : "stopped");
+}
+
+
+
+static enum MHD_Result get_container_state(struct MHD_Connection *connection)
+{
+	int cnt;
+	char line[CONTAINER_LINE];
+	container_state_t state;
+
+	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if (container_num == NULL)
+	        return send_rest_error(connection, "Missing container number.", 400);
+
+	if (sscanf(container_num, "%d", &cnt) != 1)
+	        return send_rest_error(connection, "Invalid container number.", 400);
+
+	if ((cnt < 0) || (cnt >= MAX_CONTAINERS)) {
+		snprintf(line, CONTAINER_LINE - 1, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
+		line[CONTAINER_LINE - 1] = '\0';
+		return send_rest_error(connection, line, 400);
 	}
-	fclose(fp);
 
-	return send_rest_response(connection, found ? "running" : "stopped");
+	if (get_docker_slot_state(cnt, &state) != 0)
+		return send_rest_error(connection, "Unable to communicate with docker.", 500);
+
+	if (! state.known) {
+		strcpy(state.status, "absent");
+		strcpy(state.health, "none");
+	}
+	long uptime = 0;
+	if (state.running && (state.started != 0))
+		uptime = (long) (time(NULL) - state.started);
+	if (uptime < 0)
+		uptime = 0;
+
+	snprintf(line, CONTAINER_LINE, "status=%s uptime=%ld restarts=%d exit_code=%d health=%s",
+	         state.status, uptime, state.restarts, state.exit_code, state.health);
+
+	return send_rest_response(connection, line);
 }
 
 
@@ -353,7 +413,7 @@ static enum MHD_Result get_container_version(struct MHD_Connection *connection)
 {
 	int cnt;
 	char line[CONTAINER_LINE];
-	FILE *fp;
+	container_slot_t entry;
 
 	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
 	if (container_num == NULL)
@@ -367,48 +427,260 @@ static enum MHD_Result get_container_version(struct MHD_Connection *connection)
 		line[CONTAINER_LINE - 1] = '\0';
 		return send_rest_error(connection, line, 400);
 	}
-	fp = fopen(SYSTEM_CONTAINERS_FILE, "r");
+
+	get_container_slot(cnt, &entry);
+	const char *error = container_slot_error(&entry, 1);
+	if (error != NULL)
+		return send_rest_error(connection, error, 500);
+
+	return send_rest_response(connection, entry.present ? entry.version : "");
+}
+
+
+
+// One line per slot: index!presence!id!name!version!status!uptime!restarts!exit_code!health
+static enum MHD_Result get_container_list(struct MHD_Connection *connection)
+{
+	container_slot_t entry;
+	container_state_t state;
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+
+	for (int cnt = 0; cnt < MAX_CONTAINERS; cnt++) {
+		get_container_slot(cnt, &entry);
+		const char *presence = entry.present ? "present" : "absent";
+		if (container_slot_error(&entry, 1) != NULL) {
+			presence = "unknown";
+			entry.id[0] = entry.name[0] = entry.version[0] = '\0';
+		}
+
+		long uptime = 0;
+		if (get_docker_slot_state(cnt, &state) != 0) {
+			memset(&state, 0, sizeof(state));
+			strcpy(state.status, "unknown");
+			strcpy(state.health, "unknown");
+			state.exit_code = -1;
+		} else if (! state.known) {
+			strcpy(state.status, "absent");
+			strcpy(state.health, "none");
+		} else if (state.running && (state.started != 0) && (time(NULL) > state.started)) {
+			uptime = (long) (time(NULL) - state.started);
+		}
+
+		if (addsnprintf(&reply, &size, &pos, "%d!%s!%s!%s!%s!%s!%ld!%d!%d!%s\n",
+		                cnt, presence, entry.id, entry.name, entry.version,
+		                state.status, uptime, state.restarts, state.exit_code, state.health) != 0) {
+			free(reply);
+			return send_rest_error(connection, "Not enough memory.", 500);
+		}
+	}
+
+	enum MHD_Result ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
+}
+
+
+
+// Written by the early-init tasks and report_last_shutdown():
+// <uptime in ms> <component> <step> <duration in ms>
+static enum MHD_Result get_boot_timeline(struct MHD_Connection *connection)
+{
+	return send_timeline(connection, BOOT_TIMELINE_FILE);
+}
+
+
+
+static enum MHD_Result get_container_timeline(struct MHD_Connection *connection)
+{
+	return send_timeline(connection, CONTAINER_TIMELINE_FILE);
+}
+
+
+
+static enum MHD_Result send_timeline(struct MHD_Connection *connection, const char *path)
+{
+	char line[CONTAINER_LINE];
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+
+	FILE *fp = fopen(path, "r");
 	if (fp == NULL)
-	        return send_rest_error(connection, "Unable to open containers description.", 500);
+		return send_rest_response(connection, "");
 
-	int c;
-	for (c = 0; c <= cnt; c++)
-		if (fgets(line, CONTAINER_LINE - 1, fp) == NULL)
-			break;
+	while (fgets(line, CONTAINER_LINE, fp) != NULL) {
+		if (addsnprintf(&reply, &size, &pos, "%s", line) != 0) {
+			fclose(fp);
+			free(reply);
+			return send_rest_error(connection, "Not enough memory.", 500);
+		}
+	}
 	fclose(fp);
-	if (c != cnt + 1)
-		return send_rest_error(connection, "Containers description is incomplete.", 500);
 
-	if (((line[0] == '-') && (line[1] == '1')) || (line[0] == '\0'))
-		return send_rest_response(connection, "");
+	enum MHD_Result ret = send_rest_response(connection, reply != NULL ? reply : "");
+	free(reply);
+	return ret;
+}
 
-		if (line[0] != '\0')
-		if (line[strlen(line) - 1] == '\n')
-			line[strlen(line) - 1] = '\0';
-	int i;
-	for (i = 0; (i < CONTAINER_LINE - 1) && (line[i] != '!'); i++)
-		// container id
-		;
-	if ((i == CONTAINER_LINE - 1) || (line[i] !='!'))
-	        return send_rest_error(connection, "Containers description is inconsistant.", 500);
-
-	int start = i + 1;
-	for (i ++; (i < CONTAINER_LINE - 1) && (line[i] != '!'); i++)
-		// container name
-		;
-	if ((i == CONTAINER_LINE - 1) || (line[i] !='!'))
-	        return send_rest_error(connection, "Containers description is inconsistant.", 500);
-	line[i] = '\0';
-
-
-	start = i + 1;
-	for (i ++; (i < CONTAINER_LINE - 1) && (line[i] != '!'); i++)
-		// container version
-		;
-	if ((i == CONTAINER_LINE - 1) || (line[i] !='!'))
-	        return send_rest_error(connection, "Containers description is inconsistant.", 500);
-	line[i] = '\0';
-
-	return send_rest_response(connection, &(line[start]));
+
+
+// Usage of the container against the limits of its profile (slot.conf), as
+// seen in its cgroup: "<key>=<current>/<limit>" or "<key>=<value>" lines.
+static enum MHD_Result get_container_resources(struct MHD_Connection *connection)
+{
+	int cnt;
+	char line[CONTAINER_LINE];
+	container_cgroup_t cgroup;
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+
+	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if (container_num == NULL)
+	        return send_rest_error(connection, "Missing container number.", 400);
+
+	if (sscanf(container_num, "%d", &cnt) != 1)
+	        return send_rest_error(connection, "Invalid container number.", 400);
+
+	if ((cnt < 0) || (cnt >= MAX_CONTAINERS)) {
+		snprintf(line, CONTAINER_LINE - 1, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
+		return send_rest_error(connection, line, 400);
+	}
+
+	if (container_cgroup(cnt, &cgroup) != 0)
+		return send_rest_error(connection, "Container is not running.", 404);
+
+	static const struct {
+		const char *key;
+		const char *current;
+		const char *limit;
+	} resources[] = {
+		{ "cpu_usage_usec", "cpu.stat",              NULL              },
+		{ "cpu_max",        "cpu.max",               NULL              },
+		{ "cpu_weight",     "cpu.weight",            NULL              },
+		{ "cpuset",         "cpuset.cpus.effective", "cpuset.cpus"     },
+		{ "memory",         "memory.current",        "memory.max"      },
+		{ "swap",           "memory.swap.current",   "memory.swap.max" },
+		{ "pids",           "pids.current",          "pids.max"        },
+		{ NULL,             NULL,                    NULL              },
+	};
+
+	for (int i = 0; resources[i].key != NULL; i++) {
+		char current[128];
+		char limit[128];
+		if (read_cgroup_file(&cgroup, resources[i].current, current, sizeof(current)) != 0)
+			continue;
+		// The first line of cpu.stat is "usage_usec <n>".
+		char *value = strchr(current, ' ');
+		value = ((value != NULL) && (strcmp(resources[i].current, "cpu.stat") == 0)) ? value + 1 : current;
+		int err;
+		if (resources[i].limit == NULL)
+			err = addsnprintf(&reply, &size, &pos, "%s=%s\n", resources[i].key, value);
+		else if (read_cgroup_file(&cgroup, resources[i].limit, limit, sizeof(limit)) != 0)
+			err = addsnprintf(&reply, &size, &pos, "%s=%s\n", resources[i].key, value);
+		else
+			err = addsnprintf(&reply, &size, &pos, "%s=%s/%s\n", resources[i].key, value, (limit[0] != '\0') ? limit : "all");
+		if (err != 0) {
+			free(reply);
+			return send_rest_error(connection, "Not enough memory.", 500);
+		}
+	}
+
+	enum MHD_Result ret = send_rest_response(connection, reply != NULL ? reply : "");
+	free(reply);
+	return ret;
 }
 
+
+
+// Without index: the last sample of each running container,
+//   <index>!<cpu %>!<memory>!<anon>!<file>!<io read B/s>!<io write B/s>!<pids>
+// With index: the history of the container, oldest first,
+//   <uptime in ms>!<cpu %>!<memory>!<anon>!<file>!<io read B/s>!<io write B/s>!<pids>
+static enum MHD_Result get_container_stats(struct MHD_Connection *connection)
+{
+	container_sample_t samples[CONTAINER_STATS_HISTORY];
+	char line[CONTAINER_LINE];
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+	int first = 0;
+	int last = MAX_CONTAINERS - 1;
+	int history = 0;
+
+	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if (container_num != NULL) {
+		if (sscanf(container_num, "%d", &first) != 1)
+		        return send_rest_error(connection, "Invalid container number.", 400);
+		if ((first < 0) || (first >= MAX_CONTAINERS)) {
+			snprintf(line, CONTAINER_LINE - 1, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
+			return send_rest_error(connection, line, 400);
+		}
+		last = first;
+		history = 1;
+	}
+
+	for (int cnt = first; cnt <= last; cnt++) {
+		int n = get_container_samples(cnt, samples, history ? CONTAINER_STATS_HISTORY : 1);
+		for (int i = 0; i < n; i++) {
+			const container_sample_t *s = &(samples[i]);
+			if (addsnprintf(&reply, &size, &pos, "%lld!%.1f!%llu!%llu!%llu!%.0f!%.0f!%llu\n",
+			                history ? s->time_ms : (long long) cnt, s->cpu_percent,
+			                s->memory, s->memory_anon, s->memory_file,
+			                s->io_read_rate, s->io_write_rate, s->pids) != 0) {
+				free(reply);
+				return send_rest_error(connection, "Not enough memory.", 500);
+			}
+		}
+	}
+
+	enum MHD_Result ret = send_rest_response(connection, reply != NULL ? reply : "");
+	free(reply);
+	return ret;
+}
+
+
+
+// Output of the container, from its log ring. With follow=1 the reply
+// doesn't end, the new lines being sent as they are written.
+static enum MHD_Result get_container_logs(struct MHD_Connection *connection)
+{
+	int cnt;
+	char line[CONTAINER_LINE];
+
+	const char *container_num = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if (container_num == NULL)
+	        return send_rest_error(connection, "Missing container number.", 400);
+
+	if (sscanf(container_num, "%d", &cnt) != 1)
+	        return send_rest_error(connection, "Invalid container number.", 400);
+
+	if ((cnt < 0) || (cnt >= MAX_CONTAINERS)) {
+		snprintf(line, CONTAINER_LINE - 1, "Container number must be between 0 and %d.", MAX_CONTAINERS - 1);
+		return send_rest_error(connection, line, 400);
+	}
+
+	const char *follow = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "follow");
+
+	return send_container_logs(connection, cnt, (follow != NULL) && (strcmp(follow, "1") == 0));
+}
+
+
+
+// Return the error to send for the slot, NULL if its description can be used.
+static const char *container_slot_error(const container_slot_t *entry, int need_fields)
+{
+	switch (entry->validity) {
+		case SLOT_VALID:
+			return NULL;
+		case SLOT_NO_FILE:
+			return "Unable to open containers description.";
+		case SLOT_INCOMPLETE:
+			return "Containers description is incomplete.";
+		case SLOT_INCONSISTENT:
+			return need_fields ? "Containers description is inconsistant." : NULL;
+	}
+	return NULL;
+}
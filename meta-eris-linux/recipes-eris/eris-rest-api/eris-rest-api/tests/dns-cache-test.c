@@ -0,0 +1,118 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Checks of the truncation of the UDP replies of the DNS cache, built on
+// the host with "make check". The private functions are reached by
+// including the source.
+
+#include "../dns-cache.c"
+
+
+// ---------------------- Private macros declarations.
+
+#define TEST_PAYLOAD   600
+#define TEST_ANSWERS   80          // 16 bytes each: the reply is larger than the payload.
+
+
+// ---------------------- Private method declarations.
+
+static size_t build_question (unsigned char *message, uint16_t ancount, uint16_t arcount);
+static int    check          (int condition, const char *description);
+
+
+// ---------------------- Private variables declarations.
+
+static int failures = 0;
+
+
+// ---------------------- Public methods
+
+int main(void)
+{
+	unsigned char query[DNS_MESSAGE_SIZE];
+	unsigned char reply[DNS_MESSAGE_SIZE];
+
+	// Query with an OPT record announcing a payload of TEST_PAYLOAD bytes.
+	size_t query_length = build_question(query, 0, 1);
+	unsigned char opt[] = { 0, 0, DNS_TYPE_OPT, TEST_PAYLOAD >> 8, TEST_PAYLOAD & 0xFF, 0, 0, 0, 0, 0, 0 };
+	memcpy(query + query_length, opt, sizeof(opt));
+	query_length += sizeof(opt);
+	check(udp_payload_size(query, query_length) == TEST_PAYLOAD, "EDNS payload of the query");
+
+	// Reply with TEST_ANSWERS A records pointing to the question name.
+	size_t question_end = build_question(reply, TEST_ANSWERS, 0);
+	size_t length = question_end;
+	for (int i = 0; i < TEST_ANSWERS; i++) {
+		unsigned char answer[] = { 0xC0, DNS_HEADER_SIZE, 0, 1, 0, 1, 0, 0, 1, 0, 0, 4, 10, 0, 0, i };
+		memcpy(reply + length, answer, sizeof(answer));
+		length += sizeof(answer);
+	}
+	unsigned char question[DNS_MESSAGE_SIZE];
+	memcpy(question, reply + DNS_HEADER_SIZE, question_end - DNS_HEADER_SIZE);
+
+	size_t truncated = truncate_reply(reply, length, TEST_PAYLOAD);
+	check(length > TEST_PAYLOAD, "reply larger than the payload");
+	check(truncated == question_end, "truncated to the question");
+	check((reply[2] & 0x02) != 0, "TC flag set");
+	check((reply[4] == 0) && (reply[5] == 1), "QDCOUNT kept");
+	check((reply[6] | reply[7] | reply[8] | reply[9] | reply[10] | reply[11]) == 0, "ANCOUNT, NSCOUNT and ARCOUNT zeroed");
+	check(memcmp(question, reply + DNS_HEADER_SIZE, question_end - DNS_HEADER_SIZE) == 0, "question kept");
+
+	// A reply fitting in the payload is left untouched.
+	length = build_question(reply, 0, 0);
+	check(truncate_reply(reply, length, TEST_PAYLOAD) == length, "small reply untouched");
+	check((reply[2] & 0x02) == 0, "small reply without TC flag");
+
+	// Without a valid question, only the header is sent.
+	memset(reply, 0, sizeof(reply));
+	reply[5] = 1;
+	reply[7] = 1;
+	memset(reply + DNS_HEADER_SIZE, 0x3F, TEST_PAYLOAD * 2);
+	truncated = truncate_reply(reply, DNS_HEADER_SIZE + TEST_PAYLOAD * 2, TEST_PAYLOAD);
+	check(truncated == DNS_HEADER_SIZE, "invalid question: header only");
+	check((reply[2] & 0x02) != 0, "invalid question: TC flag set");
+	check((reply[4] | reply[5] | reply[6] | reply[7]) == 0, "invalid question: counts zeroed");
+
+	return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// ---------------------- Private methods
+
+// Header and question "www.example.com A IN". Return its length.
+static size_t build_question(unsigned char *message, uint16_t ancount, uint16_t arcount)
+{
+	static const unsigned char name[] = "\003www\007example\003com";
+
+	memset(message, 0, DNS_HEADER_SIZE);
+	message[0] = 0x12;
+	message[1] = 0x34;
+	message[2] = 0x81;
+	message[3] = 0x80;
+	message[5] = 1;
+	message[6] = ancount >> 8;
+	message[7] = ancount & 0xFF;
+	message[10] = arcount >> 8;
+	message[11] = arcount & 0xFF;
+
+	size_t length = DNS_HEADER_SIZE;
+	memcpy(message + length, name, sizeof(name));
+	length += sizeof(name);
+	unsigned char type_class[] = { 0, 1, 0, 1 };
+	memcpy(message + length, type_class, sizeof(type_class));
+	return length + sizeof(type_class);
+}
+
+
+
+static int check(int condition, const char *description)
+{
+	printf("%s: %s\n", condition ? "ok" : "FAILED", description);
+	if (! condition)
+		failures++;
+	return condition;
+}
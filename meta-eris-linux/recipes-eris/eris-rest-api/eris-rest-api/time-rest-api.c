@@ -13,7 +13,9 @@
 
 #include "addsnprintf.h"
 #include "eris-rest-api.h"
+#include "sntp-client.h"
 #include "time-rest-api.h"
+#include "tz-rules.h"
 
 
 // ---------------------- Private macros declarations.
@@ -23,6 +25,21 @@
 #define TIME_ZONE_PREFIX   "time_zone="
 #define TIME_ZONE_PATH     "/usr/share/zoneinfo"
 
+#define CONVERT_MAX_SIZE   (64 * 1024)
+
+
+// ---------------------- Private types definitions.
+
+// Body of a POST /api/time/convert, gathered before the reply.
+typedef struct {
+
+	request_kind_t   request;       // REQUEST_TIME_CONVERT.
+	char            *body;
+	size_t           size;
+	int              too_large;
+
+} time_convert_t;
+
 
 // ---------------------- Private method declarations.
 
@@ -33,15 +50,20 @@ static enum MHD_Result get_time_ntp_server (struct MHD_Connection *connection);
 static enum MHD_Result put_time_ntp_server (struct MHD_Connection *connection);
 static enum MHD_Result get_time_ntp        (struct MHD_Connection *connection);
 static enum MHD_Result put_time_ntp        (struct MHD_Connection *connection);
+static enum MHD_Result get_time_ntp_status (struct MHD_Connection *connection);
 static enum MHD_Result get_time_zone_list  (struct MHD_Connection *connection);
 static enum MHD_Result get_time_zone       (struct MHD_Connection *connection);
 static enum MHD_Result put_time_zone       (struct MHD_Connection *connection);
 static enum MHD_Result get_time_local      (struct MHD_Connection *connection);
 static enum MHD_Result get_time_system     (struct MHD_Connection *connection);
 static enum MHD_Result put_time_system     (struct MHD_Connection *connection);
+static enum MHD_Result post_time_convert   (struct MHD_Connection *connection, const char *body);
 
-static void read_time_zone_list(void);
-static void set_rtc_time(struct tm *tm);
+static void        read_time_zone_list(void);
+static const char *find_time_zone(const char *name);
+static tz_rules_t *get_convert_zone(const char *name);
+static void        convert_time(const char *line, tz_rules_t *from, tz_rules_t *to, char **reply, size_t *size, size_t *pos);
+static void        set_rtc_time(struct tm *tm);
 
 // ---------------------- Private variables.
 
@@ -56,17 +78,19 @@ int init_time_rest_api(const char *app)
 	(void) app;
 
 	char *tz = NULL;
+	tz_rules_t *rules = NULL;
 
 	read_time_zone_list();
 
 	if (read_parameter_value(TIME_ZONE_PREFIX, &tz) == 0) {
-		setenv("TZ", tz, 1);
+		rules = load_tz_rules(tz);
 		free(tz);
-	} else {
-		setenv("TZ", "UTC", 1);
 	}
+	if (rules == NULL)
+		rules = load_tz_rules("UTC");
+	set_current_tz_rules(rules);
 
-	return 0;
+	return start_sntp_client();
 }
 
 
@@ -79,6 +103,10 @@ enum MHD_Result time_rest_api(struct MHD_Connection *connection, const char *url
 		if (strcmp(method, "PUT") == 0)
 			return put_time_ntp_server(connection);
 	}
+	if (strcasecmp(url, "/api/time/ntp/status") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return get_time_ntp_status(connection);
+	}
 	if (strcasecmp(url, "/api/time/ntp") == 0) {
 		if (strcmp(method, "GET") == 0)
 			return get_time_ntp(connection);
@@ -109,6 +137,68 @@ enum MHD_Result time_rest_api(struct MHD_Connection *connection, const char *url
 }
 
 
+
+int is_time_convert_request(const char *url, const char *method)
+{
+	return (strcmp(method, "POST") == 0) && (strcasecmp(url, "/api/time/convert") == 0);
+}
+
+
+
+// Called once with the headers, then for each part of the body, then
+// once more with no data, when the reply can be sent.
+enum MHD_Result time_convert_rest_api(struct MHD_Connection *connection, const char *upload_data, size_t *upload_data_size, void **ptr)
+{
+	time_convert_t *convert = *ptr;
+
+	if (convert == NULL) {
+		convert = calloc(1, sizeof(time_convert_t));
+		if (convert == NULL)
+			return MHD_NO;
+		convert->request = REQUEST_TIME_CONVERT;
+		*ptr = convert;
+		return MHD_YES;
+	}
+
+	if (*upload_data_size > 0) {
+		if ((! convert->too_large) && (convert->size + *upload_data_size > CONVERT_MAX_SIZE)) {
+			convert->too_large = 1;
+			free(convert->body);
+			convert->body = NULL;
+			convert->size = 0;
+		}
+		if (! convert->too_large) {
+			char *body = realloc(convert->body, convert->size + *upload_data_size + 1);
+			if (body == NULL)
+				return MHD_NO;
+			memcpy(body + convert->size, upload_data, *upload_data_size);
+			convert->size += *upload_data_size;
+			body[convert->size] = '\0';
+			convert->body = body;
+		}
+		*upload_data_size = 0;
+		return MHD_YES;
+	}
+
+	if (convert->too_large)
+		return send_rest_error(connection, "Too many times to convert.", 413);
+	return post_time_convert(connection, convert->body != NULL ? convert->body : "");
+}
+
+
+
+void release_time_convert(void **ptr)
+{
+	time_convert_t *convert = *ptr;
+
+	if ((convert == NULL) || (convert->request != REQUEST_TIME_CONVERT))
+		return;
+	*ptr = NULL;
+	free(convert->body);
+	free(convert);
+}
+
+
 // ---------------------- Private methods
 
 static enum MHD_Result read_and_send_value(struct MHD_Connection *connection, const char *parameter)
@@ -156,9 +246,14 @@ static enum MHD_Result put_time_ntp_server(struct MHD_Connection *connection)
 		 || (name[i] == '-')
 		 || (name[i] == '_'))
 			continue;
-		return send_rest_error(connection, "NTP server must be a string of letters, digits or .:-_.", 400);
+		// Several servers are separated by commas.
+		if ((name[i] == ',') && (i > 0) && (name[i + 1] != '\0'))
+			continue;
+		return send_rest_error(connection, "NTP server must be a string of letters, digits or .:-_, (comma between servers).", 400);
 	}
-	return store_received_value(connection, NTP_SERVER_PREFIX, name);
+	enum MHD_Result ret = store_received_value(connection, NTP_SERVER_PREFIX, name);
+	wakeup_sntp_client();
+	return ret;
 }
 
 
@@ -178,7 +273,26 @@ static enum MHD_Result put_time_ntp(struct MHD_Connection *connection)
 	if ((strcasecmp(status, "yes") != 0) && (strcasecmp(status, "no") != 0)) {
 	        return send_rest_error(connection, "NTP status must be 'yes' or 'no'.", 400);
 	}
-	return store_received_value(connection, NTP_ENABLE_PREFIX, status);
+	enum MHD_Result ret = store_received_value(connection, NTP_ENABLE_PREFIX, status);
+	wakeup_sntp_client();
+	return ret;
+}
+
+
+
+static enum MHD_Result get_time_ntp_status(struct MHD_Connection *connection)
+{
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+
+	if (get_sntp_status(&reply, &size, &pos) != 0) {
+		free(reply);
+		return send_rest_error(connection, "Not enough memory.", 500);
+	}
+	enum MHD_Result ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
 }
 
 
@@ -288,6 +402,19 @@ static enum MHD_Result get_time_zone(struct MHD_Connection *connection)
 
 
 
+static const char *find_time_zone(const char *name)
+{
+	for (int i = 0; i < nb_tz_names; i++) {
+		if (tz_names[i] != NULL) {
+			if (strcasecmp(tz_names[i], name) == 0)
+				return tz_names[i];
+		}
+	}
+	return NULL;
+}
+
+
+
 static enum MHD_Result put_time_zone(struct MHD_Connection *connection)
 {
 
@@ -295,15 +422,21 @@ static enum MHD_Result put_time_zone(struct MHD_Connection *connection)
 	if (name == NULL)
 	        return send_rest_error(connection, "Missing time zone name.", 400);
 
-	for (int i = 0; i < nb_tz_names; i++) {
-		if (tz_names[i] != NULL) {
-			if (strcasecmp(tz_names[i], name) == 0) {
-				setenv("TZ", tz_names[i], 1);
-				return store_received_value(connection, TIME_ZONE_PREFIX, tz_names[i]);
-			}
-		}
+	const char *zone = find_time_zone(name);
+	if (zone == NULL)
+		return send_rest_error(connection, "Invalid time zone name.", 400);
+
+	// Loaded before the swap: the requests in progress keep the previous rules.
+	tz_rules_t *rules = load_tz_rules(zone);
+	if (rules == NULL)
+		return send_rest_error(connection, "Unable to read time zone rules.", 500);
+
+	if (write_parameter_value(TIME_ZONE_PREFIX, zone) != 0) {
+		release_tz_rules(rules);
+		return send_rest_error(connection, "Unable to store internal parameter.", 500);
 	}
-	return send_rest_error(connection, "Invalid time zone name.", 400);
+	set_current_tz_rules(rules);
+	return send_rest_response(connection, "Ok");
 }
 
 
@@ -313,12 +446,17 @@ static enum MHD_Result get_time_local(struct MHD_Connection *connection)
 	struct timeval tv;
 	gettimeofday(&tv, NULL);
 
-	struct tm *t = localtime(&(tv.tv_sec));
+	tz_civil_t t;
+	tz_rules_t *rules = get_current_tz_rules();
+	if (rules == NULL)
+		return send_rest_error(connection, "Not enough memory.", 500);
+	tz_to_local(rules, tv.tv_sec, &t, NULL, NULL);
+	release_tz_rules(rules);
 
 	char reply[128];
 	snprintf(reply, 128, "%04d-%02d-%02d %02d:%02d:%02d:%06ld",
-		t->tm_year + 1900, t->tm_mon + 1, t->tm_mday,
-		t->tm_hour, t->tm_min, t->tm_sec,
+		t.year, t.month, t.day,
+		t.hour, t.minute, t.second,
 		tv.tv_usec);
 	int ret = send_rest_response(connection, reply);
 	return ret;
@@ -331,12 +469,13 @@ static enum MHD_Result get_time_system(struct MHD_Connection *connection)
 	struct timeval tv;
 	gettimeofday(&tv, NULL);
 
-	struct tm *t = gmtime(&(tv.tv_sec));
+	tz_civil_t t;
+	utc_to_civil(tv.tv_sec, &t);
 	char reply[128];
 
 	snprintf(reply, 128, "%04d-%02d-%02d %02d:%02d:%02d:%06ld",
-		t->tm_year + 1900, t->tm_mon + 1, t->tm_mday,
-		t->tm_hour, t->tm_min, t->tm_sec,
+		t.year, t.month, t.day,
+		t.hour, t.minute, t.second,
 		tv.tv_usec);
 	int ret = send_rest_response(connection, reply);
 	return ret;
@@ -384,20 +523,20 @@ static enum MHD_Result put_time_system(struct MHD_Connection *connection)
 	struct timeval tv;
 	memset(&tv, 0, sizeof(tv));
 
-	char timezone[64];
-	memset(timezone, 0, 64);
-
-	char *ptr = getenv("TZ");
-	if (ptr != NULL)
-		strncpy(timezone, ptr, 63);
-
-	unsetenv("TZ");
-	tv.tv_sec = mktime(&tm);
-
-	if (timezone[0] != '\0')
-		setenv("TZ", timezone, 1);
-
-	if (tv.tv_sec == (time_t) -1) {
+	tz_civil_t civil = {
+		.year   = tm.tm_year + 1900,
+		.month  = tm.tm_mon + 1,
+		.day    = tm.tm_mday,
+		.hour   = tm.tm_hour,
+		.minute = tm.tm_min,
+		.second = tm.tm_sec,
+	};
+	tv.tv_sec = civil_to_utc(&civil);
+
+	// Day out of the month (February 30th...).
+	tz_civil_t check;
+	utc_to_civil(tv.tv_sec - civil.second, &check);
+	if ((check.month != civil.month) || (check.day != civil.day)) {
 	        return send_rest_error(connection, "Wrong date.", 400);
 	}
 
@@ -409,6 +548,121 @@ static enum MHD_Result put_time_system(struct MHD_Connection *connection)
 
 
 
+// One time per line: "yyyy-mm-ddThh:mm:ss" in the source zone, or a
+// number of seconds since the Epoch.
+static enum MHD_Result post_time_convert(struct MHD_Connection *connection, const char *body)
+{
+	const char *from_name = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "from");
+	const char *to_name   = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "to");
+
+	tz_rules_t *from = get_convert_zone(from_name != NULL ? from_name : "UTC");
+	if (from == NULL)
+		return send_rest_error(connection, "Invalid source time zone.", 400);
+	tz_rules_t *to = get_convert_zone(to_name != NULL ? to_name : "local");
+	if (to == NULL) {
+		release_tz_rules(from);
+		return send_rest_error(connection, "Invalid destination time zone.", 400);
+	}
+
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+	char line[64];
+
+	while (*body != '\0') {
+		size_t len = strcspn(body, "\n");
+		while ((len > 0) && isspace(body[len - 1]))
+			len --;
+		if (len > 0) {
+			if (len >= sizeof(line))
+				len = sizeof(line) - 1;
+			memcpy(line, body, len);
+			line[len] = '\0';
+			convert_time(line, from, to, &reply, &size, &pos);
+		}
+		body += strcspn(body, "\n");
+		if (*body == '\n')
+			body ++;
+	}
+	release_tz_rules(from);
+	release_tz_rules(to);
+
+	if (reply == NULL)
+		return send_rest_response(connection, "");
+	enum MHD_Result ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
+}
+
+
+
+// "UTC", "local" (the zone of the device) or a name of the zone list.
+static tz_rules_t *get_convert_zone(const char *name)
+{
+	if (strcasecmp(name, "local") == 0)
+		return get_current_tz_rules();
+	if (strcasecmp(name, "UTC") == 0)
+		return load_tz_rules("UTC");
+
+	const char *zone = find_time_zone(name);
+	if (zone == NULL)
+		return NULL;
+	return load_tz_rules(zone);
+}
+
+
+
+static void convert_time(const char *line, tz_rules_t *from, tz_rules_t *to, char **reply, size_t *size, size_t *pos)
+{
+	tz_civil_t civil;
+	int64_t utc;
+	int n = 0;
+
+	while (isspace(*line))
+		line ++;
+
+	if ((sscanf(line, "%d-%d-%dT%d:%d:%d%n", &(civil.year), &(civil.month), &(civil.day), &(civil.hour), &(civil.minute), &(civil.second), &n) == 6)
+	 || (sscanf(line, "%d-%d-%d %d:%d:%d%n", &(civil.year), &(civil.month), &(civil.day), &(civil.hour), &(civil.minute), &(civil.second), &n) == 6)) {
+		// A final Z forces UTC.
+		int utc_time = (line[n] == 'Z');
+		if (((line[n] != '\0') && (! utc_time))
+		 || (civil.year < 1) || (civil.year > 9999) || (civil.month < 1) || (civil.month > 12)
+		 || (civil.day < 1) || (civil.day > 31) || (civil.hour < 0) || (civil.hour > 23)
+		 || (civil.minute < 0) || (civil.minute > 59) || (civil.second < 0) || (civil.second > 59)) {
+			addsnprintf(reply, size, pos, "invalid\n");
+			return;
+		}
+		tz_civil_t check;
+		utc_to_civil(civil_to_utc(&civil), &check);
+		if (check.day != civil.day) {
+			addsnprintf(reply, size, pos, "invalid\n");
+			return;
+		}
+		utc = utc_time ? civil_to_utc(&civil) : tz_from_local(from, &civil);
+	} else {
+		char *end;
+		errno = 0;
+		long long value = strtoll(line, &end, 10);
+		if ((end == line) || (*end != '\0') || (errno != 0)
+		 || (value < -62135596800LL) || (value > 253402300799LL)) {
+			addsnprintf(reply, size, pos, "invalid\n");
+			return;
+		}
+		utc = value;
+	}
+
+	int32_t offset;
+	const char *abbr;
+	tz_to_local(to, utc, &civil, &offset, &abbr);
+
+	int32_t abs_offset = offset < 0 ? -offset : offset;
+	addsnprintf(reply, size, pos, "%04d-%02d-%02dT%02d:%02d:%02d%c%02d:%02d %s\n",
+		civil.year, civil.month, civil.day, civil.hour, civil.minute, civil.second,
+		offset < 0 ? '-' : '+', abs_offset / 3600, (abs_offset / 60) % 60, abbr);
+}
+
+
+
 static void set_rtc_time(struct tm *tm)
 {
 	int fd;
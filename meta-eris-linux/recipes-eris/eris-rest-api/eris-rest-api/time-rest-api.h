@@ -14,4 +14,9 @@
 
 	enum MHD_Result time_rest_api(struct MHD_Connection *connection, const char *url, const char *method);
 
+	// POST /api/time/convert reads a body: dispatched before the other requests.
+	int             is_time_convert_request(const char *url, const char *method);
+	enum MHD_Result time_convert_rest_api(struct MHD_Connection *connection, const char *upload_data, size_t *upload_data_size, void **ptr);
+	void            release_time_convert(void **ptr);
+
 #endif
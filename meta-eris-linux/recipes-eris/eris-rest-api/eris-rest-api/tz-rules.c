@@ -0,0 +1,705 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Time zone rules read from the TZif files of /usr/share/zoneinfo, without
+// the TZ environment variable: the C library reads it without lock, and
+// changing it from a request thread races with every localtime() call.
+//
+// The transitions of the 64-bit block are used up to the last one, then
+// the POSIX TZ string of the footer gives the following years. A loaded
+// zone is never modified: the zone of the device is replaced by swapping
+// a pointer, and the previous rules are freed when their last user
+// releases them.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tz-rules.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define TZ_RULES_PATH       "/usr/share/zoneinfo"
+#define TZ_FILE_MAX_SIZE    (256 * 1024)
+#define TZ_NAME_MAX         64
+#define TZ_ABBR_MAX         16
+
+#define SECONDS_PER_DAY     86400
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	int32_t  offset;     // Seconds east of UTC.
+	int      is_dst;
+	int      abbr;       // Index in the abbreviations.
+
+} tz_type_t;
+
+typedef enum {
+
+	TZ_RULE_JULIAN = 0,  // Jn: 1 to 365, February 29th never counted.
+	TZ_RULE_DAY,         // n: 0 to 365, February 29th counted.
+	TZ_RULE_MONTH,       // Mm.w.d: day d of week w (5 = last) of month m.
+
+} tz_rule_kind_t;
+
+typedef struct {
+
+	tz_rule_kind_t  kind;
+	int             day;
+	int             week;
+	int             month;
+	int32_t         time;     // Local time of the change, may be negative or over 24h.
+
+} tz_rule_t;
+
+// POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3".
+typedef struct {
+
+	int        valid;
+	char       std_abbr[TZ_ABBR_MAX];
+	int32_t    std_offset;
+	int        has_dst;
+	char       dst_abbr[TZ_ABBR_MAX];
+	int32_t    dst_offset;
+	tz_rule_t  start;
+	tz_rule_t  end;
+
+} tz_posix_t;
+
+struct tz_rules {
+
+	int         refcount;
+	char        name[TZ_NAME_MAX];
+
+	int         nb_transitions;
+	int64_t    *transitions;
+	uint8_t    *transition_types;
+
+	int         nb_types;
+	tz_type_t  *types;
+
+	int         abbr_size;
+	char       *abbrs;
+
+	tz_posix_t  footer;
+};
+
+
+// ---------------------- Private method declarations.
+
+static tz_rules_t  *new_utc_rules         (void);
+static int          parse_tzif            (tz_rules_t *rules, const uint8_t *data, size_t size);
+static int          parse_posix_tz        (const char *string, tz_posix_t *posix);
+static const char  *parse_posix_abbr      (const char *s, char *abbr);
+static const char  *parse_posix_time      (const char *s, int32_t *value);
+static const char  *parse_posix_rule      (const char *s, tz_rule_t *rule);
+static int64_t      posix_rule_time       (const tz_rule_t *rule, int year, int32_t offset);
+static int32_t      posix_offset          (const tz_posix_t *posix, int64_t utc, int *is_dst);
+static int32_t      rules_offset          (const tz_rules_t *rules, int64_t utc, const char **abbr);
+static int64_t      days_from_civil       (int64_t year, int month, int day);
+static void         civil_from_days       (int64_t days, int *year, int *month, int *day);
+static int64_t      floor_div             (int64_t a, int64_t b);
+static uint32_t     read_be32             (const uint8_t *p);
+static uint64_t     read_be64             (const uint8_t *p);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t  tz_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tz_rules_t      *tz_current = NULL;
+
+
+// ---------------------- Public methods
+
+tz_rules_t *load_tz_rules(const char *name)
+{
+	char path[256];
+	struct stat st;
+
+	if ((name == NULL) || (name[0] == '\0') || (name[0] == '/')
+	 || (strstr(name, "..") != NULL) || (strlen(name) >= TZ_NAME_MAX)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", TZ_RULES_PATH, name);
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		if (strcmp(name, "UTC") == 0)
+			return new_utc_rules();
+		return NULL;
+	}
+	if ((fstat(fd, &st) != 0) || (! S_ISREG(st.st_mode)) || (st.st_size > TZ_FILE_MAX_SIZE)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	uint8_t *data = malloc(st.st_size + 1);
+	if (data == NULL) {
+		close(fd);
+		return NULL;
+	}
+	size_t size = 0;
+	while (size < (size_t) st.st_size) {
+		ssize_t n = read(fd, data + size, st.st_size - size);
+		if (n <= 0)
+			break;
+		size += n;
+	}
+	close(fd);
+	data[size] = '\0';
+
+	tz_rules_t *rules = calloc(1, sizeof(tz_rules_t));
+	if (rules == NULL) {
+		free(data);
+		return NULL;
+	}
+	rules->refcount = 1;
+	snprintf(rules->name, TZ_NAME_MAX, "%s", name);
+
+	if (parse_tzif(rules, data, size) != 0) {
+		free(data);
+		release_tz_rules(rules);
+		if (strcmp(name, "UTC") == 0)
+			return new_utc_rules();
+		errno = EINVAL;
+		return NULL;
+	}
+	free(data);
+	return rules;
+}
+
+
+
+void release_tz_rules(tz_rules_t *rules)
+{
+	if (rules == NULL)
+		return;
+
+	pthread_mutex_lock(&tz_mutex);
+	int last = (--(rules->refcount) == 0);
+	pthread_mutex_unlock(&tz_mutex);
+
+	if (! last)
+		return;
+
+	free(rules->transitions);
+	free(rules->transition_types);
+	free(rules->types);
+	free(rules->abbrs);
+	free(rules);
+}
+
+
+
+// Takes over the reference of the caller.
+void set_current_tz_rules(tz_rules_t *rules)
+{
+	pthread_mutex_lock(&tz_mutex);
+	tz_rules_t *previous = tz_current;
+	tz_current = rules;
+	pthread_mutex_unlock(&tz_mutex);
+
+	release_tz_rules(previous);
+}
+
+
+
+// Never NULL: UTC until a zone is set.
+tz_rules_t *get_current_tz_rules(void)
+{
+	tz_rules_t *rules;
+
+	pthread_mutex_lock(&tz_mutex);
+	if (tz_current == NULL)
+		tz_current = new_utc_rules();
+	rules = tz_current;
+	if (rules != NULL)
+		rules->refcount ++;
+	pthread_mutex_unlock(&tz_mutex);
+
+	return rules;
+}
+
+
+
+const char *tz_rules_name(const tz_rules_t *rules)
+{
+	return rules->name;
+}
+
+
+
+void tz_to_local(const tz_rules_t *rules, int64_t utc, tz_civil_t *local, int32_t *offset, const char **abbr)
+{
+	int32_t off = rules_offset(rules, utc, abbr);
+
+	if (offset != NULL)
+		*offset = off;
+	utc_to_civil(utc + off, local);
+}
+
+
+
+int64_t tz_from_local(const tz_rules_t *rules, const tz_civil_t *local)
+{
+	int64_t wall = civil_to_utc(local);
+
+	// Offsets in force one day before and one day after: the only
+	// candidates, as a zone never changes twice in two days.
+	int32_t before = rules_offset(rules, wall - SECONDS_PER_DAY, NULL);
+	int32_t after  = rules_offset(rules, wall + SECONDS_PER_DAY, NULL);
+
+	int64_t t_before = wall - before;
+	int64_t t_after  = wall - after;
+	int valid_before = (rules_offset(rules, t_before, NULL) == before);
+	int valid_after  = (rules_offset(rules, t_after,  NULL) == after);
+
+	if (valid_before && valid_after)
+		return (t_before < t_after) ? t_before : t_after;
+	if (valid_after)
+		return t_after;
+	// Valid, or in the gap of a change: the offset before the gap moves
+	// the time forward, as mktime() does.
+	return t_before;
+}
+
+
+
+int64_t civil_to_utc(const tz_civil_t *civil)
+{
+	return days_from_civil(civil->year, civil->month, civil->day) * SECONDS_PER_DAY
+	     + civil->hour * 3600 + civil->minute * 60 + civil->second;
+}
+
+
+
+void utc_to_civil(int64_t utc, tz_civil_t *civil)
+{
+	int64_t days = floor_div(utc, SECONDS_PER_DAY);
+	int64_t secs = utc - days * SECONDS_PER_DAY;
+
+	civil_from_days(days, &(civil->year), &(civil->month), &(civil->day));
+	civil->hour   = secs / 3600;
+	civil->minute = (secs / 60) % 60;
+	civil->second = secs % 60;
+}
+
+
+// ---------------------- Private methods
+
+static tz_rules_t *new_utc_rules(void)
+{
+	tz_rules_t *rules = calloc(1, sizeof(tz_rules_t));
+	if (rules == NULL)
+		return NULL;
+
+	rules->refcount = 1;
+	strcpy(rules->name, "UTC");
+	rules->footer.valid = 1;
+	strcpy(rules->footer.std_abbr, "UTC");
+	return rules;
+}
+
+
+
+// RFC 8536. Version 1 files have 32-bit times and no footer. Later
+// versions repeat the data with 64-bit times, followed by the footer.
+static int parse_tzif(tz_rules_t *rules, const uint8_t *data, size_t size)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = data + size;
+	int time_size = 4;
+
+	if ((size < 44) || (memcmp(p, "TZif", 4) != 0))
+		return -1;
+
+	for (int pass = 0; pass < 2; pass++) {
+		if ((end - p < 44) || (memcmp(p, "TZif", 4) != 0))
+			return -1;
+		int version = p[4];
+		uint32_t isutcnt  = read_be32(p + 20);
+		uint32_t isstdcnt = read_be32(p + 24);
+		uint32_t leapcnt  = read_be32(p + 28);
+		uint32_t timecnt  = read_be32(p + 32);
+		uint32_t typecnt  = read_be32(p + 36);
+		uint32_t charcnt  = read_be32(p + 40);
+		p += 44;
+
+		if ((typecnt == 0) || (typecnt > 256) || (timecnt > 65536) || (charcnt > 65536) || (leapcnt > 65536))
+			return -1;
+		size_t block = timecnt * time_size + timecnt + typecnt * 6 + charcnt
+		             + leapcnt * (time_size + 4) + isstdcnt + isutcnt;
+		if ((size_t)(end - p) < block)
+			return -1;
+
+		// Skip the 32-bit block if the 64-bit one follows.
+		if ((pass == 0) && (version != 0)) {
+			p += block;
+			time_size = 8;
+			continue;
+		}
+
+		rules->nb_transitions = timecnt;
+		rules->transitions = malloc((timecnt + 1) * sizeof(int64_t));
+		rules->transition_types = malloc(timecnt + 1);
+		rules->nb_types = typecnt;
+		rules->types = malloc(typecnt * sizeof(tz_type_t));
+		rules->abbr_size = charcnt;
+		rules->abbrs = malloc(charcnt + 1);
+		if ((rules->transitions == NULL) || (rules->transition_types == NULL)
+		 || (rules->types == NULL) || (rules->abbrs == NULL))
+			return -1;
+
+		for (uint32_t i = 0; i < timecnt; i++) {
+			if (time_size == 8)
+				rules->transitions[i] = (int64_t) read_be64(p);
+			else
+				rules->transitions[i] = (int32_t) read_be32(p);
+			p += time_size;
+		}
+		for (uint32_t i = 0; i < timecnt; i++) {
+			if (p[i] >= typecnt)
+				return -1;
+			rules->transition_types[i] = p[i];
+		}
+		p += timecnt;
+		for (uint32_t i = 0; i < typecnt; i++) {
+			rules->types[i].offset = (int32_t) read_be32(p);
+			rules->types[i].is_dst = p[4];
+			rules->types[i].abbr   = (p[5] < charcnt) ? p[5] : 0;
+			p += 6;
+		}
+		memcpy(rules->abbrs, p, charcnt);
+		rules->abbrs[charcnt] = '\0';
+		p += charcnt;
+		p += leapcnt * (time_size + 4) + isstdcnt + isutcnt;
+
+		// Footer: "\n<POSIX TZ string>\n".
+		if ((version != 0) && (end - p >= 2) && (*p == '\n')) {
+			const uint8_t *q = memchr(p + 1, '\n', end - p - 1);
+			if (q != NULL) {
+				char string[128];
+				size_t len = q - p - 1;
+				if (len < sizeof(string)) {
+					memcpy(string, p + 1, len);
+					string[len] = '\0';
+					if (parse_posix_tz(string, &(rules->footer)) != 0)
+						rules->footer.valid = 0;
+				}
+			}
+		}
+		return 0;
+	}
+	return -1;
+}
+
+
+
+static int parse_posix_tz(const char *string, tz_posix_t *posix)
+{
+	const char *s = string;
+	int32_t value;
+
+	memset(posix, 0, sizeof(tz_posix_t));
+
+	if ((s = parse_posix_abbr(s, posix->std_abbr)) == NULL)
+		return -1;
+	if ((s = parse_posix_time(s, &value)) == NULL)
+		return -1;
+	// POSIX offsets are positive west of Greenwich.
+	posix->std_offset = -value;
+
+	if (*s == '\0') {
+		posix->valid = 1;
+		return 0;
+	}
+
+	if ((s = parse_posix_abbr(s, posix->dst_abbr)) == NULL)
+		return -1;
+	posix->dst_offset = posix->std_offset + 3600;
+	if ((*s != ',') && (*s != '\0')) {
+		if ((s = parse_posix_time(s, &value)) == NULL)
+			return -1;
+		posix->dst_offset = -value;
+	}
+	// No rule given: the current US one.
+	if (*s == '\0')
+		s = ",M3.2.0,M11.1.0";
+	if (*s != ',')
+		return -1;
+	if ((s = parse_posix_rule(s + 1, &(posix->start))) == NULL)
+		return -1;
+	if (*s != ',')
+		return -1;
+	if ((s = parse_posix_rule(s + 1, &(posix->end))) == NULL)
+		return -1;
+	if (*s != '\0')
+		return -1;
+
+	posix->has_dst = 1;
+	posix->valid = 1;
+	return 0;
+}
+
+
+
+static const char *parse_posix_abbr(const char *s, char *abbr)
+{
+	int len = 0;
+
+	if (*s == '<') {
+		s++;
+		while ((*s != '>') && (*s != '\0')) {
+			if (len < TZ_ABBR_MAX - 1)
+				abbr[len++] = *s;
+			s++;
+		}
+		if (*s != '>')
+			return NULL;
+		s++;
+	} else {
+		while (((*s >= 'A') && (*s <= 'Z')) || ((*s >= 'a') && (*s <= 'z'))) {
+			if (len < TZ_ABBR_MAX - 1)
+				abbr[len++] = *s;
+			s++;
+		}
+	}
+	abbr[len] = '\0';
+	return (len < 3) ? NULL : s;
+}
+
+
+
+// [+-]hh[:mm[:ss]], hours up to 167 in version 3.
+static const char *parse_posix_time(const char *s, int32_t *value)
+{
+	int sign = 1;
+	int32_t hh = 0, mm = 0, ss = 0;
+
+	if ((*s == '+') || (*s == '-')) {
+		if (*s == '-')
+			sign = -1;
+		s++;
+	}
+	if ((*s < '0') || (*s > '9'))
+		return NULL;
+	while ((*s >= '0') && (*s <= '9') && (hh <= 167))
+		hh = hh * 10 + (*s++ - '0');
+	if (*s == ':') {
+		s++;
+		while ((*s >= '0') && (*s <= '9') && (mm < 60))
+			mm = mm * 10 + (*s++ - '0');
+		if (*s == ':') {
+			s++;
+			while ((*s >= '0') && (*s <= '9') && (ss < 60))
+				ss = ss * 10 + (*s++ - '0');
+		}
+	}
+	*value = sign * (hh * 3600 + mm * 60 + ss);
+	return s;
+}
+
+
+
+static const char *parse_posix_rule(const char *s, tz_rule_t *rule)
+{
+	char *end;
+
+	memset(rule, 0, sizeof(tz_rule_t));
+	rule->time = 2 * 3600;
+
+	if (*s == 'J') {
+		rule->kind = TZ_RULE_JULIAN;
+		rule->day = strtol(s + 1, &end, 10);
+		if ((end == s + 1) || (rule->day < 1) || (rule->day > 365))
+			return NULL;
+	} else if (*s == 'M') {
+		rule->kind = TZ_RULE_MONTH;
+		if (sscanf(s + 1, "%d.%d.%d", &(rule->month), &(rule->week), &(rule->day)) != 3)
+			return NULL;
+		if ((rule->month < 1) || (rule->month > 12) || (rule->week < 1) || (rule->week > 5)
+		 || (rule->day < 0) || (rule->day > 6))
+			return NULL;
+		end = (char *) s + 1;
+		while (((*end >= '0') && (*end <= '9')) || (*end == '.'))
+			end++;
+	} else {
+		rule->kind = TZ_RULE_DAY;
+		rule->day = strtol(s, &end, 10);
+		if ((end == s) || (rule->day < 0) || (rule->day > 365))
+			return NULL;
+	}
+	s = end;
+	if (*s == '/') {
+		if ((s = parse_posix_time(s + 1, &(rule->time))) == NULL)
+			return NULL;
+	}
+	return s;
+}
+
+
+
+// UTC time of the change given by the rule in a year, from the local
+// offset in force before it.
+static int64_t posix_rule_time(const tz_rule_t *rule, int year, int32_t offset)
+{
+	int64_t days = days_from_civil(year, 1, 1);
+	int leap = ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+
+	switch (rule->kind) {
+		case TZ_RULE_JULIAN:
+			days += rule->day - 1;
+			if (leap && (rule->day > 59))
+				days ++;
+			break;
+		case TZ_RULE_DAY:
+			days += rule->day;
+			break;
+		case TZ_RULE_MONTH: {
+			static const int month_days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+			int64_t first = days_from_civil(year, rule->month, 1);
+			int length = month_days[rule->month - 1] + ((rule->month == 2) && leap);
+			// 1970-01-01 was a Thursday.
+			int first_wday = (int)((first % 7 + 11) % 7);
+			int mday = 1 + (rule->day - first_wday + 7) % 7 + (rule->week - 1) * 7;
+			while (mday > length)
+				mday -= 7;
+			days = first + mday - 1;
+			break;
+		}
+	}
+	return days * SECONDS_PER_DAY + rule->time - offset;
+}
+
+
+
+static int32_t posix_offset(const tz_posix_t *posix, int64_t utc, int *is_dst)
+{
+	*is_dst = 0;
+	if (! posix->has_dst)
+		return posix->std_offset;
+
+	int year, month, day;
+	civil_from_days(floor_div(utc + posix->std_offset, SECONDS_PER_DAY), &year, &month, &day);
+
+	int64_t start = posix_rule_time(&(posix->start), year, posix->std_offset);
+	int64_t end   = posix_rule_time(&(posix->end),   year, posix->dst_offset);
+
+	if (start < end)
+		*is_dst = (utc >= start) && (utc < end);
+	else
+		// Southern hemisphere: summer time across the new year.
+		*is_dst = (utc < end) || (utc >= start);
+
+	return *is_dst ? posix->dst_offset : posix->std_offset;
+}
+
+
+
+static int32_t rules_offset(const tz_rules_t *rules, int64_t utc, const char **abbr)
+{
+	int n = rules->nb_transitions;
+
+	if ((n == 0) || (utc >= rules->transitions[n - 1])) {
+		if (rules->footer.valid) {
+			int is_dst;
+			int32_t offset = posix_offset(&(rules->footer), utc, &is_dst);
+			if (abbr != NULL)
+				*abbr = is_dst ? rules->footer.dst_abbr : rules->footer.std_abbr;
+			return offset;
+		}
+	}
+
+	// Before the first transition: the first type.
+	int type = 0;
+	if ((n > 0) && (utc >= rules->transitions[0])) {
+		int low = 0;
+		int high = n - 1;
+		while (low < high) {
+			int mid = (low + high + 1) / 2;
+			if (rules->transitions[mid] <= utc)
+				low = mid;
+			else
+				high = mid - 1;
+		}
+		type = rules->transition_types[low];
+	}
+	if (rules->nb_types == 0) {
+		if (abbr != NULL)
+			*abbr = "UTC";
+		return 0;
+	}
+	if (abbr != NULL)
+		*abbr = rules->abbrs + rules->types[type].abbr;
+	return rules->types[type].offset;
+}
+
+
+
+// Proleptic Gregorian calendar, days since 1970-01-01.
+static int64_t days_from_civil(int64_t year, int month, int day)
+{
+	year -= (month <= 2);
+	int64_t era = floor_div(year, 400);
+	int64_t yoe = year - era * 400;
+	int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+
+
+static void civil_from_days(int64_t days, int *year, int *month, int *day)
+{
+	days += 719468;
+	int64_t era = floor_div(days, 146097);
+	int64_t doe = days - era * 146097;
+	int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int64_t mp  = (5 * doy + 2) / 153;
+
+	*day   = doy - (153 * mp + 2) / 5 + 1;
+	*month = mp < 10 ? mp + 3 : mp - 9;
+	*year  = yoe + era * 400 + (*month <= 2);
+}
+
+
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+	int64_t q = a / b;
+	if ((a % b != 0) && ((a < 0) != (b < 0)))
+		q --;
+	return q;
+}
+
+
+
+static uint32_t read_be32(const uint8_t *p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+
+
+static uint64_t read_be64(const uint8_t *p)
+{
+	return ((uint64_t) read_be32(p) << 32) | read_be32(p + 4);
+}
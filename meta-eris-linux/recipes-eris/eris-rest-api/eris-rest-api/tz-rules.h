@@ -0,0 +1,51 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef TZ_RULES_H
+#define TZ_RULES_H
+
+	#include <stdint.h>
+
+	// Rules of a time zone, read from its TZif file. Immutable once loaded,
+	// and shared through a reference count.
+	typedef struct tz_rules tz_rules_t;
+
+	typedef struct {
+
+		int   year;
+		int   month;     // 1 to 12.
+		int   day;       // 1 to 31.
+		int   hour;
+		int   minute;
+		int   second;
+
+	} tz_civil_t;
+
+	// NULL if the zone file is missing or invalid ("UTC" is always known).
+	tz_rules_t *load_tz_rules(const char *name);
+	void        release_tz_rules(tz_rules_t *rules);
+
+	// Zone of the device, replaced atomically: the rules got from
+	// get_current_tz_rules() stay valid until released.
+	void        set_current_tz_rules(tz_rules_t *rules);
+	tz_rules_t *get_current_tz_rules(void);
+
+	const char *tz_rules_name(const tz_rules_t *rules);
+
+	// Local time of a UTC time (like localtime_r), with its offset in
+	// seconds east of UTC and the abbreviation of the zone.
+	void tz_to_local(const tz_rules_t *rules, int64_t utc, tz_civil_t *local, int32_t *offset, const char **abbr);
+
+	// UTC time of a local time (like mktime). An ambiguous time gives the
+	// earliest instant, a time in a gap is moved forward by the gap.
+	int64_t tz_from_local(const tz_rules_t *rules, const tz_civil_t *local);
+
+	// Without time zone (like timegm and gmtime_r).
+	int64_t civil_to_utc(const tz_civil_t *civil);
+	void    utc_to_civil(int64_t utc, tz_civil_t *civil);
+
+#endif
@@ -2,16 +2,22 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/reboot.h>
+#include <sys/stat.h>
 #include <uuid/uuid.h>
 
 #include "addsnprintf.h"
+#include "container-table.h"
 #include "eris-rest-api.h"
+#include "exec-job.h"
+#include "fast-shutdown.h"
+#include "system-installer.h"
 #include "update-rest-api.h"
 
 
@@ -26,6 +32,16 @@
 
 #define SERVER_CONTACT_FIFO       "/tmp/contact-eris-server"
 
+#define START_CONTAINERS_SCRIPT   "/etc/init.d/start-containers"
+#define SLOTS_DIR                 "/data/containers"
+#define MAX_CONTAINERS            4
+#define CONTAINER_ENTRY_FIELDS    8
+#define SWITCH_TIMEOUT_MS         (10 * 60 * 1000)
+#define RESOURCE_VALUE_MAX        64
+
+#define FW_SETENV                 "/usr/bin/fw_setenv"
+#define FACTORY_RESET_TIMEOUT_MS  (10 * 1000)
+
 
 // ---------------------- Private method declarations.
 
@@ -38,14 +54,46 @@ static enum MHD_Result set_reboot_now       (struct MHD_Connection *connection);
 static enum MHD_Result get_contact_period   (struct MHD_Connection *connection);
 static enum MHD_Result set_contact_period   (struct MHD_Connection *connection);
 static enum MHD_Result set_contact_now      (struct MHD_Connection *connection);
+static enum MHD_Result install_update       (struct MHD_Connection *connection);
 static enum MHD_Result rollback             (struct MHD_Connection *connection);
 static enum MHD_Result back_to_factory      (struct MHD_Connection *connection);
+static enum MHD_Result reply_back_to_factory(struct MHD_Connection *connection, const exec_result_t *result, void *arg);
 static enum MHD_Result get_container_policy (struct MHD_Connection *connection);
 static enum MHD_Result set_container_policy (struct MHD_Connection *connection);
+static enum MHD_Result get_container_switch (struct MHD_Connection *connection);
+static enum MHD_Result set_container_switch (struct MHD_Connection *connection);
+static enum MHD_Result reply_container_switch(struct MHD_Connection *connection, const exec_result_t *result, void *arg);
+static int             valid_switch_payload (int slot, const char *payload, char *path);
+static int             valid_switch_entry   (int slot, const char *entry);
+static enum MHD_Result send_switch_report   (struct MHD_Connection *connection, int slot);
+static int             read_slot_index      (struct MHD_Connection *connection, int *slot);
+static enum MHD_Result get_container_resources(struct MHD_Connection *connection);
+static enum MHD_Result set_container_resources(struct MHD_Connection *connection);
+static int             resource_key_index   (const char *line);
+static int             valid_resource_value (int key, const char *value);
 
 
 // ---------------------- Private variables.
 
+// Resource profile of a slot in its slot.conf, applied by start-containers
+// to docker run: keys and accepted characters of their values.
+static const struct {
+	const char *key;
+	const char *accepted;
+} resource_keys[] = {
+	{ "cpuset",       "0123456789,-"         },   // --cpuset-cpus
+	{ "cpus",         "0123456789."          },   // --cpus (quota)
+	{ "cpu_shares",   "0123456789"           },   // --cpu-shares
+	{ "memory",       "0123456789bkmgBKMG"   },   // --memory
+	{ "memory_swap",  "0123456789bkmgBKMG-"  },   // --memory-swap (-1: unlimited)
+	{ "pids",         "0123456789"           },   // --pids-limit
+	{ "shm_size",     "0123456789bkmgBKMG"   },   // --shm-size
+	{ "ipc",          "abcdefghijklmnopqrstuvwxyz" },   // --ipc
+	{ "rt_priority",  "0123456789"           },   // --ulimit rtprio and SYS_NICE
+	{ "rt_runtime",   "0123456789"           },   // --cpu-rt-runtime (cgroup v1 only)
+	{ NULL,           NULL                   },
+};
+
 // ---------------------- Public methods
 
 int init_update_rest_api(const char *app)
@@ -73,6 +121,9 @@ enum MHD_Result update_rest_api(struct MHD_Connection *connection, const char *u
 	if ((strcasecmp(url, "/api/update/contact/now") == 0) && (strcmp(method, "POST") == 0))
 		return set_contact_now(connection);
 
+	if ((strcasecmp(url, "/api/update/install") == 0) && (strcmp(method, "POST") == 0))
+		return install_update(connection);
+
 	if ((strcasecmp(url, "/api/update/rollback") == 0) && (strcmp(method, "POST") == 0))
 		return rollback(connection);
 	if ((strcasecmp(url, "/api/update/factory") == 0) && (strcmp(method, "POST") == 0))
@@ -90,15 +141,28 @@ enum MHD_Result update_rest_api(struct MHD_Connection *connection, const char *u
 	if ((strcasecmp(url, "/api/update/container/policy") == 0) && (strcmp(method, "PUT") == 0))
 		return set_container_policy(connection);
 
+	if ((strcasecmp(url, "/api/update/container/switch") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_switch(connection);
+	if ((strcasecmp(url, "/api/update/container/switch") == 0) && (strcmp(method, "POST") == 0))
+		return set_container_switch(connection);
+
+	if ((strcasecmp(url, "/api/update/container/resources") == 0) && (strcmp(method, "GET") == 0))
+		return get_container_resources(connection);
+	if ((strcasecmp(url, "/api/update/container/resources") == 0) && (strcmp(method, "PUT") == 0))
+		return set_container_resources(connection);
+
 	return MHD_NO;
 }
 
 
 // ---------------------- Private methods
 
+// The progress of an installation started by POST /api/update/install
+// follows the status line.
 static enum MHD_Result get_update_status(struct MHD_Connection *connection)
 {
 	FILE *fp = NULL;
+	const char *message = NULL;
 
 	int status = 0;
 	if ((fp = fopen(SYSTEM_UPDATE_STATUS_FILE, "r")) != NULL) {
@@ -112,19 +176,47 @@ static enum MHD_Result get_update_status(struct MHD_Connection *connection)
 
 	switch (status) {
 	case 1:
-		return send_rest_response(connection, "1 System OK.");
+		message = "1 System OK.";
+		break;
 	case 2:
-		return send_rest_response(connection, "2 System update install in progress.");
+		message = "2 System update install in progress.";
+		break;
 	case 3:
-		return send_rest_response(connection, "3 System update install Ok.");
+		message = "3 System update install Ok.";
+		break;
 	case 4:
-		return send_rest_response(connection, "4 System update install failed.");
+		message = "4 System update install failed.";
+		break;
 	case 5:
-		return send_rest_response(connection, "5 System reboot in progress.");
-	default:
+		message = "5 System reboot in progress.";
 		break;
+	default:
+		return send_rest_error(connection, "Unable read system update status.", 500);
 	}
-	return send_rest_error(connection, "Unable read system update status.", 500);
+
+	install_progress_t progress;
+	get_install_progress(&progress);
+	if (progress.stage == INSTALL_IDLE)
+		return send_rest_response(connection, message);
+
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+	if (addsnprintf(&reply, &size, &pos,
+	                "%s\nstage=%s\npartition=%s\npayload=%s\nbytes=%llu\ntotal=%llu\nwritten=%llu\nrate=%.0f\neta=%ld\nresumes=%d\n",
+	                message, install_stage_name(progress.stage), progress.partition, progress.delta ? "delta" : "image",
+	                progress.downloaded, progress.total, progress.written,
+	                progress.rate, progress.eta_s, progress.resumes) != 0) {
+		free(reply);
+		return send_rest_error(connection, "Not enough memory.", 500);
+	}
+	if ((progress.error[0] != '\0') && (addsnprintf(&reply, &size, &pos, "error=%s\n", progress.error) != 0)) {
+		free(reply);
+		return send_rest_error(connection, "Not enough memory.", 500);
+	}
+	enum MHD_Result ret = send_rest_response(connection, reply);
+	free(reply);
+	return ret;
 }
 
 
@@ -202,12 +294,16 @@ static enum MHD_Result set_automatic_reboot(struct MHD_Connection *connection)
 
 
 
+// The reply is sent while the containers are stopped.
 static enum MHD_Result set_reboot_now(struct MHD_Connection *connection)
 {
-	send_rest_response(connection, "Ok");
-	sync();
-	reboot(RB_AUTOBOOT);
-	return send_rest_error(connection, "Unable to reboot the system.", 500);
+	if ((start_shutdown() != 0) && (errno != EBUSY)) {
+		send_rest_response(connection, "Ok");
+		sync();
+		reboot(RB_AUTOBOOT);
+		return send_rest_error(connection, "Unable to reboot the system.", 500);
+	}
+	return send_rest_response(connection, "Ok");
 }
 
 
@@ -257,6 +353,30 @@ static enum MHD_Result set_contact_now(struct MHD_Connection *connection)
 
 
 
+static enum MHD_Result install_update(struct MHD_Connection *connection)
+{
+	const char *url = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "url");
+	if (url == NULL)
+		return send_rest_error(connection, "Missing 'url' parameter.", 400);
+	if ((strncmp(url, "http://", 7) != 0) && (strncmp(url, "https://", 8) != 0))
+		return send_rest_error(connection, "The image url must be http or https.", 400);
+
+	const char *signature = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "signature");
+	if ((signature != NULL) && (strncmp(signature, "http://", 7) != 0) && (strncmp(signature, "https://", 8) != 0))
+		return send_rest_error(connection, "The signature url must be http or https.", 400);
+
+	if (start_system_install(url, signature) != 0) {
+		if (errno == EBUSY)
+			return send_rest_error(connection, "A system update is already in progress.", 409);
+		if (errno == EINVAL)
+			return send_rest_error(connection, "Url too long.", 400);
+		return send_rest_error(connection, "Unable to start the system update.", 500);
+	}
+	return send_rest_response(connection, "Ok");
+}
+
+
+
 static enum MHD_Result rollback(struct MHD_Connection *connection)
 {
 	return send_rest_error(connection, "Feature not implemented yet.", 501);
@@ -264,9 +384,34 @@ static enum MHD_Result rollback(struct MHD_Connection *connection)
 
 
 
+// The reset itself is done at the next boot by the early-init script
+// 035-factory-reset, before the data partition is mounted.
 static enum MHD_Result back_to_factory(struct MHD_Connection *connection)
 {
-	return send_rest_error(connection, "Feature not implemented yet.", 501);
+	if (access(FW_SETENV, X_OK) != 0)
+		return send_rest_error(connection, "Feature not available on this system.", 501);
+
+	install_progress_t progress;
+	get_install_progress(&progress);
+	if ((progress.stage != INSTALL_IDLE) && (progress.stage != INSTALL_DONE) && (progress.stage != INSTALL_FAILED))
+		return send_rest_error(connection, "A system update is in progress.", 409);
+
+	const char *argv[] = { FW_SETENV, "factory_reset", "1", NULL };
+	return run_command_async(connection, argv, NULL, FACTORY_RESET_TIMEOUT_MS, 0, reply_back_to_factory, NULL, NULL);
+}
+
+
+
+static enum MHD_Result reply_back_to_factory(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	(void) arg;
+
+	if (result->exit_status != 0)
+		return send_rest_error(connection, "Unable to schedule the factory reset.", 500);
+
+	if ((start_shutdown() != 0) && (errno != EBUSY))
+		return send_rest_error(connection, "Unable to reboot the system.", 500);
+	return send_rest_response(connection, "Ok");
 }
 
 
@@ -300,3 +445,263 @@ static enum MHD_Result set_container_policy(struct MHD_Connection *connection)
 	return send_rest_response(connection, "Ok");
 }
 
+
+
+static enum MHD_Result get_container_switch(struct MHD_Connection *connection)
+{
+	int slot;
+
+	if (read_slot_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	return send_switch_report(connection, slot);
+}
+
+
+
+// Blue/green switch of a slot to a new image, see switch-slot in start-containers.
+static enum MHD_Result set_container_switch(struct MHD_Connection *connection)
+{
+	char number[16];
+	char payload[PATH_MAX];
+	int slot;
+
+	if (read_slot_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	const char *value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "payload");
+	if (value == NULL)
+		return send_rest_error(connection, "Missing 'payload' parameter'.", 400);
+	if (valid_switch_payload(slot, value, payload) != 0)
+		return send_rest_error(connection, "The container image must be a file of the directory of the slot.", 400);
+
+	const char *mode = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "mode");
+	if (mode == NULL)
+		mode = "warm";
+	if ((strcmp(mode, "warm") != 0) && (strcmp(mode, "cold") != 0))
+		return send_rest_error(connection, "Switch mode must be 'warm' or 'cold'.", 400);
+
+	const char *entry = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "entry");
+	if ((entry != NULL) && (valid_switch_entry(slot, entry) != 0))
+		return send_rest_error(connection, "The entry must be a containers line for the container of the slot.", 400);
+
+	snprintf(number, sizeof(number), "%d", slot + 1);
+	// Without entry, the NULL pointer ends the arguments.
+	const char *argv[] = { START_CONTAINERS_SCRIPT, "switch-slot", number, payload, mode, entry, NULL };
+
+	int *arg = malloc(sizeof(int));
+	if (arg == NULL)
+		return send_rest_error(connection, "Not enough memory.", 500);
+	*arg = slot;
+
+	return run_command_async(connection, argv, NULL, SWITCH_TIMEOUT_MS, 0, reply_container_switch, arg, free);
+}
+
+
+
+static enum MHD_Result reply_container_switch(struct MHD_Connection *connection, const exec_result_t *result, void *arg)
+{
+	if (result->timed_out)
+		return send_rest_error(connection, "Container switch timed out.", 500);
+
+	// A rolled back switch is reported as well.
+	return send_switch_report(connection, *(int *) arg);
+}
+
+
+
+// The payload is a file of /data/containers/slot-<n>/, resolved in path.
+static int valid_switch_payload(int slot, const char *payload, char *path)
+{
+	char slot_dir[64];
+	struct stat status;
+
+	if (realpath(payload, path) == NULL)
+		return -1;
+	snprintf(slot_dir, sizeof(slot_dir), "%s/slot-%d/", SLOTS_DIR, slot + 1);
+	if (strncmp(path, slot_dir, strlen(slot_dir)) != 0)
+		return -1;
+	if ((stat(path, &status) != 0) || (! S_ISREG(status.st_mode)) || (access(path, R_OK) != 0))
+		return -1;
+	return 0;
+}
+
+
+
+// The entry replaces the line of the slot in the containers description:
+// id!name!version!filename!b64!graphical!redirections!privileged, with the
+// id of the container currently in the slot.
+static int valid_switch_entry(int slot, const char *entry)
+{
+	container_slot_t current;
+	int fields = 1;
+
+	// Neither a new line nor an escape sequence can be given to awk.
+	if (strpbrk(entry, "\r\n\\") != NULL)
+		return -1;
+	for (const char *c = entry; *c != '\0'; c++)
+		if (*c == '!')
+			fields++;
+	if (fields != CONTAINER_ENTRY_FIELDS)
+		return -1;
+
+	if ((get_container_slot(slot, &current) != 0) || (current.validity != SLOT_VALID) || (! current.present))
+		return -1;
+	size_t length = strcspn(entry, "!");
+	if ((length != strlen(current.id)) || (strncmp(entry, current.id, length) != 0))
+		return -1;
+	return 0;
+}
+
+
+
+// Report written by start-containers:
+// result=<switched|rolled-back|stage-failed> mode=<warm|cold> stage_ms= ready_ms= downtime_ms= time=
+static enum MHD_Result send_switch_report(struct MHD_Connection *connection, int slot)
+{
+	char path[256];
+	char line[512];
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.switch", SLOTS_DIR, slot + 1);
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return send_rest_error(connection, "No container switch for this slot.", 404);
+	if (fgets(line, sizeof(line), fp) == NULL)
+		line[0] = '\0';
+	fclose(fp);
+	line[strcspn(line, "\n")] = '\0';
+
+	return send_rest_response(connection, line);
+}
+
+
+
+static int read_slot_index(struct MHD_Connection *connection, int *slot)
+{
+	const char *index = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if ((index == NULL) || (sscanf(index, "%d", slot) != 1))
+		return -1;
+	return ((*slot >= 0) && (*slot < MAX_CONTAINERS)) ? 0 : -1;
+}
+
+
+
+static enum MHD_Result get_container_resources(struct MHD_Connection *connection)
+{
+	char path[256];
+	char line[512];
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+	int slot;
+
+	if (read_slot_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.conf", SLOTS_DIR, slot + 1);
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL)
+		return send_rest_response(connection, "");
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (resource_key_index(line) < 0)
+			continue;
+		if (addsnprintf(&reply, &size, &pos, "%s", line) != 0) {
+			fclose(fp);
+			free(reply);
+			return send_rest_error(connection, "Not enough memory.", 500);
+		}
+	}
+	fclose(fp);
+
+	enum MHD_Result ret = send_rest_response(connection, reply != NULL ? reply : "");
+	free(reply);
+	return ret;
+}
+
+
+
+// The keys given replace the ones of the profile, an empty value removes the
+// key. The other lines of slot.conf (start order, readiness) are kept.
+// The profile is applied at the next start of the container.
+static enum MHD_Result set_container_resources(struct MHD_Connection *connection)
+{
+	const char *values[sizeof(resource_keys) / sizeof(resource_keys[0])];
+	char path[256];
+	char temp[272];
+	char line[512];
+	int given = 0;
+	int slot;
+
+	if (read_slot_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	for (int key = 0; resource_keys[key].key != NULL; key++) {
+		values[key] = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, resource_keys[key].key);
+		if (values[key] == NULL)
+			continue;
+		if (! valid_resource_value(key, values[key])) {
+			snprintf(line, sizeof(line), "Invalid '%s' parameter value.", resource_keys[key].key);
+			return send_rest_error(connection, line, 400);
+		}
+		given++;
+	}
+	if (given == 0)
+		return send_rest_error(connection, "Missing resource parameter.", 400);
+
+	snprintf(path, sizeof(path), "%s/slot-%d/slot.conf", SLOTS_DIR, slot + 1);
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	FILE *out = fopen(temp, "w");
+	if (out == NULL)
+		return send_rest_error(connection, "Unable to save container resources.", 500);
+
+	FILE *in = fopen(path, "r");
+	if (in != NULL) {
+		while (fgets(line, sizeof(line), in) != NULL) {
+			int key = resource_key_index(line);
+			if ((key >= 0) && (values[key] != NULL))
+				continue;
+			fputs(line, out);
+		}
+		fclose(in);
+	}
+	for (int key = 0; resource_keys[key].key != NULL; key++)
+		if ((values[key] != NULL) && (values[key][0] != '\0'))
+			fprintf(out, "%s=%s\n", resource_keys[key].key, values[key]);
+
+	if ((fclose(out) != 0) || (rename(temp, path) != 0)) {
+		unlink(temp);
+		return send_rest_error(connection, "Unable to save container resources.", 500);
+	}
+	return send_rest_response(connection, "Ok");
+}
+
+
+
+static int resource_key_index(const char *line)
+{
+	for (int key = 0; resource_keys[key].key != NULL; key++) {
+		size_t length = strlen(resource_keys[key].key);
+		if ((strncmp(line, resource_keys[key].key, length) == 0) && (line[length] == '='))
+			return key;
+	}
+	return -1;
+}
+
+
+
+static int valid_resource_value(int key, const char *value)
+{
+	size_t length = strlen(value);
+
+	if (length >= RESOURCE_VALUE_MAX)
+		return 0;
+	if (strspn(value, resource_keys[key].accepted) != length)
+		return 0;
+	if ((length > 0) && (strcmp(resource_keys[key].key, "ipc") == 0))
+		return (strcmp(value, "private") == 0) || (strcmp(value, "shareable") == 0)
+		    || (strcmp(value, "host") == 0) || (strcmp(value, "none") == 0);
+	if ((length > 0) && (strcmp(resource_keys[key].key, "rt_priority") == 0))
+		return atoi(value) <= 99;
+	return 1;
+}
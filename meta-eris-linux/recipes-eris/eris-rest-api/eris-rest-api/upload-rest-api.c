@@ -0,0 +1,510 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Uploads of system images and container images to the device, for the
+// updates without a server. The body of the request is processed as it
+// arrives, never kept in memory:
+//
+//   POST /api/update/upload       the system image (or block delta) goes
+//                                 through the installer (system-installer.c)
+//                                 to the inactive partition. When the queue
+//                                 of the installer is full, the connection
+//                                 is suspended until it has room again: the
+//                                 unread data stays in the TCP window and the
+//                                 client is slowed down.
+//   POST /api/container/upload    the container image is hashed and written
+//                                 to the directory of its slot, ready for a
+//                                 switch (see /api/update/container/switch).
+//
+// Both images are signed with the system key: the signature (openssl dgst
+// -sha256 -sign) is given in base 64 by the X-Eris-Signature header. A
+// container image whose signature doesn't match is never renamed for the
+// switch. The failures of the device are reported with 500 (507 when the
+// storage is full), the rejected images with 400.
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include "eris-rest-api.h"
+#include "system-installer.h"
+#include "upload-rest-api.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define SLOTS_DIR                  "/data/containers"
+#define MAX_CONTAINERS             4
+
+#define SYSTEM_UPLOAD_MAX_SIZE     (8ULL * 1024 * 1024 * 1024)
+#define CONTAINER_UPLOAD_MAX_SIZE  (4ULL * 1024 * 1024 * 1024)
+
+#define SIGNATURE_HEADER           "X-Eris-Signature"
+#define SIGNATURE_MAX              1024
+
+
+// ---------------------- Private types definitions.
+
+typedef enum {
+
+	UPLOAD_SYSTEM,
+	UPLOAD_CONTAINER,
+
+} upload_kind_t;
+
+
+typedef struct {
+
+	request_kind_t       request;       // REQUEST_UPLOAD.
+	upload_kind_t        kind;
+	unsigned long long   received;
+	unsigned long long   limit;
+	int                  ended;         // End of the body given to the installer.
+
+	// Container image.
+	int                  slot;
+	int                  fd;
+	int                  write_error;   // errno of the first failed write.
+	EVP_MD_CTX          *digest;
+	EVP_MD_CTX          *verify;
+	unsigned char        signature[SIGNATURE_MAX + 3];
+	int                  signature_length;
+	char                 expected[65];  // Optional SHA-256 given by the client.
+	char                 path[256];     // Part file, renamed once complete.
+
+} upload_t;
+
+
+// ---------------------- Private method declarations.
+
+static enum MHD_Result start_system_upload_request    (struct MHD_Connection *connection, void **ptr);
+static enum MHD_Result start_container_upload_request (struct MHD_Connection *connection, void **ptr);
+static enum MHD_Result continue_system_upload         (struct MHD_Connection *connection, upload_t *upload,
+                                                       const char *data, size_t *size);
+static enum MHD_Result continue_container_upload      (struct MHD_Connection *connection, upload_t *upload,
+                                                       const char *data, size_t *size);
+static enum MHD_Result end_container_upload           (struct MHD_Connection *connection, upload_t *upload);
+
+static int                read_content_length  (struct MHD_Connection *connection, unsigned long long *length);
+static int                read_signature       (struct MHD_Connection *connection, unsigned char *signature);
+static int                error_status         (int err);
+static const char        *image_extension      (int fd);
+static void               suspend_upload       (struct MHD_Connection *connection);
+static void               wake_upload          (void);
+static void               free_upload          (upload_t *upload);
+
+
+// ---------------------- Private variables declarations.
+
+// The installer takes one system image at a time: a single connection
+// may be waiting for it.
+static pthread_mutex_t         upload_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct MHD_Connection  *suspended_upload = NULL;
+
+// Container uploads in progress, accessed by the MHD thread only.
+static int                     container_uploading[MAX_CONTAINERS];
+
+
+// ---------------------- Public methods
+
+int init_upload_rest_api(const char *name)
+{
+	(void) name;
+
+	set_install_wakeup(wake_upload);
+	return 0;
+}
+
+
+
+int is_upload_request(const char *url, const char *method)
+{
+	if (strcmp(method, "POST") != 0)
+		return 0;
+	return (strcasecmp(url, "/api/update/upload") == 0) || (strcasecmp(url, "/api/container/upload") == 0);
+}
+
+
+
+enum MHD_Result upload_rest_api(struct MHD_Connection *connection, const char *url,
+                                const char *upload_data, size_t *upload_data_size, void **ptr)
+{
+	upload_t *upload = *ptr;
+
+	// First call: only the headers are known.
+	if (upload == NULL) {
+		if (strcasecmp(url, "/api/update/upload") == 0)
+			return start_system_upload_request(connection, ptr);
+		return start_container_upload_request(connection, ptr);
+	}
+
+	if (upload->kind == UPLOAD_SYSTEM)
+		return continue_system_upload(connection, upload, upload_data, upload_data_size);
+	return continue_container_upload(connection, upload, upload_data, upload_data_size);
+}
+
+
+
+void release_upload(struct MHD_Connection *connection, void **ptr)
+{
+	upload_t *upload = *ptr;
+
+	if ((upload == NULL) || (upload->request != REQUEST_UPLOAD))
+		return;
+	*ptr = NULL;
+
+	if (upload->kind == UPLOAD_SYSTEM) {
+		pthread_mutex_lock(&upload_mutex);
+		if (suspended_upload == connection)
+			suspended_upload = NULL;
+		pthread_mutex_unlock(&upload_mutex);
+		// The client went away: the installation fails.
+		if (! upload->ended)
+			end_system_upload(0);
+	} else {
+		container_uploading[upload->slot] = 0;
+	}
+	free_upload(upload);
+}
+
+
+// ---------------------- Private methods
+
+static enum MHD_Result start_system_upload_request(struct MHD_Connection *connection, void **ptr)
+{
+	unsigned char signature[SIGNATURE_MAX + 3];
+	unsigned long long length = 0;
+
+	if (read_content_length(connection, &length) != 0)
+		return send_rest_error(connection, "Invalid Content-Length.", 400);
+	if (length > SYSTEM_UPLOAD_MAX_SIZE)
+		return send_rest_error(connection, "The image is too large.", 413);
+
+	int decoded = read_signature(connection, signature);
+	if (decoded <= 0)
+		return send_rest_error(connection, "Missing or invalid '" SIGNATURE_HEADER "' header.", 400);
+
+	upload_t *upload = calloc(1, sizeof(upload_t));
+	if (upload == NULL)
+		return send_rest_error(connection, "Not enough memory.", 500);
+	upload->request = REQUEST_UPLOAD;
+	upload->kind = UPLOAD_SYSTEM;
+	upload->limit = (length > 0) ? length : SYSTEM_UPLOAD_MAX_SIZE;
+	upload->fd = -1;
+
+	if (start_system_upload(signature, decoded, length) != 0) {
+		free(upload);
+		if (errno == EBUSY)
+			return send_rest_error(connection, "An installation is already in progress.", 409);
+		return send_rest_error(connection, "Unable to start the installation.", 500);
+	}
+	*ptr = upload;
+	return MHD_YES;
+}
+
+
+
+static enum MHD_Result start_container_upload_request(struct MHD_Connection *connection, void **ptr)
+{
+	char dir[128];
+	unsigned char signature[SIGNATURE_MAX + 3];
+	unsigned long long length = 0;
+	struct statvfs fs;
+
+	const char *index = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if ((index == NULL) || (strlen(index) != 1) || (index[0] < '0') || (index[0] >= '0' + MAX_CONTAINERS))
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+	int slot = index[0] - '0';
+
+	const char *expected = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "sha256");
+	if ((expected != NULL) && ((strlen(expected) != 64) || (strspn(expected, "0123456789abcdefABCDEF") != 64)))
+		return send_rest_error(connection, "The 'sha256' parameter must be 64 hexadecimal digits.", 400);
+
+	if (read_content_length(connection, &length) != 0)
+		return send_rest_error(connection, "Invalid Content-Length.", 400);
+	if (length > CONTAINER_UPLOAD_MAX_SIZE)
+		return send_rest_error(connection, "The image is too large.", 413);
+
+	int decoded = read_signature(connection, signature);
+	if (decoded <= 0)
+		return send_rest_error(connection, "Missing or invalid '" SIGNATURE_HEADER "' header.", 400);
+
+	if (container_uploading[slot])
+		return send_rest_error(connection, "An upload is already in progress for this container.", 409);
+
+	snprintf(dir, sizeof(dir), "%s/slot-%d", SLOTS_DIR, slot + 1);
+	mkdir(dir, 0755);
+	if ((length > 0) && (statvfs(dir, &fs) == 0) && ((unsigned long long) fs.f_bavail * fs.f_frsize < length))
+		return send_rest_error(connection, "Not enough space for the image.", 507);
+
+	upload_t *upload = calloc(1, sizeof(upload_t));
+	if (upload == NULL)
+		return send_rest_error(connection, "Not enough memory.", 500);
+	upload->request = REQUEST_UPLOAD;
+	upload->kind = UPLOAD_CONTAINER;
+	upload->slot = slot;
+	upload->limit = (length > 0) ? length : CONTAINER_UPLOAD_MAX_SIZE;
+	if (expected != NULL)
+		for (int i = 0; i < 65; i++)
+			upload->expected[i] = tolower(expected[i]);
+	memcpy(upload->signature, signature, decoded);
+	upload->signature_length = decoded;
+
+	EVP_PKEY *key = NULL;
+	FILE *fp = fopen(SYSTEM_PUBLIC_KEY_FILE, "r");
+	if (fp != NULL) {
+		key = PEM_read_PUBKEY(fp, NULL, NULL, NULL);
+		fclose(fp);
+	}
+	upload->verify = EVP_MD_CTX_new();
+	if ((key == NULL) || (upload->verify == NULL)
+	 || (EVP_DigestVerifyInit(upload->verify, NULL, EVP_sha256(), NULL, key) != 1)) {
+		EVP_PKEY_free(key);
+		free_upload(upload);
+		return send_rest_error(connection, "Unable to load the system public key.", 500);
+	}
+	// The context keeps its own reference.
+	EVP_PKEY_free(key);
+
+	snprintf(upload->path, sizeof(upload->path), "%s/upload.part", dir);
+	upload->fd = open(upload->path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	upload->digest = EVP_MD_CTX_new();
+	if ((upload->fd < 0) || (upload->digest == NULL)
+	 || (EVP_DigestInit_ex(upload->digest, EVP_sha256(), NULL) != 1)) {
+		free_upload(upload);
+		return send_rest_error(connection, "Unable to store the image.", 500);
+	}
+	container_uploading[slot] = 1;
+	*ptr = upload;
+	return MHD_YES;
+}
+
+
+
+static enum MHD_Result continue_system_upload(struct MHD_Connection *connection, upload_t *upload,
+                                              const char *data, size_t *size)
+{
+	install_progress_t progress;
+
+	if (*size > 0) {
+		if (upload->received + *size > upload->limit)
+			return MHD_NO;
+		// The check of the queue and the suspension are atomic for the wakeup.
+		pthread_mutex_lock(&upload_mutex);
+		long taken = upload_system_image((const unsigned char *) data, *size);
+		if (taken == 0)
+			suspend_upload(connection);
+		pthread_mutex_unlock(&upload_mutex);
+
+		// The reason of the failure is given by /api/update/status.
+		if (taken < 0)
+			return MHD_NO;
+		upload->received += taken;
+		*size -= taken;
+		return MHD_YES;
+	}
+
+	// End of the body: wait for the end of the installation to reply.
+	pthread_mutex_lock(&upload_mutex);
+	if ((! upload->ended) && (end_system_upload(1) != 1))
+		upload->ended = 1;
+	get_install_progress(&progress);
+	if ((progress.stage != INSTALL_DONE) && (progress.stage != INSTALL_FAILED)) {
+		suspend_upload(connection);
+		pthread_mutex_unlock(&upload_mutex);
+		return MHD_YES;
+	}
+	pthread_mutex_unlock(&upload_mutex);
+
+	if (progress.stage == INSTALL_FAILED) {
+		unsigned int status = (progress.cause == INSTALL_ERROR_IMAGE) ? 400 : (progress.cause == INSTALL_ERROR_SPACE) ? 507 : 500;
+		return send_rest_error(connection, (progress.error[0] != '\0') ? progress.error : "Installation failed.", status);
+	}
+
+	char reply[128];
+	snprintf(reply, sizeof(reply), "System image installed on %s.\n", progress.partition);
+	return send_rest_response(connection, reply);
+}
+
+
+
+static enum MHD_Result continue_container_upload(struct MHD_Connection *connection, upload_t *upload,
+                                                 const char *data, size_t *size)
+{
+	if (*size == 0)
+		return end_container_upload(connection, upload);
+
+	if (upload->received + *size > upload->limit)
+		return MHD_NO;
+	EVP_DigestUpdate(upload->digest, data, *size);
+	EVP_DigestVerifyUpdate(upload->verify, data, *size);
+
+	// After a write error, the rest of the body is read for the reply.
+	size_t done = 0;
+	while ((done < *size) && (upload->write_error == 0)) {
+		ssize_t n = write(upload->fd, data + done, *size - done);
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0)
+			upload->write_error = (n < 0) ? errno : ENOSPC;
+		else
+			done += n;
+	}
+	upload->received += *size;
+	*size = 0;
+	return MHD_YES;
+}
+
+
+
+// The image is named after its compression, as expected by start-containers.
+static enum MHD_Result end_container_upload(struct MHD_Connection *connection, upload_t *upload)
+{
+	unsigned char digest[32];
+	unsigned int length = sizeof(digest);
+	char hex[65];
+	char path[256];
+
+	if (upload->received == 0)
+		return send_rest_error(connection, "Empty image.", 400);
+	if ((upload->write_error == 0) && (fsync(upload->fd) != 0))
+		upload->write_error = errno;
+	if (upload->write_error != 0)
+		return send_rest_error(connection, "Unable to store the image.", error_status(upload->write_error));
+	EVP_DigestFinal_ex(upload->digest, digest, &length);
+	for (int i = 0; i < 32; i++)
+		snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+
+	if ((upload->expected[0] != '\0') && (strcmp(hex, upload->expected) != 0))
+		return send_rest_error(connection, "The SHA-256 of the image doesn't match.", 400);
+	if (EVP_DigestVerifyFinal(upload->verify, upload->signature, upload->signature_length) != 1)
+		return send_rest_error(connection, "Invalid signature of the image.", 400);
+
+	snprintf(path, sizeof(path), "%s/slot-%d/upload%s", SLOTS_DIR, upload->slot + 1, image_extension(upload->fd));
+	const char *extensions[] = { ".tar", ".tar.zst", ".tar.xz", ".tar.gz" };
+	for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+		char previous[256];
+		snprintf(previous, sizeof(previous), "%s/slot-%d/upload%s", SLOTS_DIR, upload->slot + 1, extensions[i]);
+		unlink(previous);
+	}
+	if (rename(upload->path, path) != 0)
+		return send_rest_error(connection, "Unable to store the image.", error_status(errno));
+	upload->path[0] = '\0';
+
+	char reply[512];
+	snprintf(reply, sizeof(reply), "%s\nsha256=%s\nbytes=%llu\n", path, hex, upload->received);
+	return send_rest_response(connection, reply);
+}
+
+
+
+static int read_content_length(struct MHD_Connection *connection, unsigned long long *length)
+{
+	char *end;
+
+	*length = 0;
+	const char *value = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_CONTENT_LENGTH);
+	if (value == NULL)
+		return 0;
+	errno = 0;
+	*length = strtoull(value, &end, 10);
+	if ((errno != 0) || (end == value) || (*end != '\0'))
+		return -1;
+	return 0;
+}
+
+
+
+// The signature (openssl dgst -sha256 -sign) is given in base 64. Return
+// its length, or -1 if the header is missing or invalid.
+static int read_signature(struct MHD_Connection *connection, unsigned char *signature)
+{
+	const char *encoded = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, SIGNATURE_HEADER);
+	if ((encoded == NULL) || (strlen(encoded) == 0) || (strlen(encoded) % 4 != 0)
+	 || (strlen(encoded) / 4 * 3 > SIGNATURE_MAX + 3))
+		return -1;
+	int decoded = EVP_DecodeBlock(signature, (const unsigned char *) encoded, strlen(encoded));
+	if (decoded <= 0)
+		return -1;
+	// EVP_DecodeBlock() counts the padding.
+	for (const char *p = encoded + strlen(encoded) - 1; (p >= encoded) && (*p == '='); p--)
+		decoded--;
+	return decoded;
+}
+
+
+
+// HTTP status of a failure of the storage.
+static int error_status(int err)
+{
+	return ((err == ENOSPC) || (err == EDQUOT)) ? 507 : 500;
+}
+
+
+
+static const char *image_extension(int fd)
+{
+	unsigned char magic[6];
+
+	if (pread(fd, magic, sizeof(magic), 0) != sizeof(magic))
+		return ".tar";
+	if ((magic[0] == 0x28) && (magic[1] == 0xB5) && (magic[2] == 0x2F) && (magic[3] == 0xFD))
+		return ".tar.zst";
+	if ((magic[0] == 0x1F) && (magic[1] == 0x8B))
+		return ".tar.gz";
+	if (memcmp(magic, "\xFD" "7zXZ\0", 6) == 0)
+		return ".tar.xz";
+	return ".tar";
+}
+
+
+
+// Called with upload_mutex locked.
+static void suspend_upload(struct MHD_Connection *connection)
+{
+	MHD_suspend_connection(connection);
+	suspended_upload = connection;
+}
+
+
+
+// Called by the installer threads.
+static void wake_upload(void)
+{
+	pthread_mutex_lock(&upload_mutex);
+	if (suspended_upload != NULL) {
+		MHD_resume_connection(suspended_upload);
+		suspended_upload = NULL;
+	}
+	pthread_mutex_unlock(&upload_mutex);
+}
+
+
+
+static void free_upload(upload_t *upload)
+{
+	if (upload->fd >= 0)
+		close(upload->fd);
+	if (upload->path[0] != '\0')
+		unlink(upload->path);
+	if (upload->digest != NULL)
+		EVP_MD_CTX_free(upload->digest);
+	if (upload->verify != NULL)
+		EVP_MD_CTX_free(upload->verify);
+	free(upload);
+}
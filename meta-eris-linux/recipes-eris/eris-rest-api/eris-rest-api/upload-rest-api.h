@@ -0,0 +1,26 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef UPLOAD_REST_API_H
+#define UPLOAD_REST_API_H
+
+	#include <microhttpd.h>
+
+	int init_upload_rest_api(const char *name);
+
+	// Is this request an upload, whose body is handled by upload_rest_api()?
+	int is_upload_request(const char *url, const char *method);
+
+	// Called for the headers of the request, then for each piece of its
+	// body, with the upload_data of the MHD access handler.
+	enum MHD_Result upload_rest_api(struct MHD_Connection *connection, const char *url,
+	                                const char *upload_data, size_t *upload_data_size, void **ptr);
+
+	// End of the request (completed or interrupted).
+	void release_upload(struct MHD_Connection *connection, void **ptr);
+
+#endif
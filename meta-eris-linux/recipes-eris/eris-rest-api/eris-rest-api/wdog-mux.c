@@ -0,0 +1,448 @@
+/*
+ *  ERIS LINUX REST API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+// Software watchdogs of the container slots, multiplexed on the hardware
+// watchdog. The deadlines of the registered clients are kept in a min-heap,
+// and a single timerfd is armed on the nearest event: the earliest client
+// deadline or the next feeding of the hardware watchdog (every half of its
+// timeout). Without client, the thread wakes up at this period only.
+//
+// An expired client either gets its container restarted (and is then
+// unregistered until the new container registers again), or stops the
+// feeding of the hardware watchdog and starts an orderly reboot. The
+// hardware watchdog resets the board if this reboot hangs.
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/watchdog.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+
+#include "exec-command.h"
+#include "fast-shutdown.h"
+#include "wdog-mux.h"
+
+
+// ---------------------- Private macros declarations.
+
+#define START_CONTAINERS_SCRIPT   "/etc/init.d/start-containers"
+#define MAX_CONTAINERS            4
+
+// Used if the driver does not give its timeout.
+#define WDOG_DEFAULT_TIMEOUT_S    60
+
+
+
+// ---------------------- Private types definitions.
+
+typedef struct {
+
+	wdog_client_t  client;
+	long long      deadline_ms;
+	int            heap_pos;        // -1 if not in the heap.
+
+} wdog_slot_t;
+
+
+// ---------------------- Private method declarations.
+
+static void     *wdog_mux_thread       (void *arg);
+static void      check_deadlines       (long long now);
+static void      arm_timer             (void);
+static void      heap_push             (int slot);
+static void      heap_remove           (int slot);
+static void      heap_update           (int slot);
+static void      heap_swap             (int a, int b);
+static void      sift_up               (int pos);
+static void      sift_down             (int pos);
+static void     *restart_container     (void *arg);
+static long long monotonic_ms          (void);
+
+
+// ---------------------- Private variables declarations.
+
+static pthread_mutex_t wdog_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static wdog_slot_t     wdog_slots[MAX_CONTAINERS];
+static int             wdog_heap[MAX_CONTAINERS];
+static int             wdog_heap_count = 0;
+
+static int             wdog_fd = -1;
+static int             wdog_timer_fd = -1;
+static int             wdog_feeding = 1;
+static int             wdog_unhealthy = 0;     // Clients waiting for a reboot.
+static long long       wdog_period_ms = WDOG_DEFAULT_TIMEOUT_S * 1000 / 2;
+static long long       wdog_next_feed_ms = 0;
+
+
+// ---------------------- Public methods
+
+int start_wdog_mux(int watchdog_fd)
+{
+	pthread_t thread;
+
+	for (int i = 0; i < MAX_CONTAINERS; i++)
+		wdog_slots[i].heap_pos = -1;
+
+	wdog_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (wdog_timer_fd < 0)
+		return -1;
+
+	wdog_fd = watchdog_fd;
+	update_wdog_period();
+
+	if (pthread_create(&thread, NULL, wdog_mux_thread, NULL) != 0) {
+		close(wdog_timer_fd);
+		wdog_timer_fd = -1;
+		return -1;
+	}
+	pthread_detach(thread);
+	return 0;
+}
+
+
+
+void set_wdog_feeder(int enabled)
+{
+	pthread_mutex_lock(&wdog_mutex);
+	wdog_feeding = enabled;
+	// Fed at once when enabled.
+	wdog_next_feed_ms = 0;
+	arm_timer();
+	pthread_mutex_unlock(&wdog_mutex);
+}
+
+
+
+int wdog_feeder_is_enabled(void)
+{
+	pthread_mutex_lock(&wdog_mutex);
+	int enabled = wdog_feeding;
+	pthread_mutex_unlock(&wdog_mutex);
+	return enabled;
+}
+
+
+
+// To call when the timeout of the hardware watchdog was changed.
+void update_wdog_period(void)
+{
+	int timeout = 0;
+
+	if ((ioctl(wdog_fd, WDIOC_GETTIMEOUT, &timeout) != 0) || (timeout <= 0))
+		timeout = WDOG_DEFAULT_TIMEOUT_S;
+
+	pthread_mutex_lock(&wdog_mutex);
+	wdog_period_ms = timeout * 1000LL / 2;
+	wdog_next_feed_ms = 0;
+	arm_timer();
+	pthread_mutex_unlock(&wdog_mutex);
+}
+
+
+
+int register_wdog_client(int slot, int timeout_ms, wdog_action_t action)
+{
+	if ((slot < 0) || (slot >= MAX_CONTAINERS) || (timeout_ms <= 0)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&wdog_mutex);
+	wdog_slot_t *s = &(wdog_slots[slot]);
+	if (s->client.expired) {
+		pthread_mutex_unlock(&wdog_mutex);
+		errno = EBUSY;
+		return -1;
+	}
+	s->client.registered = 1;
+	s->client.timeout_ms = timeout_ms;
+	s->client.action = action;
+	s->deadline_ms = monotonic_ms() + timeout_ms;
+	if (s->heap_pos < 0)
+		heap_push(slot);
+	else
+		heap_update(slot);
+	arm_timer();
+	pthread_mutex_unlock(&wdog_mutex);
+	return 0;
+}
+
+
+
+int feed_wdog_client(int slot)
+{
+	if ((slot < 0) || (slot >= MAX_CONTAINERS)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&wdog_mutex);
+	wdog_slot_t *s = &(wdog_slots[slot]);
+	if (! s->client.registered) {
+		pthread_mutex_unlock(&wdog_mutex);
+		errno = ENOENT;
+		return -1;
+	}
+	// Too late: the reboot is in progress.
+	if (s->client.expired) {
+		pthread_mutex_unlock(&wdog_mutex);
+		errno = EBUSY;
+		return -1;
+	}
+	s->deadline_ms = monotonic_ms() + s->client.timeout_ms;
+	heap_update(slot);
+	arm_timer();
+	pthread_mutex_unlock(&wdog_mutex);
+	return 0;
+}
+
+
+
+int unregister_wdog_client(int slot)
+{
+	if ((slot < 0) || (slot >= MAX_CONTAINERS)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&wdog_mutex);
+	wdog_slot_t *s = &(wdog_slots[slot]);
+	if (! s->client.registered) {
+		pthread_mutex_unlock(&wdog_mutex);
+		errno = ENOENT;
+		return -1;
+	}
+	if (s->client.expired) {
+		pthread_mutex_unlock(&wdog_mutex);
+		errno = EBUSY;
+		return -1;
+	}
+	s->client.registered = 0;
+	if (s->heap_pos >= 0)
+		heap_remove(slot);
+	arm_timer();
+	pthread_mutex_unlock(&wdog_mutex);
+	return 0;
+}
+
+
+
+void get_wdog_client(int slot, wdog_client_t *client)
+{
+	memset(client, 0, sizeof(wdog_client_t));
+	if ((slot < 0) || (slot >= MAX_CONTAINERS))
+		return;
+
+	pthread_mutex_lock(&wdog_mutex);
+	*client = wdog_slots[slot].client;
+	if ((client->registered) && (! client->expired))
+		client->remaining_ms = wdog_slots[slot].deadline_ms - monotonic_ms();
+	pthread_mutex_unlock(&wdog_mutex);
+}
+
+
+
+const char *wdog_action_name(wdog_action_t action)
+{
+	return (action == WDOG_ACTION_REBOOT) ? "reboot" : "restart";
+}
+
+
+// ---------------------- Private methods
+
+static void *wdog_mux_thread(void *arg)
+{
+	uint64_t expirations;
+
+	(void) arg;
+
+	for (;;) {
+		pthread_mutex_lock(&wdog_mutex);
+		long long now = monotonic_ms();
+		check_deadlines(now);
+		if ((wdog_feeding) && (wdog_unhealthy == 0) && (now >= wdog_next_feed_ms)) {
+			ioctl(wdog_fd, WDIOC_KEEPALIVE, 0);
+			wdog_next_feed_ms = now + wdog_period_ms;
+		}
+		arm_timer();
+		pthread_mutex_unlock(&wdog_mutex);
+
+		// Also woken up when an API call sets a nearer deadline.
+		if ((read(wdog_timer_fd, &expirations, sizeof(expirations)) < 0) && (errno != EINTR))
+			return NULL;
+	}
+	return NULL;
+}
+
+
+
+// Called with the mutex held.
+static void check_deadlines(long long now)
+{
+	while ((wdog_heap_count > 0) && (wdog_slots[wdog_heap[0]].deadline_ms <= now)) {
+		int slot = wdog_heap[0];
+		wdog_slot_t *s = &(wdog_slots[slot]);
+
+		heap_remove(slot);
+		s->client.expirations++;
+
+		if (s->client.action == WDOG_ACTION_REBOOT) {
+			s->client.expired = 1;
+			wdog_unhealthy++;
+			fprintf(stderr, "Watchdog of container %d expired: reboot.\n", slot);
+			start_shutdown();
+			continue;
+		}
+
+		// The new container registers again.
+		s->client.registered = 0;
+		fprintf(stderr, "Watchdog of container %d expired: restart.\n", slot);
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, restart_container, (void *) (intptr_t) slot) == 0)
+			pthread_detach(thread);
+	}
+}
+
+
+
+// Called with the mutex held. The timer is disarmed if there is nothing
+// to wait for.
+static void arm_timer(void)
+{
+	struct itimerspec spec;
+	long long next = -1;
+
+	if (wdog_timer_fd < 0)
+		return;
+
+	if ((wdog_feeding) && (wdog_unhealthy == 0))
+		next = wdog_next_feed_ms;
+	if ((wdog_heap_count > 0) && ((next < 0) || (wdog_slots[wdog_heap[0]].deadline_ms < next)))
+		next = wdog_slots[wdog_heap[0]].deadline_ms;
+
+	memset(&spec, 0, sizeof(spec));
+	if (next >= 0) {
+		// A zero value would disarm the timer.
+		if (next <= 0)
+			next = 1;
+		spec.it_value.tv_sec  = next / 1000;
+		spec.it_value.tv_nsec = (next % 1000) * 1000000;
+	}
+	timerfd_settime(wdog_timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+
+
+static void heap_push(int slot)
+{
+	int pos = wdog_heap_count++;
+	wdog_heap[pos] = slot;
+	wdog_slots[slot].heap_pos = pos;
+	sift_up(pos);
+}
+
+
+
+static void heap_remove(int slot)
+{
+	int pos = wdog_slots[slot].heap_pos;
+	int last = --wdog_heap_count;
+
+	wdog_slots[slot].heap_pos = -1;
+	if (pos == last)
+		return;
+	wdog_heap[pos] = wdog_heap[last];
+	wdog_slots[wdog_heap[pos]].heap_pos = pos;
+	heap_update(wdog_heap[pos]);
+}
+
+
+
+// The deadline of the slot has changed.
+static void heap_update(int slot)
+{
+	int pos = wdog_slots[slot].heap_pos;
+
+	sift_up(pos);
+	sift_down(wdog_slots[slot].heap_pos);
+}
+
+
+
+static void heap_swap(int a, int b)
+{
+	int slot = wdog_heap[a];
+
+	wdog_heap[a] = wdog_heap[b];
+	wdog_heap[b] = slot;
+	wdog_slots[wdog_heap[a]].heap_pos = a;
+	wdog_slots[wdog_heap[b]].heap_pos = b;
+}
+
+
+
+static void sift_up(int pos)
+{
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+		if (wdog_slots[wdog_heap[parent]].deadline_ms <= wdog_slots[wdog_heap[pos]].deadline_ms)
+			break;
+		heap_swap(pos, parent);
+		pos = parent;
+	}
+}
+
+
+
+static void sift_down(int pos)
+{
+	for (;;) {
+		int smallest = pos;
+		int left = 2 * pos + 1;
+		int right = left + 1;
+		if ((left < wdog_heap_count) && (wdog_slots[wdog_heap[left]].deadline_ms < wdog_slots[wdog_heap[smallest]].deadline_ms))
+			smallest = left;
+		if ((right < wdog_heap_count) && (wdog_slots[wdog_heap[right]].deadline_ms < wdog_slots[wdog_heap[smallest]].deadline_ms))
+			smallest = right;
+		if (smallest == pos)
+			return;
+		heap_swap(pos, smallest);
+		pos = smallest;
+	}
+}
+
+
+
+// Out of the multiplexer thread: stopping a container may take a while.
+static void *restart_container(void *arg)
+{
+	char number[16];
+	exec_result_t result;
+
+	snprintf(number, sizeof(number), "%d", (int) (intptr_t) arg + 1);
+	const char *argv[] = { START_CONTAINERS_SCRIPT, "restart-slot", number, NULL };
+	run_command(argv, NULL, -1, 0, -1, &result);
+	free_command_result(&result);
+	return NULL;
+}
+
+
+
+static long long monotonic_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,44 @@
+/*
+ *  ERIS LINUX API
+ *
+ *  (c) 2026: Logilin
+ *  All rights reserved
+ */
+
+#ifndef WDOG_MUX_H
+#define WDOG_MUX_H
+
+	typedef enum {
+
+		WDOG_ACTION_RESTART = 0,   // Restart the container of the slot.
+		WDOG_ACTION_REBOOT,        // Stop feeding the hardware watchdog and reboot.
+
+	} wdog_action_t;
+
+	typedef struct {
+
+		int            registered;
+		int            expired;        // A reboot is pending for this client.
+		int            timeout_ms;
+		wdog_action_t  action;
+		long long      remaining_ms;
+		int            expirations;    // Since the start of the REST API.
+
+	} wdog_client_t;
+
+	// The hardware watchdog is fed every half of its timeout, while the
+	// feeder is enabled and every registered client is healthy.
+	int  start_wdog_mux(int watchdog_fd);
+	void set_wdog_feeder(int enabled);
+	int  wdog_feeder_is_enabled(void);
+	void update_wdog_period(void);
+
+	// Virtual watchdog of a container slot (index 0 to 3).
+	int  register_wdog_client(int slot, int timeout_ms, wdog_action_t action);
+	int  feed_wdog_client(int slot);
+	int  unregister_wdog_client(int slot);
+	void get_wdog_client(int slot, wdog_client_t *client);
+
+	const char *wdog_action_name(wdog_action_t action);
+
+#endif
@@ -7,7 +7,6 @@
 
 #include <errno.h>
 #include <fcntl.h>
-#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,7 +14,9 @@
 #include <linux/watchdog.h>
 #include <sys/ioctl.h>
 
+#include "addsnprintf.h"
 #include "eris-rest-api.h"
+#include "wdog-mux.h"
 #include "wdog-rest-api.h"
 
 
@@ -24,6 +25,9 @@
 #define WATCHDOG_FILE   "/dev/watchdog0"
 #define WATCHDOG_DELAY_PREFIX "watchdog_delay="
 
+#define MAX_CONTAINERS  4
+#define CLIENT_TIMEOUT_MAX_S  3600
+
 
 // ---------------------- Private types definitions.
 
@@ -36,9 +40,14 @@ static enum MHD_Result set_watchdog_delay     (struct MHD_Connection *connection
 static enum MHD_Result start_watchdog_feeder  (struct MHD_Connection *connection);
 static enum MHD_Result stop_watchdog_feeder   (struct MHD_Connection *connection);
 static enum MHD_Result watchdog_feeder_status (struct MHD_Connection *connection);
+static enum MHD_Result list_watchdog_clients  (struct MHD_Connection *connection);
+static enum MHD_Result register_watchdog_client(struct MHD_Connection *connection);
+static enum MHD_Result feed_watchdog_client   (struct MHD_Connection *connection);
+static enum MHD_Result unregister_watchdog_client(struct MHD_Connection *connection);
+static int             read_client_index      (struct MHD_Connection *connection, int *slot);
+static enum MHD_Result send_client_error      (struct MHD_Connection *connection);
 
 
-static void *_feeder_function(void *arg);
 static int   _keep_wd_alive(void);
 static int   _disable_wd(void);
 static int   _get_wd_delay(int *delay);
@@ -47,8 +56,6 @@ static int   _set_wd_delay(int delay);
 
 // ---------------------- Private variables declarations.
 
-static int       _feeder_running = 0;
-static pthread_t _feeder_thread;
 static int       _watchdog_fd = -1;
 
 
@@ -67,10 +74,8 @@ int init_wdog_rest_api(const char *name)
 	 && (delay_line != NULL)
 	 && (sscanf(delay_line, "%ld", &delay) == 1))
 		_set_wd_delay(delay);
-	
-	pthread_create(&_feeder_thread, NULL, _feeder_function, NULL);
 
-	return 0;
+	return start_wdog_mux(_watchdog_fd);
 }
 
 
@@ -98,6 +103,17 @@ enum MHD_Result wdog_rest_api(struct MHD_Connection *connection, const char *url
 		if (strcmp(method, "DELETE") == 0)
 			return stop_watchdog_feeder(connection);
 	}
+
+	if (strcasecmp(url, "/api/watchdog/client") == 0) {
+		if (strcmp(method, "GET") == 0)
+			return list_watchdog_clients(connection);
+		if (strcmp(method, "PUT") == 0)
+			return register_watchdog_client(connection);
+		if (strcmp(method, "POST") == 0)
+			return feed_watchdog_client(connection);
+		if (strcmp(method, "DELETE") == 0)
+			return unregister_watchdog_client(connection);
+	}
 	return MHD_NO;
 }
 
@@ -115,11 +131,7 @@ static enum MHD_Result feed_watchdog(struct MHD_Connection *connection)
 
 static enum MHD_Result disable_watchdog(struct MHD_Connection *connection)
 {
-	if (_feeder_running) {
-		pthread_cancel(_feeder_thread);
-		pthread_join(_feeder_thread, NULL);
-		_feeder_running = 0;
-	}
+	set_wdog_feeder(0);
 	if (_disable_wd() == 0) 
 		return send_rest_response(connection, "Ok");
 	return send_rest_error(connection, "No watchdog available", 500);
@@ -162,8 +174,8 @@ static enum MHD_Result set_watchdog_delay (struct MHD_Connection *connection)
 
 static enum MHD_Result start_watchdog_feeder(struct MHD_Connection *connection)
 {
-	if (_feeder_running == 0) {
-		pthread_create(&_feeder_thread, NULL, _feeder_function, NULL);
+	if (! wdog_feeder_is_enabled()) {
+		set_wdog_feeder(1);
 		return send_rest_response(connection, "Ok");
 	}
 	return send_rest_error(connection, "Already running", 400);
@@ -173,10 +185,8 @@ static enum MHD_Result start_watchdog_feeder(struct MHD_Connection *connection)
 
 static enum MHD_Result stop_watchdog_feeder(struct MHD_Connection *connection)
 {
-	if (_feeder_running) {
-		pthread_cancel(_feeder_thread);
-		pthread_join(_feeder_thread, NULL);
-		_feeder_running = 0;
+	if (wdog_feeder_is_enabled()) {
+		set_wdog_feeder(0);
 		return send_rest_response(connection, "Ok");
 	}
 	return send_rest_error(connection, "Already stopped", 400);
@@ -186,20 +196,114 @@ static enum MHD_Result stop_watchdog_feeder(struct MHD_Connection *connection)
 
 static enum MHD_Result watchdog_feeder_status(struct MHD_Connection *connection)
 {
-	return send_rest_response(connection, _feeder_running ? "running" : "stopped");
+	return send_rest_response(connection, wdog_feeder_is_enabled() ? "running" : "stopped");
 
 }
 
 
 
-static void *_feeder_function(void *arg)
+// One line per registered client:
+// <index>!<healthy|expired>!<timeout in ms>!<action>!<remaining ms>!<expirations>
+static enum MHD_Result list_watchdog_clients(struct MHD_Connection *connection)
 {
-	_feeder_running = 1;
-	for (;;) {
-		_keep_wd_alive();
-		sleep(1);
+	wdog_client_t client;
+	char *reply = NULL;
+	size_t size = 0;
+	size_t pos = 0;
+
+	for (int slot = 0; slot < MAX_CONTAINERS; slot++) {
+		get_wdog_client(slot, &client);
+		if (! client.registered)
+			continue;
+		if (addsnprintf(&reply, &size, &pos, "%d!%s!%d!%s!%lld!%d\n",
+		                slot, client.expired ? "expired" : "healthy", client.timeout_ms,
+		                wdog_action_name(client.action), client.remaining_ms, client.expirations) != 0) {
+			free(reply);
+			return send_rest_error(connection, "Not enough memory.", 500);
+		}
 	}
-	return NULL;
+
+	enum MHD_Result ret = send_rest_response(connection, reply != NULL ? reply : "");
+	free(reply);
+	return ret;
+}
+
+
+
+static enum MHD_Result register_watchdog_client(struct MHD_Connection *connection)
+{
+	int slot;
+	int timeout;
+	wdog_action_t action = WDOG_ACTION_RESTART;
+
+	if (read_client_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	const char *timeout_str = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "timeout");
+	if ((timeout_str == NULL)
+	 || (sscanf(timeout_str, "%d", &timeout) != 1)
+	 || (timeout < 1)
+	 || (timeout > CLIENT_TIMEOUT_MAX_S))
+		return send_rest_error(connection, "Invalid timeout.", 400);
+
+	const char *action_str = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "action");
+	if ((action_str != NULL) && (strcmp(action_str, "reboot") == 0))
+		action = WDOG_ACTION_REBOOT;
+	else if ((action_str != NULL) && (strcmp(action_str, "restart") != 0))
+		return send_rest_error(connection, "Action must be 'restart' or 'reboot'.", 400);
+
+	if (register_wdog_client(slot, timeout * 1000, action) != 0)
+		return send_client_error(connection);
+	return send_rest_response(connection, "Ok");
+}
+
+
+
+static enum MHD_Result feed_watchdog_client(struct MHD_Connection *connection)
+{
+	int slot;
+
+	if (read_client_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	if (feed_wdog_client(slot) != 0)
+		return send_client_error(connection);
+	return send_rest_response(connection, "Ok");
+}
+
+
+
+static enum MHD_Result unregister_watchdog_client(struct MHD_Connection *connection)
+{
+	int slot;
+
+	if (read_client_index(connection, &slot) != 0)
+		return send_rest_error(connection, "Container number must be between 0 and 3.", 400);
+
+	if (unregister_wdog_client(slot) != 0)
+		return send_client_error(connection);
+	return send_rest_response(connection, "Ok");
+}
+
+
+
+static int read_client_index(struct MHD_Connection *connection, int *slot)
+{
+	const char *index = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "index");
+	if ((index == NULL) || (sscanf(index, "%d", slot) != 1))
+		return -1;
+	return ((*slot >= 0) && (*slot < MAX_CONTAINERS)) ? 0 : -1;
+}
+
+
+
+static enum MHD_Result send_client_error(struct MHD_Connection *connection)
+{
+	if (errno == ENOENT)
+		return send_rest_error(connection, "No watchdog registered for this container.", 404);
+	if (errno == EBUSY)
+		return send_rest_error(connection, "Watchdog expired, reboot in progress.", 409);
+	return send_rest_error(connection, "Invalid watchdog parameters.", 400);
 }
 
 
@@ -237,6 +341,7 @@ static int _set_wd_delay(int delay)
 {
 	ioctl(_watchdog_fd, WDIOC_SETTIMEOUT, &delay);
 	ioctl(_watchdog_fd, WDIOC_KEEPALIVE, 0);
+	update_wdog_period();
 
 	return 0;
 }
@@ -33,6 +33,17 @@ typedef struct {
 	size_t size;
 } easy_curl_memory_t;
 
+// Parser of the server-sent events of /api/events.
+typedef struct {
+	eris_event_callback_t  callback;
+	void                  *arg;
+	int                    stopped;
+	char                   line[256];
+	size_t                 length;
+	char                   event[64];
+	char                   value[128];
+} event_stream_t;
+
 
 // ---------------------- Private method declarations.
 
@@ -43,6 +54,7 @@ static void    create_easy_curl_key (void);
 static CURL   *get_easy_curl_handle (void);
 static size_t  easy_curl_callback   (void *content, size_t size, size_t count, void *user_ptr);
 static int     perform_request      (const char *url, const char *method, char *reply, size_t size);
+static size_t  event_stream_callback(void *content, size_t size, size_t count, void *user_ptr);
 
 
 // ---------------------- Private variables.
@@ -451,6 +463,36 @@ int eris_get_wifi_quality(const char *interface, char *buffer, size_t size)
 }
 
 
+
+int eris_get_network_quality(char *buffer, size_t size)
+{
+	return perform_request(REST_API_PREFIX "/api/network/quality", "GET", buffer, size);
+}
+
+
+
+int eris_run_network_selftest(int port, size_t bytes, int pings, char *buffer, size_t size)
+{
+	char request[512];
+
+	if ((port <= 0)
+	 || (port > 65535)
+	 || (snprintf(request, 512, "%s/api/network/selftest?port=%d&bytes=%zu&pings=%d",
+			REST_API_PREFIX, port, bytes, pings) >= 512)) {
+		errno = EINVAL;
+		return -1;
+	}
+	int err = perform_request(request, "POST", buffer, size);
+	if (err == 0)
+		return 0;
+	if (err == -400)
+		errno = EINVAL;
+	else
+		errno = EIO;
+	return -1;
+}
+
+
 /******************************* SBOM ****************************************/
 
 int eris_get_list_of_packages(char *buffer, size_t size)
@@ -583,6 +625,17 @@ int eris_get_container_status(int slot, char *buffer, size_t size)
 
 
 
+int eris_get_container_state(int slot, char *buffer, size_t size)
+{
+	char request[128];
+
+	snprintf(request, 127, "%s/api/container/state?index=%d", REST_API_PREFIX, slot);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
+
 int eris_get_container_version(int slot, char *buffer, size_t size)
 {
 	char request[128];
@@ -593,6 +646,64 @@ int eris_get_container_version(int slot, char *buffer, size_t size)
 }
 
 
+
+int eris_get_container_list(char *buffer, size_t size)
+{
+	char request[128];
+
+	snprintf(request, 127, "%s/api/container/list", REST_API_PREFIX);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
+
+int eris_get_container_timeline(char *buffer, size_t size)
+{
+	char request[128];
+
+	snprintf(request, 127, "%s/api/container/timeline", REST_API_PREFIX);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
+
+int eris_get_container_resources(int index, char *buffer, size_t size)
+{
+	char request[128];
+
+	snprintf(request, 127, "%s/api/container/resources?index=%d", REST_API_PREFIX, index);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
+
+int eris_get_container_stats(int index, char *buffer, size_t size)
+{
+	char request[128];
+
+	if (index < 0)
+		snprintf(request, 127, "%s/api/container/stats", REST_API_PREFIX);
+	else
+		snprintf(request, 127, "%s/api/container/stats?index=%d", REST_API_PREFIX, index);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
+
+int eris_get_container_logs(int index, char *buffer, size_t size)
+{
+	char request[128];
+
+	snprintf(request, 127, "%s/api/container/logs?index=%d", REST_API_PREFIX, index);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
 /****************************** UPDATE ***************************************/
 
 int eris_get_system_update_status(void)
@@ -608,6 +719,52 @@ int eris_get_system_update_status(void)
 
 
 
+int eris_install_system_update(const char *url, const char *signature)
+{
+	char request[2048];
+	char reply[128];
+
+	if (url == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	char *escaped_url = curl_easy_escape(get_easy_curl_handle(), url, 0);
+	char *escaped_sig = (signature != NULL) ? curl_easy_escape(get_easy_curl_handle(), signature, 0) : NULL;
+	int length;
+	if (escaped_sig != NULL)
+		length = snprintf(request, sizeof(request), "%s/api/update/install?url=%s&signature=%s",
+		                  REST_API_PREFIX, escaped_url, escaped_sig);
+	else
+		length = snprintf(request, sizeof(request), "%s/api/update/install?url=%s",
+		                  REST_API_PREFIX, escaped_url);
+	curl_free(escaped_url);
+	curl_free(escaped_sig);
+	if ((escaped_url == NULL) || (length >= (int) sizeof(request))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int err = perform_request(request, "POST", reply, sizeof(reply));
+	if (err == 0)
+		return 0;
+	if (err == -409)
+		errno = EBUSY;
+	else if (err == -400)
+		errno = EINVAL;
+	else
+		errno = EIO;
+	return -1;
+}
+
+
+
+int eris_get_system_update_progress(char *buffer, size_t size)
+{
+	return perform_request(REST_API_PREFIX "/api/update/status", "GET", buffer, size);
+}
+
+
+
 int eris_get_reboot_needed_flag(void)
 {
 	char reply[128];
@@ -730,6 +887,16 @@ int eris_set_container_update_policy(int policy)
 }
 
 
+int eris_get_container_switch_report(int index, char *buffer, size_t size)
+{
+	char request[128];
+
+	snprintf(request, 127, "%s/api/update/container/switch?index=%d", REST_API_PREFIX, index);
+
+	return perform_request(request, "GET", buffer, size);
+}
+
+
 int eris_restore_factory_preset(void)
 {
 	char reply[128];
@@ -766,6 +933,42 @@ int eris_reboot(void)
 }
 
 
+
+int eris_subscribe_events(eris_event_callback_t callback, void *arg)
+{
+	if (callback == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// A handle of its own: the stream keeps it for a long time.
+	pthread_once(&easy_curl_once, create_easy_curl_key);
+	CURL *handle = curl_easy_init();
+	if (handle == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	event_stream_t stream;
+	memset(&stream, 0, sizeof(stream));
+	stream.callback = callback;
+	stream.arg = arg;
+
+	curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(handle, CURLOPT_URL, REST_API_PREFIX "/api/events");
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, event_stream_callback);
+	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &stream);
+
+	curl_easy_perform(handle);
+	curl_easy_cleanup(handle);
+
+	if (stream.stopped)
+		return 0;
+	errno = ECONNRESET;
+	return -1;
+}
+
+
 /***************************** TIME ******************************************/
 
 int eris_get_ntp_server(char *buffer, size_t size)
@@ -824,6 +1027,13 @@ int eris_set_ntp_enable(const char *enable)
 
 
 
+int eris_get_ntp_status(char *buffer, size_t size)
+{
+	return perform_request(REST_API_PREFIX "/api/time/ntp/status", "GET", buffer, size);
+}
+
+
+
 int eris_list_time_zones(char *buffer, size_t size)
 {
 	return perform_request(REST_API_PREFIX "/api/time/zone/list", "GET", buffer, size);
@@ -961,6 +1171,50 @@ int eris_watchdog_feeder_status(char *buffer, size_t size)
 
 
 
+int eris_register_watchdog_client(int index, int timeout, const char *action)
+{
+	char request[512];
+	char reply[512];
+
+	snprintf(request, 512, "%s/api/watchdog/client?index=%d&timeout=%d&action=%s",
+	         REST_API_PREFIX, index, timeout, action != NULL ? action : "restart");
+
+	return perform_request(request, "PUT", reply, 512);
+}
+
+
+
+int eris_feed_watchdog_client(int index)
+{
+	char request[512];
+	char reply[512];
+
+	snprintf(request, 512, "%s/api/watchdog/client?index=%d", REST_API_PREFIX, index);
+
+	return perform_request(request, "POST", reply, 512);
+}
+
+
+
+int eris_unregister_watchdog_client(int index)
+{
+	char request[512];
+	char reply[512];
+
+	snprintf(request, 512, "%s/api/watchdog/client?index=%d", REST_API_PREFIX, index);
+
+	return perform_request(request, "DELETE", reply, 512);
+}
+
+
+
+int eris_get_watchdog_clients(char *buffer, size_t size)
+{
+	return perform_request(REST_API_PREFIX "/api/watchdog/client", "GET", buffer, size);
+}
+
+
+
 // ---------------------- Private methods
 
 static void create_easy_curl_key(void)
@@ -1007,6 +1261,41 @@ static size_t easy_curl_callback(void *content, size_t size, size_t count, void
 
 
 
+// Each event is an "event:" line and a "data:" line, ended by an empty line.
+static size_t event_stream_callback(void *content, size_t size, size_t count, void *user_ptr)
+{
+	event_stream_t *stream = (event_stream_t *)user_ptr;
+	const char *data = content;
+	size_t content_size = size * count;
+
+	for (size_t i = 0; i < content_size; i++) {
+		if (data[i] != '\n') {
+			if ((data[i] != '\r') && (stream->length < sizeof(stream->line) - 1))
+				stream->line[stream->length++] = data[i];
+			continue;
+		}
+		stream->line[stream->length] = '\0';
+		stream->length = 0;
+
+		if (strncmp(stream->line, "event: ", 7) == 0) {
+			snprintf(stream->event, sizeof(stream->event), "%s", stream->line + 7);
+		} else if (strncmp(stream->line, "data: ", 6) == 0) {
+			snprintf(stream->value, sizeof(stream->value), "%s", stream->line + 6);
+		} else if ((stream->line[0] == '\0') && (stream->event[0] != '\0')) {
+			if (stream->callback(stream->event, stream->value, stream->arg) != 0) {
+				// Abort the transfer.
+				stream->stopped = 1;
+				return 0;
+			}
+			stream->event[0] = '\0';
+			stream->value[0] = '\0';
+		}
+	}
+	return content_size;
+}
+
+
+
 static int perform_request(const char *url, const char *method, char *reply, size_t size)
 {
 	CURL *handle = get_easy_curl_handle();
@@ -453,6 +453,63 @@ int eris_disconnect_wifi(void);
 int eris_get_wifi_quality(const char *interface, char *buffer, size_t size);
 
 
+/**
+ * @defgroup NETQUALITY
+ * @ingroup  NETWORK
+ * @brief    This is a group of functions to measure the quality of the network.
+ *
+ */
+
+/**
+ * @brief Get the latency and loss measured toward the gateway and the configured targets.
+ *
+ * @ingroup NETQUALITY
+ *
+ * @param buffer     The buffer to fill with the network quality.
+ * @param size       The maximum size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * The host probes the targets once per second. The buffer is filled with
+ * one line per target and per sliding window (10s, 60s, 300s).
+ * For example:
+ *
+ * @code
+ *   target=192.168.1.1 address=192.168.1.1 role=gateway window=10s sent=10 received=10 loss=0.0% min=0.412ms avg=0.530ms p95=0.801ms
+ * @endcode
+ *
+ */
+int eris_get_network_quality(char *buffer, size_t size);
+
+/**
+ * @brief Measure the network path between the host and the calling container.
+ *
+ * @ingroup NETQUALITY
+ *
+ * @param port       The TCP port of an echo server running in the container.
+ * @param bytes      The amount of data to send through the echo server.
+ * @param pings      The number of round trip time measurements.
+ * @param buffer     The buffer to fill with the result.
+ * @param size       The maximum size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * The container must be running a TCP echo server on the given port
+ * before calling this function. The buffer is filled with a single line.
+ * For example:
+ *
+ * @code
+ *   peer=172.17.0.2:7 bytes=16777216 duration_ms=120 throughput_mbps=1118 cpu_ms=21 cpu_ns_per_kb=1281 pings=100 rtt_min_us=48 rtt_p50_us=61 rtt_p90_us=80 rtt_p99_us=140 rtt_max_us=152 system_version=1.2.0
+ * @endcode
+ *
+ */
+int eris_run_network_selftest(int port, size_t bytes, int pings, char *buffer, size_t size);
+
+
 /*****************************************************************************/
 
 /**
@@ -768,6 +825,30 @@ int eris_get_container_presence(int slot);
 int eris_get_container_status(int container, char *buffer, size_t size);
 
 
+/**
+ * @brief Get the runtime state of the container in a given slot.
+ *
+ * @ingroup SYSTEM_INFO
+ *
+ * @param slot      The number of the slot hosting the container.
+ * @param buffer    The buffer to fill with the state.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * This function fills the buffer with a line of the form
+ * "status=running uptime=120 restarts=0 exit_code=-1 health=none".
+ *
+ * The uptime is given in seconds, the exit code is the one of the last run
+ * (-1 if the container never exited) and the health is "none" if the
+ * container has no health check.
+ *
+ */ 
+int eris_get_container_state(int slot, char *buffer, size_t size);
+
+
 /**
  * @brief Read the version number  of the container in a given slot.
  *
@@ -792,6 +873,118 @@ int eris_get_container_status(int container, char *buffer, size_t size);
 int eris_get_container_version(int container, char *buffer, size_t size);
 
 
+/**
+ * @brief Read the description and the state of all the slots at once.
+ *
+ * @ingroup SYSTEM_INFO
+ *
+ * @param buffer    The buffer to fill with the list.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * This function fills the buffer with one line per slot, the fields being
+ * separated by '!':
+ * "index!presence!id!name!version!status!uptime!restarts!exit_code!health".
+ *
+ * It is equivalent to calling eris_get_container_presence(),
+ * eris_get_container_name(), eris_get_container_version() and
+ * eris_get_container_state() for each slot, in a single request.
+ *
+ */ 
+int eris_get_container_list(char *buffer, size_t size);
+
+
+/**
+ * @brief Read the start timeline of the containers.
+ *
+ * @ingroup SYSTEM_INFO
+ *
+ * @param buffer    The buffer to fill with the timeline.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * This function fills the buffer with one line per step of the start of
+ * the containers: "<uptime in ms> slot-<n> <step> <duration in ms>".
+ * The steps are import, created, started and ready. A slot may wait for
+ * other slots to be ready, as set in its slot.conf file.
+ *
+ */ 
+int eris_get_container_timeline(char *buffer, size_t size);
+
+
+/**
+ * @brief Read the resource usage of a container against its limits.
+ *
+ * @ingroup SYSTEM_INFO
+ *
+ * @param index     The container index (from 0).
+ * @param buffer    The buffer to fill with the usage.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * This function fills the buffer with one line per resource of the
+ * running container: "cpu_usage_usec=<n>", "cpu_max=<quota> <period>",
+ * "cpu_weight=<n>", "cpuset=<cpus>/<allowed>", "memory=<bytes>/<limit>",
+ * "swap=<bytes>/<limit>" and "pids=<n>/<limit>". The limits come from
+ * the resource profile of the slot.
+ *
+ */ 
+int eris_get_container_resources(int index, char *buffer, size_t size);
+
+
+/**
+ * @brief Read the sampled resource usage of the containers.
+ *
+ * @ingroup SYSTEM_INFO
+ *
+ * @param index     The container index (from 0), or -1 for all containers.
+ * @param buffer    The buffer to fill with the samples.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * With an index of -1, this function fills the buffer with one line per
+ * running container: "index!cpu%!memory!anon!file!read B/s!write B/s!pids".
+ * With the index of a container, the buffer receives its last samples
+ * (one per second), the first field being the uptime of the sample in ms.
+ *
+ */ 
+int eris_get_container_stats(int index, char *buffer, size_t size);
+
+
+/**
+ * @brief Read the output of a container.
+ *
+ * @ingroup SYSTEM_INFO
+ *
+ * @param index     The container index (from 0).
+ * @param buffer    The buffer to fill with the lines.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * This function fills the buffer with the last lines written by the
+ * container (stdout and stderr), kept in a ring by the host. A line
+ * "[eris-linux] <n> lines dropped" replaces the lines above the rate
+ * allowed to the container.
+ *
+ */ 
+int eris_get_container_logs(int index, char *buffer, size_t size);
+
+
 /*****************************************************************************/
 /**
  *  @defgroup TIME
@@ -872,6 +1065,24 @@ int eris_get_ntp_enable(char *buffer, size_t size);
 int eris_set_ntp_enable(const char *status);
 
 
+/**
+ * @brief Get the status of the NTP synchronization.
+ *
+ * @ingroup NTP
+ *
+ * This function fills the provided buffer with `key=value` lines: whether
+ * the clock is synchronized, the selected server with its stratum, the last
+ * measured offset, delay and jitter (in microseconds), and the times of
+ * the last synchronization and of the last RTC write.
+ *
+ * @param buffer    the buffer to fill with the NTP status.
+ * @param size      the size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ */
+int eris_get_ntp_status(char *buffer, size_t size);
+
+
 /**
  * @defgroup TIMEZONE
  * @ingroup  TIME
@@ -1044,6 +1255,49 @@ int eris_set_system_time(const char *time);
 int eris_get_system_update_status(void);
 
 
+/**
+ * @brief  Install a system image on the inactive system partition.
+ *
+ * @ingroup SYSTEM_UPDATE
+ *
+ * @param url        The http or https URL of the image (raw, gzip or zstd).
+ * @param signature  The URL of its signature, or NULL for `<url>.sig`.
+ *
+ * @return 0 if the installation is started, -1 on error and errno is set
+ * appropriately (EBUSY if an installation is already in progress).
+ *
+ * @details
+ *
+ * The image is downloaded, checked against the system public key,
+ * decompressed and written in one pass. The system boots on it at the next
+ * reboot once the installation is done. Use
+ * `eris_get_system_update_progress` to follow the installation.
+ *
+ */ 
+int eris_install_system_update(const char *url, const char *signature);
+
+
+/**
+ * @brief  Get the progress of the system image installation.
+ *
+ * @ingroup SYSTEM_UPDATE
+ *
+ * @param buffer    The buffer to fill with the progress.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * The buffer receives the status line (see `eris_get_system_update_status`)
+ * followed by "stage=", "partition=", "bytes=", "total=", "written=",
+ * "rate=" (bytes per second), "eta=" (seconds, -1 if unknown), "resumes="
+ * and "error=" lines.
+ *
+ */ 
+int eris_get_system_update_progress(char *buffer, size_t size);
+
+
 /**
  * @brief  Get the state of the "Reboot Needed" flag.
  *
@@ -1209,6 +1463,28 @@ int eris_get_container_update_policy(void);
 int eris_set_container_update_policy(int policy);
 
 
+/**
+ * @brief  Read the report of the last blue/green switch of a container.
+ *
+ * @ingroup SYSTEM_UPDATE
+ *
+ * @param index     The container index (from 0).
+ * @param buffer    The buffer to fill with the report.
+ * @param size      The size of the buffer.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ *
+ * @details
+ *
+ * The report is a line like `result=switched mode=warm stage_ms=1520
+ * ready_ms=830 downtime_ms=12 time=1792322523`. The result is `switched`,
+ * `rolled-back` (the new image didn't become ready) or `stage-failed`.
+ * The downtime is the time during which no ready container answered on
+ * the ports of the slot.
+ */ 
+int eris_get_container_switch_report(int index, char *buffer, size_t size);
+
+
 /**
  * @brief  Force the system to return to a factory preset state.
  *
@@ -1259,6 +1535,47 @@ int eris_rollback(void);
 int eris_reboot(void);
 
 
+/**
+ * @brief  Function called by `eris_subscribe_events` for each state change.
+ *
+ * @ingroup SYSTEM_UPDATE
+ *
+ * @param event  The name of the state: "update-status", "reboot-needed",
+ *               "boot-ended" or "contact-period".
+ * @param value  Its new value: the status number (see `eris_get_system_update_status`),
+ *               "yes" or "no", or the period in seconds.
+ * @param arg    The argument given to `eris_subscribe_events`.
+ *
+ * @return 0 to wait for the next event, another value to stop.
+ */
+typedef int (*eris_event_callback_t)(const char *event, const char *value, void *arg);
+
+
+/**
+ * @brief  Wait for the state changes of the update system.
+ *
+ * @ingroup SYSTEM_UPDATE
+ *
+ * @param callback  The function called for each event.
+ * @param arg       Argument given to the callback.
+ *
+ * @return 0 when the callback asked to stop, -1 on error (the connection
+ * could not be opened or was lost) and errno is set appropriately.
+ *
+ * @details
+ *
+ * The callback is called at once with the current value of each state,
+ * then each time a state changes, in place of a polling of
+ * `eris_get_reboot_needed_flag` or `eris_get_system_update_status`. A
+ * state changing several times in a row may be reported once, with its
+ * last value.
+ *
+ * The function blocks while the callback returns 0: call it from a
+ * dedicated thread, and call it again after an error.
+ */
+int eris_subscribe_events(eris_event_callback_t callback, void *arg);
+
+
 /*****************************************************************************/
 
 /**
@@ -1349,7 +1666,8 @@ int eris_set_watchdog_delay(int delay);
  * @brief    Functions to configure the automatic watchdog feeder.
  *
  * Eris Linux contains an automatic watchdog feeder that feeds the watchdog
- * every second.
+ * every half of its delay, as long as no container watchdog has expired
+ * with the `reboot` action.
  *
  * It is started automatically when the system boots.
  */
@@ -1393,6 +1711,73 @@ int eris_stop_watchdog_feeder(void);
 int eris_watchdog_feeder_status(char *buffer, size_t size);
 
 
+
+/**
+ * @defgroup WATCHDOG_CLIENTS
+ * @ingroup  WATCHDOG
+ * @brief    Software watchdogs of the containers.
+ *
+ * Each container slot may register its own watchdog, with its own timeout.
+ * When it is not fed in time, the container is restarted (`restart` action)
+ * or the system is rebooted (`reboot` action): the automatic feeder then
+ * stops feeding the hardware watchdog.
+ *
+ * A container should unregister its watchdog before a planned stop.
+ */
+
+/**
+ * @brief Register the watchdog of a container.
+ *
+ * @ingroup WATCHDOG_CLIENTS
+ *
+ * @param index    Container number (0 to 3).
+ * @param timeout  Timeout in seconds (1 to 3600).
+ * @param action   "restart" (default if NULL) or "reboot".
+ *
+ * A new call changes the timeout and the action, and feeds the watchdog.
+ * After a restart, the new container must register again.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ */
+int eris_register_watchdog_client(int index, int timeout, const char *action);
+
+
+
+/**
+ * @brief Feed the watchdog of a container.
+ *
+ * @ingroup WATCHDOG_CLIENTS
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ */
+int eris_feed_watchdog_client(int index);
+
+
+
+/**
+ * @brief Unregister the watchdog of a container.
+ *
+ * @ingroup WATCHDOG_CLIENTS
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ */
+int eris_unregister_watchdog_client(int index);
+
+
+
+/**
+ * @brief Get the registered container watchdogs.
+ *
+ * @ingroup WATCHDOG_CLIENTS
+ *
+ * This function fills the provided buffer with one line per registered
+ * watchdog: `<index>!<healthy|expired>!<timeout in ms>!<action>!<remaining ms>!<expirations>`.
+ *
+ * @return 0 on success, -1 on error and errno is set appropriately.
+ */
+int eris_get_watchdog_clients(char *buffer, size_t size);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,8 +1,11 @@
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <sys/inotify.h>
 #include <sys/time.h>
 #include <X11/Xlib.h>
 
@@ -11,6 +14,18 @@
 
 #define ERIS_SYSTEM_VERSION "0.0.0"
 
+#define FLAG_FILES_DIR      "/tmp"
+#define BOOT_ENDED_FLAG     "boot-ended"
+#define REBOOT_NEEDED_FLAG  "reboot-is-needed"
+
+#define RUN_DIR             "/run/eris-linux"
+#define FACTORY_RESET_NAME  "factory-reset"
+#define FACTORY_RESET_STATE RUN_DIR "/" FACTORY_RESET_NAME
+
+// Redraw period: animation during the boot, then the clock.
+#define BOOT_REFRESH_MS     500
+#define CLOCK_REFRESH_MS    1000
+
 
 unsigned long alloc_pixel_from_rgb(Display *dpy, int screen, unsigned char r, unsigned char g, unsigned char b)
 {
@@ -29,6 +44,82 @@ unsigned long alloc_pixel_from_rgb(Display *dpy, int screen, unsigned char r, un
 
 
 
+// State written by the early-init script 035-factory-reset:
+// "running <step>", "done <ms>" or "failed <step>".
+int read_factory_reset_state(char *message, size_t size)
+{
+	char line[64];
+	long ms;
+
+	FILE *fp = fopen(FACTORY_RESET_STATE, "r");
+	if (fp == NULL)
+		return -1;
+	if (fgets(line, sizeof(line), fp) == NULL) {
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+	line[strcspn(line, "\n")] = '\0';
+
+	if (sscanf(line, "done %ld", &ms) == 1)
+		snprintf(message, size, "Factory reset done in %ld.%01ld s", ms / 1000, (ms % 1000) / 100);
+	else if (strncmp(line, "failed ", 7) == 0)
+		snprintf(message, size, "Factory reset failed (%s)", line + 7);
+	else if (strncmp(line, "running ", 8) == 0)
+		snprintf(message, size, "Factory reset: %s", line + 8);
+	else
+		return -1;
+	return 0;
+}
+
+
+
+// Wait for the end of the redraw period, reading the changes of the flag
+// files instead of checking them at each period.
+void wait_for_flags(int fd, int timeout_ms, int *boot_ended, int *reboot_needed, int *factory_reset_changed)
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (;;) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		int elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+		if (elapsed >= timeout_ms)
+			return;
+
+		if (fd < 0) {
+			usleep((timeout_ms - elapsed) * 1000);
+			return;
+		}
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		int err = poll(&pfd, 1, timeout_ms - elapsed);
+		if ((err < 0) && (errno == EINTR))
+			continue;
+		if (err <= 0)
+			return;
+
+		ssize_t n = read(fd, buffer, sizeof(buffer));
+		if (n <= 0)
+			return;
+		for (char *p = buffer; p < buffer + n; ) {
+			struct inotify_event *event = (struct inotify_event *) p;
+			p += sizeof(struct inotify_event) + event->len;
+			if (event->len == 0)
+				continue;
+			if (strcmp(event->name, BOOT_ENDED_FLAG) == 0)
+				*boot_ended = (access(FLAG_FILES_DIR "/" BOOT_ENDED_FLAG, F_OK) == 0);
+			else if (strcmp(event->name, REBOOT_NEEDED_FLAG) == 0)
+				*reboot_needed = (access(FLAG_FILES_DIR "/" REBOOT_NEEDED_FLAG, F_OK) == 0);
+			else if (strcmp(event->name, FACTORY_RESET_NAME) == 0)
+				*factory_reset_changed = 1;
+		}
+	}
+}
+
+
+
 int main(int argc, char *argv[])
 {
 	Window win;
@@ -87,10 +178,21 @@ int main(int argc, char *argv[])
 	x = width / 2 - DELTA;
 	y = height / 2 - DELTA;
 
+	// Watches set before the first check: no change can be missed.
+	int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotify_fd >= 0) {
+		inotify_add_watch(inotify_fd, FLAG_FILES_DIR, IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM);
+		inotify_add_watch(inotify_fd, RUN_DIR, IN_CLOSE_WRITE | IN_MOVED_TO);
+	}
+	int boot_ended = (access(FLAG_FILES_DIR "/" BOOT_ENDED_FLAG, F_OK) == 0);
+	int reboot_needed = (access(FLAG_FILES_DIR "/" REBOOT_NEEDED_FLAG, F_OK) == 0);
+	int reboot_drawn = 0;
+	int factory_reset_changed = 1;
+
 
 	for (;;) {
 
-		if (access("/tmp/boot-ended", F_OK) != 0) {
+		if (! boot_ended) {
 
 			// Still booting: animated dots.
 			XSetForeground(dpy, gc, dark_blue_pixel);
@@ -118,11 +220,11 @@ int main(int argc, char *argv[])
 			}
 		}
 
-		if (access("/tmp/reboot-is-needed", F_OK) == 0) {
+		int xc = width - 80;
+		int yc = 80;
+		if (reboot_needed) {
 
 			// Update ready: display the reboot symbol
-			int xc = width - 80;
-			int yc = 80;
 			XSetForeground(dpy, gc, light_red_pixel);
 			XSetLineAttributes(dpy, gc, 20, LineSolid, CapRound, JoinRound);
 			XDrawArc(dpy, win, gc, xc - 40, yc - 40, 80, 80, 0*64, -270*64);
@@ -137,6 +239,24 @@ int main(int argc, char *argv[])
 			points[2].x = xc + 40;
 			points[2].y = yc - 40;
 			XFillPolygon(dpy, win, gc, points, 3, Convex, CoordModeOrigin);
+			reboot_drawn = 1;
+
+		} else if (reboot_drawn) {
+			// Flag cleared: erase the reboot symbol.
+			XSetForeground(dpy, gc, dark_blue_pixel);
+			XFillRectangle(dpy, win, gc, xc - 51, yc - 81, 102, 132);
+			reboot_drawn = 0;
+		}
+
+
+		if (factory_reset_changed && (read_factory_reset_state(message, 64) == 0)) {
+			// Pad with spaces to erase a longer previous message.
+			size_t len = strlen(message);
+			memset(message + len, ' ', 64 - len);
+			message[64] = '\0';
+			XSetForeground(dpy, gc, light_blue_pixel);
+			XSetBackground(dpy, gc, dark_blue_pixel);
+			XDrawImageString(dpy, win, gc, 50, 80, message, strlen(message));
 		}
 
 
@@ -160,7 +280,9 @@ int main(int argc, char *argv[])
 
 		XFlush(dpy);
 
-		usleep(500000);
+		factory_reset_changed = 0;
+		wait_for_flags(inotify_fd, boot_ended ? CLOCK_REFRESH_MS : BOOT_REFRESH_MS,
+		               &boot_ended, &reboot_needed, &factory_reset_changed);
 
 	}
 